@@ -268,8 +268,7 @@ void DBViewController::showHideFoldersStateDidChange(MDStudio::Button* sender, b
 
 // ---------------------------------------------------------------------------------------------------------------------
 void DBViewController::reloadSequences(bool isRowSelectionPreserved) {
-    _sequencesDB->invalidateSequencesCache();
-
+    // The sequences database keeps its cached lists up to date
     // Check if we have at least one sequence in the database
     bool isSequenceAvailable = _sequencesDB->getNbSequences(MelobaseCore::SequencesDB::None, "", nullptr, false) > 0;
     _view->sequencesView()->noSequencesImageView()->setIsVisible(!isSequenceAvailable);
@@ -20,6 +20,9 @@ void midiInCallback(double deltatime, std::vector<unsigned char>* message, void*
           std::cout << "stamp = " << deltatime << std::endl;
     */
 
+    // The studio places the events at their arrival rather than at their processing
+    MDStudio::StudioEventAgeScope eventAgeScope(midiHub->midiInMessageAge(deltatime));
+
     if (nBytes >= 2) {
         int type = message->at(0) & 0xF0;
         int channel = message->at(0) & 0x0F;
@@ -93,6 +96,7 @@ void midiInCallback(double deltatime, std::vector<unsigned char>* message, void*
 // ---------------------------------------------------------------------------------------------------------------------
 MIDIHub::MIDIHub() {
     _nbMIDIInputPorts = -1;
+    _lastMIDIInTime = 0.0;
     _midiIn = new RtMidiIn();
     int nPorts = static_cast<int>(_midiIn->getPortCount());
     if (nPorts > 0) _defaultMIDIInputPortName = _midiIn->getPortName(nPorts - 1);
@@ -175,6 +179,7 @@ void MIDIHub::openMIDIInputPort() {
     for (int port = 0; port < nPorts; ++port) {
         if (std::string(_midiIn->getPortName(port)) == _topViewController->midiInputPortName()) {
             _midiIn->openPort(port);
+            _lastMIDIInTime = 0.0;
             // Set our callback function.  This should be done immediately after
             // opening the port to avoid having incoming messages written to the
             // queue.
@@ -190,6 +195,19 @@ void MIDIHub::openMIDIInputPort() {
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// The delta times are accumulated from the first message, which is taken as arriving now. The accumulated time is
+// resynchronized whenever it gets ahead of the clock or too far behind.
+double MIDIHub::midiInMessageAge(double deltatime) {
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    double time = _lastMIDIInTime + deltatime;
+    if (_lastMIDIInTime == 0.0 || time > now || now - time > STUDIO_MAX_EVENT_AGE) time = now;
+    _lastMIDIInTime = time;
+
+    return now - time;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 void MIDIHub::openMIDIOutputPort() {
     if (_topViewController->midiOutputPortName() == _currentMIDIOutputPortName) return;
@@ -419,7 +437,7 @@ void MIDIHub::studioDidPerformChannelAftertouch(MDStudio::Studio* studio, int so
 
 // ---------------------------------------------------------------------------------------------------------------------
 void MIDIHub::studioDidSendSystemExclusive(MDStudio::Studio* studio, int source, double timestamp, UInt32 tick,
-                                           int channel, std::vector<UInt8> data) {
+                                           int channel, const std::vector<UInt8>& data) {
     if (_midiOut->isPortOpen()) {
         std::vector<unsigned char> message;
 
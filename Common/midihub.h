@@ -11,6 +11,7 @@
 
 #include <RtMidi.h>
 
+#include <chrono>
 #include <thread>
 
 #include "topviewcontroller.h"
@@ -29,6 +30,9 @@ class MIDIHub {
     std::string _defaultMIDIInputPortName, _defaultMIDIOutputPortName;
     std::string _currentMIDIInputPortName, _currentMIDIOutputPortName;
 
+    // Arrival time of the last MIDI input message, in seconds
+    double _lastMIDIInTime;
+
     void studioDidPlayNote(MDStudio::Studio* studio, int source, double timestamp, UInt32 tick, int channel, int pitch,
                            Float32 velocity);
     void studioDidReleaseNote(MDStudio::Studio* studio, int source, double timestamp, UInt32 tick, int channel,
@@ -52,7 +56,7 @@ class MIDIHub {
     void studioDidPerformChannelAftertouch(MDStudio::Studio* studio, int source, double timestamp, UInt32 tick,
                                            int channel, Float32 value);
     void studioDidSendSystemExclusive(MDStudio::Studio* studio, int source, double timestamp, UInt32 tick, int channel,
-                                      std::vector<UInt8> data);
+                                      const std::vector<UInt8>& data);
 
     void openMIDIInputPort();
     void openMIDIOutputPort();
@@ -67,6 +71,10 @@ class MIDIHub {
 
     TopViewController* topViewController() { return _topViewController; }
 
+    // Returns how long ago the message arrived, given the delta time reported by the MIDI input (called from the MIDI
+    // input thread only)
+    double midiInMessageAge(double deltatime);
+
     std::string defaultMIDIInputPortName() { return _defaultMIDIInputPortName; }
     std::string defaultMIDIOutputPortName() { return _defaultMIDIOutputPortName; }
 };
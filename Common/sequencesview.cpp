@@ -46,6 +46,7 @@ SequencesView::SequencesView(std::string name, void* owner) : View(name, owner)
     _controlsView->addSubview(_filterSegmentedControl);
 
     _nameSearchField = std::shared_ptr<SearchField>(new SearchField("nameSearchField", owner));
+    _nameSearchField->setTooltipText(_ui.findString("nameSearchTooltip"));
     _controlsView->addSubview(_nameSearchField);
 
     // Create table view
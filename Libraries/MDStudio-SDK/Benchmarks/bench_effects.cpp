@@ -0,0 +1,119 @@
+//
+//  bench_effects.cpp
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "bench_effects.h"
+
+#include <Chorus/chorusmodel.h>
+#include <DspFilters/Filter.h>
+#include <DspFilters/RBJ.h>
+#include <Reverb/revmodel.h>
+#include <lowpassfilterunit.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+#define BENCH_MAX_INSTANCES 1024
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Deterministic noise, so that the runs are comparable
+static void fillNoise(std::vector<GraphSampleType>* buffer) {
+    srand(0);
+    for (auto& sample : *buffer) sample = (GraphSampleType)rand() / RAND_MAX - 0.5f;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Times one instance, then finds the largest number of instances whose blocks all render in time
+static void printEffectResult(const std::string& name, const createRenderBlockFnType& createRenderBlockFn) {
+    BenchmarkResult result;
+    result.name = name;
+    result.configuration = std::to_string(BENCH_FRAMES_PER_BUFFER) + " frames";
+    measureBlocks(createRenderBlockFn(1), BENCH_NB_BLOCKS, &result);
+    result.maxInstances = measureMaxInstances(createRenderBlockFn, BENCH_MAX_INSTANCES);
+    printBenchmarkResult(result);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool benchEffects() {
+    std::vector<GraphSampleType> inL(BENCH_FRAMES_PER_BUFFER), inR(BENCH_FRAMES_PER_BUFFER);
+    std::vector<GraphSampleType> outL(BENCH_FRAMES_PER_BUFFER), outR(BENCH_FRAMES_PER_BUFFER);
+    fillNoise(&inL);
+    fillNoise(&inR);
+
+    printEffectResult("Reverb", [&](int nbInstances) {
+        auto revModels = std::make_shared<std::vector<RevModel>>(nbInstances);
+        for (auto& revModel : *revModels) revModel.setSampleRate(UNIT_DEFAULT_SAMPLE_RATE);
+        return [&, revModels]() {
+            for (auto& revModel : *revModels)
+                revModel.processMix(inL.data(), inR.data(), outL.data(), outR.data(), BENCH_FRAMES_PER_BUFFER, 1);
+        };
+    });
+
+    GraphSampleType* ioData[2] = {outL.data(), outR.data()};
+    printEffectResult("Chorus", [&](int nbInstances) {
+        auto chorusModels = std::make_shared<std::vector<ChorusModel>>(nbInstances);
+        for (auto& chorusModel : *chorusModels) chorusModel.setSampleRate(UNIT_DEFAULT_SAMPLE_RATE);
+        return [&, chorusModels]() {
+            for (auto& chorusModel : *chorusModels) {
+                std::copy(inL.begin(), inL.end(), outL.begin());
+                std::copy(inR.begin(), inR.end(), outR.begin());
+                chorusModel.renderInput(BENCH_FRAMES_PER_BUFFER, ioData, 1);
+            }
+        };
+    });
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool benchFilters() {
+    std::vector<GraphSampleType> inL(BENCH_FRAMES_PER_BUFFER), inR(BENCH_FRAMES_PER_BUFFER);
+    std::vector<GraphSampleType> outL(BENCH_FRAMES_PER_BUFFER), outR(BENCH_FRAMES_PER_BUFFER);
+    fillNoise(&inL);
+    fillNoise(&inR);
+
+    // Low-pass filter of a sampler voice, with its parameters updated every block
+    typedef Dsp::FilterDesign<Dsp::RBJ::Design::LowPass, 2> VoiceFilter;
+    float* o[2] = {outL.data(), outR.data()};
+    printEffectResult("VoiceLowPassFilter", [&](int nbInstances) {
+        auto voiceFilters = std::make_shared<std::vector<VoiceFilter>>(nbInstances);
+        return [&, voiceFilters]() {
+            for (auto& voiceFilter : *voiceFilters) {
+                std::copy(inL.begin(), inL.end(), outL.begin());
+                std::copy(inR.begin(), inR.end(), outR.begin());
+                Dsp::Params params;
+                params[0] = UNIT_DEFAULT_SAMPLE_RATE;
+                params[1] = 8000.0f;
+                params[2] = 0.7f;
+                voiceFilter.setParams(params);
+                voiceFilter.process(BENCH_FRAMES_PER_BUFFER, o);
+            }
+        };
+    });
+
+    GraphSampleType* ioData[2] = {outL.data(), outR.data()};
+    printEffectResult("LowPassFilterUnit", [&](int nbInstances) {
+        auto lowPassFilterUnits = std::make_shared<std::vector<LowPassFilterUnit>>(nbInstances);
+        for (auto& lowPassFilterUnit : *lowPassFilterUnits)
+            lowPassFilterUnit.setFormat(UNIT_DEFAULT_SAMPLE_RATE, BENCH_FRAMES_PER_BUFFER);
+        return [&, lowPassFilterUnits]() {
+            for (auto& lowPassFilterUnit : *lowPassFilterUnits) {
+                std::copy(inL.begin(), inL.end(), outL.begin());
+                std::copy(inR.begin(), inR.end(), outR.begin());
+                lowPassFilterUnit.renderInput(BENCH_FRAMES_PER_BUFFER, ioData, 1);
+            }
+        };
+    });
+
+    return true;
+}
@@ -0,0 +1,15 @@
+//
+//  bench_effects.h
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef BENCH_EFFECTS_H
+#define BENCH_EFFECTS_H
+
+bool benchEffects();
+bool benchFilters();
+
+#endif  // BENCH_EFFECTS_H
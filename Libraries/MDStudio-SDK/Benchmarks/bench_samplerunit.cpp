@@ -0,0 +1,69 @@
+//
+//  bench_samplerunit.cpp
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "bench_samplerunit.h"
+
+#include <samplerunit.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "sineinstrument.h"
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the render function of a block of a sampler playing the given number of voices spread over the channels
+static std::function<void()> createRenderBlockFn(std::shared_ptr<MultiInstrument> multiInstrument, UInt32 nbWorkers,
+                                                 int nbVoices) {
+    auto samplerUnit = std::make_shared<SamplerUnit>(SAMPLER_MAX_VOICES);
+    samplerUnit->setFormat(UNIT_DEFAULT_SAMPLE_RATE, BENCH_FRAMES_PER_BUFFER);
+    samplerUnit->setNbRenderWorkers(nbWorkers);
+
+    // Detuned pitches so that every voice is resampled
+    for (int voice = 0; voice < nbVoices; ++voice)
+        samplerUnit->playNote(40.5f + voice, 0.8f, multiInstrument, voice % SAMPLER_MAX_CHANNELS);
+
+    auto out = std::make_shared<std::vector<GraphSampleType>>(2 * BENCH_FRAMES_PER_BUFFER);
+
+    return [samplerUnit, out]() {
+        GraphSampleType* ioData[2] = {&(*out)[0], &(*out)[1]};
+        samplerUnit->renderInput(BENCH_FRAMES_PER_BUFFER, ioData, 2);
+    };
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Renders all the voices, then finds the largest polyphony whose blocks all render in time
+static BenchmarkResult measureLoad(std::shared_ptr<MultiInstrument> multiInstrument, UInt32 nbWorkers) {
+    BenchmarkResult result;
+    result.name = "SamplerPolyphony";
+    result.configuration = std::to_string(SAMPLER_MAX_VOICES) + " voices, " + std::to_string(nbWorkers + 1) +
+                           " threads, " + std::to_string(BENCH_FRAMES_PER_BUFFER) + " frames";
+    measureBlocks(createRenderBlockFn(multiInstrument, nbWorkers, SAMPLER_MAX_VOICES), BENCH_NB_BLOCKS, &result);
+
+    result.maxInstances = measureMaxInstances(
+        [&](int nbVoices) { return createRenderBlockFn(multiInstrument, nbWorkers, nbVoices); }, SAMPLER_MAX_VOICES);
+
+    return result;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool benchSamplerPolyphony() {
+    auto multiInstrument = createSineMultiInstrument("bench_samplerunit.raw", BENCH_SAMPLE_LENGTH);
+    if (!multiInstrument) return false;
+
+    UInt32 nbCores = std::max(std::thread::hardware_concurrency(), 1U);
+
+    for (UInt32 nbWorkers = 0; nbWorkers < nbCores; ++nbWorkers)
+        printBenchmarkResult(measureLoad(multiInstrument, nbWorkers));
+
+    return true;
+}
@@ -0,0 +1,14 @@
+//
+//  bench_samplerunit.h
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef BENCH_SAMPLERUNIT_H
+#define BENCH_SAMPLERUNIT_H
+
+bool benchSamplerPolyphony();
+
+#endif  // BENCH_SAMPLERUNIT_H
@@ -0,0 +1,137 @@
+//
+//  bench_sequence.cpp
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "bench_sequence.h"
+
+#include <math.h>
+#include <midifile.h>
+#include <mixer.h>
+#include <platform.h>
+#include <sequencer.h>
+#include <stdio.h>
+#include <studio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "sf2writer.h"
+
+#define BENCH_SEQUENCE_NAME "danc_qn.mid"
+#define BENCH_SEQUENCE_TAIL 2.0             // Time rendered after the end of the sequence, in seconds
+#define BENCH_SEQUENCE_MAX_DURATION 1200.0  // Maximum time rendered, in seconds
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Every channel plays the piano, or the drum kit on channel 10, so that all the notes sound with the test SoundFont
+static void setPianoPrograms(std::shared_ptr<Sequence> sequence) {
+    for (auto& track : sequence->data.tracks) {
+        for (auto& event : track.events) {
+            if (event.type != EVENT_TYPE_PROGRAM_CHANGE) continue;
+            event.param1 = STUDIO_INSTRUMENT_GM_PIANO;
+            event.param2 = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Plays a bundled MIDI file with the sequencer of a studio without audio device. The metronome is clocked by the
+// blocks rendered back to back by the mixer, and each block is timed from the end of the previous one.
+bool benchSequencePlayback() {
+    auto sequence = readMIDIFile(std::string("Resources/") + BENCH_SEQUENCE_NAME);
+    if (!sequence) {
+        std::cerr << "Unable to read " << BENCH_SEQUENCE_NAME << "\n";
+        return false;
+    }
+    setPianoPrograms(sequence);
+
+    std::vector<SInt16> samples(BENCH_SAMPLE_LENGTH);
+    for (int i = 0; i < BENCH_SAMPLE_LENGTH; ++i) samples[i] = (SInt16)(16000.0f * sinf(i * 2.0f * M_PI / 100.0f));
+    if (!writeTestSF2("./GM.sf2", samples, {}, true)) {
+        std::cerr << "Unable to write the SoundFont\n";
+        return false;
+    }
+
+    UInt32 nbEvents = 0;
+    for (auto& track : sequence->data.tracks) nbEvents += static_cast<UInt32>(track.events.size());
+
+    std::vector<double> blockUs(
+        static_cast<size_t>(BENCH_SEQUENCE_MAX_DURATION * UNIT_DEFAULT_SAMPLE_RATE / BENCH_FRAMES_PER_BUFFER));
+    std::atomic<size_t> nbBlocks(0);
+    UInt32 nbTailBlocks = static_cast<UInt32>(BENCH_SEQUENCE_TAIL * UNIT_DEFAULT_SAMPLE_RATE / BENCH_FRAMES_PER_BUFFER);
+    bool isPlayed = false;
+
+    {
+        Studio studio(STUDIO_MAX_CHANNELS, ".", SAMPLER_MAX_VOICES, true);
+        studio.mixer()->setFramesPerBuffer(BENCH_FRAMES_PER_BUFFER);
+
+        // The first block is not timed, as it starts the mixer
+        std::chrono::high_resolution_clock::time_point lastRenderTime;
+        bool isFirstBlock = true;
+        studio.mixer()->setDidRenderNullOutputFn(
+            [&](Mixer* sender, const GraphSampleType* samples, UInt32 nbFrames) {
+                auto now = std::chrono::high_resolution_clock::now();
+                if (!isFirstBlock) {
+                    size_t index = nbBlocks.load();
+                    if (index < blockUs.size()) {
+                        blockUs[index] = std::chrono::duration<double, std::micro>(now - lastRenderTime).count();
+                        nbBlocks.store(index + 1);
+                    }
+                }
+                isFirstBlock = false;
+                lastRenderTime = now;
+            });
+        studio.setIsAudioClockEnabled(true);
+
+        Sequencer sequencer(nullptr, &studio);
+        sequencer.setSequence(sequence);
+        sequencer.play();
+
+        // The instruments loaded in background start the playback from the main thread
+        while (sequencer.isPlaying() && nbBlocks.load() < blockUs.size()) {
+            Platform::sharedInstance()->process();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        isPlayed = !sequencer.isPlaying();
+
+        // The released notes are rendered until the end of their envelope
+        size_t nbPlaybackBlocks = nbBlocks.load();
+        while (nbBlocks.load() < std::min(nbPlaybackBlocks + nbTailBlocks, blockUs.size()))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        sequencer.stop();
+        studio.stopMixer();
+        Platform::sharedInstance()->process();
+    }
+
+    remove("./GM.sf2");
+
+    if (!isPlayed) {
+        std::cerr << "The playback of " << BENCH_SEQUENCE_NAME << " did not end\n";
+        return false;
+    }
+
+    blockUs.resize(nbBlocks.load());
+
+    BenchmarkResult result;
+    result.name = "SequencePlayback";
+    result.configuration = std::string(BENCH_SEQUENCE_NAME) + ", " + std::to_string(nbEvents) + " events, " +
+                           std::to_string(BENCH_FRAMES_PER_BUFFER) + " frames";
+    setBlockTimes(blockUs, &result);
+    result.maxInstances = -1;
+
+    printBenchmarkResult(result);
+
+    return true;
+}
@@ -0,0 +1,14 @@
+//
+//  bench_sequence.h
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef BENCH_SEQUENCE_H
+#define BENCH_SEQUENCE_H
+
+bool benchSequencePlayback();
+
+#endif  // BENCH_SEQUENCE_H
@@ -0,0 +1,99 @@
+//
+//  benchmark.cpp
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "benchmark.h"
+
+#include <unit.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+double blockDeadlineUs() { return 1000000.0 * BENCH_FRAMES_PER_BUFFER / UNIT_DEFAULT_SAMPLE_RATE; }
+
+// ---------------------------------------------------------------------------------------------------------------------
+void measureBlocks(const std::function<void()>& renderBlockFn, UInt32 nbBlocks, BenchmarkResult* result) {
+    std::vector<double> blockUs(nbBlocks);
+
+    for (auto& us : blockUs) {
+        auto start = std::chrono::high_resolution_clock::now();
+        renderBlockFn();
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::high_resolution_clock::now() - start;
+        us = elapsed.count();
+    }
+
+    setBlockTimes(blockUs, result);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void setBlockTimes(const std::vector<double>& blockUs, BenchmarkResult* result) {
+    double totalUs = 0.0, maxUs = 0.0;
+    for (auto us : blockUs) {
+        totalUs += us;
+        maxUs = std::max(maxUs, us);
+    }
+
+    result->usPerBlock = blockUs.empty() ? 0.0 : totalUs / blockUs.size();
+    result->maxUsPerBlock = maxUs;
+    result->load = result->usPerBlock / blockDeadlineUs();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The number of instances is doubled until a block misses the deadline, then the last count in time is refined by
+// bisection, assuming the render time grows with the number of instances
+int measureMaxInstances(const createRenderBlockFnType& createRenderBlockFn, int maxNbInstances) {
+    auto isInTime = [&](int nbInstances) {
+        BenchmarkResult result;
+        measureBlocks(createRenderBlockFn(nbInstances), BENCH_NB_PROBE_BLOCKS, &result);
+        return result.maxUsPerBlock <= blockDeadlineUs();
+    };
+
+    int inTime = 0, late = maxNbInstances + 1;
+    for (int nbInstances = 1; nbInstances <= maxNbInstances; nbInstances *= 2) {
+        if (!isInTime(nbInstances)) {
+            late = nbInstances;
+            break;
+        }
+        inTime = nbInstances;
+    }
+
+    // The maximum is probed when every power of two below it was in time
+    if (late > maxNbInstances && inTime < maxNbInstances) {
+        if (!isInTime(maxNbInstances)) {
+            late = maxNbInstances;
+        } else {
+            inTime = maxNbInstances;
+        }
+    }
+
+    while (late - inTime > 1) {
+        int nbInstances = (inTime + late) / 2;
+        if (isInTime(nbInstances)) {
+            inTime = nbInstances;
+        } else {
+            late = nbInstances;
+        }
+    }
+
+    return inTime;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void printBenchmarkHeader() {
+    std::cout << "benchmark\tconfiguration\tus_per_block\tmax_us_per_block\tload\tmax_instances\n";
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void printBenchmarkResult(const BenchmarkResult& result) {
+    std::cout << result.name << "\t" << result.configuration << "\t" << result.usPerBlock << "\t"
+              << result.maxUsPerBlock << "\t" << result.load << "\t" << result.maxInstances << "\n";
+}
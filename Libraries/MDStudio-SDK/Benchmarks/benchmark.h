@@ -0,0 +1,52 @@
+//
+//  benchmark.h
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <types.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define BENCH_FRAMES_PER_BUFFER 256
+#define BENCH_NB_BLOCKS 2000
+#define BENCH_NB_PROBE_BLOCKS 50  // Blocks rendered for each number of instances probed
+#define BENCH_SAMPLE_LENGTH 44100
+
+// Result of a benchmark, printed as one tab-separated line
+struct BenchmarkResult {
+    std::string name;
+    std::string configuration;
+    double usPerBlock;     // Average time to render a block, in microseconds
+    double maxUsPerBlock;  // Time of the slowest block, in microseconds
+    double load;           // Fraction of the real-time budget of a block used on average
+    int maxInstances;      // Voices or instances whose blocks all render within the deadline (-1 if not applicable)
+};
+
+// Returns the render function of a block for the given number of instances
+typedef std::function<std::function<void()>(int nbInstances)> createRenderBlockFnType;
+
+// Real-time budget of a block, in microseconds
+double blockDeadlineUs();
+
+// Times each call of the render function and fills the timing fields of the result
+void measureBlocks(const std::function<void()>& renderBlockFn, UInt32 nbBlocks, BenchmarkResult* result);
+
+// Fills the timing fields of the result from the render times of the blocks, in microseconds
+void setBlockTimes(const std::vector<double>& blockUs, BenchmarkResult* result);
+
+// Largest number of instances, up to the given maximum, whose blocks all render within the deadline (0 if none)
+int measureMaxInstances(const createRenderBlockFnType& createRenderBlockFn, int maxNbInstances);
+
+void printBenchmarkHeader();
+void printBenchmarkResult(const BenchmarkResult& result);
+
+#endif  // BENCHMARK_H
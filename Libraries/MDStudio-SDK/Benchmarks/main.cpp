@@ -0,0 +1,44 @@
+//
+//  main.cpp
+//  MDStudioBenchmark
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "bench_effects.h"
+#include "bench_samplerunit.h"
+#include "bench_sequence.h"
+#include "benchmark.h"
+
+int main(int argc, const char* argv[]) {
+    std::map<std::string, std::function<bool()>> benchmarks = {{"SamplerPolyphony", benchSamplerPolyphony},
+                                                               {"Effects", benchEffects},
+                                                               {"Filters", benchFilters},
+                                                               {"SequencePlayback", benchSequencePlayback}};
+
+    bool isAll = argc >= 2 && std::string(argv[1]) == "All";
+    if (argc < 2 || (!isAll && benchmarks.find(argv[1]) == benchmarks.end())) {
+        std::cout << "Usage: " << argv[0] << " <benchmark name>\n";
+        std::cout << "Benchmarks:\n";
+        std::cout << "  All\n";
+        for (auto& benchmark : benchmarks) std::cout << "  " << benchmark.first << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // The results are written to the standard output as tab-separated values, one line per configuration
+    printBenchmarkHeader();
+
+    if (!isAll) return benchmarks[argv[1]]() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    bool isSuccess = true;
+    for (auto& benchmark : benchmarks)
+        if (!benchmark.second()) isSuccess = false;
+
+    return isSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -13,9 +13,9 @@
 #include <stdio.h>
 #include <string.h>
 
-#define GRAPH_SAMPLE_RATE 44100
+#define DEFAULT_SAMPLE_RATE 44100.0f
 #define ROUND(n) ((int)((float)(n) + 0.5))
-#define BSZ 8192  // must be about 1/5 of a second at given sample rate
+#define BUFFER_DURATION 0.2f  // in seconds
 #define MODF(n, i, f) ((i) = (int)(n), (f) = (n) - (float)(i))
 
 using namespace MDStudio;
@@ -24,6 +24,10 @@ using namespace MDStudio;
 
 // ---------------------------------------------------------------------------------------------------------------------
 ChorusModel::ChorusModel() {
+    _sampleRate = DEFAULT_SAMPLE_RATE;
+    _buf = nullptr;
+    _bufSize = 0;
+
     _paramWidth = 0.8f;
     _paramDelay = 0.2f;
     _paramMixMode = 0;
@@ -42,8 +46,7 @@ ChorusModel::ChorusModel() {
     _wet = 0.0f;
 
     // allocate the buffer
-    _buf = new GraphSampleType[BSZ];
-    memset(_buf, 0, sizeof(GraphSampleType) * BSZ);
+    setSampleRate(_sampleRate);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -51,10 +54,33 @@ ChorusModel::~ChorusModel() {
     if (_buf) delete[] _buf;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+void ChorusModel::setSampleRate(float sampleRate) {
+    // Keep the same delay in seconds
+    _delaySamples = ROUND(_delaySamples * sampleRate / _sampleRate);
+    _sampleRate = sampleRate;
+
+    // The buffer size must be a power of two
+    int bufSize = 1;
+    while (bufSize < BUFFER_DURATION * sampleRate) bufSize <<= 1;
+
+    if (bufSize != _bufSize) {
+        if (_buf) delete[] _buf;
+        _bufSize = bufSize;
+        _buf = new GraphSampleType[_bufSize];
+    }
+    memset(_buf, 0, sizeof(GraphSampleType) * _bufSize);
+    _fp = 0;
+
+    // Update the parameters expressed in samples
+    setRate(_paramSweepRate);
+    setWidth(_paramWidth);
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 void ChorusModel::setRate(float rate) {
     _paramSweepRate = rate;
-    _lfoDeltaPhase = 2 * M_PI * rate / GRAPH_SAMPLE_RATE;
+    _lfoDeltaPhase = 2 * M_PI * rate / _sampleRate;
 
     // map into param onto desired sweep range with log curve
     _sweepRate = pow(10.0, (double)_paramSweepRate);
@@ -72,7 +98,7 @@ void ChorusModel::setWidth(float v) {
     _paramWidth = v;
 
     // map so that we can spec between 0ms and 50ms
-    _sweepSamples = ROUND(v * 0.05 * GRAPH_SAMPLE_RATE);
+    _sweepSamples = ROUND(v * 0.05 * _sampleRate);
 
     // finish setup
     setSweep();
@@ -85,7 +111,7 @@ void ChorusModel::setDelay(float v) {
 
     // make onto desired values applying log curve
     double delay = pow(10.0, (double)v * 2.0) / 1000.0;  // map logarithmically and convert to seconds
-    _delaySamples = ROUND(delay * GRAPH_SAMPLE_RATE);
+    _delaySamples = ROUND(delay * _sampleRate);
 
     // finish setup
     setSweep();
@@ -150,16 +176,16 @@ int ChorusModel::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2],
         // assemble mono input value and store it in circle queue
         float inval = (*io1 + *io2) / 2.0f;
         _buf[_fp] = inval;
-        _fp = (_fp + 1) & (BSZ - 1);
+        _fp = (_fp + 1) & (_bufSize - 1);
 
         // build the two emptying pointers and do linear interpolation
         int ep1, ep2;
         float w1, w2;
         float ep = _fp - _sweep;
         MODF(ep, ep1, w2);
-        ep1 &= (BSZ - 1);
+        ep1 &= (_bufSize - 1);
         ep2 = ep1 + 1;
-        ep2 &= (BSZ - 1);
+        ep2 &= (_bufSize - 1);
         w1 = 1.0 - w2;
         GraphSampleType outval = _buf[ep1] * w1 + _buf[ep2] * w2;
 
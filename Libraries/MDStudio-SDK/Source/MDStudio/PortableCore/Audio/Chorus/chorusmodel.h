@@ -27,9 +27,11 @@ class ChorusModel {
     float _maxSweepSamples;  // upper bound, ditto
     int _mixMode;            // mapped to supported mix modes
     GraphSampleType* _buf;   // stored sound
+    int _bufSize;            // power of two holding about 1/5 of a second
     int _fp;                 // fill/write pointer
     float _sweep;
 
+    float _sampleRate;
     float _lfoPhase;
     float _lfoDeltaPhase;
 
@@ -46,6 +48,8 @@ class ChorusModel {
     ChorusModel();
     ~ChorusModel();
 
+    void setSampleRate(float sampleRate);
+
     int renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride = 1);
 
     void setRate(float v);
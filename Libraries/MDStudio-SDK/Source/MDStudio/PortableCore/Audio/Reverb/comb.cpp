@@ -22,6 +22,7 @@ Comb::Comb() {
 void Comb::setBuffer(GraphSampleType* buf, int size) {
     _buffer = buf;
     _bufSize = size;
+    _bufIdx = 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
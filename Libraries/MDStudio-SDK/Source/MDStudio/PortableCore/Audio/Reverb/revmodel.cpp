@@ -14,15 +14,7 @@ using namespace MDStudio;
 
 // ---------------------------------------------------------------------------------------------------------------------
 RevModel::RevModel() {
-    // Tie the components to their buffers
-    _combs[0].setBuffer(_bufComb1, combTuning1);
-    _combs[1].setBuffer(_bufComb2, combTuning2);
-    _combs[2].setBuffer(_bufComb3, combTuning3);
-    _combs[3].setBuffer(_bufComb4, combTuning4);
-    _combs[4].setBuffer(_bufComb5, combTuning5);
-    _combs[5].setBuffer(_bufComb6, combTuning6);
-    _combs[6].setBuffer(_bufComb7, combTuning7);
-    _combs[7].setBuffer(_bufComb8, combTuning8);
+    setSampleRate(tuningSampleRate);
 
     // Set default values
     setWet(initialWet);
@@ -36,6 +28,29 @@ RevModel::RevModel() {
     mute();
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+void RevModel::setSampleRate(float sampleRate) {
+    const int combTunings[numCombs] = {combTuning1, combTuning2, combTuning3, combTuning4,
+                                       combTuning5, combTuning6, combTuning7, combTuning8};
+
+    // Scale the comb lengths so that the delays stay the same in seconds
+    int sizes[numCombs];
+    int totalSize = 0;
+    for (int i = 0; i < numCombs; ++i) {
+        sizes[i] = (int)(combTunings[i] * sampleRate / tuningSampleRate + 0.5f);
+        totalSize += sizes[i];
+    }
+
+    _bufCombs.assign(totalSize, 0);
+
+    // Tie the components to their buffers
+    GraphSampleType* buf = _bufCombs.data();
+    for (int i = 0; i < numCombs; ++i) {
+        _combs[i].setBuffer(buf, sizes[i]);
+        buf += sizes[i];
+    }
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 void RevModel::mute() {
     if (mode() >= freezeMode) return;
@@ -11,6 +11,8 @@
 #ifndef REVMODEL_H
 #define REVMODEL_H
 
+#include <vector>
+
 #include "comb.h"
 #include "tuning.h"
 
@@ -25,25 +27,15 @@ class RevModel {
     float _width;
     float _mode;
 
-    // The following are all declared inline
-    // to remove the need for dynamic allocation
-    // with its subsequent error-checking messiness
-
     // Comb filters
     Comb _combs[numCombs];
 
-    // Buffers for the combs
-    GraphSampleType _bufComb1[combTuning1];
-    GraphSampleType _bufComb2[combTuning2];
-    GraphSampleType _bufComb3[combTuning3];
-    GraphSampleType _bufComb4[combTuning4];
-    GraphSampleType _bufComb5[combTuning5];
-    GraphSampleType _bufComb6[combTuning6];
-    GraphSampleType _bufComb7[combTuning7];
-    GraphSampleType _bufComb8[combTuning8];
+    // Buffers for the combs, sized for the sample rate
+    std::vector<GraphSampleType> _bufCombs;
 
    public:
     RevModel();
+    void setSampleRate(float sampleRate);
     void mute();
     void processMix(GraphSampleType* inputL, GraphSampleType* inputR, GraphSampleType* outputL,
                     GraphSampleType* outputR, unsigned long numSamples, unsigned long stride);
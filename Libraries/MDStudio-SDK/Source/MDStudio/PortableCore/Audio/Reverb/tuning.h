@@ -38,6 +38,8 @@ const float freezeMode = 1.0f;
 // they will probably be OK for 48KHz sample rate
 // but would need scaling for 96KHz (or other) sample rates.
 // The values were obtained by listening tests.
+// They are scaled by RevModel::setSampleRate() for other sample rates.
+const float tuningSampleRate = 44100.0f;
 const int combTuning1 = 1116;
 const int combTuning2 = 1188;
 const int combTuning3 = 1277;
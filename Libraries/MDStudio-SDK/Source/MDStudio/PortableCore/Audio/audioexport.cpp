@@ -8,6 +8,9 @@
 
 #include "audioexport.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "platform.h"
 
 extern "C" {
@@ -32,49 +35,52 @@ AudioExport::~AudioExport() {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-// Audio export thread
-void AudioExport::exportAudioThread() {
+// Renders the sequence into the file, block by block and as fast as possible. The metronome is advanced to the end of
+// each block before it is rendered so that the events of the block are scheduled at their exact sample time.
+bool AudioExport::renderSequence(std::function<void(float progress)> progressFn) {
     AIFF_Ref exportAudioAIFFRef = static_cast<AIFF_Ref>(_exportAudioAIFFRef);
 
+    Studio* studio = _sequencer->studio();
     Metronome::timePointType startTime = std::chrono::high_resolution_clock::now();
-    Metronome::timePointType currentTime = startTime;
-    Metronome::doublePrecisionDurationType period = Metronome::doublePrecisionDurationType(1.0 / 44100.0);
+    Float64 sampleRate = studio->mixer()->sampleRate();
+
+    if (AIFF_SetAudioFormat(exportAudioAIFFRef, 2, sampleRate, 16) < 1) return false;
+    if (AIFF_StartWritingSamples(exportAudioAIFFRef) < 1) return false;
 
-    AIFF_SetAudioFormat(exportAudioAIFFRef, 2, 44100.0, 16);
-    AIFF_StartWritingSamples(exportAudioAIFFRef);
+    std::vector<GraphSampleType> outputBuffer(AUDIO_EXPORT_BLOCK_FRAMES * 2);
+    std::vector<int32_t> samples(AUDIO_EXPORT_BLOCK_FRAMES * 2);
 
-    bool isDone = false;
+    UInt64 nbRenderedFrames = 0;
     bool isMetronomeDone = false;
-    int nbFramesAtEnd = 44100;
+    UInt32 nbFramesAtEnd = static_cast<UInt32>(sampleRate);  // One second of tail
 
+    bool isWritten = true;
     float lastProgress = 0.0f;
-    while (!isDone && !_isAborted) {
+    while (isWritten && !_isAborted) {
+        UInt32 nbFrames = AUDIO_EXPORT_BLOCK_FRAMES;
+
         if (!isMetronomeDone) {
-            if (!_sequencer->studio()->metronome()->performTick(startTime, currentTime)) isMetronomeDone = true;
+            Metronome::timePointType blockEndTime =
+                startTime + Metronome::doublePrecisionDurationType((nbRenderedFrames + nbFrames) / sampleRate);
+            if (!studio->metronome()->performTick(startTime, blockEndTime)) isMetronomeDone = true;
+        } else {
+            if (nbFramesAtEnd == 0) break;
+            nbFrames = std::min(nbFrames, nbFramesAtEnd);
+            nbFramesAtEnd -= nbFrames;
         }
 
-        GraphSampleType outA, outB;
-        GraphSampleType* ioData[2];
-        ioData[0] = &outA;
-        ioData[1] = &outB;
-        // Render a single frame
-        _sequencer->studio()->mixer()->renderInput(1, ioData, 1);
-        int32_t samples[2] = {(int32_t)(outA * 2147483647.0f), (int32_t)(outB * 2147483647.0f)};
-
-        AIFF_WriteSamples32Bit(exportAudioAIFFRef, samples, 2);
-        currentTime += period;
-
-        if (isMetronomeDone) {
-            if (nbFramesAtEnd == 0) {
-                isDone = true;
-            } else {
-                nbFramesAtEnd--;
-            }
-        } else {
-            float progress =
-                static_cast<float>(_sequencer->studio()->metronome()->tick()) / static_cast<float>(_totalNbTicks);
+        GraphSampleType* ioData[2] = {&outputBuffer[0], &outputBuffer[1]};
+        studio->mixer()->renderInput(nbFrames, ioData, 2);
+
+        for (UInt32 i = 0; i < nbFrames * 2; ++i) samples[i] = (int32_t)(outputBuffer[i] * 2147483647.0f);
+        isWritten = AIFF_WriteSamples32Bit(exportAudioAIFFRef, samples.data(), nbFrames * 2) > 0;
+
+        nbRenderedFrames += nbFrames;
+
+        if (!isMetronomeDone && progressFn) {
+            float progress = static_cast<float>(studio->metronome()->tick()) / static_cast<float>(_totalNbTicks);
             if (progress - lastProgress > 0.01f) {
-                Platform::sharedInstance()->invoke([=] { setProgress(progress); });
+                progressFn(progress);
                 lastProgress = progress;
             }
         }
@@ -82,49 +88,89 @@ void AudioExport::exportAudioThread() {
 
     AIFF_EndWritingSamples(exportAudioAIFFRef);
 
-    Platform::sharedInstance()->invoke([=] { exportAudioCompleted(); });
+    return isWritten && !_isAborted;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-bool AudioExport::exportAudio(const std::string& path) {
-    if (_audioExportDidStartFn) _audioExportDidStartFn(this);
+// Audio export thread
+void AudioExport::exportAudioThread() {
+    renderSequence([=](float progress) { Platform::sharedInstance()->invoke([=] { setProgress(progress); }); });
 
+    Platform::sharedInstance()->invoke([=] { exportAudioCompleted(); });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool AudioExport::beginExport(const std::string& path) {
     // Calculate the total nb of ticks
 
     _totalNbTicks = 0;
     for (auto& track : _sequencer->sequence()->data.tracks) {
         UInt32 totalNbTicksInTrack = 0;
-        for (auto event : track.events) totalNbTicksInTrack += event.tickCount;
+        for (auto& event : track.events) totalNbTicksInTrack += event.tickCount;
         if (totalNbTicksInTrack > _totalNbTicks) _totalNbTicks = totalNbTicksInTrack;
     }
 
+    _exportAudioAIFFRef = AIFF_OpenFile(path.c_str(), F_WRONLY);
+    if (_exportAudioAIFFRef == nullptr) return false;
+
     _sequencer->stop();
     _sequencer->studio()->metronome()->moveToTick(0);
 
     _previousMasterMixerLevel = _sequencer->studio()->masterMixerLevel();
     _sequencer->studio()->setMasterMixerLevel(STUDIO_SOURCE_USER, 0.5f);
 
-    _exportAudioAIFFRef = AIFF_OpenFile(path.c_str(), F_WRONLY);
-    if (_exportAudioAIFFRef == nullptr) return false;
+    // The units are rendered by the export only
+    _wasMixerRunning = _sequencer->studio()->mixer()->isRunning();
+    _sequencer->studio()->stopMixer();
+    _sequencer->studio()->startOfflineRendering();
 
     // Start the sequencer for audio export
     _sequencer->playAudioExport();
 
-    // Create a new audio export thread
     _isAborted = false;
-    _exportAudioThread = std::thread(&AudioExport::exportAudioThread, this);
 
     return true;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void AudioExport::exportAudioCompleted() {
-    _exportAudioThread.join();
-
+void AudioExport::endExport() {
     AIFF_Ref exportAudioAIFFRef = static_cast<AIFF_Ref>(_exportAudioAIFFRef);
     AIFF_CloseFile(exportAudioAIFFRef);
 
+    _sequencer->studio()->stopOfflineRendering();
+    if (_wasMixerRunning) _sequencer->studio()->startMixer();
+
     _sequencer->studio()->setMasterMixerLevel(STUDIO_SOURCE_USER, _previousMasterMixerLevel);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool AudioExport::exportAudio(const std::string& path) {
+    if (_audioExportDidStartFn) _audioExportDidStartFn(this);
+
+    if (!beginExport(path)) return false;
+
+    // Create a new audio export thread
+    _exportAudioThread = std::thread(&AudioExport::exportAudioThread, this);
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool AudioExport::renderAudio(const std::string& path) {
+    if (!beginExport(path)) return false;
+
+    bool isRendered = renderSequence(nullptr);
+
+    endExport();
+
+    return isRendered;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void AudioExport::exportAudioCompleted() {
+    _exportAudioThread.join();
+
+    endExport();
 
     if (_audioExportDidFinishFn) _audioExportDidFinishFn(this);
 }
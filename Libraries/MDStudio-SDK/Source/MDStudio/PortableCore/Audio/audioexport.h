@@ -9,10 +9,14 @@
 #ifndef AUDIOEXPORT_H
 #define AUDIOEXPORT_H
 
+#include <atomic>
+#include <functional>
 #include <thread>
 
 #include "sequencer.h"
 
+#define AUDIO_EXPORT_BLOCK_FRAMES 512
+
 namespace MDStudio {
 
 class AudioExport {
@@ -27,6 +31,10 @@ class AudioExport {
     std::thread _exportAudioThread;
     void* _exportAudioAIFFRef;
 
+    bool beginExport(const std::string& path);
+    bool renderSequence(std::function<void(float progress)> progressFn);
+    void endExport();
+
     void exportAudioThread();
     void exportAudioCompleted();
 
@@ -36,6 +44,7 @@ class AudioExport {
 
     UInt32 _totalNbTicks;
     Float32 _previousMasterMixerLevel;
+    bool _wasMixerRunning;
 
     std::atomic<bool> _isAborted;
 
@@ -45,8 +54,13 @@ class AudioExport {
     AudioExport(Sequencer* sequencer);
     ~AudioExport();
 
+    // Exports the sequence in the background and reports the progress on the main thread
     bool exportAudio(const std::string& path);
 
+    // Renders the sequence synchronously on the calling thread (for headless tools). The live audio output is
+    // suspended during the rendering.
+    bool renderAudio(const std::string& path);
+
     void setAudioExportDidStartFn(audioExportDidStartFnType audioExportDidStart) {
         _audioExportDidStartFn = audioExportDidStart;
     }
@@ -15,12 +15,13 @@ extern "C" {
 using namespace MDStudio;
 
 // ---------------------------------------------------------------------------------------------------------------------
-AudioPlayerUnit::AudioPlayerUnit() { _samples = nullptr; }
+AudioPlayerUnit::AudioPlayerUnit() : _samplesQueue(4) {
+    _samplePos = 0;
+    _level = 1.0f;
+}
 
 // ---------------------------------------------------------------------------------------------------------------------
-AudioPlayerUnit::~AudioPlayerUnit() {
-    if (_samples) delete[] _samples;
-}
+AudioPlayerUnit::~AudioPlayerUnit() {}
 
 // ---------------------------------------------------------------------------------------------------------------------
 bool AudioPlayerUnit::playAudioFile(const std::string& path) {
@@ -46,48 +47,51 @@ bool AudioPlayerUnit::playAudioFile(const std::string& path) {
         return false;
     }
 
-    _nbSamples = static_cast<size_t>(nbSamples);
-
-    std::lock_guard<std::mutex> lock(_renderMutex);
-
-    if (_samples) {
-        delete[] _samples;
-        _samples = nullptr;
-    }
-
-    _samples = new Float32[_nbSamples];
+    // The file is decoded outside of the audio thread
+    auto samples = std::make_shared<std::vector<Float32>>(static_cast<size_t>(nbSamples));
 
-    if (AIFF_ReadSamplesFloat(aiffRef, _samples, static_cast<int>(_nbSamples)) < 0) {
-        delete[] _samples;
-        _samples = nullptr;
+    if (AIFF_ReadSamplesFloat(aiffRef, samples->data(), static_cast<int>(samples->size())) < 0) {
         AIFF_CloseFile(aiffRef);
         return false;
     }
 
     AIFF_CloseFile(aiffRef);
 
-    _samplePos = 0;
+    // Hand the samples over to the audio thread
+    std::lock_guard<std::mutex> lock(_samplesQueueMutex);
+    _samplesQueue.enqueue(samples);
 
     return true;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 int AudioPlayerUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride) {
-    std::lock_guard<std::mutex> lock(_renderMutex);
+    _graveyard.retry();
+
+    // Switch to the most recent file; the previous samples are released by the graveyard
+    std::shared_ptr<std::vector<Float32>> samples;
+    while (_samplesQueue.try_dequeue(samples)) {
+        _graveyard.bury(_samples);
+        _samples = std::move(samples);
+        _samplePos = 0;
+    }
+
+    if (!_samples) return 0;
 
     GraphSampleType* outA = (GraphSampleType*)ioData[0];
     GraphSampleType* outB = (GraphSampleType*)ioData[1];
 
-    for (UInt32 i = 0; i < inNumberFrames; ++i) {
-        if (_samples && (_samplePos < _nbSamples)) {
-            GraphSampleType s;
+    const Float32* data = _samples->data();
+    size_t nbSamples = _samples->size();
+    Float32 level = _level;
+
+    for (UInt32 i = 0; i < inNumberFrames && _samplePos < nbSamples; ++i) {
+        GraphSampleType s = data[_samplePos] * level;
 
-            s = _samples[_samplePos] * _level;
+        *outA += s;
+        *outB += s;
+        ++_samplePos;
 
-            *outA += s;
-            *outB += s;
-            ++_samplePos;
-        }
         outA += stride;
         outB += stride;
     }
@@ -96,10 +100,7 @@ int AudioPlayerUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void AudioPlayerUnit::setLevel(Float32 level) {
-    std::lock_guard<std::mutex> lock(_renderMutex);
-    _level = level;
-}
+void AudioPlayerUnit::setLevel(Float32 level) { _level = level; }
 
 // ---------------------------------------------------------------------------------------------------------------------
 Float32 AudioPlayerUnit::level() { return _level; }
@@ -9,25 +9,37 @@
 #ifndef AUDIOPLAYERUNIT_H
 #define AUDIOPLAYERUNIT_H
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
+#include "graveyard.h"
+#include "readerwriterqueue.h"
 #include "unit.h"
 
 namespace MDStudio {
 
 class AudioPlayerUnit : public Unit {
-    Float32* _samples;
-    size_t _nbSamples;
+    // Decoded files sent to the audio thread, the producers being serialized by the mutex
+    moodycamel::ReaderWriterQueue<std::shared_ptr<std::vector<Float32>>> _samplesQueue;
+    std::mutex _samplesQueueMutex;
+
+    // Owned by the audio thread
+    std::shared_ptr<std::vector<Float32>> _samples;
     size_t _samplePos;
-    std::mutex _renderMutex;
 
-    Float32 _level;
+    // Replaced samples released by the audio thread
+    Graveyard _graveyard;
+
+    std::atomic<Float32> _level;
 
    public:
     AudioPlayerUnit();
     ~AudioPlayerUnit();
 
+    // Can be called from any thread, except the audio thread
     bool playAudioFile(const std::string& path);
 
     void setLevel(Float32 level);
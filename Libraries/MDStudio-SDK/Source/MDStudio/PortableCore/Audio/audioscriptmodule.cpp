@@ -26,6 +26,73 @@
 
 using namespace MDStudio;
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Pushes a table with the given render statistics, the times being in seconds
+static void pushRenderStats(lua_State* L, const RenderStatsSnapshot& stats) {
+    lua_newtable(L);
+
+    lua_pushinteger(L, stats.nbRenders);
+    lua_setfield(L, -2, "nbRenders");
+
+    lua_pushinteger(L, stats.nbOverruns);
+    lua_setfield(L, -2, "nbOverruns");
+
+    lua_pushnumber(L, stats.averageRenderTime() / 1e9);
+    lua_setfield(L, -2, "averageRenderTime");
+
+    lua_pushnumber(L, stats.maxRenderTime / 1e9);
+    lua_setfield(L, -2, "maxRenderTime");
+
+    lua_pushnumber(L, stats.load);
+    lua_setfield(L, -2, "load");
+
+    lua_pushnumber(L, stats.peakLoad);
+    lua_setfield(L, -2, "peakLoad");
+
+    // Number of renders per power of two of microseconds
+    lua_newtable(L);
+    for (int bin = 0; bin < RENDER_STATS_NB_BINS; ++bin) {
+        lua_pushinteger(L, stats.histogram[bin]);
+        lua_rawseti(L, -2, bin + 1);
+    }
+    lua_setfield(L, -2, "histogram");
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Pushes the render statistics of the mixer, with the xruns and the statistics of each unit
+static void pushMixerStats(lua_State* L, Mixer* mixer) {
+    pushRenderStats(L, mixer->renderStats().snapshot());
+
+    lua_pushinteger(L, mixer->nbXRuns());
+    lua_setfield(L, -2, "nbXRuns");
+
+    lua_newtable(L);
+    lua_Integer i = 1;
+    for (auto it = mixer->unitsBegin(); it != mixer->unitsEnd(); ++it) {
+        pushRenderStats(L, (*it)->renderStats().snapshot());
+        lua_rawseti(L, -2, i++);
+    }
+    lua_setfield(L, -2, "units");
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Pushes the render statistics of the sampler along with its voice and command counters
+static void pushSamplerStats(lua_State* L, SamplerUnit* samplerUnit) {
+    pushRenderStats(L, samplerUnit->renderStats().snapshot());
+
+    lua_pushinteger(L, samplerUnit->nbPlayingVoices());
+    lua_setfield(L, -2, "nbPlayingVoices");
+
+    lua_pushinteger(L, samplerUnit->nbStolenVoices());
+    lua_setfield(L, -2, "nbStolenVoices");
+
+    lua_pushinteger(L, samplerUnit->nbPendingCmds());
+    lua_setfield(L, -2, "nbPendingCommands");
+
+    lua_pushinteger(L, samplerUnit->nbStreamUnderruns());
+    lua_setfield(L, -2, "nbStreamUnderruns");
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 void AudioScriptModule::init(Script* script) {
     // Mixer
@@ -62,6 +129,18 @@ void AudioScriptModule::init(Script* script) {
                                                               mixer->start();
                                                               return 0;
                                                           }},
+                                                         {"stats",
+                                                          [](lua_State* L) -> int {
+                                                              auto mixer = getElement<Mixer>(L);
+                                                              pushMixerStats(L, mixer.get());
+                                                              return 1;
+                                                          }},
+                                                         {"resetStats",
+                                                          [](lua_State* L) -> int {
+                                                              auto mixer = getElement<Mixer>(L);
+                                                              mixer->resetStats();
+                                                              return 0;
+                                                          }},
                                                          {"addUnit", [](lua_State* L) -> int {
                                                               auto mixer = getElement<Mixer>(L);
                                                               auto unit = getElement<Unit>(L, 2);
@@ -273,6 +352,12 @@ void AudioScriptModule::init(Script* script) {
              samplerUnit->setChorus(chorus, static_cast<UInt32>(channel));
              return 0;
          }},
+        {"stats",
+         [](lua_State* L) -> int {
+             auto samplerUnit = getElement<SamplerUnit>(L);
+             pushSamplerStats(L, samplerUnit.get());
+             return 1;
+         }},
         {"setExpression", [](lua_State* L) -> int {
              auto samplerUnit = getElement<SamplerUnit>(L);
              auto expression = luaL_checknumber(L, 2);
@@ -432,6 +517,20 @@ void AudioScriptModule::init(Script* script) {
              lua_pushboolean(L, e1 == e2);
              return 1;
          }},
+        {"stats",
+         [](lua_State* L) -> int {
+             auto studio = getElement<Studio>(L);
+             pushMixerStats(L, studio->mixer());
+             pushSamplerStats(L, studio->sampler());
+             lua_setfield(L, -2, "sampler");
+             return 1;
+         }},
+        {"resetStats",
+         [](lua_State* L) -> int {
+             auto studio = getElement<Studio>(L);
+             studio->resetStats();
+             return 0;
+         }},
         {"startMixer", [](lua_State* L) -> int {
              auto studio = getElement<Studio>(L);
              studio->startMixer();
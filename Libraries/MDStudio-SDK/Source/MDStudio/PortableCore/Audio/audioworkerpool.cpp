@@ -0,0 +1,120 @@
+//
+//  audioworkerpool.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "audioworkerpool.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define AUDIO_WORKER_POOL_PAUSE() _mm_pause()
+#else
+#define AUDIO_WORKER_POOL_PAUSE()
+#endif
+
+#define AUDIO_WORKER_POOL_MAX_TASKS 0xFFFF
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Raises the priority of the calling thread to a real-time priority just below the maximum, so that a worker is not
+// preempted while the audio thread waits for its task. Without the required privileges, the thread keeps its priority.
+static void setRealTimePriority() {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+AudioWorkerPool::AudioWorkerPool(UInt32 nbWorkers) {
+    _isStopped = false;
+    _taskFn = nullptr;
+    _context = nullptr;
+    _generation = 0;
+    _jobState = 0;
+    _nbCompletedTasks = 0;
+
+    for (UInt32 i = 0; i < nbWorkers; ++i) {
+        auto worker = std::unique_ptr<Worker>(new Worker);
+        worker->thread = std::thread(&AudioWorkerPool::workerThread, this, worker.get());
+        _workers.push_back(std::move(worker));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+AudioWorkerPool::~AudioWorkerPool() {
+    _isStopped = true;
+    for (auto& worker : _workers) worker->semaphore.signal();
+    for (auto& worker : _workers) worker->thread.join();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void AudioWorkerPool::executeTasks() {
+    UInt64 state = _jobState.load(std::memory_order_acquire);
+    while (true) {
+        UInt32 taskIndex = (UInt32)(state & 0xFFFF);
+        UInt32 nbTasks = (UInt32)((state >> 16) & 0xFFFF);
+        if (taskIndex >= nbTasks) break;
+
+        // The job cannot be replaced before its claimed tasks are completed
+        if (_jobState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            _taskFn(_context, taskIndex);
+            _nbCompletedTasks.fetch_add(1, std::memory_order_release);
+            state = _jobState.load(std::memory_order_acquire);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Worker thread
+void AudioWorkerPool::workerThread(Worker* worker) {
+    setRealTimePriority();
+
+    while (true) {
+        // Spin then park until a job is posted
+        worker->semaphore.wait();
+        if (_isStopped) break;
+
+        // A worker waking up late may find the tasks of the job already claimed
+        executeTasks();
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void AudioWorkerPool::execute(TaskFnType taskFn, void* context, UInt32 nbTasks) {
+    assert(nbTasks <= AUDIO_WORKER_POOL_MAX_TASKS);
+
+    _taskFn = taskFn;
+    _context = context;
+    _nbCompletedTasks.store(0, std::memory_order_relaxed);
+    ++_generation;
+    _jobState.store(((UInt64)_generation << 32) | ((UInt64)nbTasks << 16), std::memory_order_release);
+
+    // Wake up as many workers as needed to help the calling thread
+    UInt32 nbWorkersToWake = std::min(nbWorkers(), nbTasks > 0 ? nbTasks - 1 : 0);
+    for (UInt32 i = 0; i < nbWorkersToWake; ++i) _workers[i]->semaphore.signal();
+
+    // The calling thread takes every task not yet started by a worker
+    executeTasks();
+
+    // Wait for the tasks in progress on the workers
+    while (_nbCompletedTasks.load(std::memory_order_acquire) < nbTasks) AUDIO_WORKER_POOL_PAUSE();
+}
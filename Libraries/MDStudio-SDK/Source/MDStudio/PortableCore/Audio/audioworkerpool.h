@@ -0,0 +1,64 @@
+//
+//  audioworkerpool.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef AUDIOWORKERPOOL_H
+#define AUDIOWORKERPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "atomicops.h"
+#include "types.h"
+
+namespace MDStudio {
+
+// Pre-spawned threads helping the audio thread to execute a set of independent tasks. The workers run at real-time
+// priority when the system allows it. The tasks are claimed on an atomic job state, so a thread that finishes early
+// takes the next pending task and the audio thread renders the tasks not yet started by a worker. Idle workers spin
+// for a short while before parking on their semaphore.
+class AudioWorkerPool {
+   public:
+    typedef void (*TaskFnType)(void* context, UInt32 taskIndex);
+
+   private:
+    struct Worker {
+        std::thread thread;
+        moodycamel::spsc_sema::LightweightSemaphore semaphore;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic<bool> _isStopped;
+
+    // Current job. The state holds the generation of the job in its high 32 bits, the number of tasks in the next 16
+    // bits and the index of the next task to claim in the low 16 bits, so that a late worker cannot claim a task of
+    // a job that is over.
+    TaskFnType _taskFn;
+    void* _context;
+    UInt32 _generation;
+    std::atomic<UInt64> _jobState;
+    std::atomic<UInt32> _nbCompletedTasks;
+
+    void workerThread(Worker* worker);
+    void executeTasks();
+
+   public:
+    AudioWorkerPool(UInt32 nbWorkers);
+    ~AudioWorkerPool();
+
+    UInt32 nbWorkers() { return static_cast<UInt32>(_workers.size()); }
+
+    // Executes the tasks on the calling thread and on the workers. Returns once all the tasks are completed, waiting
+    // only for the tasks already started by the workers. Does not allocate or lock.
+    void execute(TaskFnType taskFn, void* context, UInt32 nbTasks);
+};
+
+}  // namespace MDStudio
+
+#endif  // AUDIOWORKERPOOL_H
@@ -9,15 +9,13 @@
 #include "event.h"
 
 // ---------------------------------------------------------------------------------------------------------------------
-MDStudio::Event MDStudio::makeEvent(UInt8 type, UInt8 channel, UInt32 tickCount, SInt32 param1, SInt32 param2,
-                                    std::vector<UInt8> data) {
+MDStudio::Event MDStudio::makeEvent(UInt8 type, UInt8 channel, UInt32 tickCount, SInt32 param1, SInt32 param2) {
     Event event;
     event.type = type;
     event.channel = channel;
     event.tickCount = tickCount;
     event.param1 = param1;
-    event.param2 = param2;
-    event.data = data;
+    event.param2 = static_cast<SInt16>(param2);
 
     return event;
 }
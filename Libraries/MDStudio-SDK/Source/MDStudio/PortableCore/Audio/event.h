@@ -9,7 +9,7 @@
 #ifndef MDSTUDIO_EVENT_H
 #define MDSTUDIO_EVENT_H
 
-#include <vector>
+#include <type_traits>
 
 #include "../types.h"
 
@@ -34,19 +34,23 @@
 #define EVENT_TYPE_META_END_OF_TRACK 0xF2    // 0xFF, Meta: 0x2F
 #define EVENT_TYPE_META_GENERIC 0xFF         // Generic Meta event not included in cases above
 
+#define EVENT_NO_DATA 0xFFFFFFFF
+
 namespace MDStudio {
 
+// The payload of the system exclusive and generic meta events is stored in the event data of their track
 struct Event {
     UInt8 type;
     UInt8 channel;
+    SInt16 param2;
     UInt32 tickCount;
     SInt32 param1;
-    SInt32 param2;
-    std::vector<UInt8> data;
+    UInt32 dataOffset = EVENT_NO_DATA;  // Offset of the payload in the event data of the track
 };
 
-Event makeEvent(UInt8 type, UInt8 channel, UInt32 tickCount, SInt32 param1, SInt32 param2,
-                std::vector<UInt8> data = {});
+static_assert(sizeof(Event) == 16 && std::is_trivially_copyable<Event>::value, "Events must remain packed");
+
+Event makeEvent(UInt8 type, UInt8 channel, UInt32 tickCount, SInt32 param1, SInt32 param2);
 
 }  // namespace MDStudio
 
@@ -0,0 +1,50 @@
+//
+//  graveyard.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-20.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "graveyard.h"
+
+#include <chrono>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+Graveyard::Graveyard(size_t capacity, size_t overflowCapacity) : _queue(capacity) {
+    _overflow.reserve(overflowCapacity);
+
+    _isCollectThreadStopped = false;
+    _collectThread = std::thread(&Graveyard::collectThread, this);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Graveyard::~Graveyard() {
+    _isCollectThreadStopped = true;
+    _collectThread.join();
+
+    // Drop the references buried after the last collection
+    collect();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Graveyard::collect() {
+    std::shared_ptr<void> object;
+    while (_queue.try_dequeue(object)) object = nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Graveyard::retry() {
+    while (!_overflow.empty() && _queue.try_enqueue(std::move(_overflow.back()))) _overflow.pop_back();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Collect thread
+void Graveyard::collectThread() {
+    while (!_isCollectThreadStopped) {
+        collect();
+        std::this_thread::sleep_for(std::chrono::duration<double>(GRAVEYARD_COLLECT_PERIOD));
+    }
+}
@@ -0,0 +1,67 @@
+//
+//  graveyard.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-20.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef GRAVEYARD_H
+#define GRAVEYARD_H
+
+#include <assert.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "readerwriterqueue.h"
+
+#define GRAVEYARD_CAPACITY 4096
+#define GRAVEYARD_OVERFLOW_CAPACITY 4096  // References kept by the audio thread while the queue is full
+#define GRAVEYARD_COLLECT_PERIOD 0.05  // in seconds
+
+namespace MDStudio {
+
+// Holds the references released by the audio thread until they are dropped by a background thread, so that no
+// destructor or deallocation runs during rendering.
+class Graveyard {
+    moodycamel::ReaderWriterQueue<std::shared_ptr<void>> _queue;
+
+    // References that did not fit in the queue, enqueued again at the next block (audio thread only)
+    std::vector<std::shared_ptr<void>> _overflow;
+
+    std::thread _collectThread;
+    std::atomic<bool> _isCollectThreadStopped;
+
+    void collectThread();
+    void collect();
+
+   public:
+    Graveyard(size_t capacity = GRAVEYARD_CAPACITY, size_t overflowCapacity = GRAVEYARD_OVERFLOW_CAPACITY);
+    ~Graveyard();
+
+    // Moves the reference into the graveyard (called from the audio thread only)
+    template <typename T>
+    void bury(std::shared_ptr<T>& object) {
+        if (!object) return;
+        std::shared_ptr<void> o = std::move(object);
+        if (_queue.try_enqueue(std::move(o))) return;
+
+        // The queue is full until the next collection, so the reference is kept in the preallocated overflow
+        bool isKept = _overflow.size() < _overflow.capacity();
+        assert(isKept);
+        if (isKept) _overflow.push_back(std::move(o));
+    }
+
+    // Enqueues the references kept while the queue was full (called from the audio thread at each block)
+    void retry();
+
+    // Number of references waiting in the overflow (audio thread only)
+    size_t nbOverflowed() { return _overflow.size(); }
+};
+
+}  // namespace MDStudio
+
+#endif  // GRAVEYARD_H
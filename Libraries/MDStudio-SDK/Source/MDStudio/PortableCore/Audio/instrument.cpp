@@ -26,6 +26,7 @@ Instrument::Instrument() {
     _decayRate = 0.0f;
     _sustainLevel = 1.0f;
     _releaseRate = 1.0f;
+    _nbVoiceReferences = 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -9,6 +9,7 @@
 #ifndef INSTRUMENT_H
 #define INSTRUMENT_H
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -56,6 +57,8 @@ class Instrument {
     Float32 _filterFc;  // Cut-off frequency
     Float32 _filterQ;   // Resonance
 
+    std::atomic<int> _nbVoiceReferences;  // Number of sampler voices referencing the instrument
+
    public:
     Instrument();
 
@@ -72,6 +75,7 @@ class Instrument {
     Float32 loopEnd() { return _loopEnd; }
 
     void setAudioFilename(std::string audioFileName) { _audioFileName = audioFileName; }
+    std::string audioFilename() { return _audioFileName; }
 
     // Pitch range
 
@@ -141,6 +145,11 @@ class Instrument {
 
     void setSF2SampleBasePos(SInt64 SF2SampleBasePos) { _SF2SampleBasePos = SF2SampleBasePos; }
     SInt64 SF2SampleBasePos() { return _SF2SampleBasePos; }
+
+    // Updated by the audio thread, can be read from any thread
+    void addVoiceReference() { ++_nbVoiceReferences; }
+    void removeVoiceReference() { --_nbVoiceReferences; }
+    int nbVoiceReferences() { return _nbVoiceReferences; }
 };
 
 }  // namespace MDStudio
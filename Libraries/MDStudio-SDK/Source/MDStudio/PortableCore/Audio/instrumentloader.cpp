@@ -0,0 +1,97 @@
+//
+//  instrumentloader.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-03.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "instrumentloader.h"
+
+#include <algorithm>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+InstrumentLoader::InstrumentLoader(InstrumentManager* instrumentManager, const std::string& name, UInt32 nbThreads,
+                                   didLoadInstrumentFnType didLoadInstrumentFn)
+    : _instrumentManager(instrumentManager), _name(name), _didLoadInstrumentFn(didLoadInstrumentFn) {
+    _isStopped = false;
+
+    for (UInt32 i = 0; i < nbThreads; ++i) _threads.push_back(std::thread(&InstrumentLoader::loadThread, this));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+InstrumentLoader::~InstrumentLoader() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopped = true;
+    }
+    _condition.notify_all();
+
+    for (auto& thread : _threads) thread.join();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool InstrumentLoader::load(int bank, int number, bool isUrgent) {
+    auto preset = std::make_pair(bank, number);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_requestedPresets.find(preset) != _requestedPresets.end()) {
+            // Already requested, but an urgent request must not wait behind the preloads
+            if (isUrgent) {
+                auto it = std::find(_pendingPresets.begin(), _pendingPresets.end(), preset);
+                if (it != _pendingPresets.end()) {
+                    _pendingPresets.erase(it);
+                    _pendingPresets.push_front(preset);
+                }
+            }
+            return false;
+        }
+
+        _requestedPresets.insert(preset);
+        if (isUrgent) {
+            _pendingPresets.push_front(preset);
+        } else {
+            _pendingPresets.push_back(preset);
+        }
+    }
+
+    _condition.notify_one();
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool InstrumentLoader::isLoading(int bank, int number) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _requestedPresets.find(std::make_pair(bank, number)) != _requestedPresets.end();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Load thread
+void InstrumentLoader::loadThread() {
+    while (true) {
+        std::pair<int, int> preset;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _isStopped || !_pendingPresets.empty(); });
+            if (_isStopped) return;
+            preset = _pendingPresets.front();
+            _pendingPresets.pop_front();
+        }
+
+        auto multiInstrument = _instrumentManager->loadSF2MultiInstrument(_name, preset.first, preset.second);
+
+        // The preset can be requested again once delivered
+        _didLoadInstrumentFn(this, preset.first, preset.second, multiInstrument);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _requestedPresets.erase(preset);
+        }
+    }
+}
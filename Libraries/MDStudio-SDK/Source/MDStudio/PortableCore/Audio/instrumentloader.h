@@ -0,0 +1,65 @@
+//
+//  instrumentloader.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-03.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef INSTRUMENTLOADER_H
+#define INSTRUMENTLOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "instrumentmanager.h"
+#include "multiinstrument.h"
+
+namespace MDStudio {
+
+// Loads the presets of a SoundFont on a fixed number of background threads. A preset is only queued once while it is
+// pending or being loaded, and urgent requests are served before the preloads.
+class InstrumentLoader {
+   public:
+    typedef std::function<void(InstrumentLoader* sender, int bank, int number,
+                               std::shared_ptr<MultiInstrument> multiInstrument)>
+        didLoadInstrumentFnType;
+
+   private:
+    InstrumentManager* _instrumentManager;
+    std::string _name;
+    didLoadInstrumentFnType _didLoadInstrumentFn;
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _isStopped;
+
+    std::deque<std::pair<int, int>> _pendingPresets;  // (bank, number) waiting for a thread
+    std::set<std::pair<int, int>> _requestedPresets;  // Pending or being loaded
+
+    void loadThread();
+
+   public:
+    // The load function is called from the loading threads
+    InstrumentLoader(InstrumentManager* instrumentManager, const std::string& name, UInt32 nbThreads,
+                     didLoadInstrumentFnType didLoadInstrumentFn);
+    ~InstrumentLoader();
+
+    // Queues the preset unless already requested. Returns true if a new load was queued.
+    bool load(int bank, int number, bool isUrgent);
+
+    bool isLoading(int bank, int number);
+};
+
+}  // namespace MDStudio
+
+#endif  // INSTRUMENTLOADER_H
@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include <algorithm>
+#include <set>
 
 #include "soundfont2.h"
 
@@ -11,29 +12,100 @@
 using namespace MDStudio;
 
 // ---------------------------------------------------------------------------------------------------------------------
-InstrumentManager::InstrumentManager(const std::string& audioPath) { _audioPath = audioPath; }
+InstrumentManager::InstrumentManager(const std::string& audioPath, UInt8 sampleFormat) {
+    _audioPath = audioPath;
+    _sampleFormat = sampleFormat;
+    _isStreaming = false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the bank of the given name, parsing the SoundFont on first use. The SoundFont is parsed without holding the
+// lock, the bank of the first thread to complete being kept.
+std::shared_ptr<InstrumentManager::SF2Bank> InstrumentManager::sf2Bank(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(_sf2BanksMutex);
+        auto it = _sf2Banks.find(name);
+        if (it != _sf2Banks.end()) return it->second;
+    }
+
+    auto bank = std::make_shared<SF2Bank>();
+
+    // Read the SF2 file
+    std::string path = _audioPath + "/" + name + ".sf2";
+    if (!bank->soundFont.load(path)) return nullptr;
+
+    std::lock_guard<std::mutex> lock(_sf2BanksMutex);
+    auto it = _sf2Banks.find(name);
+    if (it != _sf2Banks.end()) return it->second;
+    _sf2Banks[name] = bank;
+    return bank;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the sample of the instrument, shared with any other instrument still using the same sample data. The sample
+// is converted without holding the lock, the sample of the first thread to complete being kept.
+std::shared_ptr<Sample> InstrumentManager::sf2Sample(const std::shared_ptr<SF2Bank>& bank, Instrument* instrument) {
+    // A streamed sample keeps the loop of the instrument in memory
+    bool isStreamed = _isStreaming && _sampleFormat == SAMPLE_FORMAT_INT16 && !bank->soundFont.samples24();
+    UInt32 loopStart = isStreamed ? (UInt32)instrument->loopStart() : 0;
+    UInt32 loopEnd = isStreamed ? (UInt32)ceil(instrument->loopEnd()) : 0;
+
+    auto key = std::make_tuple((UInt32)instrument->SF2SampleStart(), (UInt32)instrument->SF2SampleEnd(), loopStart,
+                               loopEnd);
+
+    std::shared_ptr<Sample> sample;
+    {
+        std::lock_guard<std::mutex> lock(_sf2BanksMutex);
+        auto it = bank->samples.find(key);
+        if (it != bank->samples.end()) sample = it->second.lock();
+    }
+    if (sample) return sample;
+
+    if (instrument->SF2SampleStart() > instrument->SF2SampleEnd() ||
+        instrument->SF2SampleEnd() > bank->soundFont.nbSamples())
+        return nullptr;
+
+    sample = std::make_shared<Sample>();
+    sample->setSF2SampleRate(instrument->SF2SampleRate());
+    sample->setSF2SampleStart(instrument->SF2SampleStart());
+    sample->setSF2SampleEnd(instrument->SF2SampleEnd());
+    sample->setSF2SampleBasePos(instrument->SF2SampleBasePos());
+    sample->setFormat(_sampleFormat);
+    if (isStreamed) {
+        if (!sample->streamSF2Audio(bank->soundFont.samples(), bank, loopStart, loopEnd)) return nullptr;
+    } else {
+        if (!sample->loadSF2Audio(bank->soundFont.samples(), bank->soundFont.samples24())) return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_sf2BanksMutex);
+    auto& cachedSample = bank->samples[key];
+    auto otherSample = cachedSample.lock();
+    if (otherSample) return otherSample;
+    cachedSample = sample;
+
+    // The bank may have been released by an unload in the meantime
+    _sf2Banks.emplace(instrument->audioFilename(), bank);
+
+    return sample;
+}
 
 // ---------------------------------------------------------------------------------------------------------------------
 std::shared_ptr<MultiInstrument> InstrumentManager::loadSF2MultiInstrument(const std::string& name, int presetBank,
                                                                            int preset) {
-    SoundFont2 sf2;
-
     std::shared_ptr<MultiInstrument> multiInstrument = nullptr;
 
     //
     // Load the instrument
     //
 
-    std::string path = _audioPath + "/" + name + ".sf2";
-
-    // Read the SF2 file
-    if (!sf2.load(path)) return nullptr;
+    std::shared_ptr<SF2Bank> bank = sf2Bank(name);
+    if (!bank) return nullptr;
 
     multiInstrument = std::shared_ptr<MultiInstrument>(new MultiInstrument());
 
-    auto basePos = sf2.samplesOffset();
+    auto basePos = bank->soundFont.samplesOffset();
 
-    auto data = sf2.dataForPreset(presetBank, preset);
+    auto data = bank->soundFont.dataForPreset(presetBank, preset);
 
     // For each data element
     for (auto datum : data) {
@@ -106,61 +178,27 @@ std::shared_ptr<MultiInstrument> InstrumentManager::loadSF2MultiInstrument(const
     }  // for each data element
 
     //
-    // We load the samples for each instrument
+    // We set the samples of each instrument
     //
 
     // For each instrument
-    std::vector<std::shared_ptr<Instrument>>::iterator it;
-    for (it = multiInstrument->instrumentsBegin(); it != multiInstrument->instrumentsEnd(); it++) {
+    for (auto it = multiInstrument->instrumentsBegin(); it != multiInstrument->instrumentsEnd(); it++) {
         std::shared_ptr<Instrument> instrument = *it;
-
-        //
-        // We check if the sample has already been loaded from another instrument
-        //
-
-        std::shared_ptr<Sample> foundSample = nullptr;
-        // For each loaded sample
-
-        std::vector<std::shared_ptr<Sample>>::iterator itSample;
-        for (itSample = _loadedSamples.begin(); itSample != _loadedSamples.end(); itSample++) {
-            std::shared_ptr<Sample> sample = *itSample;
-            // If we have the same sample already loaded
-            if ((sample->SF2SampleStart() == instrument->SF2SampleStart()) &&
-                (sample->SF2SampleEnd() == instrument->SF2SampleEnd())) {
-                // We found the sample
-                foundSample = sample;
-                break;
-            }
-        }  // for each loaded sample
-
-        // If we found a sample
-        if (foundSample) {
-            // We set the sample
-            instrument->setSample(foundSample);
-        } else {
-            // We load the sample
-            std::shared_ptr<Sample> newSample = instrument->loadSF2Sample(path);
-            _loadedSamples.push_back(newSample);
-        }
-    }  // for each instrument
+        instrument->setSample(sf2Sample(bank, instrument.get()));
+    }
 
     return multiInstrument;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 std::vector<Preset> InstrumentManager::getSF2Presets(const std::string& name) {
-    SoundFont2 sf2;
-
     std::vector<Preset> presetNames;
 
-    // We load the instrument
-    std::string path = _audioPath + "/" + name + ".sf2";
-
-    // We read the SF2 file
-    if (!sf2.load(path)) return presetNames;
+    std::shared_ptr<SF2Bank> bank = sf2Bank(name);
+    if (!bank) return presetNames;
 
     // We get the preset headers
-    auto presetHeaders = sf2.presetHeaders();
+    auto presetHeaders = bank->soundFont.presetHeaders();
 
     // For each preset header
     for (auto presetHeader : presetHeaders) {
@@ -183,15 +221,40 @@ std::vector<Preset> InstrumentManager::getSF2Presets(const std::string& name) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
+// Forgets the samples used by the multi-instrument only, along with the expired ones. A bank left without any sample
+// is released, so that its file is unmapped once the streamed samples are gone. The samples themselves are released
+// with their last instrument.
 void InstrumentManager::unloadMultiInstrument(std::shared_ptr<MultiInstrument> multiInstrument) {
-    std::vector<std::shared_ptr<Instrument>>::iterator itInstrument;
+    std::lock_guard<std::mutex> lock(_sf2BanksMutex);
+
+    // References held by the multi-instrument per sample
+    std::map<Sample*, long> nbReferences;
+    std::set<std::string> bankNames;
+    for (auto it = multiInstrument->instrumentsBegin(); it != multiInstrument->instrumentsEnd(); ++it) {
+        auto sample = (*it)->sample();
+        if (sample) ++nbReferences[sample.get()];
+        bankNames.insert((*it)->audioFilename());
+    }
 
-    // For each instrument
-    for (itInstrument = multiInstrument->instrumentsBegin(); itInstrument != multiInstrument->instrumentsEnd();
-         itInstrument++) {
-        std::shared_ptr<Instrument> instrument = *itInstrument;
-        std::shared_ptr<Sample> sample = instrument->sample();
-        auto itSample = std::find(_loadedSamples.begin(), _loadedSamples.end(), sample);
-        if (itSample != _loadedSamples.end()) _loadedSamples.erase(itSample);
+    for (auto& bankName : bankNames) {
+        auto bankIt = _sf2Banks.find(bankName);
+        if (bankIt == _sf2Banks.end()) continue;
+
+        auto& samples = bankIt->second->samples;
+        for (auto it = samples.begin(); it != samples.end();) {
+            auto sample = it->second.lock();
+            auto nbReferencesIt = sample ? nbReferences.find(sample.get()) : nbReferences.end();
+
+            // The local reference aside
+            bool isUnused = !sample || (nbReferencesIt != nbReferences.end() &&
+                                        sample.use_count() - 1 <= nbReferencesIt->second);
+            if (isUnused) {
+                it = samples.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (samples.empty()) _sf2Banks.erase(bankIt);
     }
 }
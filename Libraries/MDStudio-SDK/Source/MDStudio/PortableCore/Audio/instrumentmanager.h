@@ -9,11 +9,16 @@
 #ifndef INSTRUMENTMANAGER_H
 #define INSTRUMENTMANAGER_H
 
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "multiinstrument.h"
+#include "soundfont2.h"
 
 namespace MDStudio {
 
@@ -25,11 +30,31 @@ class Preset {
 };
 
 class InstrumentManager {
+    // SoundFont parsed once, with the samples converted so far. The bank is kept alive by its streamed samples.
+    struct SF2Bank {
+        SoundFont2 soundFont;
+        // By start, end and loop (for streamed samples only)
+        std::map<std::tuple<UInt32, UInt32, UInt32, UInt32>, std::weak_ptr<Sample>> samples;
+    };
+
     std::string _audioPath;
-    std::vector<std::shared_ptr<Sample>> _loadedSamples;
+    UInt8 _sampleFormat;
+    std::atomic<bool> _isStreaming;
+    std::map<std::string, std::shared_ptr<SF2Bank>> _sf2Banks;
+    // Guards the banks and their sample maps only, the SoundFonts being parsed and the samples converted outside
+    std::mutex _sf2BanksMutex;
+
+    std::shared_ptr<SF2Bank> sf2Bank(const std::string& name);
+    std::shared_ptr<Sample> sf2Sample(const std::shared_ptr<SF2Bank>& bank, Instrument* instrument);
 
    public:
-    InstrumentManager(const std::string& audioPath);
+    // The samples are kept in the given format, except the 24-bit ones which are converted to floating point
+    InstrumentManager(const std::string& audioPath, UInt8 sampleFormat = SAMPLE_FORMAT_INT16);
+
+    // When enabled, only the head and the loop of the 16-bit samples loaded afterwards are kept in memory, the rest
+    // being streamed from the SoundFont by the sampler
+    void setIsStreaming(bool isStreaming) { _isStreaming = isStreaming; }
+    bool isStreaming() { return _isStreaming; }
 
     std::shared_ptr<MultiInstrument> loadSF2MultiInstrument(const std::string& name, int presetBank, int preset);
     void unloadMultiInstrument(std::shared_ptr<MultiInstrument> multiInstrument);
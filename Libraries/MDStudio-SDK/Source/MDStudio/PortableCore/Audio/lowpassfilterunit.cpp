@@ -8,8 +8,6 @@
 
 #include "lowpassfilterunit.h"
 
-#include "mixer.h"
-
 using namespace MDStudio;
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -17,17 +15,26 @@ LowPassFilterUnit::LowPassFilterUnit() {
     _isBypassed = false;
     _cutoffFreq = 4000.0f;
     _filter = new Dsp::SmoothedFilterDesign<Dsp::RBJ::Design::LowPass, 2>(1024);
+
+    LowPassFilterUnit::setFormat(_sampleRate, _framesPerBuffer);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 LowPassFilterUnit::~LowPassFilterUnit() { delete _filter; }
 
+// ---------------------------------------------------------------------------------------------------------------------
+void LowPassFilterUnit::setFormat(Float64 sampleRate, UInt32 framesPerBuffer) {
+    Unit::setFormat(sampleRate, framesPerBuffer);
+    _bufA.resize(framesPerBuffer);
+    _bufB.resize(framesPerBuffer);
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 int LowPassFilterUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride) {
     if (_isBypassed) return 0;
 
-    float a[MIXER_FRAMES_PER_BUFFER];
-    float b[MIXER_FRAMES_PER_BUFFER];
+    float* a = _bufA.data();
+    float* b = _bufB.data();
 
     GraphSampleType* outA = (GraphSampleType*)ioData[0];
     GraphSampleType* outB = (GraphSampleType*)ioData[1];
@@ -41,7 +48,7 @@ int LowPassFilterUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioDat
     }
 
     Dsp::Params params;
-    params[0] = 44100;  // sample rate
+    params[0] = _sampleRate;  // sample rate
     params[1] = _cutoffFreq;
     params[2] = 1.25;  // Q
     _filter->setParams(params);
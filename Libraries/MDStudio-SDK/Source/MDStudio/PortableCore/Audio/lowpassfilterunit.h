@@ -13,6 +13,7 @@
 #include <DspFilters/SmoothedFilter.h>
 
 #include <atomic>
+#include <vector>
 
 #include "unit.h"
 
@@ -22,11 +23,14 @@ class LowPassFilterUnit : public Unit {
     std::atomic<bool> _isBypassed;
     std::atomic<float> _cutoffFreq;
     Dsp::SmoothedFilterDesign<Dsp::RBJ::Design::LowPass, 2>* _filter;
+    std::vector<float> _bufA, _bufB;
 
    public:
     LowPassFilterUnit();
     ~LowPassFilterUnit();
 
+    void setFormat(Float64 sampleRate, UInt32 framesPerBuffer) override;
+
     int renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride = 1);
 
     void setIsBypassed(bool isBypassed) { _isBypassed = isBypassed; }
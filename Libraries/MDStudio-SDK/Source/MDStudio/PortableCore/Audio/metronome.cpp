@@ -32,6 +32,7 @@ Metronome::Metronome() {
     _playMajorTickFn = nullptr;
     _playMajorTickFn = nullptr;
     _didTickFn = nullptr;
+    _waitForClockFn = nullptr;
     _bpmDidChangeFn = nullptr;
     _timeSignatureDidChangeFn = nullptr;
 }
@@ -203,6 +204,7 @@ void Metronome::getBeatAndMesureForTick(UInt32 tick, UInt32* beat, UInt32* measu
 bool Metronome::performTick(timePointType startTime, timePointType currentTime) {
     if (!_didTickFn) return false;
 
+    _startTime = startTime;
     _tick = tickForTime(startTime, currentTime);
     return _didTickFn(this);
 }
@@ -221,7 +223,18 @@ void Metronome::metronomeThread() {
     std::pair<UInt32, UInt32> lastTimeSignature{0, 0};
     unsigned int lastBPM = 0;
 
-    startBeatTime = std::chrono::high_resolution_clock::now() - doublePrecisionDurationType(periodForTicks(_tick));
+    // The current time is taken either from the clock or from the system
+    waitForClockFnType waitForClockFn = _waitForClockFn;
+    timePointType currentTime = std::chrono::high_resolution_clock::now();
+    if (waitForClockFn) {
+        double time = 0.0;
+        while (!_stopMetronomeThread && !waitForClockFn(this, &time)) {
+        }
+        currentTime = timePointType(doublePrecisionDurationType(time));
+    }
+
+    startBeatTime = currentTime - doublePrecisionDurationType(periodForTicks(_tick));
+    _startTime = startBeatTime;
     getBeatAndMesureForTick(_tick, &lastBeat, &lastMeasure, &isMajorTickForcefullyPlayed);
 
     UInt32 lastTick = _tick;
@@ -234,7 +247,7 @@ void Metronome::metronomeThread() {
 
         _metronomeMutex.lock();
 
-        auto tick = tickForTime(startBeatTime, std::chrono::high_resolution_clock::now());
+        auto tick = tickForTime(startBeatTime, currentTime);
         _tick = std::max(tick, lastTick);
         lastTick = _tick;
 
@@ -283,9 +296,15 @@ void Metronome::metronomeThread() {
         }
 
         // We wait for the next tick
-        double beatPeriod = 60.0 / (double)bpm;
-        double tickPeriod = beatPeriod / (double)_timeDivision;
-        std::this_thread::sleep_for(doublePrecisionDurationType(tickPeriod));
+        if (waitForClockFn) {
+            double time;
+            if (waitForClockFn(this, &time)) currentTime = timePointType(doublePrecisionDurationType(time));
+        } else {
+            double beatPeriod = 60.0 / (double)bpm;
+            double tickPeriod = beatPeriod / (double)_timeDivision;
+            std::this_thread::sleep_for(doublePrecisionDurationType(tickPeriod));
+            currentTime = std::chrono::high_resolution_clock::now();
+        }
     }
 
     _isRunning = true;
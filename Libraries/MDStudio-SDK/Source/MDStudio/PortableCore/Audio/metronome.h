@@ -30,6 +30,9 @@ class Metronome {
 
     typedef std::function<bool(Metronome* sender)> didTickFnType;
 
+    // Blocks until the clock advances and provides its time in seconds. Returns false if the clock is not available.
+    typedef std::function<bool(Metronome* sender, double* time)> waitForClockFnType;
+
     typedef std::function<void(Metronome* sender, unsigned int bpm)> bpmDidChangeFnType;
     typedef std::function<void(Metronome* sender, std::pair<UInt32, UInt32> timeSignature)>
         timeSignatureDidChangeFnType;
@@ -47,6 +50,8 @@ class Metronome {
 
     std::atomic<UInt32> _tick;
 
+    timePointType _startTime;  // Time point of the tick 0
+
     std::thread _metronomeThread;
 
     bool _areTicksAudible;
@@ -65,6 +70,7 @@ class Metronome {
     playMajorTickFnType _playMajorTickFn;
     playMinorTickFnType _playMinorTickFn;
     didTickFnType _didTickFn;
+    waitForClockFnType _waitForClockFn;
     bpmDidChangeFnType _bpmDidChangeFn;
     timeSignatureDidChangeFnType _timeSignatureDidChangeFn;
 
@@ -98,6 +104,14 @@ class Metronome {
     std::vector<std::pair<UInt32, unsigned int>> bpms() { return _bpms; }
     std::vector<std::pair<UInt32, std::pair<UInt32, UInt32>>> timeSignatures() { return _timeSignatures; }
     unsigned int bpmForTick(UInt32 tick);
+
+    // Time point of the tick 0 of the current performance
+    timePointType startTime() { return _startTime; }
+
+    // Returns the time point of a given tick of the current performance
+    timePointType timePointForTick(UInt32 tick) {
+        return _startTime + doublePrecisionDurationType(periodForTicks(tick));
+    }
     std::pair<UInt32, UInt32> timeSignatureForTick(UInt32 tick);
 
     void addMajorTickFn(std::shared_ptr<majorTickFnType> majorTickFn);
@@ -110,6 +124,10 @@ class Metronome {
     void setPlayMinorTickFn(playMinorTickFnType playMinorTickFn) { _playMinorTickFn = playMinorTickFn; }
 
     void setDidTickFn(didTickFnType didTickFn) { _didTickFn = didTickFn; }
+
+    // When set, the metronome thread is driven by the given clock instead of sleeping for a tick period, and the time
+    // points are expressed in the time of that clock. Must not be called while the metronome is running.
+    void setWaitForClockFn(waitForClockFnType waitForClockFn) { _waitForClockFn = waitForClockFn; }
     void setDidMoveTickFn(didMoveTickFnType didMoveTickFn) { _didMoveTickFn = didMoveTickFn; }
 
     // Warning: not called from the main thread
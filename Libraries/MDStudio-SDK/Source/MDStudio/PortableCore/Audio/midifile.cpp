@@ -87,7 +87,8 @@ std::vector<UInt8> midiTrackDataFromSequence(std::shared_ptr<Sequence> sequence,
         trackData.insert(trackData.end(), name.begin(), name.end());
     }
 
-    for (auto event : sequence->data.tracks[trackIndex].events) {
+    auto& track = sequence->data.tracks[trackIndex];
+    for (auto& event : track.events) {
         //
         // Delta time
         //
@@ -197,10 +198,10 @@ std::vector<UInt8> midiTrackDataFromSequence(std::shared_ptr<Sequence> sequence,
                 bytes[0] = 0xF0 | event.channel;
                 trackData.push_back(bytes[0]);
                 {
-                    auto vlLength = vlEncode((UInt32)(event.data.size()));
+                    auto vlLength = vlEncode(track.dataLength(event));
                     trackData.insert(trackData.end(), vlLength.begin(), vlLength.end());
+                    trackData.insert(trackData.end(), track.data(event), track.data(event) + track.dataLength(event));
                 }
-                trackData.insert(trackData.end(), event.data.begin(), event.data.end());
                 break;
 
             case EVENT_TYPE_META_SET_TEMPO:
@@ -237,10 +238,10 @@ std::vector<UInt8> midiTrackDataFromSequence(std::shared_ptr<Sequence> sequence,
                 bytes[1] = event.param1;
                 for (std::size_t i = 0; i < 2; i++) trackData.push_back(bytes[i]);
                 {
-                    auto vlLength = vlEncode((UInt32)(event.data.size()));
+                    auto vlLength = vlEncode(track.dataLength(event));
                     trackData.insert(trackData.end(), vlLength.begin(), vlLength.end());
+                    trackData.insert(trackData.end(), track.data(event), track.data(event) + track.dataLength(event));
                 }
-                trackData.insert(trackData.end(), event.data.begin(), event.data.end());
                 break;
 
         }  // switch event type
@@ -588,7 +589,9 @@ std::shared_ptr<Sequence> MDStudio::readMIDIFile(const std::string& path) {
                                 metaData.push_back(v);
                             }
 
-                            events.push_back(makeEvent(EVENT_TYPE_META_GENERIC, 0, deltaTime, type, -1, metaData));
+                            event = makeEvent(EVENT_TYPE_META_GENERIC, 0, deltaTime, type, -1);
+                            event.dataOffset = sequence->data.tracks[track].addEventData(metaData);
+                            events.push_back(event);
                         } break;
                     }
                 } else {
@@ -710,8 +713,9 @@ std::shared_ptr<Sequence> MDStudio::readMIDIFile(const std::string& path) {
                                     sysexData.push_back(v);
                                 }
 
-                                events.push_back(
-                                    makeEvent(EVENT_TYPE_SYSTEM_EXCLUSIVE, channel, deltaTime, -1, -1, sysexData));
+                                event = makeEvent(EVENT_TYPE_SYSTEM_EXCLUSIVE, channel, deltaTime, -1, -1);
+                                event.dataOffset = sequence->data.tracks[track].addEventData(sysexData);
+                                events.push_back(event);
                                 break;
                             }
 
@@ -18,12 +18,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
-#define SAMPLE_RATE (44100)
-
-#define INPUT_NUM_CHANNELS 1
+#include "rtcheck.h"
 
 using namespace MDStudio;
 
@@ -43,36 +42,19 @@ static int renderCallback(const void* inputBuffer, void* outputBuffer, unsigned
     float* out[2];
     out[0] = ob;
     out[1] = ob + 1;
-    (void)inputBuffer; /* Prevent unused argument warning. */
 
     mixer->renderInput(static_cast<UInt32>(framesPerBuffer), out, 2);
+    mixer->didRender();
 
     //
     // Input
     //
 
-    AudioBuffer* data = mixer->inputAudioBuffer();
-    const float* rptr = (const float*)inputBuffer;
-    float* wptr = &data->samples[data->frameIndex * INPUT_NUM_CHANNELS];
-    long i;
-
-    (void)outputBuffer; /* Prevent unused variable warnings. */
     (void)timeInfo;
-    (void)statusFlags;
-    (void)userData;
-
-    data->mutex.lock();
 
-    if (inputBuffer != NULL) {
-        for (i = 0; i < MIXER_FRAMES_PER_BUFFER; i++) {
-            *wptr++ = *rptr++;                              /* left */
-            if (INPUT_NUM_CHANNELS == 2) *wptr++ = *rptr++; /* right */
-        }
-    }
+    if (statusFlags & (paInputUnderflow | paInputOverflow | paOutputUnderflow | paOutputOverflow)) mixer->countXRun();
 
-    data->frameIndex = 0;
-
-    data->mutex.unlock();
+    if (inputBuffer != NULL) mixer->writeInput((const float*)inputBuffer, static_cast<UInt32>(framesPerBuffer));
 
     return paContinue;
 }
@@ -110,32 +92,44 @@ static void PrintSupportedStandardSampleRates(const PaStreamParameters* inputPar
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Mixer::Mixer() {
+Mixer::Mixer(bool isNullOutput) : _inputQueue(MIXER_INPUT_NB_BLOCKS) {
     _stream = nullptr;
     _isRunning = false;
     _level = 0.5f;  // -3 dB
+    _sampleRate = UNIT_DEFAULT_SAMPLE_RATE;
+    _framesPerBuffer = UNIT_DEFAULT_FRAMES_PER_BUFFER;
+    _pendingSampleRate = _sampleRate;
+    _pendingFramesPerBuffer = _framesPerBuffer;
+    _isNullOutput = isNullOutput;
+    _didRenderNullOutputFn = nullptr;
+
+    if (_isNullOutput) {
+        _outputDeviceName = MIXER_NULL_OUTPUT_DEVICE_NAME;
+        _outputLatency = 0.0;
+    } else {
+        Pa_Initialize();
+
+        PaDeviceIndex outputDevice;
+        outputDevice = Pa_GetDefaultOutputDevice();
+        _outputDeviceName = Pa_GetDeviceInfo(outputDevice)->name;
+        _outputLatency = Pa_GetDeviceInfo(outputDevice)->defaultLowOutputLatency;
+    }
 
-    Pa_Initialize();
-
-    PaDeviceIndex outputDevice;
-    outputDevice = Pa_GetDefaultOutputDevice();
-    _outputDeviceName = Pa_GetDeviceInfo(outputDevice)->name;
-    _outputLatency = Pa_GetDeviceInfo(outputDevice)->defaultLowOutputLatency;
-
-    _inputAudioBuffer.samples = NULL;
+    _nbInputOverruns = 0;
+    _nbXRuns = 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 Mixer::~Mixer() {
     if (_isRunning) stop();
 
-    Pa_Terminate();
-
-    if (_inputAudioBuffer.samples) free(_inputAudioBuffer.samples);
+    if (!_isNullOutput) Pa_Terminate();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 void Mixer::printDevices() {
+    if (_isNullOutput) return;
+
     int i, numDevices, defaultDisplayed;
     const PaDeviceInfo* deviceInfo;
     PaStreamParameters inputParameters, outputParameters;
@@ -255,6 +249,8 @@ void Mixer::printDevices() {
 std::vector<std::pair<std::string, double>> Mixer::outputDevices() {
     std::vector<std::pair<std::string, double>> outputDevices;
 
+    if (_isNullOutput) return outputDevices;
+
     int i, numDevices;
     const PaDeviceInfo* deviceInfo;
 
@@ -276,6 +272,8 @@ bool Mixer::start(bool isInputEnabled) {
     // If already running, we return right away
     if (_isRunning) return true;
 
+    if (_isNullOutput) return startNullOutput();
+
     PaStreamParameters outputParameters;
     PaStreamParameters inputParameters;
     PaError err;
@@ -319,29 +317,20 @@ bool Mixer::start(bool isInputEnabled) {
             goto error;
         }
 
-        inputParameters.channelCount = 1; /* mono input */
+        inputParameters.channelCount = MIXER_INPUT_NB_CHANNELS; /* mono input */
         inputParameters.sampleFormat = paFloat32;
         inputParameters.suggestedLatency = Pa_GetDeviceInfo(inputParameters.device)->defaultLowInputLatency;
         inputParameters.hostApiSpecificStreamInfo = NULL;
 
-        int totalFrames;
-        int numSamples;
-        int numBytes;
-
-        _inputAudioBuffer.maxFrameIndex = totalFrames = MIXER_FRAMES_PER_BUFFER; /* Record for a few seconds. */
-        _inputAudioBuffer.frameIndex = 0;
-        numSamples = totalFrames * INPUT_NUM_CHANNELS;
-        numBytes = numSamples * sizeof(float);
-        _inputAudioBuffer.samples = (float*)malloc(numBytes); /* From now on, recordedSamples is initialised. */
-        if (_inputAudioBuffer.samples == NULL) {
-            printf("Could not allocate record array.\n");
-            goto error;
-        }
-        for (int i = 0; i < numSamples; ++i) _inputAudioBuffer.samples[i] = 0;
+        // Discard the input of a previous session
+        while (_inputQueue.pop()) continue;
     }  // if input is enabled
 
+    // The units are configured before the stream starts calling them
+    applyFormat();
+
     err = Pa_OpenStream(&_stream, isInputEnabled ? &inputParameters : NULL, &outputParameters, /* As above. */
-                        SAMPLE_RATE, MIXER_FRAMES_PER_BUFFER,                                  /* Frames per buffer. */
+                        _sampleRate, _framesPerBuffer,                                         /* Frames per buffer. */
                         paClipOff, /* No out of range samples expected. */
                         renderCallback, this);
     if (err != paNoError) goto error;
@@ -361,6 +350,11 @@ error:
 
 // ---------------------------------------------------------------------------------------------------------------------
 void Mixer::stop() {
+    if (_isNullOutput) {
+        stopNullOutput();
+        return;
+    }
+
     if (_stream != nullptr) {
         Pa_CloseStream(_stream);
 
@@ -368,13 +362,36 @@ void Mixer::stop() {
     }
 
     _isRunning = false;
+
+    // Release the thread waiting for a block
+    _renderSemaphore.signal();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Mixer::addUnit(std::shared_ptr<Unit> unit) { _units.push_back(unit); }
+void Mixer::addUnit(std::shared_ptr<Unit> unit) {
+    unit->setFormat(_sampleRate, _framesPerBuffer);
+    _units.push_back(unit);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Mixer::writeInput(const Float32* samples, UInt32 nbFrames) {
+    AudioInputBlock block;
+
+    while (nbFrames > 0) {
+        block.nbFrames = nbFrames < MIXER_INPUT_BLOCK_FRAMES ? nbFrames : MIXER_INPUT_BLOCK_FRAMES;
+        memcpy(block.samples, samples, block.nbFrames * MIXER_INPUT_NB_CHANNELS * sizeof(Float32));
+        if (!_inputQueue.try_enqueue(block)) ++_nbInputOverruns;
+        samples += block.nbFrames * MIXER_INPUT_NB_CHANNELS;
+        nbFrames -= block.nbFrames;
+    }
+}
 
 // ---------------------------------------------------------------------------------------------------------------------
 int Mixer::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride) {
+    RealTimeScope realTimeScope;
+
+    UInt64 startTime = RenderStats::now();
+
     // For each sample
     float* p = ioData[0];
     for (UInt32 i = 0; i < inNumberFrames; ++i) {
@@ -387,10 +404,17 @@ int Mixer::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32
         p += stride;
     }
 
-    std::vector<Unit*>::iterator it;
-
-    // Render the units
-    for (auto unit : _units) unit->renderInput(inNumberFrames, ioData, stride);
+    // Render the units, never exceeding the number of frames per buffer they were configured for
+    for (UInt32 frameIndex = 0; frameIndex < inNumberFrames; frameIndex += _framesPerBuffer) {
+        UInt32 nbFrames = std::min(inNumberFrames - frameIndex, _framesPerBuffer);
+        GraphSampleType* out[2] = {ioData[0] + frameIndex * stride, ioData[1] + frameIndex * stride};
+        UInt64 deadline = (UInt64)(nbFrames * 1e9 / _sampleRate);
+        for (auto& unit : _units) {
+            UInt64 unitStartTime = RenderStats::now();
+            unit->renderInput(nbFrames, out, stride);
+            unit->renderStats().record(RenderStats::now() - unitStartTime, deadline);
+        }
+    }
 
     float gain = level();
 
@@ -408,5 +432,7 @@ int Mixer::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32
         p += stride;
     }
 
+    _renderStats.record(RenderStats::now() - startTime, (UInt64)(inNumberFrames * 1e9 / _sampleRate));
+
     return 0;
 }
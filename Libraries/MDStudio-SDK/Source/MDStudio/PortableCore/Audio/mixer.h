@@ -9,45 +9,91 @@
 #ifndef MIXER_H
 #define MIXER_H
 
+#include "readerwriterqueue.h"
+#include "renderstats.h"
 #include "unit.h"
 #if !TARGET_OS_IPHONE
 #include <portaudio.h>
 #endif
 #include <atomic>
+#include <functional>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
-#define MIXER_FRAMES_PER_BUFFER 256
+#define MIXER_INPUT_NB_CHANNELS 1
+#define MIXER_INPUT_BLOCK_FRAMES 256
+#define MIXER_INPUT_NB_BLOCKS 64  // Capacity of the input ring (about 370 ms at 44.1 kHz)
+
+#define MIXER_NULL_OUTPUT_DEVICE_NAME "Null"
 
 namespace MDStudio {
 
-struct AudioBuffer {
-    std::mutex mutex;
-    int frameIndex; /* Index into sample array. */
-    int maxFrameIndex;
-    Float32* samples;
+// Block of interleaved input samples captured by the audio thread
+struct AudioInputBlock {
+    UInt32 nbFrames;
+    Float32 samples[MIXER_INPUT_BLOCK_FRAMES * MIXER_INPUT_NB_CHANNELS];
 };
 
 class Mixer {
+   public:
+    // Called by the null output thread with each rendered block of interleaved stereo samples
+    typedef std::function<void(Mixer* sender, const GraphSampleType* samples, UInt32 nbFrames)>
+        didRenderNullOutputFnType;
+
+   private:
 #if !TARGET_OS_IPHONE
     PaStream* _stream;
 #endif
     std::vector<std::shared_ptr<Unit>> _units;
 
-    bool _isRunning;
+    std::atomic<bool> _isRunning;
 
     std::string _outputDeviceName;
     double _outputLatency;
 
+    // Format of the stream, read by the audio thread
+    Float64 _sampleRate;
+    UInt32 _framesPerBuffer;
+
+    // Format requested while running, applied at the next start
+    Float64 _pendingSampleRate;
+    UInt32 _pendingFramesPerBuffer;
+
     std::atomic<Float32> _level;
     std::atomic<bool> _isAGCEnabled;
 
-    AudioBuffer _inputAudioBuffer;
+    moodycamel::ReaderWriterQueue<AudioInputBlock> _inputQueue;
+    std::atomic<UInt32> _nbInputOverruns;
+
+    // Signaled by the audio thread after each rendered block
+    moodycamel::spsc_sema::LightweightSemaphore _renderSemaphore;
+
+    // Render times of the blocks against their duration
+    RenderStats _renderStats;
+    std::atomic<UInt64> _nbXRuns;
+
+    // Null output
+    bool _isNullOutput;
+    std::thread _nullOutputThread;
+    didRenderNullOutputFnType _didRenderNullOutputFn;
+
+    // Must not be called while the mixer is running
+    void applyFormat() {
+        _sampleRate = _pendingSampleRate;
+        _framesPerBuffer = _pendingFramesPerBuffer;
+        for (auto& unit : _units) unit->setFormat(_sampleRate, _framesPerBuffer);
+    }
+
+    bool startNullOutput();
+    void stopNullOutput();
+    void nullOutputThread();
 
    public:
-    Mixer();
+    // With a null output, no audio device is opened: once started, the mixer renders into memory as fast as possible
+    // on a thread of its own. The input is not available.
+    Mixer(bool isNullOutput = false);
     ~Mixer();
 
     void printDevices();
@@ -63,12 +109,32 @@ class Mixer {
     std::string outputDeviceName() { return _outputDeviceName; }
     void setOutputDeviceName(const std::string& outputDeviceName) { _outputDeviceName = outputDeviceName; }
 
+    // If the mixer is running, the format is applied at the next start. The getters return the format in use.
+    Float64 sampleRate() { return _sampleRate; }
+    void setSampleRate(Float64 sampleRate) {
+        _pendingSampleRate = sampleRate;
+        if (!_isRunning) applyFormat();
+    }
+
+    UInt32 framesPerBuffer() { return _framesPerBuffer; }
+    void setFramesPerBuffer(UInt32 framesPerBuffer) {
+        _pendingFramesPerBuffer = framesPerBuffer;
+        if (!_isRunning) applyFormat();
+    }
+
     bool start(bool isInputEnabled = false);
     void stop();
     void addUnit(std::shared_ptr<Unit> unit);
 
     bool isRunning() { return _isRunning; }
 
+    bool isNullOutput() { return _isNullOutput; }
+
+    // Must not be called while the mixer is running
+    void setDidRenderNullOutputFn(didRenderNullOutputFnType didRenderNullOutputFn) {
+        _didRenderNullOutputFn = didRenderNullOutputFn;
+    }
+
     void setLevel(Float32 level) { _level = level; }
     Float32 level() { return _level; }
 
@@ -79,7 +145,44 @@ class Mixer {
 
     int renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride = 1);
 
-    AudioBuffer* inputAudioBuffer() { return &_inputAudioBuffer; }
+    // Called by the audio thread after each block rendered for the output
+    void didRender() { _renderSemaphore.signal(); }
+
+    // Called by the audio thread when the device reports an underflow or an overflow
+    void countXRun() { _nbXRuns.fetch_add(1, std::memory_order_relaxed); }
+    UInt64 nbXRuns() { return _nbXRuns; }
+
+    // Statistics of the rendered blocks, the load being the ratio of the render time to the duration of the block.
+    // The statistics of each unit are recorded against the same deadline.
+    RenderStats& renderStats() { return _renderStats; }
+    void resetStats() {
+        _renderStats.reset();
+        _nbXRuns = 0;
+        for (auto& unit : _units) unit->renderStats().reset();
+    }
+
+    // Blocks until the audio thread has rendered the next block (single waiting thread). Returns false right away if
+    // the mixer is not running.
+    bool waitForRender() {
+        if (!_isRunning) return false;
+        _renderSemaphore.wait();
+
+        // We skip the blocks rendered while nobody was waiting
+        while (_renderSemaphore.tryWait()) {
+        }
+
+        return _isRunning;
+    }
+
+#if !TARGET_OS_IPHONE
+    // Called by the audio thread with the captured input; the block is dropped if the ring is full
+    void writeInput(const Float32* samples, UInt32 nbFrames);
+#endif
+
+    // Input ring consumer (single consumer thread)
+    bool readInput(AudioInputBlock* block) { return _inputQueue.try_dequeue(*block); }
+    size_t nbAvailableInputBlocks() { return _inputQueue.size_approx(); }
+    UInt32 nbInputOverruns() { return _nbInputOverruns; }
 };
 
 }  // namespace MDStudio
@@ -15,17 +15,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
 #include "mixer.h"
+#include "rtcheck.h"
 
 #define MIXER_NB_INPUTS 64
 #define MIXER_MAX_CHANNELS MD_MIXER_NB_INPUTS
 
-#define MIXER_GRAPH_SAMPLE_RATE 44100.0
-#define MIXER_GRAPH_SAMPLE_PERIOD (1.0 / MD_MIXER_GRAPH_SAMPLE_RATE)
-
 #define MIXER_MAX_LEVEL 1.0
 
 #define MIXER_AGC_MAX_GAIN 4.0  // Maximum gain for the AGC
@@ -46,18 +45,29 @@ bool applyReverbStates[MIXER_NB_INPUTS];
 // ---------------------------------------------------------------------------------------------------------------------
 static void renderData(Mixer* mixer, UInt32 nbFrames, GraphSampleType* ioData[2], UInt32 stride,
                        bool bypassAGC = false) {
+    RealTimeScope realTimeScope;
+
+    UInt64 startTime = RenderStats::now();
+
     GraphSampleType* outA = ioData[0];
     GraphSampleType* outB = ioData[1];
 
     memset(outA, 0, nbFrames * sizeof(GraphSampleType));
     memset(outB, 0, nbFrames * sizeof(GraphSampleType));
 
-    // Render the units
-    for (auto it = mixer->unitsBegin(); it != mixer->unitsEnd(); it++) {
-        GraphSampleType* out[2];
-        out[0] = outA;
-        out[1] = outB;
-        (*it)->renderInput(static_cast<UInt32>(nbFrames), out, stride);
+    // Render the units, never exceeding the number of frames per buffer they were configured for
+    UInt32 framesPerBuffer = mixer->framesPerBuffer();
+    for (UInt32 frameIndex = 0; frameIndex < nbFrames; frameIndex += framesPerBuffer) {
+        UInt32 nbChunkFrames = std::min(nbFrames - frameIndex, framesPerBuffer);
+        UInt64 deadline = (UInt64)(nbChunkFrames * 1e9 / mixer->sampleRate());
+        for (auto it = mixer->unitsBegin(); it != mixer->unitsEnd(); it++) {
+            GraphSampleType* out[2];
+            out[0] = outA + frameIndex * stride;
+            out[1] = outB + frameIndex * stride;
+            UInt64 unitStartTime = RenderStats::now();
+            (*it)->renderInput(nbChunkFrames, out, stride);
+            (*it)->renderStats().record(RenderStats::now() - unitStartTime, deadline);
+        }
     }
 
     //
@@ -100,6 +110,8 @@ static void renderData(Mixer* mixer, UInt32 nbFrames, GraphSampleType* ioData[2]
     } else {
         gain = 1.0f;
     }
+
+    mixer->renderStats().record(RenderStats::now() - startTime, (UInt64)(nbFrames * 1e9 / mixer->sampleRate()));
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -112,12 +124,13 @@ static OSStatus renderInput(void* inRefCon, AudioUnitRenderActionFlags* ioAction
     buffers[0] = (GraphSampleType*)ioData->mBuffers[0].mData;
     buffers[1] = (GraphSampleType*)ioData->mBuffers[1].mData;
     renderData(mixer, inNumberFrames, buffers, 1);
+    mixer->didRender();
 
     return noErr;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-static bool initialize(void* controller) {
+static bool initialize(Mixer* mixer) {
     OSStatus result = noErr;
     currentInput = 0;
 
@@ -150,7 +163,7 @@ static bool initialize(void* controller) {
 
     AudioStreamBasicDescription desc = {0};
 
-    desc.mSampleRate = MIXER_GRAPH_SAMPLE_RATE;
+    desc.mSampleRate = mixer->sampleRate();
     desc.mFormatID = kAudioFormatLinearPCM;
     desc.mFormatFlags = kAudioFormatFlagsNativeFloatPacked | kAudioFormatFlagIsNonInterleaved;
     desc.mBytesPerPacket = sizeof(GraphSampleType);
@@ -171,7 +184,7 @@ static bool initialize(void* controller) {
     // Set a callback for the specified node's specified input
     AURenderCallbackStruct rcbs;
     rcbs.inputProc = &renderInput;
-    rcbs.inputProcRefCon = controller;
+    rcbs.inputProcRefCon = mixer;
 
     result = AudioUnitSetProperty(outputAU, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Global, 0, &rcbs,
                                   sizeof(rcbs));
@@ -184,6 +197,32 @@ static bool initialize(void* controller) {
     return true;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+static bool setSampleRate(Float64 sampleRate) {
+    AudioStreamBasicDescription desc;
+    UInt32 size = sizeof(desc);
+
+    OSStatus result =
+        AudioUnitGetProperty(outputAU, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, &desc, &size);
+    if (result) return false;
+
+    if (desc.mSampleRate == sampleRate) return true;
+
+    // The format can only be changed while the graph is uninitialized
+    result = AUGraphUninitialize(graph);
+    if (result) return false;
+
+    desc.mSampleRate = sampleRate;
+    result =
+        AudioUnitSetProperty(outputAU, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, &desc, sizeof(desc));
+    if (result) return false;
+
+    result = AUGraphInitialize(graph);
+    if (result) return false;
+
+    return true;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 static bool addRenderCallback(AURenderCallbackStruct rcbs, bool applyReverb) {
     if (currentInput >= MIXER_NB_INPUTS) return false;
@@ -236,17 +275,32 @@ static void dispose() {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Mixer::Mixer() {
+Mixer::Mixer(bool isNullOutput) : _inputQueue(MIXER_INPUT_NB_BLOCKS) {
     _isRunning = false;
+    _isNullOutput = isNullOutput;
+    _didRenderNullOutputFn = nullptr;
 
     _level = 0.5f;  // -3 dB
     _isAGCEnabled = false;
-
-    ::initialize(this);
+    _nbInputOverruns = 0;
+    _nbXRuns = 0;
+    _sampleRate = UNIT_DEFAULT_SAMPLE_RATE;
+    _framesPerBuffer = UNIT_DEFAULT_FRAMES_PER_BUFFER;
+    _pendingSampleRate = _sampleRate;
+    _pendingFramesPerBuffer = _framesPerBuffer;
+
+    if (!_isNullOutput) ::initialize(this);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Mixer::~Mixer() { ::dispose(); }
+Mixer::~Mixer() {
+    if (_isNullOutput) {
+        if (_isRunning) stop();
+        return;
+    }
+
+    ::dispose();
+}
 
 // ---------------------------------------------------------------------------------------------------------------------
 void Mixer::printDevices() {
@@ -266,6 +320,13 @@ bool Mixer::start(bool isInputEnabled) {
     // If already running, we return right away
     if (_isRunning) return true;
 
+    if (_isNullOutput) return startNullOutput();
+
+    // The units are configured before the graph starts calling them
+    applyFormat();
+
+    if (!::setSampleRate(_sampleRate)) return false;
+
     ::start(this);
 
     _isRunning = true;
@@ -277,15 +338,26 @@ bool Mixer::start(bool isInputEnabled) {
 
 // ---------------------------------------------------------------------------------------------------------------------
 void Mixer::stop() {
+    if (_isNullOutput) {
+        stopNullOutput();
+        return;
+    }
+
     ::stop(this);
 
     _isRunning = false;
 
     for (auto unit : _units) unit->setIsRunning(false);
+
+    // Release the thread waiting for a block
+    _renderSemaphore.signal();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Mixer::addUnit(std::shared_ptr<Unit> unit) { _units.push_back(unit); }
+void Mixer::addUnit(std::shared_ptr<Unit> unit) {
+    unit->setFormat(_sampleRate, _framesPerBuffer);
+    _units.push_back(unit);
+}
 
 // ---------------------------------------------------------------------------------------------------------------------
 int Mixer::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride) {
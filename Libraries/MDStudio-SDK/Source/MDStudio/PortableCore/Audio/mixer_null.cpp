@@ -0,0 +1,57 @@
+//
+//  mixer_null.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include <vector>
+
+#include "mixer.h"
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool Mixer::startNullOutput() {
+    // Discard the input of a previous session
+    while (_inputQueue.pop()) continue;
+
+    // The units are configured before the thread starts calling them
+    applyFormat();
+
+    _isRunning = true;
+
+    for (auto unit : _units) unit->setIsRunning(true);
+
+    _nullOutputThread = std::thread(&Mixer::nullOutputThread, this);
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Mixer::stopNullOutput() {
+    _isRunning = false;
+
+    if (_nullOutputThread.joinable()) _nullOutputThread.join();
+
+    for (auto unit : _units) unit->setIsRunning(false);
+
+    // Release the thread waiting for a block
+    _renderSemaphore.signal();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Renders the blocks back to back, without waiting for any clock
+void Mixer::nullOutputThread() {
+    UInt32 framesPerBuffer = _framesPerBuffer;
+
+    std::vector<GraphSampleType> buffer(2 * framesPerBuffer);
+    GraphSampleType* out[2] = {&buffer[0], &buffer[1]};
+
+    while (_isRunning) {
+        renderInput(framesPerBuffer, out, 2);
+        if (_didRenderNullOutputFn) _didRenderNullOutputFn(this, buffer.data(), framesPerBuffer);
+        didRender();
+    }
+}
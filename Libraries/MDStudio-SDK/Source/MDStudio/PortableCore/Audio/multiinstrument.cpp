@@ -37,17 +37,21 @@ std::shared_ptr<Instrument> MultiInstrument::instrument(Float32 pitch, Float32 v
     return NULL;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+bool MultiInstrument::isInstrumentInRange(Instrument* instrument, Float32 pitch, Float32 velocity) {
+    velocity = floorf(velocity * 127.0);
+    return pitch >= instrument->lowestPitch() && pitch <= instrument->highestPitch() &&
+           velocity >= instrument->lowestVelocity() && velocity <= instrument->highestVelocity();
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 std::vector<std::shared_ptr<Instrument>> MultiInstrument::instruments(Float32 pitch, Float32 velocity) {
     std::vector<std::shared_ptr<Instrument>> foundInstruments;
 
-    velocity = floorf(velocity * 127.0);
     std::vector<std::shared_ptr<Instrument>>::iterator it;
 
     for (it = _instruments.begin(); it != _instruments.end(); it++) {
-        if (pitch >= (*it)->lowestPitch() && pitch <= (*it)->highestPitch() && velocity >= (*it)->lowestVelocity() &&
-            velocity <= (*it)->highestVelocity())
-            foundInstruments.push_back(*it);
+        if (isInstrumentInRange(it->get(), pitch, velocity)) foundInstruments.push_back(*it);
     }
 
     return foundInstruments;
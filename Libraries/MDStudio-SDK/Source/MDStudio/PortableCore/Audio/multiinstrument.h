@@ -30,6 +30,9 @@ class MultiInstrument {
     std::vector<std::shared_ptr<Instrument>>::iterator instrumentsEnd() { return _instruments.end(); }
     void addInstrument(std::shared_ptr<Instrument> instrument) { _instruments.push_back(instrument); }
     std::vector<std::shared_ptr<Instrument>> instruments(Float32 pitch, Float32 velocity);
+
+    // Returns true if the instrument can play the given pitch and velocity (does not allocate)
+    static bool isInstrumentInRange(Instrument* instrument, Float32 pitch, Float32 velocity);
 };
 
 }  // namespace MDStudio
@@ -0,0 +1,68 @@
+//
+//  renderstats.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-25.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "renderstats.h"
+
+#include <chrono>
+
+#define RENDER_STATS_LOAD_SMOOTHING 0.1f
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+UInt64 RenderStats::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Only the audio thread writes the statistics, so the updates do not need to be atomic as a whole
+void RenderStats::record(UInt64 renderTime, UInt64 deadline) {
+    _nbRenders.store(_nbRenders.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _totalRenderTime.store(_totalRenderTime.load(std::memory_order_relaxed) + renderTime, std::memory_order_relaxed);
+    if (renderTime > _maxRenderTime.load(std::memory_order_relaxed))
+        _maxRenderTime.store(renderTime, std::memory_order_relaxed);
+
+    if (deadline > 0) {
+        Float32 load = (Float32)renderTime / (Float32)deadline;
+        Float32 smoothedLoad = _load.load(std::memory_order_relaxed);
+        _load.store(smoothedLoad + RENDER_STATS_LOAD_SMOOTHING * (load - smoothedLoad), std::memory_order_relaxed);
+        if (load > _peakLoad.load(std::memory_order_relaxed)) _peakLoad.store(load, std::memory_order_relaxed);
+        if (renderTime > deadline)
+            _nbOverruns.store(_nbOverruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    int bin = 0;
+    for (UInt64 us = renderTime / 1000; us > 1 && bin < RENDER_STATS_NB_BINS - 1; us >>= 1) ++bin;
+    _histogram[bin].store(_histogram[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void RenderStats::reset() {
+    _nbRenders = 0;
+    _nbOverruns = 0;
+    _totalRenderTime = 0;
+    _maxRenderTime = 0;
+    _load = 0.0f;
+    _peakLoad = 0.0f;
+    for (auto& count : _histogram) count = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+RenderStatsSnapshot RenderStats::snapshot() const {
+    RenderStatsSnapshot snapshot;
+    snapshot.nbRenders = _nbRenders.load(std::memory_order_relaxed);
+    snapshot.nbOverruns = _nbOverruns.load(std::memory_order_relaxed);
+    snapshot.totalRenderTime = _totalRenderTime.load(std::memory_order_relaxed);
+    snapshot.maxRenderTime = _maxRenderTime.load(std::memory_order_relaxed);
+    snapshot.load = _load.load(std::memory_order_relaxed);
+    snapshot.peakLoad = _peakLoad.load(std::memory_order_relaxed);
+    for (int bin = 0; bin < RENDER_STATS_NB_BINS; ++bin)
+        snapshot.histogram[bin] = _histogram[bin].load(std::memory_order_relaxed);
+    return snapshot;
+}
@@ -0,0 +1,61 @@
+//
+//  renderstats.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-25.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <atomic>
+
+#include "../types.h"
+
+// Bin k of the histogram counts the render times from 2^k to 2^(k+1) microseconds, the first and last bins being open
+#define RENDER_STATS_NB_BINS 16
+
+namespace MDStudio {
+
+// Copy of the render statistics at a given time
+struct RenderStatsSnapshot {
+    UInt64 nbRenders;
+    UInt64 nbOverruns;       // Renders that took longer than their deadline
+    UInt64 totalRenderTime;  // In nanoseconds
+    UInt64 maxRenderTime;    // In nanoseconds
+    Float32 load;            // Smoothed ratio of the render time to the deadline
+    Float32 peakLoad;
+    UInt64 histogram[RENDER_STATS_NB_BINS];
+
+    Float64 averageRenderTime() const { return nbRenders > 0 ? (Float64)totalRenderTime / nbRenders : 0.0; }
+};
+
+// Render time statistics recorded by the audio thread without locking and readable from any thread
+class RenderStats {
+    std::atomic<UInt64> _nbRenders;
+    std::atomic<UInt64> _nbOverruns;
+    std::atomic<UInt64> _totalRenderTime;
+    std::atomic<UInt64> _maxRenderTime;
+    std::atomic<Float32> _load;
+    std::atomic<Float32> _peakLoad;
+    std::atomic<UInt64> _histogram[RENDER_STATS_NB_BINS];
+
+   public:
+    RenderStats() { reset(); }
+
+    // Monotonic time in nanoseconds
+    static UInt64 now();
+
+    // Records a render that took the given time for the given deadline (audio thread only)
+    void record(UInt64 renderTime, UInt64 deadline);
+
+    // A reset performed while rendering may lose the render being recorded
+    void reset();
+
+    RenderStatsSnapshot snapshot() const;
+};
+
+}  // namespace MDStudio
+
+#endif  // RENDERSTATS_H
@@ -0,0 +1,73 @@
+//
+//  rtcheck.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-20.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "rtcheck.h"
+
+#ifdef MDSTUDIO_RT_CHECK
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <new>
+
+using namespace MDStudio;
+
+static thread_local int realTimeScopeDepth = 0;
+
+// ---------------------------------------------------------------------------------------------------------------------
+RealTimeScope::RealTimeScope() { ++realTimeScopeDepth; }
+
+// ---------------------------------------------------------------------------------------------------------------------
+RealTimeScope::~RealTimeScope() { --realTimeScopeDepth; }
+
+// ---------------------------------------------------------------------------------------------------------------------
+static void* checkedAlloc(std::size_t size) {
+    assert(realTimeScopeDepth == 0 && "Memory allocated by a real-time thread");
+    return malloc(size == 0 ? 1 : size);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static void checkedFree(void* p) {
+    if (!p) return;
+    assert(realTimeScopeDepth == 0 && "Memory freed by a real-time thread");
+    free(p);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void* operator new(std::size_t size) {
+    void* p = checkedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void* operator new[](std::size_t size) {
+    void* p = checkedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return checkedAlloc(size); }
+
+// ---------------------------------------------------------------------------------------------------------------------
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return checkedAlloc(size); }
+
+// ---------------------------------------------------------------------------------------------------------------------
+void operator delete(void* p) noexcept { checkedFree(p); }
+
+// ---------------------------------------------------------------------------------------------------------------------
+void operator delete[](void* p) noexcept { checkedFree(p); }
+
+// ---------------------------------------------------------------------------------------------------------------------
+void operator delete(void* p, std::size_t) noexcept { checkedFree(p); }
+
+// ---------------------------------------------------------------------------------------------------------------------
+void operator delete[](void* p, std::size_t) noexcept { checkedFree(p); }
+
+#endif  // MDSTUDIO_RT_CHECK
@@ -0,0 +1,26 @@
+//
+//  rtcheck.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-20.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef RTCHECK_H
+#define RTCHECK_H
+
+namespace MDStudio {
+
+// Marks the current thread as real-time for the lifetime of the object.
+// When built with MDSTUDIO_RT_CHECK, any memory allocation or deallocation performed by a real-time thread asserts.
+class RealTimeScope {
+   public:
+#ifdef MDSTUDIO_RT_CHECK
+    RealTimeScope();
+    ~RealTimeScope();
+#endif
+};
+
+}  // namespace MDStudio
+
+#endif  // RTCHECK_H
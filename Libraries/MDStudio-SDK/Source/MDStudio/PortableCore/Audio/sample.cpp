@@ -9,6 +9,9 @@
 #include "sample.h"
 
 #include <assert.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "stdio.h"
 #include "stdlib.h"
@@ -24,6 +27,12 @@ static const Float64 kDefaultSampleRate = 44100.0;
 Sample::Sample() {
     _data = _dataWithMargin = NULL;
     _sampleRate = kDefaultSampleRate;
+    _format = SAMPLE_FORMAT_INT16;
+    _gain = 1.0f;
+    _streamSource = NULL;
+    _streamStart = _streamEnd = 0;
+    _loopDataWithMargin = NULL;
+    _loopDataStart = 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -55,38 +64,105 @@ bool Sample::loadSF2Audio(const std::string& path) {
     // Close the SF2 bank
     fclose(f);
 
-    // Calculate the number of samples at the output
-    UInt32 numOutputSamples = numFrames;
+    bool isConverted = convertSF2Audio(inputData, NULL, numFrames);
 
-    // Allocate the output data buffer
-    _dataWithMargin = (SampleType*)calloc(numOutputSamples + 2 * SAMPLE_DATA_MARGIN_LENGTH, sizeof(SampleType));
-    if (_dataWithMargin == NULL) {
-        free(inputData);
-        return false;
-    }
+    // Dispose the input buffer
+    free(inputData);
 
-    assert(_dataWithMargin);
+    return isConverted;
+}
 
-    _data = _dataWithMargin + SAMPLE_DATA_MARGIN_LENGTH;
+// ---------------------------------------------------------------------------------------------------------------------
+bool Sample::loadSF2Audio(const SInt16* samples, const UInt8* samples24) {
+    _sampleRate = _SF2SampleRate;
+
+    // Calculate the number of frames
+    UInt32 numFrames = (UInt32)(_SF2SampleEnd - _SF2SampleStart);
+    _length = numFrames;
+
+    return convertSF2Audio(samples + _SF2SampleStart, samples24 ? samples24 + _SF2SampleStart : NULL, numFrames);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// In the 16-bit format, the data is copied as is and the gain is applied by the resampling kernel
+bool Sample::convertSF2Audio(const SInt16* inputData, const UInt8* inputData24, UInt32 numFrames) {
+    if (inputData24) _format = SAMPLE_FORMAT_FLOAT32;
 
-    // Clear the margins
-    for (UInt32 i = 0; i < SAMPLE_DATA_MARGIN_LENGTH; i++) {
-        _dataWithMargin[i] = 0;
-        _dataWithMargin[numOutputSamples + 2 * SAMPLE_DATA_MARGIN_LENGTH - i - 1] = 0;
+    size_t sampleSize = (_format == SAMPLE_FORMAT_INT16) ? sizeof(SInt16) : sizeof(SampleType);
+
+    // Allocate the output data buffer with the margins cleared
+    _dataWithMargin = calloc(numFrames + 2 * SAMPLE_DATA_MARGIN_LENGTH, sampleSize);
+    if (_dataWithMargin == NULL) return false;
+
+    assert(_dataWithMargin);
+
+    if (_format == SAMPLE_FORMAT_INT16) {
+        SInt16* data = static_cast<SInt16*>(_dataWithMargin) + SAMPLE_DATA_MARGIN_LENGTH;
+        memcpy(data, inputData, numFrames * sizeof(SInt16));
+        _data = data;
+        _gain = 1.0f / 65536.0f * MD_SF2_SAMPLE_GAIN;
+        return true;
     }
 
-    for (UInt32 i = 0; i < numFrames; i++) {
-        _dataWithMargin[i + SAMPLE_DATA_MARGIN_LENGTH] = (SampleType)(inputData[i]) / 65536.0f * MD_SF2_SAMPLE_GAIN;
+    SampleType* data = static_cast<SampleType*>(_dataWithMargin) + SAMPLE_DATA_MARGIN_LENGTH;
+    if (inputData24) {
+        for (UInt32 i = 0; i < numFrames; i++)
+            data[i] = (SampleType)(inputData[i] * 256 + inputData24[i]) / 16777216.0f * MD_SF2_SAMPLE_GAIN;
+    } else {
+        for (UInt32 i = 0; i < numFrames; i++) data[i] = (SampleType)(inputData[i]) / 65536.0f * MD_SF2_SAMPLE_GAIN;
     }
+    _data = data;
+    _gain = 1.0f;
 
-    // Dispose the input buffer
-    free(inputData);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool Sample::streamSF2Audio(const SInt16* samples, std::shared_ptr<const void> samplesOwner, UInt32 loopStart,
+                            UInt32 loopEnd, UInt32 headLength) {
+    UInt32 numFrames = (UInt32)(_SF2SampleEnd - _SF2SampleStart);
+    if (headLength < SAMPLE_DATA_MARGIN_LENGTH) headLength = SAMPLE_DATA_MARGIN_LENGTH;
+    if (loopStart > numFrames) loopStart = numFrames;
+    if (loopEnd < loopStart) loopEnd = loopStart;
+
+    // Nothing to stream
+    _format = SAMPLE_FORMAT_INT16;
+    if (loopStart <= headLength) return loadSF2Audio(samples);
+
+    _sampleRate = _SF2SampleRate;
+    _length = numFrames;
+    _gain = 1.0f / 65536.0f * MD_SF2_SAMPLE_GAIN;
+
+    const SInt16* inputData = samples + _SF2SampleStart;
+
+    // Head, followed by the first frames of the streamed region so that the resampling window stays in memory
+    UInt32 nbHeadFrames = std::min(headLength + SAMPLE_DATA_MARGIN_LENGTH, numFrames);
+    _dataWithMargin = calloc(headLength + 2 * SAMPLE_DATA_MARGIN_LENGTH, sizeof(SInt16));
+    if (_dataWithMargin == NULL) return false;
+    SInt16* data = static_cast<SInt16*>(_dataWithMargin) + SAMPLE_DATA_MARGIN_LENGTH;
+    memcpy(data, inputData, nbHeadFrames * sizeof(SInt16));
+    _data = data;
+
+    // Loop with margins on both sides, the frames past the end of the sample being zeros
+    _loopDataStart = loopStart - SAMPLE_DATA_MARGIN_LENGTH;
+    UInt32 nbLoopFrames = loopEnd - loopStart + 2 * SAMPLE_DATA_MARGIN_LENGTH;
+    _loopDataWithMargin = static_cast<SInt16*>(calloc(nbLoopFrames, sizeof(SInt16)));
+    if (_loopDataWithMargin == NULL) return false;
+    memcpy(_loopDataWithMargin, inputData + _loopDataStart,
+           std::min(nbLoopFrames, numFrames - _loopDataStart) * sizeof(SInt16));
+
+    _streamSourceOwner = samplesOwner;
+    _streamSource = inputData;
+    _streamStart = headLength;
+    _streamEnd = loopStart;
 
     return true;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 Sample::~Sample() {
+    if (_loopDataWithMargin) free(_loopDataWithMargin);
+
     if (_dataWithMargin) {
         free(_dataWithMargin);
         _dataWithMargin = _data = NULL;
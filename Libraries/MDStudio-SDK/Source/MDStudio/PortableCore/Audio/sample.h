@@ -9,30 +9,53 @@
 #ifndef SAMPLE_H
 #define SAMPLE_H
 
+#include <memory>
 #include <string>
 
 #include "../types.h"
 
+// Storage of the sample data in memory
+#define SAMPLE_FORMAT_FLOAT32 0  // Converted to floating point when loaded
+#define SAMPLE_FORMAT_INT16 1    // Native 16-bit data, converted by the resampling kernel
+
+#define SAMPLE_STREAM_HEAD_FRAMES 16384  // Frames kept in memory at the start of a streamed sample
+
 namespace MDStudio {
 
 class Sample {
-    SampleType* _data;
+    void* _data;
     Float64 _sampleRate;
 
     // Audio data
     std::string* _audioFileName;  // name of the audio file
     Float32 _length;              // length of the buffer in frames
-    SampleType* _dataWithMargin;  // Internal use only
+    void* _dataWithMargin;        // Internal use only
+    UInt8 _format;
+    Float32 _gain;
 
     Float64 _SF2SampleRate;
     SInt64 _SF2SampleStart;
     SInt64 _SF2SampleEnd;
     SInt64 _SF2SampleBasePos;
 
+    // Streaming from the disk
+    std::shared_ptr<const void> _streamSourceOwner;
+    const SInt16* _streamSource;
+    UInt32 _streamStart;
+    UInt32 _streamEnd;
+    SInt16* _loopDataWithMargin;
+    UInt32 _loopDataStart;
+
+    bool convertSF2Audio(const SInt16* inputData, const UInt8* inputData24, UInt32 numFrames);
+
    public:
     Sample();
     ~Sample();
 
+    // Must be set before loading the audio. The 24-bit SoundFont samples are always converted to floating point.
+    void setFormat(UInt8 format) { _format = format; }
+    UInt8 format() { return _format; }
+
     void setSF2SampleRate(Float64 sampleRate) { _SF2SampleRate = sampleRate; }
     Float64 SF2SampleRate() { return _SF2SampleRate; }
 
@@ -47,7 +70,40 @@ class Sample {
 
     bool loadSF2Audio(const std::string& path);
 
-    SampleType* data() { return _data; }
+    // Loads the audio from the sample data of a SoundFont already in memory (the sample base position is ignored).
+    // The optional least significant bytes of the 24-bit samples are given by samples24.
+    bool loadSF2Audio(const SInt16* samples, const UInt8* samples24 = nullptr);
+
+    // Keeps only the head and the loop of the sample in memory in the 16-bit format. The frames between them are
+    // streamed by the sampler from the samples of the SoundFont, which are kept alive by the given owner. The sample
+    // is fully loaded if the loop starts within the head.
+    bool streamSF2Audio(const SInt16* samples, std::shared_ptr<const void> samplesOwner, UInt32 loopStart,
+                        UInt32 loopEnd, UInt32 headLength = SAMPLE_STREAM_HEAD_FRAMES);
+
+    bool isLoaded() { return _data != NULL; }
+    bool isStreamed() { return _streamSource != NULL; }
+
+    // Frames of the streamed region, from the end of the head to the start of the loop
+    const SInt16* streamSource() { return _streamSource; }
+    UInt32 streamStart() { return _streamStart; }
+    UInt32 streamEnd() { return _streamEnd; }
+
+    // Frames of a streamed sample kept in memory from the loop start minus a margin
+    const SInt16* loopData() { return _loopDataWithMargin; }
+    UInt32 loopDataStart() { return _loopDataStart; }
+
+    // Data in the floating point format, NULL otherwise
+    SampleType* data() { return _format == SAMPLE_FORMAT_FLOAT32 ? static_cast<SampleType*>(_data) : NULL; }
+
+    // Data in the 16-bit format, NULL otherwise
+    SInt16* data16() { return _format == SAMPLE_FORMAT_INT16 ? static_cast<SInt16*>(_data) : NULL; }
+
+    // Data in the storage format, preceded and followed by zeros for the resampling kernel
+    void* rawData() { return _data; }
+
+    // Factor applied to the stored values when rendered
+    Float32 gain() { return _gain; }
+
     Float64 sampleRate() { return _sampleRate; }
     Float32 length() { return _length; }
 };
@@ -13,8 +13,8 @@
 #include <assert.h>
 #include <math.h>
 
+#include <algorithm>
 #include <chrono>
-#include <thread>
 #include <vector>
 
 #include "filter_k12z4.h"
@@ -25,11 +25,23 @@
 #include <Accelerate/Accelerate.h>
 #endif
 
+#if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 // Convert [0 .. 1] to [-100 .. 0]
 #define TO_ATTENUATION_DB_RANGE(_x_, _range_) ((1.0f - _x_) * _range_)
 
-#define GRAPH_SAMPLE_RATE 44100
-#define SAMPLER_CROSS_FADE_RATE (1000.0 / GRAPH_SAMPLE_RATE)
+#define SAMPLER_CROSS_FADE_DURATION 0.001  // in seconds
+
+// Number of scratch buffers of one block used by renderFrames() and by renderChannel() for each channel
+#define SAMPLER_NB_RENDER_BUFFERS 6
+#define SAMPLER_NB_CHANNEL_BUFFERS 4
+
+// Number of frames processed at once by the block voice renderer
+#define SAMPLER_RENDER_CHUNK_FRAMES 64
 
 // Returns the rate for a given pitch
 #define SAMPLER_RATE_FOR_PITCH(_base_pitch_, _pitch_) exp2f((float)(_pitch_ - _base_pitch_) / 12.0f)
@@ -43,11 +55,8 @@
 #define SAMPLER_SET_SUSTAIN_STATE_CMD 6
 #define SAMPLER_SET_PITCH_BEND_CMD 7
 #define SAMPLER_SET_MODULATION_CMD 8
-#define SAMPLER_IS_NOTE_PLAYING_CMD 9
-#define SAMPLER_IS_NOTE_PLAYING_PITCH_CMD 10
 #define SAMPLER_CLEAR_VOICES_CMD 11
 #define SAMPLER_CLEAR_ALL_VOICES_CMD 12
-#define SAMPLER_IS_MULTI_INSTRUMENT_IN_USE_CMD 13
 #define SAMPLER_SET_LEVEL_CMD 14
 #define SAMPLER_SET_BALANCE_CMD 15
 #define SAMPLER_SET_REVERB_CMD 16
@@ -104,6 +113,41 @@ static inline Float32 dotProduct4(const Float32* a, const Float32* b, int n) {
 #endif  // _LINUX
 
 // ---------------------------------------------------------------------------------------------------------------------
+// Dot product of all the taps of the resampling kernel
+static inline GraphSampleType dotProduct(const SampleType* pIn, const SampleType* pCoefficients) {
+#if _LINUX
+
+    // The first coefficient is always zero, so we skip it
+    return dotProduct4(pIn + 1, pCoefficients + 1, 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS);
+
+#else  // _LINUX
+
+#if (TARGET_OS_IPHONE || TARGET_OS_MAC)
+
+    GraphSampleType tempS;
+
+    vDSP_dotpr(pIn, 1, pCoefficients, 1, &tempS, 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS + 1);
+
+    return (GraphSampleType)tempS;
+
+#else
+    GraphSampleType s = 0;
+
+    for (int i = 0; i < 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS + 1; i++) {
+        s += *pIn * *pCoefficients;
+        pCoefficients++;
+        pIn++;
+    }
+
+    return s;
+
+#endif
+
+#endif  // _LINUX
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Reference rendering of a single frame. Streamed samples are only supported by renderVoiceBlock().
 void SamplerUnit::renderVoice(struct Voice* voice, UInt64 rate, GraphSampleType* out) {
     if (voice->isPlaying && voice->data != NULL) {
         GraphSampleType s;
@@ -125,41 +169,32 @@ void SamplerUnit::renderVoice(struct Voice* voice, UInt64 rate, GraphSampleType*
 
             SampleType* pCoefficients = resamplerCoefficients[sincTableOffset];
 
-            SampleType* pIn = voice->data + (posInt - RESAMPLE_WINDOW_NB_ZERO_CROSSINGS - 1);
-#if _LINUX
-
-            s = dotProduct4(pIn, pCoefficients, 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS);
-
-#else  // _LINUX
-
-#if (TARGET_OS_IPHONE || TARGET_OS_MAC)
-
-            GraphSampleType tempS;
-
-            vDSP_dotpr(pIn, 1, pCoefficients, 1, &tempS, 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS + 1);
+            if (voice->dataFormat == SAMPLE_FORMAT_INT16) {
+                const SInt16* pIn =
+                    static_cast<const SInt16*>(voice->data) + (posInt - RESAMPLE_WINDOW_NB_ZERO_CROSSINGS);
 
-            s = (GraphSampleType)tempS;
-
-#else
-            s = 0;
-
-            for (int i = 0; i < 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS + 1; i++) {
-                s += *pIn * *pCoefficients;
-                pCoefficients++;
-                pIn++;
+                // The first coefficient is always zero, so we skip it
+                s = 0;
+                for (int i = 1; i < 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS + 1; i++)
+                    s += (Float32)*pIn++ * pCoefficients[i];
+                s *= voice->dataGain;
+            } else {
+                const SampleType* pIn =
+                    static_cast<const SampleType*>(voice->data) + (posInt - RESAMPLE_WINDOW_NB_ZERO_CROSSINGS - 1);
+                s = dotProduct(pIn, pCoefficients);
             }
 
-#endif
-
-#endif  // _LINUX
-
         } else {
             //
             // No interpolation
             //
 
-            SampleType* pIn = voice->data + (pos >> VOICE_FRACTION_BITS);
-            s = *pIn;
+            SInt32 posInt = pos >> VOICE_FRACTION_BITS;
+            if (voice->dataFormat == SAMPLE_FORMAT_INT16) {
+                s = static_cast<const SInt16*>(voice->data)[posInt] * voice->dataGain;
+            } else {
+                s = static_cast<const SampleType*>(voice->data)[posInt];
+            }
         }
 
         Float32 volEnvFactor = voice->volEnvFactor;
@@ -195,10 +230,10 @@ void SamplerUnit::renderVoice(struct Voice* voice, UInt64 rate, GraphSampleType*
                 voice->data = nullptr;
             }
 
+            // The instrument is released by the sampler once the voice is no longer active
             if (voice->pos >= voice->length) {
                 voice->isPlaying = false;
                 voice->data = nullptr;
-                voice->instrument = nullptr;
             }
         }
 
@@ -228,241 +263,653 @@ void SamplerUnit::renderVoice(struct Voice* voice, UInt64 rate, GraphSampleType*
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-int SamplerUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride) {
-    // Command interpreter
+// Dot product of the 8 non-zero taps of the resampling kernel
+static inline Float32 sincDotProduct(const SampleType* in, const SampleType* coefficients) {
+#if defined(__AVX__)
+    __m256 p = _mm256_mul_ps(_mm256_loadu_ps(in), _mm256_loadu_ps(coefficients));
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(p), _mm256_extractf128_ps(p, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+    return _mm_cvtss_f32(s);
+#elif defined(__SSE__) || defined(_M_X64)
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in), _mm_loadu_ps(coefficients)),
+                          _mm_mul_ps(_mm_loadu_ps(in + 4), _mm_loadu_ps(coefficients + 4)));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+    return _mm_cvtss_f32(s);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t p = vmulq_f32(vld1q_f32(in), vld1q_f32(coefficients));
+    p = vmlaq_f32(p, vld1q_f32(in + 4), vld1q_f32(coefficients + 4));
+    float32x2_t s = vadd_f32(vget_low_f32(p), vget_high_f32(p));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#else
+    Float32 s = 0.0f;
+    for (int i = 0; i < 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS; ++i) s += in[i] * coefficients[i];
+    return s;
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Dot product of the 8 non-zero taps of the resampling kernel over 16-bit samples, converted to floating point in the
+// registers
+static inline Float32 sincDotProduct16(const SInt16* in, const SampleType* coefficients) {
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    // Sign extension of each 16-bit sample to 32 bits
+    __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+    __m128 s = _mm_add_ps(_mm_mul_ps(lo, _mm_loadu_ps(coefficients)), _mm_mul_ps(hi, _mm_loadu_ps(coefficients + 4)));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+    return _mm_cvtss_f32(s);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    int16x8_t v = vld1q_s16(in);
+    float32x4_t p = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), vld1q_f32(coefficients));
+    p = vmlaq_f32(p, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), vld1q_f32(coefficients + 4));
+    float32x2_t s = vadd_f32(vget_low_f32(p), vget_high_f32(p));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#else
+    Float32 s = 0.0f;
+    for (int i = 0; i < 2 * RESAMPLE_WINDOW_NB_ZERO_CROSSINGS; ++i) s += (Float32)in[i] * coefficients[i];
+    return s;
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Block version of renderVoice().
+// The envelope and the positions are first advanced for a chunk of frames, then the resampling kernel and the gain
+// are applied over the whole chunk.
+void SamplerUnit::renderVoiceBlock(struct Voice* voice, UInt64 rate, GraphSampleType* out, UInt32 nbFrames) {
+    const bool isInterpolated = rate != (UInt64)1 << VOICE_FRACTION_BITS;
+    const bool isLooped = voice->loopStart != 0 || voice->loopEnd != 0;
+    const bool isInt16 = voice->dataFormat == SAMPLE_FORMAT_INT16;
+    const Float32 dataGain = voice->dataGain;
+    SampleStream* stream = voice->stream;
+
+    SInt32 posInts[SAMPLER_RENDER_CHUNK_FRAMES];
+    UInt32 sincTableOffsets[SAMPLER_RENDER_CHUNK_FRAMES];
+    Float32 gains[SAMPLER_RENDER_CHUNK_FRAMES];
+
+    while (nbFrames > 0) {
+        if (!voice->isPlaying || voice->data == NULL) {
+            // The data is null or the voice is not playing therefore we force silence.
+            for (UInt32 i = 0; i < nbFrames; ++i) out[i] = 0;
+            return;
+        }
+
+        const void* data = voice->data;
+        UInt64 pos = voice->pos;
+        Float32 volEnvFactor = voice->volEnvFactor;
+        UInt32 volEnvHoldCounter = voice->volEnvHoldCounter;
+
+        UInt32 nbChunkFrames = nbFrames < SAMPLER_RENDER_CHUNK_FRAMES ? nbFrames : SAMPLER_RENDER_CHUNK_FRAMES;
+
+        //
+        // We advance the position and the envelope
+        //
+
+        UInt32 n = 0;
+        int region = SAMPLE_STREAM_REGION_HEAD;
+        while (n < nbChunkFrames) {
+            SInt32 posInt = (SInt32)(pos >> VOICE_FRACTION_BITS);
+
+            // A chunk of a streamed sample is read from a single region
+            if (stream) {
+                int posRegion = stream->region(posInt);
+                if (n == 0) {
+                    region = posRegion;
+                } else if (posRegion != region) {
+                    break;
+                }
+            }
+
+            posInts[n] = posInt;
+            sincTableOffsets[n] = (UInt32)((pos & (((UInt64)(1) << VOICE_FRACTION_BITS) - 1)) >>
+                                           (VOICE_FRACTION_BITS - RESAMPLE_WINDOW_SAMPLES_PER_ZERO_CROSSING_BITS));
+            gains[n] = getAttenuation(TO_ATTENUATION_DB_RANGE(volEnvFactor, -100)) * dataGain;
+            ++n;
+
+            UInt64 previousPos = pos;
+
+            // We progress in the wave
+            pos += rate;
+
+            // We loop
+            if (isLooped && pos >= voice->loopEnd) {
+                if (voice->loopStart != voice->loopEnd) {
+                    pos = (pos - voice->loopEnd) % (voice->loopEnd - voice->loopStart) + voice->loopStart;
+                } else {
+                    pos = voice->loopStart;
+                }
+            }
+
+            if (!voice->isNoteOn) {
+                // We update the release phase envelope
+                if (!voice->isNoteSustained) {
+                    volEnvFactor -= voice->releaseRatePerSample;
+                }
+
+                if (volEnvFactor < 0.0f) {
+                    voice->isPlaying = false;
+                    voice->data = nullptr;
+                }
+
+                if (previousPos >= voice->length) {
+                    voice->isPlaying = false;
+                    voice->data = nullptr;
+                }
+            }
+
+            // If the note is on or if the note is sustained
+            if (voice->isNoteOn || voice->isNoteSustained) {
+                if (volEnvHoldCounter > 0) {
+                    // We are in the hold phase
+                    volEnvHoldCounter--;
+                } else if (volEnvFactor > voice->sustainLevel) {
+                    // We are in the decay-sustain phase envelope
+                    volEnvFactor -= voice->decayRatePerSample;
+                }
+            }
+
+            if (!voice->isPlaying) break;
+        }
+
+        voice->volEnvHoldCounter = volEnvHoldCounter;
+        voice->volEnvFactor = volEnvFactor;
+        voice->pos = pos;
+
+        //
+        // We render the mono samples
+        //
+
+        if (isInt16) {
+            // The frames are read from the data at the given origin, wrapped by the mask within the ring
+            const SInt16* data16 = static_cast<const SInt16*>(data);
+            SInt32 origin = 0;
+            SInt32 mask = -1;
+            bool isAvailable = true;
+
+            const bool isRing = stream && region == SAMPLE_STREAM_REGION_RING;
+            if (isRing) {
+                data16 = stream->ring.data();
+                mask = SAMPLE_STREAM_RING_FRAMES - 1;
+                isAvailable = stream->isAvailable(posInts[n - 1]);
+                if (!isAvailable) stream->nbUnderruns.fetch_add(1, std::memory_order_relaxed);
+            } else if (stream && region == SAMPLE_STREAM_REGION_LOOP) {
+                data16 = stream->loopData;
+                origin = stream->loopDataStart;
+            }
+
+            if (!isAvailable) {
+                // The frames were not read in time
+                for (UInt32 i = 0; i < n; ++i) out[i] = 0;
+            } else if (isInterpolated) {
+                // Band-limited interpolation
+                for (UInt32 i = 0; i < n; ++i) {
+                    const SInt16* in = data16 + ((posInts[i] - RESAMPLE_WINDOW_NB_ZERO_CROSSINGS - origin) & mask);
+                    out[i] = sincDotProduct16(in, &resamplerCoefficients[sincTableOffsets[i]][1]);
+                }
+            } else {
+                // No interpolation
+                for (UInt32 i = 0; i < n; ++i) out[i] = data16[(posInts[i] - origin) & mask];
+            }
+
+            // The frames before the next position can be overwritten by the reader thread
+            if (isRing)
+                stream->readFrame.store((SInt32)(pos >> VOICE_FRACTION_BITS) - SAMPLE_STREAM_MARGIN,
+                                        std::memory_order_release);
+        } else {
+            const SampleType* dataFloat = static_cast<const SampleType*>(data);
+            if (isInterpolated) {
+                // Band-limited interpolation
+                for (UInt32 i = 0; i < n; ++i) {
+                    out[i] = sincDotProduct(dataFloat + posInts[i] - RESAMPLE_WINDOW_NB_ZERO_CROSSINGS,
+                                            &resamplerCoefficients[sincTableOffsets[i]][1]);
+                }
+            } else {
+                // No interpolation
+                for (UInt32 i = 0; i < n; ++i) out[i] = dataFloat[posInts[i]];
+            }
+        }
+
+        // We apply the volume envelope and data gain factors
+        for (UInt32 i = 0; i < n; ++i) out[i] *= gains[i];
+
+        out += n;
+        nbFrames -= n;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Command interpreter
+void SamplerUnit::processCmd(const SamplerCmd& cmd) {
+    switch (cmd.op) {
+        case SAMPLER_PLAY_NOTE_CMD:
+            playNoteCmd(cmd.p1, cmd.p2, cmd.multiInstrument, cmd.channel);
+            break;
+        case SAMPLER_RELEASE_NOTE_CMD:
+            releaseNoteCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_STOP_NOTE_CMD:
+            stopNoteCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_RELEASE_ALL_NOTES_CMD:
+            releaseAllNotesCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_STOP_ALL_NOTES_PITCH_CMD:
+            stopAllNotesPitchCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_STOP_ALL_NOTES_CMD:
+            stopAllNotesCmd(cmd.channel);
+            break;
+        case SAMPLER_SET_SUSTAIN_STATE_CMD:
+            setSustainStateCmd(cmd.p1 == 1.0f, cmd.channel);
+            break;
+        case SAMPLER_SET_PITCH_BEND_CMD:
+            setPitchBendCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_SET_MODULATION_CMD:
+            setModulationCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_CLEAR_VOICES_CMD:
+            clearVoicesCmd(cmd.channel);
+            break;
+        case SAMPLER_CLEAR_ALL_VOICES_CMD:
+            clearAllVoicesCmd();
+            break;
+        case SAMPLER_SET_LEVEL_CMD:
+            setLevelCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_SET_BALANCE_CMD:
+            setBalanceCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_SET_REVERB_CMD:
+            setReverbCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_SET_CHORUS_CMD:
+            setChorusCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_SET_EXPRESSION_CMD:
+            setExpressionCmd(cmd.p1, cmd.channel);
+            break;
+        case SAMPLER_SET_PITCH_BEND_FACTOR_CMD:
+            setPitchBendFactorCmd(cmd.p1, cmd.channel);
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns true if the given immediate command stops or clears the notes of the given held command
+static bool isCancellingCmd(const SamplerCmd& cmd, const SamplerCmd& heldCmd) {
+    if (heldCmd.op != SAMPLER_PLAY_NOTE_CMD && heldCmd.op != SAMPLER_RELEASE_NOTE_CMD) return false;
+
+    switch (cmd.op) {
+        case SAMPLER_STOP_NOTE_CMD:
+        case SAMPLER_RELEASE_ALL_NOTES_CMD:
+        case SAMPLER_STOP_ALL_NOTES_PITCH_CMD:
+            return heldCmd.channel == cmd.channel && heldCmd.p1 == cmd.p1;
+        case SAMPLER_STOP_ALL_NOTES_CMD:
+        case SAMPLER_CLEAR_VOICES_CMD:
+            return heldCmd.channel == cmd.channel;
+        case SAMPLER_CLEAR_ALL_VOICES_CMD:
+            return true;
+    }
+
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Moves the received commands into the held commands sorted by sample time. The commands already due keep their order
+// of reception, so that an immediate command is never held behind a command scheduled later. Since the commands
+// stopping or clearing the notes are immediate, they drop the matching notes scheduled before them, which would
+// otherwise be played after them without ever being released.
+void SamplerUnit::receiveCmds(UInt64 sampleTime) {
     SamplerCmd cmd;
-    while (_cmdQueue.try_dequeue(cmd)) {
-        switch (cmd.op) {
-            case SAMPLER_PLAY_NOTE_CMD:
-                playNoteCmd(cmd.p1, cmd.p2, cmd.multiInstrument, cmd.channel);
-                break;
-            case SAMPLER_RELEASE_NOTE_CMD:
-                releaseNoteCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_STOP_NOTE_CMD:
-                stopNoteCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_RELEASE_ALL_NOTES_CMD:
-                releaseAllNotesCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_STOP_ALL_NOTES_PITCH_CMD:
-                stopAllNotesPitchCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_STOP_ALL_NOTES_CMD:
-                stopAllNotesCmd(cmd.channel);
-                break;
-            case SAMPLER_SET_SUSTAIN_STATE_CMD:
-                setSustainStateCmd(cmd.p1 == 1.0f, cmd.channel);
-                break;
-            case SAMPLER_SET_PITCH_BEND_CMD:
-                setPitchBendCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_SET_MODULATION_CMD:
-                setModulationCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_IS_NOTE_PLAYING_CMD:
-                isNotePlayingCmd(cmd.channel);
-                break;
-            case SAMPLER_IS_NOTE_PLAYING_PITCH_CMD:
-                isNotePlayingPitchCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_CLEAR_VOICES_CMD:
-                clearVoicesCmd(cmd.channel);
-                break;
-            case SAMPLER_CLEAR_ALL_VOICES_CMD:
-                clearAllVoicesCmd();
-                break;
-            case SAMPLER_IS_MULTI_INSTRUMENT_IN_USE_CMD:
-                isMultiInstrumentInUseCmd(cmd.multiInstrument);
-                break;
-            case SAMPLER_SET_LEVEL_CMD:
-                setLevelCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_SET_BALANCE_CMD:
-                setBalanceCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_SET_REVERB_CMD:
-                setReverbCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_SET_CHORUS_CMD:
-                setChorusCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_SET_EXPRESSION_CMD:
-                setExpressionCmd(cmd.p1, cmd.channel);
-                break;
-            case SAMPLER_SET_PITCH_BEND_FACTOR_CMD:
-                setPitchBendFactorCmd(cmd.p1, cmd.channel);
+    while (_heldCmds.size() < SAMPLER_MAX_HELD_CMDS && _cmdQueue.try_dequeue(cmd)) {
+        if (cmd.sampleTime == 0) {
+            size_t nbKeptCmds = 0;
+            for (size_t i = 0; i < _heldCmds.size(); ++i) {
+                if (isCancellingCmd(cmd, _heldCmds[i])) {
+                    _graveyard.bury(_heldCmds[i].multiInstrument);
+                } else {
+                    if (nbKeptCmds != i) _heldCmds[nbKeptCmds] = std::move(_heldCmds[i]);
+                    ++nbKeptCmds;
+                }
+            }
+            _heldCmds.erase(_heldCmds.begin() + nbKeptCmds, _heldCmds.end());
+        }
+        if (cmd.sampleTime < sampleTime) cmd.sampleTime = sampleTime;
+        auto it = _heldCmds.end();
+        while (it != _heldCmds.begin() && (it - 1)->sampleTime > cmd.sampleTime) --it;
+        _heldCmds.insert(it, std::move(cmd));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Commands are executed at the frame given by their sample time, in order of reception when due at the same frame.
+// The rendering is split at the command boundaries within the block.
+int SamplerUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride) {
+    UInt64 sampleTime = _sampleTime;
+
+    // We update the relation between the render clock and the sample time. When rendered outside of the live stream
+    // (offline), the sample time is unrelated to the clock and the relation is established again at the next start.
+    if (isRunning()) {
+        std::chrono::duration<double> now = std::chrono::high_resolution_clock::now().time_since_epoch();
+        double origin = now.count() - (double)sampleTime / _sampleRate;
+        double previousOrigin = _sampleTimeOrigin;
+        _sampleTimeOrigin = (previousOrigin == 0.0) ? origin : previousOrigin + 0.05 * (origin - previousOrigin);
+    } else {
+        _sampleTimeOrigin = 0.0;
+    }
+
+    GraphSampleType* outA = (GraphSampleType*)ioData[0];
+    GraphSampleType* outB = (GraphSampleType*)ioData[1];
+
+    _graveyard.retry();
+    receiveCmds(sampleTime);
+
+    size_t cmdIndex = 0;
+    UInt32 frameIndex = 0;
+    while (frameIndex < inNumberFrames) {
+        UInt32 nbFrames = std::min(inNumberFrames - frameIndex, _framesPerBuffer);
+
+        // We execute the commands that are due
+        while (cmdIndex < _heldCmds.size()) {
+            SamplerCmd& cmd = _heldCmds[cmdIndex];
+            if (cmd.sampleTime > sampleTime) {
+                if (cmd.sampleTime - sampleTime < nbFrames) nbFrames = (UInt32)(cmd.sampleTime - sampleTime);
                 break;
+            }
+            processCmd(cmd);
+            _graveyard.bury(cmd.multiInstrument);
+            ++cmdIndex;
         }
+
+        renderFrames(nbFrames, outA + frameIndex * stride, outB + frameIndex * stride, stride);
+
+        frameIndex += nbFrames;
+        sampleTime += nbFrames;
     }
 
+    // The executed commands no longer hold any reference
+    _heldCmds.erase(_heldCmds.begin(), _heldCmds.begin() + cmdIndex);
+    _nbHeldCmds = (UInt32)_heldCmds.size();
+
+    _sampleTime = sampleTime;
+
+    publishVoiceStates();
+
+    // The streams are refilled while the next block is waited for
+    if (_streamer) _streamer->update();
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Publish the notes currently on and the number of playing voices so that they can be queried from any thread
+void SamplerUnit::publishVoiceStates() {
+    UInt32 notesOnBits[SAMPLER_MAX_CHANNELS][SAMPLER_NOTES_BITS_WORDS] = {};
+    UInt32 nbPlayingVoices = 0;
+
+    for (int i = 0; i < _nbVoices; i++) {
+        struct Voice* voice = &_context.voices[i];
+        if (voice->isPlaying) ++nbPlayingVoices;
+        if (voice->isNoteOn) {
+            int pitch = std::min(std::max((int)voice->pitch, 0), 127);
+            notesOnBits[voice->channel][pitch >> 5] |= 1U << (pitch & 31);
+        }
+    }
+
+    for (int channel = 0; channel < SAMPLER_MAX_CHANNELS; channel++)
+        for (int word = 0; word < SAMPLER_NOTES_BITS_WORDS; word++)
+            _notesOnBits[channel][word].store(notesOnBits[channel][word], std::memory_order_relaxed);
+
+    _nbPlayingVoices.store(nbPlayingVoices, std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Render the active voices of a channel into its own buffers. Channels are independent, so they can be rendered by the
+// worker pool in any order.
+void SamplerUnit::renderChannel(UInt32 channelIndex) {
     struct SamplerContext* context = &_context;
 
-    // LFO
+    UInt32 inNumberFrames = _renderNbFrames;
+    Float32 lfoPitch = _renderLFOPitch;
+    const double crossFadeRate = 1.0 / (SAMPLER_CROSS_FADE_DURATION * _sampleRate);
 
-    context->lfoPhase += context->lfoFrequency * (Float32)(inNumberFrames) / GRAPH_SAMPLE_RATE;
-    if (context->lfoPhase > 1.0f) context->lfoPhase = 0.0f;
-    Float32 lfoPitch =
-        ((context->lfoPhase < 0.5f) ? (context->lfoPhase * 2.0f) : (1.0f - (context->lfoPhase - 0.5f) * 2.0f));
+    // Scratch buffers of the channel allocated by setFormat()
+    GraphSampleType* channelBuffers = &_channelBuffers[channelIndex * SAMPLER_NB_CHANNEL_BUFFERS * _framesPerBuffer];
+    GraphSampleType* channelBufA = channelBuffers;
+    GraphSampleType* channelBufB = channelBuffers + _framesPerBuffer;
+    GraphSampleType* bufA = channelBuffers + 2 * _framesPerBuffer;
+    GraphSampleType* bufB = channelBuffers + 3 * _framesPerBuffer;
 
-    GraphSampleType reverbBufA[4096];
-    GraphSampleType reverbBufB[4096];
+    context->nbReleasedVoices[channelIndex] = 0;
 
-    GraphSampleType chorusBufA[4096];
-    GraphSampleType chorusBufB[4096];
+    UInt32* activeVoices = context->activeVoices[channelIndex];
 
     for (UInt32 i = 0; i < inNumberFrames; ++i) {
-        reverbBufA[i] = 0;
-        reverbBufB[i] = 0;
-        chorusBufA[i] = 0;
-        chorusBufB[i] = 0;
+        channelBufA[i] = 0;
+        channelBufB[i] = 0;
     }
 
-    GraphSampleType* outA = (GraphSampleType*)ioData[0];
-    GraphSampleType* outB = (GraphSampleType*)ioData[1];
+    // For each active voice of the channel
+    for (UInt32 activeVoiceIndex = 0; activeVoiceIndex < context->nbActiveVoices[channelIndex]; ++activeVoiceIndex) {
+        UInt32 voiceIndex = activeVoices[activeVoiceIndex];
+        struct Voice* voice = &context->voices[voiceIndex];
+
+        if (voice->isPlaying) {
+            UInt64 rate =
+                SAMPLER_RATE_FOR_PITCH(
+                    voice->instrumentBasePitch,
+                    voice->pitch +
+                        context->pitchBendValues[voice->channel] * context->pitchBendFactors[voice->channel] +
+                        context->modulationValues[voice->channel] * 0.5f * (lfoPitch - 0.5f)) *
+                (voice->instrumentSampleRate / _sampleRate) * ((UInt64)1 << VOICE_FRACTION_BITS);
+
+            // We calculate the balance
+            Float32 mixerBalance = context->balance[voice->channel];  // between -1.0 and 1.0
+            Float32 volumeA, volumeB;
+            if (mixerBalance < 0.0f) {
+                volumeA = 1.0f;
+                volumeB = mixerBalance + 1.0f;
+            } else {
+                volumeA = 1.0f - mixerBalance;
+                volumeB = 1.0f;
+            }
 
-    // For each channel
-    for (UInt32 channelIndex = 0; channelIndex < SAMPLER_MAX_CHANNELS; ++channelIndex) {
-        GraphSampleType channelBufA[4096];
-        GraphSampleType channelBufB[4096];
+            float level = context->level[voice->channel] * context->expressionValues[voice->channel];
 
-        for (UInt32 i = 0; i < inNumberFrames; ++i) {
-            channelBufA[i] = 0;
-            channelBufB[i] = 0;
-        }
+            volumeA *= level;
+            volumeB *= level;
 
-        // For each voice
-        for (UInt32 voiceIndex = 0; voiceIndex < context->nbVoices; ++voiceIndex) {
-            struct Voice* voice = &context->voices[voiceIndex];
+            Float32 crossFadeFactor = context->crossFadeFactors[voiceIndex];
 
-            // If the voice is not for the current channel, continue
-            if (voice->channel != channelIndex) continue;
+            struct Voice* oldVoice = &context->oldVoices[voiceIndex];
 
-            assert(inNumberFrames <= 4096);
+            // We render the current voice
+            renderVoiceBlock(voice, rate, bufA, inNumberFrames);
 
-            GraphSampleType bufA[4096];
-            GraphSampleType bufB[4096];
+            // Render the old voice if still active
+            UInt32 nbCrossFadeFrames = 0;
+            if (crossFadeFactor < 1.0f) {
+                for (Float32 f = crossFadeFactor; f < 1.0f && nbCrossFadeFrames < inNumberFrames; f += crossFadeRate)
+                    ++nbCrossFadeFrames;
 
-            if (voice->isPlaying) {
-                UInt64 rate =
+                UInt64 oldRate =
                     SAMPLER_RATE_FOR_PITCH(
-                        voice->instrumentBasePitch,
-                        voice->pitch +
-                            context->pitchBendValues[voice->channel] * context->pitchBendFactors[voice->channel] +
-                            context->modulationValues[voice->channel] * 0.5f * (lfoPitch - 0.5f)) *
-                    (voice->instrumentSampleRate / GRAPH_SAMPLE_RATE) * ((UInt64)1 << VOICE_FRACTION_BITS);
-
-                // We calculate the balance
-                Float32 mixerBalance = context->balance[voice->channel];  // between -1.0 and 1.0
-                Float32 volumeA, volumeB;
-                if (mixerBalance < 0.0f) {
-                    volumeA = 1.0f;
-                    volumeB = mixerBalance + 1.0f;
-                } else {
-                    volumeA = 1.0f - mixerBalance;
-                    volumeB = 1.0f;
-                }
+                        oldVoice->instrumentBasePitch,
+                        oldVoice->pitch + context->pitchBendValues[oldVoice->channel] +
+                            context->modulationValues[oldVoice->channel] * 0.5f * (lfoPitch - 0.5f)) *
+                    (voice->instrumentSampleRate / _sampleRate) * ((UInt64)1 << VOICE_FRACTION_BITS);
+                renderVoiceBlock(oldVoice, oldRate, bufB, nbCrossFadeFrames);
+            }
 
-                float level = context->level[voice->channel] * context->expressionValues[voice->channel];
+            for (UInt32 i = 0; i < nbCrossFadeFrames; ++i) {
+                GraphSampleType sA, sB, sOldA, sOldB;
 
-                volumeA *= level;
-                volumeB *= level;
+                sA = bufA[i] * voice->volumeA;
+                sB = bufA[i] * voice->volumeB;
+                sOldA = bufB[i] * oldVoice->volumeA;
+                sOldB = bufB[i] * oldVoice->volumeB;
 
-                Float32 crossFadeFactor = context->crossFadeFactors[voiceIndex];
+                // We mix the old voice with the new one
+                sA = crossFadeFactor * sA + (1.0f - crossFadeFactor) * sOldA;
+                sB = crossFadeFactor * sB + (1.0f - crossFadeFactor) * sOldB;
 
-                struct Voice* oldVoice = &context->oldVoices[voiceIndex];
+                crossFadeFactor += crossFadeRate;
 
-                for (UInt32 i = 0; i < inNumberFrames; ++i) {
-                    GraphSampleType sA, sB;
+                bufA[i] = sA * volumeA;
+                bufB[i] = sB * volumeB;
+            }
+
+            for (UInt32 i = nbCrossFadeFrames; i < inNumberFrames; ++i) {
+                GraphSampleType s = bufA[i];
+                bufA[i] = s * voice->volumeA * volumeA;
+                bufB[i] = s * voice->volumeB * volumeB;
+            }
+
+            context->crossFadeFactors[voiceIndex] = crossFadeFactor;
+
+        } else {
+            for (UInt32 i = 0; i < inNumberFrames; ++i) {
+                bufA[i] = 0;
+                bufB[i] = 0;
+            }
+        }
 
-                    // We render the current voice
-                    renderVoice(voice, rate, &sA);
-                    sB = sA;
-                    sA *= voice->volumeA;
-                    sB *= voice->volumeB;
+        //
+        // Apply a low-pass filter
+        //
 
-                    // Render the old voice if still active
-                    if (crossFadeFactor < 1.0f) {
-                        UInt64 oldRate =
-                            SAMPLER_RATE_FOR_PITCH(
-                                oldVoice->instrumentBasePitch,
-                                oldVoice->pitch + context->pitchBendValues[oldVoice->channel] +
-                                    context->modulationValues[oldVoice->channel] * 0.5f * (lfoPitch - 0.5f)) *
-                            (voice->instrumentSampleRate / GRAPH_SAMPLE_RATE) * ((UInt64)1 << VOICE_FRACTION_BITS);
-                        GraphSampleType sOldA, sOldB;
-                        renderVoice(oldVoice, oldRate, &sOldA);
-                        sOldB = sOldA;
-                        sOldA *= oldVoice->volumeA;
-                        sOldB *= oldVoice->volumeB;
+        Float32 filterFc = voice->filterFc;
 
-                        // We mix the old voice with the new one
-                        sA = crossFadeFactor * sA + (1.0f - crossFadeFactor) * sOldA;
-                        sB = crossFadeFactor * sB + (1.0f - crossFadeFactor) * sOldB;
+        Dsp::Params params;
+        params[0] = _sampleRate;     // Sample rate
+        params[1] = filterFc;        // Cut-off frequency
+        params[2] = voice->filterQ;  // Q
 
-                        crossFadeFactor += SAMPLER_CROSS_FADE_RATE;
-                    }
+        context->lowPassFilters[voiceIndex]->setParams(params);
+        float* o[2] = {bufA, bufB};
+        context->lowPassFilters[voiceIndex]->process(inNumberFrames, o);
 
-                    sA *= volumeA;
-                    sB *= volumeB;
+        //
+        // Calculate the maximum output and perform the mix
+        //
 
-                    bufA[i] = sA;
-                    bufB[i] = sB;
+        GraphSampleType maxOutput = 0;
 
-                }  // for each sample
+        for (UInt32 i = 0; i < inNumberFrames; ++i) {
+            GraphSampleType sA, sB;
+            sA = bufA[i];
+            sB = bufB[i];
 
-                context->crossFadeFactors[voiceIndex] = crossFadeFactor;
+            GraphSampleType sum = fabs(sA) + fabs(sB);
 
-            } else {
-                for (UInt32 i = 0; i < inNumberFrames; ++i) {
-                    bufA[i] = 0;
-                    bufB[i] = 0;
-                }
+            if (sum > maxOutput) {
+                maxOutput = sum;
             }
 
-            //
-            // Apply a low-pass filter
-            //
+            channelBufA[i] += sA;
+            channelBufB[i] += sB;
 
-            Float32 filterFc = voice->filterFc;
+        }  // for each sample
 
-            Dsp::Params params;
-            params[0] = GRAPH_SAMPLE_RATE;  // Sample rate
-            params[1] = filterFc;           // Cut-off frequency
-            params[2] = voice->filterQ;     // Q
+        voice->maxOutput = 0.9f * voice->maxOutput + 0.1f * maxOutput;
 
-            context->lowPassFilters[voiceIndex]->setParams(params);
-            float* o[2] = {bufA, bufB};
-            context->lowPassFilters[voiceIndex]->process(inNumberFrames, o);
+    }  // for each active voice
 
-            //
-            // Calculate the maximum output and perform the mix
-            //
+    //
+    // Remove the voices that are no longer playing
+    //
 
-            GraphSampleType maxOutput = 0;
+    UInt32 nbActiveVoices = 0;
+    for (UInt32 activeVoiceIndex = 0; activeVoiceIndex < context->nbActiveVoices[channelIndex]; ++activeVoiceIndex) {
+        UInt32 voiceIndex = activeVoices[activeVoiceIndex];
+        struct Voice* voice = &context->voices[voiceIndex];
 
-            for (UInt32 i = 0; i < inNumberFrames; ++i) {
-                GraphSampleType sA, sB;
-                sA = bufA[i];
-                sB = bufB[i];
+        // A stolen voice without a new note is done once faded to silence
+        if (voice->isPlaying && voice->data == nullptr && context->crossFadeFactors[voiceIndex] >= 1.0f)
+            voice->isPlaying = false;
 
-                GraphSampleType sum = fabs(sA) + fabs(sB);
+        if (voice->isPlaying) {
+            activeVoices[nbActiveVoices++] = voiceIndex;
+        } else {
+            // The instruments are released once back on the rendering thread
+            context->isVoiceActive[voiceIndex] = false;
+            context->releasedVoices[channelIndex][context->nbReleasedVoices[channelIndex]++] = voiceIndex;
+        }
+    }
+    context->nbActiveVoices[channelIndex] = nbActiveVoices;
+}
 
-                if (sum > maxOutput) {
-                    maxOutput = sum;
-                }
+// ---------------------------------------------------------------------------------------------------------------------
+void SamplerUnit::renderChannelTask(void* context, UInt32 taskIndex) {
+    SamplerUnit* samplerUnit = static_cast<SamplerUnit*>(context);
+    samplerUnit->renderChannel(samplerUnit->_renderChannels[taskIndex]);
+}
 
-                channelBufA[i] += sA;
-                channelBufB[i] += sB;
+// ---------------------------------------------------------------------------------------------------------------------
+void SamplerUnit::renderFrames(UInt32 inNumberFrames, GraphSampleType* outA, GraphSampleType* outB, UInt32 stride) {
+    struct SamplerContext* context = &_context;
 
-            }  // for each sample
+    // LFO
 
-            voice->maxOutput = 0.9f * voice->maxOutput + 0.1f * maxOutput;
+    context->lfoPhase += context->lfoFrequency * (Float32)(inNumberFrames) / _sampleRate;
+    if (context->lfoPhase > 1.0f) context->lfoPhase = 0.0f;
+    Float32 lfoPitch =
+        ((context->lfoPhase < 0.5f) ? (context->lfoPhase * 2.0f) : (1.0f - (context->lfoPhase - 0.5f) * 2.0f));
 
-        }  // for each voice
+    // Scratch buffers allocated by setFormat()
+    GraphSampleType* reverbBufA = &_renderBuffers[0 * _framesPerBuffer];
+    GraphSampleType* reverbBufB = &_renderBuffers[1 * _framesPerBuffer];
+    GraphSampleType* reverb2BufA = &_renderBuffers[2 * _framesPerBuffer];
+    GraphSampleType* reverb2BufB = &_renderBuffers[3 * _framesPerBuffer];
+    GraphSampleType* chorusBufA = &_renderBuffers[4 * _framesPerBuffer];
+    GraphSampleType* chorusBufB = &_renderBuffers[5 * _framesPerBuffer];
 
-        //
-        // Mix the channel buffer with the output
-        //
+    assert(inNumberFrames <= _framesPerBuffer);
+
+    for (UInt32 i = 0; i < inNumberFrames; ++i) {
+        reverbBufA[i] = 0;
+        reverbBufB[i] = 0;
+        chorusBufA[i] = 0;
+        chorusBufB[i] = 0;
+    }
+
+    //
+    // Render the channels that are not silent, in parallel if we have workers
+    //
+
+    _renderNbFrames = inNumberFrames;
+    _renderLFOPitch = lfoPitch;
+
+    _nbRenderChannels = 0;
+    for (UInt32 channelIndex = 0; channelIndex < SAMPLER_MAX_CHANNELS; ++channelIndex)
+        if (context->nbActiveVoices[channelIndex] > 0) _renderChannels[_nbRenderChannels++] = channelIndex;
+
+    if (_workerPool && _nbRenderChannels > 1) {
+        _workerPool->execute(renderChannelTask, this, _nbRenderChannels);
+    } else {
+        for (UInt32 i = 0; i < _nbRenderChannels; ++i) renderChannel(_renderChannels[i]);
+    }
+
+    //
+    // Mix the channel buffers with the sends and the output, always in the same order
+    //
+
+    for (UInt32 renderChannelIndex = 0; renderChannelIndex < _nbRenderChannels; ++renderChannelIndex) {
+        UInt32 channelIndex = _renderChannels[renderChannelIndex];
+
+        GraphSampleType* channelBufA = &_channelBuffers[channelIndex * SAMPLER_NB_CHANNEL_BUFFERS * _framesPerBuffer];
+        GraphSampleType* channelBufB = channelBufA + _framesPerBuffer;
+
+        // Release the instruments of the voices that are no longer playing
+        for (UInt32 i = 0; i < context->nbReleasedVoices[channelIndex]; ++i) {
+            UInt32 voiceIndex = context->releasedVoices[channelIndex][i];
+            setVoiceInstrument(&context->voices[voiceIndex], nullptr);
+            setVoiceInstrument(&context->oldVoices[voiceIndex], nullptr);
+        }
 
         UInt32 outIndex = 0;
         for (UInt32 i = 0; i < inNumberFrames; ++i) {
@@ -483,9 +930,6 @@ int SamplerUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2],
     // Apply the reverberation
     //
 
-    GraphSampleType reverb2BufA[4096];
-    GraphSampleType reverb2BufB[4096];
-
     for (UInt32 i = 0; i < inNumberFrames; ++i) {
         reverb2BufA[i] = 0;
         reverb2BufB[i] = 0;
@@ -503,13 +947,27 @@ int SamplerUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2],
         outB[outIndex] += reverb2BufB[i] + chorusBufB[i];
         outIndex += stride;
     }
-    return 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-SamplerUnit::SamplerUnit(UInt32 nbVoices) : _cmdQueue(1024), _cmdOutQueue(1024) {
-    // Initialize the filters
-    for (int i = 0; i < SAMPLER_MAX_VOICES; ++i) _context.lowPassFilters[i] = nullptr;
+SamplerUnit::SamplerUnit(UInt32 nbVoices) : _cmdQueue(1024) {
+    _sampleTime = 0;
+    _sampleTimeOrigin = 0.0;
+
+    _heldCmds.reserve(SAMPLER_MAX_HELD_CMDS);
+    _nbHeldCmds = 0;
+
+    for (int channel = 0; channel < SAMPLER_MAX_CHANNELS; channel++)
+        for (int word = 0; word < SAMPLER_NOTES_BITS_WORDS; word++) _notesOnBits[channel][word] = 0;
+    _nbPlayingVoices = 0;
+    _nbStolenVoices = 0;
+
+    // Initialize the filters and the streams
+    for (int i = 0; i < SAMPLER_MAX_VOICES; ++i) {
+        _context.lowPassFilters[i] = nullptr;
+        _context.voices[i].stream = nullptr;
+        _context.oldVoices[i].stream = nullptr;
+    }
 
     _nbVoices = 0;
 
@@ -546,6 +1004,8 @@ SamplerUnit::SamplerUnit(UInt32 nbVoices) : _cmdQueue(1024), _cmdOutQueue(1024)
 
     _context.chorusModel.setWet(1.0f);
 
+    SamplerUnit::setFormat(_sampleRate, _framesPerBuffer);
+
     // We initialize the global tables if necessary
 
     calculateResamplerCoefficients();
@@ -564,6 +1024,54 @@ SamplerUnit::SamplerUnit(UInt32 nbVoices) : _cmdQueue(1024), _cmdOutQueue(1024)
     _currentNotesGroupID = 0;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+void SamplerUnit::setFormat(Float64 sampleRate, UInt32 framesPerBuffer) {
+    Unit::setFormat(sampleRate, framesPerBuffer);
+
+    _renderBuffers.assign(SAMPLER_NB_RENDER_BUFFERS * framesPerBuffer, 0.0f);
+    _channelBuffers.assign(SAMPLER_MAX_CHANNELS * SAMPLER_NB_CHANNEL_BUFFERS * framesPerBuffer, 0.0f);
+
+    _context.reverbModel.setSampleRate(sampleRate);
+    _context.chorusModel.setSampleRate(sampleRate);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void SamplerUnit::setNbRenderWorkers(UInt32 nbRenderWorkers) {
+    if (nbRenderWorkers == this->nbRenderWorkers()) return;
+
+    _workerPool.reset();
+    if (nbRenderWorkers > 0) _workerPool = std::unique_ptr<AudioWorkerPool>(new AudioWorkerPool(nbRenderWorkers));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void SamplerUnit::setIsStreaming(bool isStreaming) {
+    if (isStreaming == this->isStreaming()) return;
+
+    if (isStreaming) {
+        _streamer = std::unique_ptr<SampleStreamer>(new SampleStreamer(2 * SAMPLER_MAX_VOICES));
+        return;
+    }
+
+    // The voices release their streams before the streamer is destroyed
+    setNbVoices(_nbVoices);
+    _streamer.reset();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+UInt64 SamplerUnit::sampleTimeForTimestamp(double timestamp) {
+    double origin = _sampleTimeOrigin;
+
+    // If nothing has been rendered yet, the command is executed as soon as possible
+    if (origin == 0.0) return 0;
+
+    double sampleTime = (timestamp - origin) * _sampleRate + SAMPLER_SCHEDULING_LATENCY_FRAMES;
+    if (sampleTime <= 0.0) return 0;
+
+    // We never hold the queue for more than a few blocks
+    UInt64 maxSampleTime = _sampleTime + 4 * SAMPLER_SCHEDULING_LATENCY_FRAMES;
+    return std::min((UInt64)sampleTime, maxSampleTime);
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 SamplerUnit::~SamplerUnit() {
     for (int i = 0; i < _nbVoices; ++i) {
@@ -575,12 +1083,18 @@ SamplerUnit::~SamplerUnit() {
 void SamplerUnit::setNbVoices(UInt32 nbVoices) {
     if (nbVoices > SAMPLER_MAX_VOICES) nbVoices = SAMPLER_MAX_VOICES;
 
-    // Free the filters if already allocated
-    for (int voiceIndex = 0; voiceIndex < _nbVoices; ++voiceIndex)
+    // Free the filters if already allocated and release the streams
+    for (int voiceIndex = 0; voiceIndex < _nbVoices; ++voiceIndex) {
         if (_context.lowPassFilters[voiceIndex]) delete _context.lowPassFilters[voiceIndex];
+        releaseVoiceStream(&_context.voices[voiceIndex]);
+        releaseVoiceStream(&_context.oldVoices[voiceIndex]);
+    }
 
     _nbVoices = nbVoices;
     _context.nbVoices = nbVoices;
+
+    for (int channelIndex = 0; channelIndex < SAMPLER_MAX_CHANNELS; ++channelIndex)
+        _context.nbActiveVoices[channelIndex] = 0;
     _context.lfoPhase = 0.0f;
     _context.lfoFrequency = 4.0f;
 
@@ -588,39 +1102,107 @@ void SamplerUnit::setNbVoices(UInt32 nbVoices) {
     for (int voiceIndex = 0; voiceIndex < _nbVoices; voiceIndex++) {
         _context.lowPassFilters[voiceIndex] = new Dsp::FilterDesign<Dsp::RBJ::Design::LowPass, 2>();
         _context.voices[voiceIndex].isPlaying = NO;
+        _context.voices[voiceIndex].isNoteOn = NO;
+        _context.voices[voiceIndex].channel = 0;
         _context.voices[voiceIndex].data = NULL;
+        _context.voices[voiceIndex].dataFormat = SAMPLE_FORMAT_FLOAT32;
+        _context.voices[voiceIndex].dataGain = 1.0f;
         _context.voices[voiceIndex].filterFc = 8000.0f;
         _context.voices[voiceIndex].filterQ = 1.0f;
         _context.oldVoices[voiceIndex].isPlaying = NO;
+        _context.oldVoices[voiceIndex].isNoteOn = NO;
+        _context.oldVoices[voiceIndex].channel = 0;
         _context.oldVoices[voiceIndex].data = NULL;
+        _context.oldVoices[voiceIndex].dataFormat = SAMPLE_FORMAT_FLOAT32;
+        _context.oldVoices[voiceIndex].dataGain = 1.0f;
         _context.oldVoices[voiceIndex].filterFc = 8000.0f;
         _context.oldVoices[voiceIndex].filterQ = 1.0f;
         _context.crossFadeFactors[voiceIndex] = 1.0f;
+        _context.isVoiceActive[voiceIndex] = false;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Add the voice to the active voices of the given channel
+void SamplerUnit::activateVoice(UInt32 voiceIndex, UInt32 channel) {
+    if (_context.isVoiceActive[voiceIndex]) {
+        if (_context.voices[voiceIndex].channel == channel) return;
+        deactivateVoice(voiceIndex);
+    } else {
+        // The voice was idle, so we clear the remaining state of the filter
+        _context.lowPassFilters[voiceIndex]->reset();
+    }
+
+    _context.activeVoices[channel][_context.nbActiveVoices[channel]++] = voiceIndex;
+    _context.isVoiceActive[voiceIndex] = true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Remove the voice from the active voices of its channel
+void SamplerUnit::deactivateVoice(UInt32 voiceIndex) {
+    if (!_context.isVoiceActive[voiceIndex]) return;
+
+    UInt32 channel = _context.voices[voiceIndex].channel;
+    UInt32* activeVoices = _context.activeVoices[channel];
+    UInt32 nbActiveVoices = _context.nbActiveVoices[channel];
+
+    for (UInt32 i = 0; i < nbActiveVoices; ++i) {
+        if (activeVoices[i] == voiceIndex) {
+            activeVoices[i] = activeVoices[nbActiveVoices - 1];
+            _context.nbActiveVoices[channel] = nbActiveVoices - 1;
+            break;
+        }
+    }
+
+    _context.isVoiceActive[voiceIndex] = false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Set the instrument of a voice while keeping the voice references of the instruments up to date.
+// The previous instrument is buried so that it is never destroyed by the audio thread. The stream of the voice, if
+// any, is released.
+void SamplerUnit::setVoiceInstrument(struct Voice* voice, const std::shared_ptr<Instrument>& instrument) {
+    releaseVoiceStream(voice);
+    if (voice->instrument == instrument) return;
+    if (instrument) instrument->addVoiceReference();
+    if (voice->instrument) {
+        voice->instrument->removeVoiceReference();
+        _graveyard.bury(voice->instrument);
     }
+    voice->instrument = instrument;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<MultiInstrument> multiInstrument,
+void SamplerUnit::releaseVoiceStream(struct Voice* voice) {
+    if (!voice->stream) return;
+    _streamer->release(voice->stream);
+    voice->stream = nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, const std::shared_ptr<MultiInstrument>& multiInstrument,
                               UInt32 channel) {
     // If we have no current instrument, we return right away
     if (!multiInstrument) return;
 
-    // We get an instruments based on the desired pitch and velocity
-    std::vector<std::shared_ptr<Instrument>> instruments = multiInstrument->instruments(pitch, velocity);
-
     // All voices can initially be stolen
     for (int i = 0; i < _nbVoices; i++) {
         struct Voice* voice = &_context.voices[i];
         voice->isLocked = NO;
     }
 
+    // We get the instruments based on the desired pitch and velocity
+    int nbInstruments = 0;
     int nbFoundVoices = 0;
     std::vector<std::shared_ptr<Instrument>>::iterator it;
-    for (it = instruments.begin(); it != instruments.end(); it++) {
-        std::shared_ptr<Instrument> instrument = (*it);
+    for (it = multiInstrument->instrumentsBegin(); it != multiInstrument->instrumentsEnd(); it++) {
+        const std::shared_ptr<Instrument>& instrument = (*it);
+
+        if (!MultiInstrument::isInstrumentInRange(instrument.get(), pitch, velocity)) continue;
+        ++nbInstruments;
 
         // We check if the instrument is available
-        if (!instrument || (instrument->sample() && instrument->sample()->data() == NULL)) continue;
+        if (!instrument || !instrument->sample() || !instrument->sample()->isLoaded()) continue;
 
         // Clamp the velocity
         if (velocity < 0.0f) {
@@ -629,6 +1211,13 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
             velocity = 1.0f;
         }
 
+        // A streamed sample needs a stream, otherwise the note is cancelled
+        SampleStream* stream = nullptr;
+        if (instrument->sample()->isStreamed()) {
+            stream = _streamer ? _streamer->acquire(instrument->sample()) : nullptr;
+            if (!stream) continue;
+        }
+
         // We find a voice
         bool voiceFound = false;
 
@@ -674,8 +1263,12 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
                         oldVoice->instrumentBasePitch = v->instrumentBasePitch;
                         oldVoice->instrumentSampleRate = v->instrumentSampleRate;
 
-                        oldVoice->instrument = v->instrument;
+                        setVoiceInstrument(oldVoice, v->instrument);
+                        oldVoice->stream = v->stream;
+                        v->stream = nullptr;
                         oldVoice->data = v->data;
+                        oldVoice->dataFormat = v->dataFormat;
+                        oldVoice->dataGain = v->dataGain;
                         oldVoice->length = v->length;
                         oldVoice->loopStart = v->loopStart;
                         oldVoice->loopEnd = v->loopEnd;
@@ -703,6 +1296,7 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
                         // Fade to silence
                         v->isPlaying = true;
                         v->data = nullptr;
+                        _nbStolenVoices.fetch_add(1, std::memory_order_relaxed);
 
                         _context.crossFadeFactors[i] = 0.0f;  // We start with the old voice
 
@@ -718,13 +1312,17 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
             // We lock this voice in order to ensure that it will not be stolen again
             voice->isLocked = true;
 
+            activateVoice((UInt32)(voice - _context.voices), channel);
             voice->channel = channel;
 
             voice->instrumentBasePitch = instrument->basePitch();
             voice->instrumentSampleRate = instrument->sample()->sampleRate();
 
-            voice->instrument = instrument;
-            voice->data = instrument->sample()->data();
+            setVoiceInstrument(voice, instrument);
+            voice->stream = stream;
+            voice->data = instrument->sample()->rawData();
+            voice->dataFormat = instrument->sample()->format();
+            voice->dataGain = instrument->sample()->gain();
             voice->length = instrument->sample()->length() * ((UInt64)1 << VOICE_FRACTION_BITS);
             voice->loopStart = instrument->loopStart() * ((UInt64)1 << VOICE_FRACTION_BITS);
             voice->loopEnd = instrument->loopEnd() * ((UInt64)1 << VOICE_FRACTION_BITS);
@@ -733,7 +1331,7 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
             voice->isNoteOn = true;
             voice->isPlaying = true;
             voice->volEnvFactor = 1.0f;  // Note: The attack phase is not yet implemented
-            voice->volEnvHoldCounter = instrument->holdTime() * GRAPH_SAMPLE_RATE;
+            voice->volEnvHoldCounter = instrument->holdTime() * _sampleRate;
             voice->pitch = pitch;
             voice->velocity = exp2f(velocity) - 1.0f;
             voice->isNoteSustained = _sustainValues[channel] >= 0.5f;
@@ -773,13 +1371,13 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
             voice->volumeB = volumeB;
 
             // Pre-calculate the decay rate per sample
-            voice->decayRatePerSample = 1.0f / (instrument->decayRate() * GRAPH_SAMPLE_RATE);
+            voice->decayRatePerSample = 1.0f / (instrument->decayRate() * _sampleRate);
 
             // Sustain level
             voice->sustainLevel = instrument->sustainLevel();
 
             // Pre-calculate the release rate per sample
-            voice->releaseRatePerSample = 1.0f / (instrument->releaseRate() * GRAPH_SAMPLE_RATE);
+            voice->releaseRatePerSample = 1.0f / (instrument->releaseRate() * _sampleRate);
 
             // Filter
             voice->filterFc = instrument->filterFc() <= 20000.0f ? instrument->filterFc() : 20000.0f;
@@ -789,11 +1387,13 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
             voice->notesGroupID = _currentNotesGroupID;
 
             ++nbFoundVoices;
+        } else if (stream) {
+            _streamer->release(stream);
         }  // if a voice is available
     }      // for each instrument
 
     // If we did not reach our target, we cancel
-    if (nbFoundVoices != instruments.size()) {
+    if (nbFoundVoices != nbInstruments) {
         for (int i = 0; i < _nbVoices; i++) {
             Voice* voice = &_context.voices[i];
             if (voice->notesGroupID == _currentNotesGroupID) {
@@ -807,8 +1407,8 @@ void SamplerUnit::playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<M
 
 // ---------------------------------------------------------------------------------------------------------------------
 void SamplerUnit::playNote(Float32 pitch, Float32 velocity, std::shared_ptr<MultiInstrument> multiInstrument,
-                           UInt32 channel) {
-    SamplerCmd cmd = {SAMPLER_PLAY_NOTE_CMD, pitch, velocity, channel, multiInstrument};
+                           UInt32 channel, UInt64 sampleTime) {
+    SamplerCmd cmd = {SAMPLER_PLAY_NOTE_CMD, pitch, velocity, channel, multiInstrument, sampleTime};
     _cmdQueue.enqueue(cmd);
 }
 
@@ -822,8 +1422,8 @@ void SamplerUnit::releaseNoteCmd(Float32 pitch, UInt32 channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::releaseNote(Float32 pitch, UInt32 channel) {
-    SamplerCmd cmd = {SAMPLER_RELEASE_NOTE_CMD, pitch, 0, channel, nullptr};
+void SamplerUnit::releaseNote(Float32 pitch, UInt32 channel, UInt64 sampleTime) {
+    SamplerCmd cmd = {SAMPLER_RELEASE_NOTE_CMD, pitch, 0, channel, nullptr, sampleTime};
     _cmdQueue.enqueue(cmd);
 }
 
@@ -900,10 +1500,10 @@ void SamplerUnit::setSustainStateCmd(bool state, UInt32 channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::setSustain(Float32 sustain, UInt32 channel) {
+void SamplerUnit::setSustain(Float32 sustain, UInt32 channel, UInt64 sampleTime) {
     _sustainValues[channel] = sustain;
 
-    SamplerCmd cmd = {SAMPLER_SET_SUSTAIN_STATE_CMD, sustain >= 0.5f ? 1.0f : 0.0f, 0, channel, nullptr};
+    SamplerCmd cmd = {SAMPLER_SET_SUSTAIN_STATE_CMD, sustain >= 0.5f ? 1.0f : 0.0f, 0, channel, nullptr, sampleTime};
     _cmdQueue.enqueue(cmd);
 }
 
@@ -914,10 +1514,10 @@ Float32 SamplerUnit::sustain(UInt32 channel) { return _sustainValues[channel]; }
 void SamplerUnit::setPitchBendCmd(Float32 pitchBend, UInt32 channel) { _context.pitchBendValues[channel] = pitchBend; }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::setPitchBend(Float32 pitchBend, UInt32 channel) {
+void SamplerUnit::setPitchBend(Float32 pitchBend, UInt32 channel, UInt64 sampleTime) {
     _pitchBendValues[channel] = pitchBend;
 
-    SamplerCmd cmd = {SAMPLER_SET_PITCH_BEND_CMD, pitchBend, 0, channel, nullptr};
+    SamplerCmd cmd = {SAMPLER_SET_PITCH_BEND_CMD, pitchBend, 0, channel, nullptr, sampleTime};
     _cmdQueue.enqueue(cmd);
 }
 
@@ -930,75 +1530,38 @@ void SamplerUnit::setModulationCmd(Float32 modulation, UInt32 channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::setModulation(Float32 modulation, UInt32 channel) {
+void SamplerUnit::setModulation(Float32 modulation, UInt32 channel, UInt64 sampleTime) {
     _modulationValues[channel] = modulation;
 
-    SamplerCmd cmd = {SAMPLER_SET_MODULATION_CMD, modulation, 0, channel, nullptr};
+    SamplerCmd cmd = {SAMPLER_SET_MODULATION_CMD, modulation, 0, channel, nullptr, sampleTime};
     _cmdQueue.enqueue(cmd);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 Float32 SamplerUnit::modulation(UInt32 channel) { return _modulationValues[channel]; }
 
-// ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::isNotePlayingCmd(UInt32 channel) {
-    bool isPlaying = false;
-
-    for (int i = 0; i < _nbVoices; i++) {
-        if (_context.voices[i].channel == channel && _context.voices[i].isNoteOn) {
-            isPlaying = true;
-        }
-    }
-
-    SamplerCmd cmd = {SAMPLER_IS_NOTE_PLAYING_CMD, isPlaying ? 1.0f : 0.0f, 0, channel, nullptr};
-    _cmdOutQueue.enqueue(cmd);
-}
-
 // ---------------------------------------------------------------------------------------------------------------------
 bool SamplerUnit::isNotePlaying(UInt32 channel) {
-    SamplerCmd cmd = {SAMPLER_IS_NOTE_PLAYING_CMD, 0.0f, 0.0f, channel, nullptr};
-    _cmdQueue.enqueue(cmd);
-
-    while (!_cmdOutQueue.try_dequeue(cmd) && isRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    };
-
-    assert(cmd.op == SAMPLER_IS_NOTE_PLAYING_CMD);
-    return (cmd.p1 == 1.0f);
-}
-
-// ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::isNotePlayingPitchCmd(Float32 pitch, UInt32 channel) {
-    bool isPlaying = false;
-
-    for (int i = 0; i < _nbVoices; i++) {
-        if (_context.voices[i].channel == channel && _context.voices[i].isNoteOn && _context.voices[i].pitch == pitch) {
-            isPlaying = true;
-        }
-    }
-
-    SamplerCmd cmd = {SAMPLER_IS_NOTE_PLAYING_PITCH_CMD, isPlaying ? 1.0f : 0.0f, 0, channel, nullptr};
-    _cmdOutQueue.enqueue(cmd);
+    for (int word = 0; word < SAMPLER_NOTES_BITS_WORDS; word++)
+        if (_notesOnBits[channel][word].load(std::memory_order_relaxed) != 0) return true;
+    return false;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 bool SamplerUnit::isNotePlaying(Float32 pitch, UInt32 channel) {
-    SamplerCmd cmd = {SAMPLER_IS_NOTE_PLAYING_PITCH_CMD, pitch, 0.0f, channel, nullptr};
-    _cmdQueue.enqueue(cmd);
-
-    while (!_cmdOutQueue.try_dequeue(cmd) && isRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    };
-
-    assert(cmd.op == SAMPLER_IS_NOTE_PLAYING_PITCH_CMD);
-    return (cmd.p1 == 1.0f);
+    int p = std::min(std::max((int)pitch, 0), 127);
+    return (_notesOnBits[channel][p >> 5].load(std::memory_order_relaxed) & (1U << (p & 31))) != 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 void SamplerUnit::clearVoicesCmd(UInt32 channel) {
     for (int i = 0; i < _nbVoices; i++) {
         if (_context.voices[i].channel == channel) {
+            deactivateVoice(i);
+            setVoiceInstrument(&_context.voices[i], nullptr);
+            setVoiceInstrument(&_context.oldVoices[i], nullptr);
             _context.voices[i].isNoteOn = false;
+            _context.voices[i].isPlaying = false;
             _context.voices[i].data = NULL;
             _context.oldVoices[i].isNoteOn = false;
             _context.oldVoices[i].data = NULL;
@@ -1015,7 +1578,11 @@ void SamplerUnit::clearVoices(UInt32 channel) {
 // ---------------------------------------------------------------------------------------------------------------------
 void SamplerUnit::clearAllVoicesCmd() {
     for (int i = 0; i < _nbVoices; i++) {
+        deactivateVoice(i);
+        setVoiceInstrument(&_context.voices[i], nullptr);
+        setVoiceInstrument(&_context.oldVoices[i], nullptr);
         _context.voices[i].isNoteOn = false;
+        _context.voices[i].isPlaying = false;
         _context.voices[i].data = NULL;
         _context.oldVoices[i].isNoteOn = false;
         _context.oldVoices[i].data = NULL;
@@ -1029,37 +1596,12 @@ void SamplerUnit::clearAllVoices() {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void SamplerUnit::isMultiInstrumentInUseCmd(std::shared_ptr<MultiInstrument> multiInstrument) {
-    bool inUse = false;
-
+bool SamplerUnit::isMultiInstrumentInUse(std::shared_ptr<MultiInstrument> multiInstrument) {
     std::vector<std::shared_ptr<Instrument>>::iterator it;
     for (it = multiInstrument->instrumentsBegin(); it != multiInstrument->instrumentsEnd(); it++) {
-        std::shared_ptr<Instrument> instrument = (*it);
-        for (int voiceIndex = 0; voiceIndex < _nbVoices; voiceIndex++) {
-            if (instrument == _context.voices[voiceIndex].instrument ||
-                instrument == _context.oldVoices[voiceIndex].instrument) {
-                inUse = true;
-                break;
-            }
-        }
-        if (inUse) break;
+        if ((*it)->nbVoiceReferences() > 0) return true;
     }
-
-    SamplerCmd cmd = {SAMPLER_IS_MULTI_INSTRUMENT_IN_USE_CMD, inUse ? 1.0f : 0.0f, 0, 0, multiInstrument};
-    _cmdOutQueue.enqueue(cmd);
-}
-
-// ---------------------------------------------------------------------------------------------------------------------
-bool SamplerUnit::isMultiInstrumentInUse(std::shared_ptr<MultiInstrument> multiInstrument) {
-    SamplerCmd cmd = {SAMPLER_IS_MULTI_INSTRUMENT_IN_USE_CMD, 0.0f, 0.0f, 0, multiInstrument};
-    _cmdQueue.enqueue(cmd);
-
-    while (!_cmdOutQueue.try_dequeue(cmd) && isRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    };
-
-    assert(cmd.op == SAMPLER_IS_MULTI_INSTRUMENT_IN_USE_CMD);
-    return (cmd.p1 == 1.0f);
+    return false;
 }
 
 // Balance and Levels
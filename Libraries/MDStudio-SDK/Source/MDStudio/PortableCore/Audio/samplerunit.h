@@ -9,15 +9,20 @@
 #ifndef SAMPLERUNIT_H
 #define SAMPLERUNIT_H
 
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "Chorus/chorusmodel.h"
 #include "DspFilters/Filter.h"
 #include "DspFilters/RBJ.h"
 #include "Reverb/revmodel.h"
+#include "audioworkerpool.h"
+#include "graveyard.h"
 #include "multiinstrument.h"
 #include "readerwriterqueue.h"
+#include "samplestreamer.h"
 #include "types.h"
 #include "unit.h"
 #include "voice.h"
@@ -25,6 +30,15 @@
 #define SAMPLER_MAX_VOICES 64
 #define SAMPLER_MAX_CHANNELS 16
 
+// Number of 32-bit words holding one bit per pitch
+#define SAMPLER_NOTES_BITS_WORDS 4
+
+// Delay added to scheduled commands so that they are always received ahead of their sample time
+#define SAMPLER_SCHEDULING_LATENCY_FRAMES 512
+
+// Maximum number of received commands waiting for their sample time
+#define SAMPLER_MAX_HELD_CMDS 1024
+
 namespace MDStudio {
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -37,6 +51,12 @@ struct SamplerContext {
     ChorusModel chorusModel;
 
     Float32 crossFadeFactors[SAMPLER_MAX_VOICES];
+
+    UInt32 activeVoices[SAMPLER_MAX_CHANNELS][SAMPLER_MAX_VOICES];  // Indices of the active voices per channel
+    UInt32 nbActiveVoices[SAMPLER_MAX_CHANNELS];
+    UInt32 releasedVoices[SAMPLER_MAX_CHANNELS][SAMPLER_MAX_VOICES];  // Voices stopped during the last block
+    UInt32 nbReleasedVoices[SAMPLER_MAX_CHANNELS];
+    bool isVoiceActive[SAMPLER_MAX_VOICES];
     int baseMixerInput;
     UInt32 nbVoices;
 
@@ -60,6 +80,7 @@ struct SamplerCmd {
     Float32 p2;
     UInt32 channel;
     std::shared_ptr<MultiInstrument> multiInstrument;
+    UInt64 sampleTime = 0;  // Sample time at which the command is executed (0 = as soon as possible)
 };
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -79,9 +100,53 @@ class SamplerUnit : public Unit {
 
     unsigned int _currentNotesGroupID;
 
-    moodycamel::ReaderWriterQueue<SamplerCmd> _cmdQueue, _cmdOutQueue;
+    moodycamel::ReaderWriterQueue<SamplerCmd> _cmdQueue;
+
+    // Commands received by the audio thread, sorted by sample time
+    std::vector<SamplerCmd> _heldCmds;
+    std::atomic<UInt32> _nbHeldCmds;
+
+    // References released during rendering
+    Graveyard _graveyard;
+
+    // Streams of the voices playing streamed samples, created with its reader thread once streaming is enabled
+    std::unique_ptr<SampleStreamer> _streamer;
+
+    std::vector<GraphSampleType> _renderBuffers;
+    std::vector<GraphSampleType> _channelBuffers;
+
+    // Optional pool rendering the channels in parallel
+    std::unique_ptr<AudioWorkerPool> _workerPool;
+
+    // Block being rendered, shared with the workers
+    UInt32 _renderNbFrames;
+    Float32 _renderLFOPitch;
+    UInt32 _renderChannels[SAMPLER_MAX_CHANNELS];
+    UInt32 _nbRenderChannels;
+
+    // Voice states published at each block
+    std::atomic<UInt32> _notesOnBits[SAMPLER_MAX_CHANNELS][SAMPLER_NOTES_BITS_WORDS];
+    std::atomic<UInt32> _nbPlayingVoices;
+    std::atomic<UInt64> _nbStolenVoices;
 
-    void playNoteCmd(Float32 pitch, Float32 velocity, std::shared_ptr<MultiInstrument> multiInstrument, UInt32 channel);
+    std::atomic<UInt64> _sampleTime;        // Number of frames rendered so far
+    std::atomic<double> _sampleTimeOrigin;  // Timestamp of the sample time 0 (in seconds)
+
+    void processCmd(const SamplerCmd& cmd);
+    void receiveCmds(UInt64 sampleTime);
+    void renderFrames(UInt32 inNumberFrames, GraphSampleType* outA, GraphSampleType* outB, UInt32 stride);
+    void renderChannel(UInt32 channelIndex);
+    static void renderChannelTask(void* context, UInt32 taskIndex);
+    void publishVoiceStates();
+
+    void activateVoice(UInt32 voiceIndex, UInt32 channel);
+    void deactivateVoice(UInt32 voiceIndex);
+
+    void setVoiceInstrument(struct Voice* voice, const std::shared_ptr<Instrument>& instrument);
+    void releaseVoiceStream(struct Voice* voice);
+
+    void playNoteCmd(Float32 pitch, Float32 velocity, const std::shared_ptr<MultiInstrument>& multiInstrument,
+                     UInt32 channel);
     void releaseNoteCmd(Float32 pitch, UInt32 channel);
     void stopNoteCmd(Float32 pitch, UInt32 channel);
     void releaseAllNotesCmd(Float32 pitch, UInt32 channel);
@@ -90,11 +155,8 @@ class SamplerUnit : public Unit {
     void setSustainStateCmd(bool state, UInt32 channel);
     void setPitchBendCmd(Float32 pitchBend, UInt32 channel);
     void setModulationCmd(Float32 modulation, UInt32 channel);
-    void isNotePlayingCmd(UInt32 channel);
-    void isNotePlayingPitchCmd(Float32 pitch, UInt32 channel);
     void clearVoicesCmd(UInt32 channel);
     void clearAllVoicesCmd();
-    void isMultiInstrumentInUseCmd(std::shared_ptr<MultiInstrument> multiInstrument);
     void setLevelCmd(Float32 levelValue, UInt32 channel);
     void setBalanceCmd(Float32 balanceValue, UInt32 channel);
     void setReverbCmd(Float32 reverbValue, UInt32 channel);
@@ -108,33 +170,67 @@ class SamplerUnit : public Unit {
 
     void setNbVoices(UInt32 nbVoices);
 
+    void setFormat(Float64 sampleRate, UInt32 framesPerBuffer) override;
+
+    // Number of threads rendering the channels along with the audio thread (0 = single-threaded rendering).
+    // Must not be called while rendering.
+    void setNbRenderWorkers(UInt32 nbRenderWorkers);
+    UInt32 nbRenderWorkers() { return _workerPool ? _workerPool->nbWorkers() : 0; }
+
+    // Without streaming, the notes of streamed samples are cancelled. Disabling it stops all the voices.
+    // Must not be called while rendering.
+    void setIsStreaming(bool isStreaming);
+    bool isStreaming() { return _streamer != nullptr; }
+
     static void renderVoice(struct Voice* voice, UInt64 rate, GraphSampleType* out);
+    static void renderVoiceBlock(struct Voice* voice, UInt64 rate, GraphSampleType* out, UInt32 nbFrames);
     int renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride = 1) override;
 
-    void playNote(Float32 pitch, Float32 velocity, std::shared_ptr<MultiInstrument> multiInstrument, UInt32 channel);
-    void releaseNote(Float32 pitch, UInt32 channel);
+    // Sample time of the next frame to be rendered
+    UInt64 sampleTime() { return _sampleTime; }
+
+    // Returns the sample time at which a command sent for the given timestamp (in seconds on the high resolution
+    // clock) must be executed
+    UInt64 sampleTimeForTimestamp(double timestamp);
+
+    void playNote(Float32 pitch, Float32 velocity, std::shared_ptr<MultiInstrument> multiInstrument, UInt32 channel,
+                  UInt64 sampleTime = 0);
+    void releaseNote(Float32 pitch, UInt32 channel, UInt64 sampleTime = 0);
     void stopNote(Float32 pitch, UInt32 channel);
     void releaseAllNotes(Float32 pitch, UInt32 channel);
     void stopAllNotes(Float32 pitch, UInt32 channel);
     void stopAllNotes(UInt32 channel);
 
-    void setSustain(Float32 sustain, UInt32 channel);
+    void setSustain(Float32 sustain, UInt32 channel, UInt64 sampleTime = 0);
     Float32 sustain(UInt32 channel);
 
-    void setPitchBend(Float32 pitchBend, UInt32 channel);
+    void setPitchBend(Float32 pitchBend, UInt32 channel, UInt64 sampleTime = 0);
     Float32 pitchBend(UInt32 channel);
 
-    void setModulation(Float32 modulation, UInt32 channel);
+    void setModulation(Float32 modulation, UInt32 channel, UInt64 sampleTime = 0);
     Float32 modulation(UInt32 channel);
 
+    // Wait-free queries of the voice states published by the last rendered block. They are not ordered after the
+    // commands: a note sent with playNote() is reported only once a rendered block has executed it.
     bool isNotePlaying(UInt32 channel);
     bool isNotePlaying(Float32 pitch, UInt32 channel);
 
     void clearVoices(UInt32 channel);
     void clearAllVoices();
 
+    // Whether a voice references the instrument as of the last rendered block. A pending command is not reported, but
+    // it holds its own reference to the instrument until it is executed.
     bool isMultiInstrumentInUse(std::shared_ptr<MultiInstrument> multiInstrument);
 
+    // Wait-free statistics for monitoring
+    UInt32 nbPlayingVoices() { return _nbPlayingVoices; }
+    UInt64 nbStolenVoices() { return _nbStolenVoices; }
+    void resetNbStolenVoices() { _nbStolenVoices = 0; }
+    size_t nbPendingCmds() { return _cmdQueue.size_approx() + _nbHeldCmds; }
+
+    // Number of times a voice playing a streamed sample was silenced because its frames were not read in time
+    UInt64 nbStreamUnderruns() { return _streamer ? _streamer->nbUnderruns() : 0; }
+
     void setLevel(Float32 levelValue, UInt32 channel);
     Float32 level(UInt32 channel);
 
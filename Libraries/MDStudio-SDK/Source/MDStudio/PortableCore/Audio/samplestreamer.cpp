@@ -0,0 +1,129 @@
+//
+//  samplestreamer.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "samplestreamer.h"
+
+#include <algorithm>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+SampleStreamer::SampleStreamer(UInt32 nbStreams) : _nbActiveStreams(0), _nbStarvations(0) {
+    for (UInt32 i = 0; i < nbStreams; ++i) {
+        std::unique_ptr<SampleStream> stream(new SampleStream());
+        stream->state = SAMPLE_STREAM_FREE;
+        stream->nbUnderruns = 0;
+        stream->ring.resize(SAMPLE_STREAM_RING_FRAMES + SAMPLE_STREAM_GUARD_FRAMES, 0);
+        _streams.push_back(std::move(stream));
+    }
+
+    _isReaderThreadStopped = false;
+    _readerThread = std::thread(&SampleStreamer::readerThread, this);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+SampleStreamer::~SampleStreamer() {
+    _isReaderThreadStopped = true;
+    _semaphore.signal();
+    _readerThread.join();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+SampleStream* SampleStreamer::acquire(const std::shared_ptr<Sample>& sample) {
+    for (auto& s : _streams) {
+        SampleStream* stream = s.get();
+        if (stream->state.load(std::memory_order_acquire) != SAMPLE_STREAM_FREE) continue;
+
+        stream->sample = sample;
+        stream->source = sample->streamSource();
+        stream->length = (SInt32)sample->length();
+        stream->headEnd = (SInt32)sample->streamStart();
+        stream->loopStart = (SInt32)sample->streamEnd();
+        stream->endFrame = stream->loopStart + SAMPLE_STREAM_MARGIN;
+        stream->loopData = sample->loopData();
+        stream->loopDataStart = (SInt32)sample->loopDataStart();
+
+        SInt32 startFrame = stream->headEnd - SAMPLE_STREAM_MARGIN;
+        stream->writeFrame.store(startFrame, std::memory_order_relaxed);
+        stream->readFrame.store(startFrame, std::memory_order_relaxed);
+
+        stream->state.store(SAMPLE_STREAM_ACTIVE, std::memory_order_release);
+        ++_nbActiveStreams;
+        _semaphore.signal();
+        return stream;
+    }
+
+    _nbStarvations.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The stream is freed by the reader thread, which drops the reference to the sample
+void SampleStreamer::release(SampleStream* stream) {
+    stream->state.store(SAMPLE_STREAM_RELEASED, std::memory_order_release);
+    --_nbActiveStreams;
+    _semaphore.signal();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+UInt64 SampleStreamer::nbUnderruns() {
+    UInt64 nbUnderruns = _nbStarvations.load(std::memory_order_relaxed);
+    for (auto& stream : _streams) nbUnderruns += stream->nbUnderruns.load(std::memory_order_relaxed);
+    return nbUnderruns;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Fills the ring up to the frames still needed by the voice. The frames past the end of the sample are zeros.
+void SampleStreamer::readStream(SampleStream* stream) {
+    const SInt32 mask = SAMPLE_STREAM_RING_FRAMES - 1;
+    SInt16* ring = stream->ring.data();
+
+    SInt32 writeFrame = stream->writeFrame.load(std::memory_order_relaxed);
+    SInt32 readFrame = stream->readFrame.load(std::memory_order_acquire);
+
+    // After an underrun, the frames already passed by the voice are skipped
+    if (writeFrame < readFrame) writeFrame = readFrame;
+
+    SInt32 endFrame = std::min(stream->endFrame, readFrame + SAMPLE_STREAM_RING_FRAMES);
+
+    while (writeFrame < endFrame) {
+        SInt32 index = writeFrame & mask;
+        SInt32 nbFrames = std::min(endFrame - writeFrame, SAMPLE_STREAM_RING_FRAMES - index);
+
+        SInt32 nbSourceFrames = std::max(std::min(nbFrames, stream->length - writeFrame), 0);
+        std::copy(stream->source + writeFrame, stream->source + writeFrame + nbSourceFrames, ring + index);
+        std::fill(ring + index + nbSourceFrames, ring + index + nbFrames, 0);
+
+        // The resampling kernel reads past the end of the ring into the copy of its first frames
+        if (index < SAMPLE_STREAM_GUARD_FRAMES)
+            std::copy(ring + index, ring + std::min(index + nbFrames, SAMPLE_STREAM_GUARD_FRAMES),
+                      ring + SAMPLE_STREAM_RING_FRAMES + index);
+
+        writeFrame += nbFrames;
+        stream->writeFrame.store(writeFrame, std::memory_order_release);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Reader thread, woken up by the audio thread
+void SampleStreamer::readerThread() {
+    while (!_isReaderThreadStopped) {
+        _semaphore.wait();
+
+        for (auto& s : _streams) {
+            SampleStream* stream = s.get();
+            int state = stream->state.load(std::memory_order_acquire);
+            if (state == SAMPLE_STREAM_ACTIVE) {
+                readStream(stream);
+            } else if (state == SAMPLE_STREAM_RELEASED) {
+                stream->sample = nullptr;
+                stream->state.store(SAMPLE_STREAM_FREE, std::memory_order_release);
+            }
+        }
+    }
+}
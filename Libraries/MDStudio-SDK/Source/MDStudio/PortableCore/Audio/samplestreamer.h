@@ -0,0 +1,100 @@
+//
+//  samplestreamer.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef SAMPLESTREAMER_H
+#define SAMPLESTREAMER_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "atomicops.h"
+#include "sample.h"
+#include "types.h"
+
+#define SAMPLE_STREAM_RING_FRAMES 8192  // Frames read ahead of a voice (power of two)
+#define SAMPLE_STREAM_GUARD_FRAMES 16   // Copy of the first frames of the ring after its end
+#define SAMPLE_STREAM_MARGIN 8          // Frames read around the position of a voice by the resampling kernel
+
+#define SAMPLE_STREAM_FREE 0
+#define SAMPLE_STREAM_ACTIVE 1
+#define SAMPLE_STREAM_RELEASED 2
+
+// Regions of a streamed sample
+#define SAMPLE_STREAM_REGION_HEAD 0
+#define SAMPLE_STREAM_REGION_RING 1
+#define SAMPLE_STREAM_REGION_LOOP 2
+
+namespace MDStudio {
+
+// Sample data streamed from the disk for a voice. The voice reads the head and the loop of the sample from memory
+// and the frames between them from the ring, filled ahead of the voice by the reader thread.
+struct SampleStream {
+    std::atomic<int> state;
+
+    std::shared_ptr<Sample> sample;  // Dropped by the reader thread once released
+    const SInt16* source;
+    SInt32 length;
+    SInt32 headEnd;        // First frame read from the ring
+    SInt32 loopStart;      // First frame read from the loop data
+    SInt32 endFrame;       // Frame following the last frame read into the ring
+    const SInt16* loopData;
+    SInt32 loopDataStart;  // Frame of the first element of the loop data
+
+    std::atomic<SInt32> writeFrame;  // The frames below are in the ring
+    std::atomic<SInt32> readFrame;   // The frames below are no longer needed by the voice
+    std::atomic<UInt32> nbUnderruns;
+
+    std::vector<SInt16> ring;
+
+    int region(SInt32 frame) const {
+        if (frame < headEnd) return SAMPLE_STREAM_REGION_HEAD;
+        return frame >= loopStart ? SAMPLE_STREAM_REGION_LOOP : SAMPLE_STREAM_REGION_RING;
+    }
+
+    // Returns true if the ring holds the frames read for the positions up to the given frame
+    bool isAvailable(SInt32 frame) const {
+        return writeFrame.load(std::memory_order_acquire) >= frame + SAMPLE_STREAM_MARGIN;
+    }
+};
+
+// Pool of streams filled by a reader thread. The streams are acquired and released by the audio thread without
+// locking or allocating.
+class SampleStreamer {
+    std::vector<std::unique_ptr<SampleStream>> _streams;
+    UInt32 _nbActiveStreams;
+    std::atomic<UInt32> _nbStarvations;
+
+    std::thread _readerThread;
+    std::atomic<bool> _isReaderThreadStopped;
+    moodycamel::spsc_sema::LightweightSemaphore _semaphore;
+
+    void readerThread();
+    void readStream(SampleStream* stream);
+
+   public:
+    SampleStreamer(UInt32 nbStreams);
+    ~SampleStreamer();
+
+    // Returns nullptr if all the streams are in use (called from the audio thread only)
+    SampleStream* acquire(const std::shared_ptr<Sample>& sample);
+    void release(SampleStream* stream);
+
+    // Wakes up the reader thread after a block if any stream is active (called from the audio thread only)
+    void update() {
+        if (_nbActiveStreams > 0) _semaphore.signal();
+    }
+
+    // Number of times a voice was silenced because its data was not read in time or no stream was available
+    UInt64 nbUnderruns();
+};
+
+}  // namespace MDStudio
+
+#endif  // SAMPLESTREAMER_H
@@ -11,88 +11,73 @@
 using namespace MDStudio;
 
 // ---------------------------------------------------------------------------------------------------------------------
-static std::vector<Event> mergeEvents(const std::vector<Event>& newEvents, const std::vector<Event>& events) {
+static void addMergedEvent(Track* mergedTrack, const Track& track, const Event& event, UInt32 deltaTickCount) {
+    Event eventToAdd = event;
+    eventToAdd.tickCount = deltaTickCount;
+
+    // The payload is copied to the merged track
+    if (event.dataOffset != EVENT_NO_DATA)
+        eventToAdd.dataOffset = mergedTrack->addEventData(track.data(event), track.dataLength(event));
+
+    mergedTrack->events.push_back(eventToAdd);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static Track mergeTracks(const Track& newTrack, const Track& track) {
     UInt32 tickCount;
 
     //
-    // First, we convert parameters to absolute timings
+    // First, we convert the events to absolute timings
     //
 
-    std::vector<Event> absNewEvents;
-    std::vector<Event> absEvents;
+    std::vector<UInt32> absNewTickCounts;
+    std::vector<UInt32> absTickCounts;
 
     tickCount = 0;
-    for (auto event : newEvents) {
+    for (auto& event : newTrack.events) {
         tickCount += event.tickCount;
-
-        Event absNewEvent;
-        absNewEvent.type = event.type;
-        absNewEvent.channel = event.channel;
-        absNewEvent.tickCount = tickCount;
-        absNewEvent.param1 = event.param1;
-        absNewEvent.param2 = event.param2;
-        absNewEvents.push_back(absNewEvent);
+        absNewTickCounts.push_back(tickCount);
     }
 
     tickCount = 0;
-    for (auto event : events) {
+    for (auto& event : track.events) {
         tickCount += event.tickCount;
-
-        Event absEvent;
-        absEvent.type = event.type;
-        absEvent.channel = event.channel;
-        absEvent.tickCount = tickCount;
-        absEvent.param1 = event.param1;
-        absEvent.param2 = event.param2;
-        absEvents.push_back(absEvent);
+        absTickCounts.push_back(tickCount);
     }
 
     //
     // We now perform the merge
     //
 
-    std::vector<Event> retEvents;
+    Track retTrack;
+    retTrack.events.reserve(newTrack.events.size() + track.events.size());
 
     std::size_t eventIndex = 0, newEventIndex = 0;
 
-    Event eventToAdd;
-
     tickCount = 0;
     while (1) {
-        Event* event = (eventIndex < events.size()) ? &absEvents[eventIndex] : nullptr;
-        Event* newEvent = (newEventIndex < newEvents.size()) ? &absNewEvents[newEventIndex] : nullptr;
+        bool hasEvent = eventIndex < track.events.size();
+        bool hasNewEvent = newEventIndex < newTrack.events.size();
 
         // If we have no more events, we stop
-        if ((event == nullptr) && (newEvent == nullptr)) break;
+        if (!hasEvent && !hasNewEvent) break;
 
-        UInt32 eventDeltaTickCount = event ? (event->tickCount - tickCount) : 0xFFFFFFFF;
-        UInt32 newEventDeltaTickCount = newEvent ? (newEvent->tickCount - tickCount) : 0xFFFFFFFF;
+        UInt32 eventDeltaTickCount = hasEvent ? (absTickCounts[eventIndex] - tickCount) : 0xFFFFFFFF;
+        UInt32 newEventDeltaTickCount = hasNewEvent ? (absNewTickCounts[newEventIndex] - tickCount) : 0xFFFFFFFF;
 
         // We pick the earliest event
-        if (eventDeltaTickCount < newEventDeltaTickCount) {
-            eventToAdd.type = event->type;
-            eventToAdd.channel = event->channel;
-            eventToAdd.tickCount = eventDeltaTickCount;
-            eventToAdd.param1 = event->param1;
-            eventToAdd.param2 = event->param2;
-            retEvents.push_back(eventToAdd);
+        if (!hasNewEvent || (hasEvent && eventDeltaTickCount < newEventDeltaTickCount)) {
+            addMergedEvent(&retTrack, track, track.events[eventIndex], eventDeltaTickCount);
             eventIndex++;
             tickCount += eventDeltaTickCount;
         } else {
-            if (newEvent) {
-                eventToAdd.type = newEvent->type;
-                eventToAdd.channel = newEvent->channel;
-                eventToAdd.tickCount = newEventDeltaTickCount;
-                eventToAdd.param1 = newEvent->param1;
-                eventToAdd.param2 = newEvent->param2;
-                retEvents.push_back(eventToAdd);
-                newEventIndex++;
-                tickCount += newEventDeltaTickCount;
-            }
+            addMergedEvent(&retTrack, newTrack, newTrack.events[newEventIndex], newEventDeltaTickCount);
+            newEventIndex++;
+            tickCount += newEventDeltaTickCount;
         }
     }
 
-    return retEvents;
+    return retTrack;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -104,7 +89,7 @@ void MDStudio::convertSequenceToSingleTrack(std::shared_ptr<MDStudio::Sequence>
 
     size_t nbTracks = sequence->data.tracks.size();
     for (size_t trackIndex = 0; trackIndex < nbTracks; ++trackIndex) {
-        track.events = mergeEvents(sequence->data.tracks[trackIndex].events, track.events);
+        track = mergeTracks(sequence->data.tracks[trackIndex], track);
     }
 
     //
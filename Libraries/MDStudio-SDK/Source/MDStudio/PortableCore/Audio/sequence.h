@@ -9,6 +9,8 @@
 #ifndef SEQUENCE_H
 #define SEQUENCE_H
 
+#include <string.h>
+
 #include <functional>
 #include <memory>
 #include <string>
@@ -32,11 +34,37 @@ struct Track {
 
     std::vector<struct Event> events;
 
+    // Payloads of the events, each one preceded by its length
+    std::vector<UInt8> eventData;
+
     void addEvent(Event event) {
         events.push_back(event);
         if (_didAddEventFn) _didAddEventFn(this, &event);
     }
 
+    // Stores a payload and returns its offset in the event data
+    UInt32 addEventData(const UInt8* data, UInt32 length) {
+        UInt32 offset = static_cast<UInt32>(eventData.size());
+        eventData.resize(offset + sizeof(length) + length);
+        memcpy(eventData.data() + offset, &length, sizeof(length));
+        if (length > 0) memcpy(eventData.data() + offset + sizeof(length), data, length);
+        return offset;
+    }
+    UInt32 addEventData(const std::vector<UInt8>& data) {
+        return addEventData(data.data(), static_cast<UInt32>(data.size()));
+    }
+
+    // Payload of an event (nullptr if none)
+    const UInt8* data(const Event& event) const {
+        return (event.dataOffset != EVENT_NO_DATA) ? eventData.data() + event.dataOffset + sizeof(UInt32) : nullptr;
+    }
+    UInt32 dataLength(const Event& event) const {
+        if (event.dataOffset == EVENT_NO_DATA) return 0;
+        UInt32 length;
+        memcpy(&length, &eventData[event.dataOffset], sizeof(length));
+        return length;
+    }
+
     Track() {
         _didAddEventFn = nullptr;
         channel = SEQUENCE_TRACK_MULTI_CHANNEL;
@@ -31,8 +31,100 @@
     IMPLEMENT_ADD_NOTIFICATION(_name_, _variable_) \
     IMPLEMENT_REMOVE_NOTIFICATION(_name_, _variable_)
 
+// Channel states restored when seeking: program, mixer level, mixer balance, sustain, pitch bend, modulation and the
+// value of each controller
+#define SEQUENCER_SEEK_NB_CHANNEL_STATES (6 + 128)
+#define SEQUENCER_SEEK_NB_STATES (STUDIO_MAX_CHANNELS * SEQUENCER_SEEK_NB_CHANNEL_STATES)
+
+#define SEQUENCER_SEEK_NO_STATE -1          // The event does not change any state while seeking
+#define SEQUENCER_SEEK_SEQUENTIAL_STATE -2  // The event depends on the previous ones and is always replayed
+#define SEQUENCER_SEEK_NO_EVENT 0xFFFFFFFF
+
 using namespace MDStudio;
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the channel state set by the event when seeking
+static int seekState(const Event& event, UInt8 channel) {
+    int state;
+
+    switch (event.type) {
+        case EVENT_TYPE_PROGRAM_CHANGE:
+            state = 0;
+            break;
+        case EVENT_TYPE_MIXER_LEVEL_CHANGE:
+            state = 1;
+            break;
+        case EVENT_TYPE_MIXER_BALANCE_CHANGE:
+            state = 2;
+            break;
+        case EVENT_TYPE_SUSTAIN:
+            state = 3;
+            break;
+        case EVENT_TYPE_PITCH_BEND:
+            state = 4;
+            break;
+        case EVENT_TYPE_MODULATION:
+            state = 5;
+            break;
+        case EVENT_TYPE_CONTROL_CHANGE:
+            switch (event.param1) {
+                // The data entries apply to the last selected parameter
+                case STUDIO_CONTROL_DATA_ENTRY_MSB:
+                case STUDIO_CONTROL_DATA_ENTRY_LSB:
+                case STUDIO_CONTROL_NON_REG_PARAM_NUM_LSB:
+                case STUDIO_CONTROL_NON_REG_PARAM_NUM_MSB:
+                case STUDIO_CONTROL_REG_PARAM_NUM_LSB:
+                case STUDIO_CONTROL_REG_PARAM_NUM_MSB:
+                    return SEQUENCER_SEEK_SEQUENTIAL_STATE;
+            }
+            if (event.param1 < 0 || event.param1 > 127) return SEQUENCER_SEEK_SEQUENTIAL_STATE;
+            state = 6 + event.param1;
+            break;
+        case EVENT_TYPE_SYSTEM_EXCLUSIVE:
+            return SEQUENCER_SEEK_SEQUENTIAL_STATE;
+        default:
+            // Notes, aftertouches and meta events
+            return SEQUENCER_SEEK_NO_STATE;
+    }
+
+    if (channel >= STUDIO_MAX_CHANNELS) return SEQUENCER_SEEK_SEQUENTIAL_STATE;
+
+    return channel * SEQUENCER_SEEK_NB_CHANNEL_STATES + state;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the instrument selected by a program change event
+static int instrumentForEvent(const Event& event) {
+    if (event.channel == 9) return STUDIO_INSTRUMENT_GM_STANDARD_DRUM_KIT;
+
+    int instrument = STUDIO_INSTRUMENT_GM_PIANO;
+    if (event.param2 == -1) {
+        // Compatibility conversion
+        if (event.param1 >= 128) {
+            instrument = STUDIO_INSTRUMENT_FROM_PRESET(0, event.param1 - 128);
+        } else {
+            switch (event.param1) {
+                case 1:  // STUDIO_INSTRUMENT_PIANO
+                    instrument = STUDIO_INSTRUMENT_GM_PIANO;
+                    break;
+                case 2:  // STUDIO_INSTRUMENT_HARPSICHORD
+                    instrument = STUDIO_INSTRUMENT_GM_HARPSICHORD;
+                    break;
+                case 3:  // STUDIO_INSTRUMENT_BASS
+                    instrument = STUDIO_INSTRUMENT_GM_BASS;
+                    break;
+                case 4:  // STUDIO_INSTRUMENT_STRINGS
+                    instrument = STUDIO_INSTRUMENT_GM_STRINGS;
+                    break;
+            }
+        }
+    } else {
+        instrument = event.param1;
+    }
+
+    return instrument;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 Sequencer::Sequencer(void* owner, Studio* studio) : _owner(owner), _studio(studio) {
     _isPlaying = false;
@@ -40,6 +132,7 @@ Sequencer::Sequencer(void* owner, Studio* studio) : _owner(owner), _studio(studi
     _isPaused = false;
     _soloTrackIndex = -1;
     _isLastNoteOffDetected = false;
+    _sysExData.reserve(SEQUENCER_SYSEX_BUFFER_SIZE);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -75,19 +168,21 @@ bool Sequencer::processMetaEvent(const Event& event) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Sequencer::processEvent(const Event& event, bool ignoreNotes, bool isPreloadingOnly,
-                             bool* isLoadingInstrumentInBackground) {
+void Sequencer::processEvent(const Track& track, const Event& event, bool ignoreNotes, bool isPreloadingOnly,
+                             bool* isLoadingInstrumentInBackground, UInt64 sampleTime) {
     // We play the event
     switch (event.type) {
         case EVENT_TYPE_NOTE_ON:
             if (!ignoreNotes)
                 _studio->playNote(STUDIO_SOURCE_SEQUENCER, event.param1,
-                                  (event.param2 < 0) ? 1.0f : (Float32)event.param2 / 127.0f, event.channel);
+                                  (event.param2 < 0) ? 1.0f : (Float32)event.param2 / 127.0f, event.channel,
+                                  sampleTime);
             break;
         case EVENT_TYPE_NOTE_OFF:
             if (!ignoreNotes)
                 _studio->releaseNote(STUDIO_SOURCE_SEQUENCER, event.param1,
-                                     (event.param2 < 0) ? 1.0f : (Float32)event.param2 / 127.0f, event.channel);
+                                     (event.param2 < 0) ? 1.0f : (Float32)event.param2 / 127.0f, event.channel,
+                                     sampleTime);
             break;
         case EVENT_TYPE_KEY_AFTERTOUCH:
             if (!ignoreNotes)
@@ -99,37 +194,12 @@ void Sequencer::processEvent(const Event& event, bool ignoreNotes, bool isPreloa
                 _studio->channelAftertouch(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel);
             break;
         case EVENT_TYPE_SUSTAIN:
-            _studio->setSustain(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel);
+            _studio->setSustain(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel, sampleTime);
+            break;
+        case EVENT_TYPE_PROGRAM_CHANGE:
+            _studio->setInstrument(STUDIO_SOURCE_SEQUENCER, instrumentForEvent(event), event.channel, isPreloadingOnly,
+                                   isLoadingInstrumentInBackground);
             break;
-        case EVENT_TYPE_PROGRAM_CHANGE: {
-            int instrument = STUDIO_INSTRUMENT_GM_PIANO;
-            if (event.param2 == -1) {
-                // Compatibility conversion
-                if (event.param1 >= 128) {
-                    instrument = STUDIO_INSTRUMENT_FROM_PRESET(0, event.param1 - 128);
-                } else {
-                    switch (event.param1) {
-                        case 1:  // STUDIO_INSTRUMENT_PIANO
-                            instrument = STUDIO_INSTRUMENT_GM_PIANO;
-                            break;
-                        case 2:  // STUDIO_INSTRUMENT_HARPSICHORD
-                            instrument = STUDIO_INSTRUMENT_GM_HARPSICHORD;
-                            break;
-                        case 3:  // STUDIO_INSTRUMENT_BASS
-                            instrument = STUDIO_INSTRUMENT_GM_BASS;
-                            break;
-                        case 4:  // STUDIO_INSTRUMENT_STRINGS
-                            instrument = STUDIO_INSTRUMENT_GM_STRINGS;
-                            break;
-                    }
-                }
-            } else {
-                instrument = event.param1;
-            }
-            _studio->setInstrument(STUDIO_SOURCE_SEQUENCER,
-                                   (event.channel == 9) ? STUDIO_INSTRUMENT_GM_STANDARD_DRUM_KIT : instrument,
-                                   event.channel, isPreloadingOnly, isLoadingInstrumentInBackground);
-        } break;
         case EVENT_TYPE_MIXER_LEVEL_CHANGE:
             _studio->setMixerLevel(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / (event.param2 == 0 ? 127.0f : 100),
                                    event.channel);
@@ -146,17 +216,21 @@ void Sequencer::processEvent(const Event& event, bool ignoreNotes, bool isPreloa
             Float32 multiplier = event.param2 > 0 ? (Float32)event.param2 : 1.0f;
             _studio->setPitchBend(STUDIO_SOURCE_SEQUENCER,
                                   multiplier * (((Float32)event.param1 - 0.5f) * 2.0f / 16383.0f - 1.0f),
-                                  event.channel);
+                                  event.channel, sampleTime);
         } break;
         case EVENT_TYPE_MODULATION:
-            _studio->setModulation(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel);
+            _studio->setModulation(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel,
+                                   sampleTime);
             break;
         case EVENT_TYPE_CONTROL_CHANGE:
             _studio->setControlValue(STUDIO_SOURCE_SEQUENCER, event.param1, event.param2, event.channel);
             break;
-        case EVENT_TYPE_SYSTEM_EXCLUSIVE:
-            _studio->sendSystemExclusive(STUDIO_SOURCE_SEQUENCER, event.data, event.channel);
-            break;
+        case EVENT_TYPE_SYSTEM_EXCLUSIVE: {
+            // The buffer only grows for a payload larger than the reserved capacity
+            const UInt8* data = track.data(event);
+            _sysExData.assign(data, data + track.dataLength(event));
+            _studio->sendSystemExclusive(STUDIO_SOURCE_SEQUENCER, _sysExData, event.channel);
+        } break;
     }
 }
 
@@ -228,8 +302,9 @@ bool Sequencer::metronomeDidTick(Metronome* metronome) {
                     // Rechannelize the event unless this is a mult-channel track
                     if (track.channel != SEQUENCE_TRACK_MULTI_CHANNEL) event.channel = track.channel;
 
-                    // We process the event
-                    processEvent(event, isMuted);
+                    // We process the event at the exact sample time of its tick
+                    processEvent(track, event, isMuted, false, nullptr,
+                                 _studio->sampleTimeForTick(_playerTicks[trackIndex]));
                 }
 
                 // We go to the next event
@@ -268,16 +343,116 @@ bool Sequencer::metronomeDidTick(Metronome* metronome) {
     return ret;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// The index is built for the current content of the sequence and is rebuilt when the tracks are modified
+bool Sequencer::isSeekIndexValid() {
+    if (_seekIndex.size() != _sequence->data.tracks.size()) return false;
+
+    for (size_t trackIndex = 0; trackIndex < _seekIndex.size(); ++trackIndex) {
+        auto& track = _sequence->data.tracks[trackIndex];
+        if (_seekIndex[trackIndex].channel != track.channel ||
+            _seekIndex[trackIndex].ticks.size() != track.events.size())
+            return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Sequencer::buildSeekIndex() {
+    _seekIndex.clear();
+    _seekIndex.resize(_sequence->data.tracks.size());
+    _seekStateEvents.resize(SEQUENCER_SEEK_NB_STATES);
+
+    for (size_t trackIndex = 0; trackIndex < _sequence->data.tracks.size(); ++trackIndex) {
+        auto& track = _sequence->data.tracks[trackIndex];
+        auto& seekTrack = _seekIndex[trackIndex];
+
+        UInt32 nbEvents = static_cast<UInt32>(track.events.size());
+        seekTrack.channel = track.channel;
+        seekTrack.ticks.resize(nbEvents);
+        seekTrack.endOfTrackEventIndex = nbEvents;
+        seekTrack.checkpoints.reserve(nbEvents / SEQUENCER_SEEK_CHECKPOINT_INTERVAL + 1);
+
+        std::fill(_seekStateEvents.begin(), _seekStateEvents.end(), SEQUENCER_SEEK_NO_EVENT);
+
+        UInt32 tick = 0;
+        for (UInt32 eventIndex = 0; eventIndex <= nbEvents; ++eventIndex) {
+            // We take a snapshot of the states at each interval
+            if (eventIndex % SEQUENCER_SEEK_CHECKPOINT_INTERVAL == 0) {
+                seekTrack.checkpoints.emplace_back();
+                for (UInt16 state = 0; state < SEQUENCER_SEEK_NB_STATES; ++state)
+                    if (_seekStateEvents[state] != SEQUENCER_SEEK_NO_EVENT)
+                        seekTrack.checkpoints.back().push_back({state, _seekStateEvents[state]});
+            }
+
+            if (eventIndex == nbEvents) break;
+
+            auto& event = track.events[eventIndex];
+            tick += event.tickCount;
+            seekTrack.ticks[eventIndex] = tick;
+
+            if (event.type == EVENT_TYPE_META_END_OF_TRACK && seekTrack.endOfTrackEventIndex == nbEvents)
+                seekTrack.endOfTrackEventIndex = eventIndex;
+
+            // Rechannelize the event unless this is a mult-channel track
+            int state =
+                seekState(event, (track.channel != SEQUENCE_TRACK_MULTI_CHANNEL) ? track.channel : event.channel);
+            if (state == SEQUENCER_SEEK_SEQUENTIAL_STATE) {
+                seekTrack.sequentialEvents.push_back(eventIndex);
+            } else if (state != SEQUENCER_SEEK_NO_STATE) {
+                _seekStateEvents[state] = eventIndex;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Bring the studio to the state it would have after the given number of events of the track were played, replaying
+// only the last event setting each channel state
+void Sequencer::chaseEvents(size_t trackIndex, UInt32 nbEvents) {
+    auto& track = _sequence->data.tracks[trackIndex];
+    auto& seekTrack = _seekIndex[trackIndex];
+
+    // We start from the closest checkpoint
+    UInt32 checkpointIndex = nbEvents / SEQUENCER_SEEK_CHECKPOINT_INTERVAL;
+    std::fill(_seekStateEvents.begin(), _seekStateEvents.end(), SEQUENCER_SEEK_NO_EVENT);
+    for (auto& stateEvent : seekTrack.checkpoints[checkpointIndex])
+        _seekStateEvents[stateEvent.first] = stateEvent.second;
+
+    // We scan the remaining events
+    for (UInt32 eventIndex = checkpointIndex * SEQUENCER_SEEK_CHECKPOINT_INTERVAL; eventIndex < nbEvents;
+         ++eventIndex) {
+        auto& event = track.events[eventIndex];
+        int state = seekState(event, (track.channel != SEQUENCE_TRACK_MULTI_CHANNEL) ? track.channel : event.channel);
+        if (state >= 0) _seekStateEvents[state] = eventIndex;
+    }
+
+    // We replay the retained events in their original order
+    _seekChasedEvents.clear();
+    for (auto eventIndex : _seekStateEvents)
+        if (eventIndex != SEQUENCER_SEEK_NO_EVENT) _seekChasedEvents.push_back(eventIndex);
+    auto sequentialEventsEnd =
+        std::lower_bound(seekTrack.sequentialEvents.begin(), seekTrack.sequentialEvents.end(), nbEvents);
+    _seekChasedEvents.insert(_seekChasedEvents.end(), seekTrack.sequentialEvents.begin(), sequentialEventsEnd);
+    std::sort(_seekChasedEvents.begin(), _seekChasedEvents.end());
+
+    for (auto eventIndex : _seekChasedEvents) {
+        Event event = track.events[eventIndex];
+
+        // Rechannelize the event unless this is a mult-channel track
+        if (track.channel != SEQUENCE_TRACK_MULTI_CHANNEL) event.channel = track.channel;
+
+        processEvent(track, event, true);
+    }
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // This delegate is called when the metronome has moved to another specific tick value
 // We must re-calculate the player tick position and event index based on the new tick.
 // Special care must be taken in order to have a proper studio state.
 void Sequencer::metronomeDidMoveTick(Metronome* metronome) {
-    for (size_t i = 0; i < _sequence->data.tracks.size(); ++i) {
-        _playerTicks[i] = 0;
-        _playerEventIndices[i] = 0;
-        _playerEOTDetected[i] = false;
-    }
+    if (!isSeekIndexValid()) buildSeekIndex();
 
     // Make sure we do not send states to MIDI output
     bool wasMIDIOutputEnabled = _studio->isMIDIOutputEnabled();
@@ -287,38 +462,38 @@ void Sequencer::metronomeDidMoveTick(Metronome* metronome) {
     _studio->disableStateNotifications();
 
     // For each track
-    int trackIndex = 0;
-    for (auto track : _sequence->data.tracks) {
-        // For each event
-        for (auto event : track.events) {
-            // If an EOT was detected for this track, we skip it
-            if (_playerEOTDetected[trackIndex]) continue;
-
-            // We increase the tick
-            _playerTicks[trackIndex] += event.tickCount;
-
-            // If we reach the desired metronome tick, we break
-            if (_playerTicks[trackIndex] >= metronome->tick()) break;
-
-            // If the even is a meta event, we must process it in order to keep the sequencer in a proper state
-            if (event.type & 0xF0) {
-                // We process the meta event
-                if (!processMetaEvent(event)) {
-                    _playerEOTDetected[trackIndex] = true;
-                }
-            } else {
-                // We must process every non-note events
-
-                // Rechannelize the event unless this is a mult-channel track
-                if (track.channel != SEQUENCE_TRACK_MULTI_CHANNEL) event.channel = track.channel;
-
-                processEvent(event, true);
-            }
-
-            // We go to the next event unless we are at the last one
-            if (_playerEventIndices[trackIndex] < (track.events.size() - 1)) _playerEventIndices[trackIndex]++;
+    UInt32 tick = metronome->tick();
+    for (size_t trackIndex = 0; trackIndex < _sequence->data.tracks.size(); ++trackIndex) {
+        auto& seekTrack = _seekIndex[trackIndex];
+        UInt32 nbEvents = static_cast<UInt32>(seekTrack.ticks.size());
+
+        // Number of events before the desired metronome tick
+        UInt32 nbPrecedingEvents = static_cast<UInt32>(
+            std::lower_bound(seekTrack.ticks.begin(), seekTrack.ticks.end(), tick) - seekTrack.ticks.begin());
+
+        UInt32 nbChasedEvents;
+        if (seekTrack.endOfTrackEventIndex < nbPrecedingEvents) {
+            // The end of track is reached before the desired tick
+            nbChasedEvents = seekTrack.endOfTrackEventIndex + 1;
+            _playerTicks[trackIndex] = seekTrack.ticks[seekTrack.endOfTrackEventIndex];
+            _playerEventIndices[trackIndex] = std::min(nbChasedEvents, nbEvents - 1);
+            _playerEOTDetected[trackIndex] = true;
+        } else if (nbPrecedingEvents < nbEvents) {
+            // We stop on the first event at or after the desired tick
+            nbChasedEvents = nbPrecedingEvents;
+            _playerTicks[trackIndex] = seekTrack.ticks[nbPrecedingEvents];
+            _playerEventIndices[trackIndex] = nbPrecedingEvents;
+            _playerEOTDetected[trackIndex] = false;
+        } else {
+            // The whole track is before the desired tick, we stay on the last event
+            nbChasedEvents = nbEvents;
+            _playerTicks[trackIndex] = (nbEvents > 0) ? seekTrack.ticks[nbEvents - 1] : 0;
+            _playerEventIndices[trackIndex] = (nbEvents > 0) ? nbEvents - 1 : 0;
+            _playerEOTDetected[trackIndex] = false;
         }
-        ++trackIndex;
+
+        // We must process every non-note events in order to keep the studio in a proper state
+        chaseEvents(trackIndex, nbChasedEvents);
     }  // for each track
 
     programMetronome();
@@ -445,18 +620,22 @@ void Sequencer::resumePlayback() {
 
 // ---------------------------------------------------------------------------------------------------------------------
 void Sequencer::preloadInstruments(bool* isLoadingInstrumentInBackground) {
+    // We gather the instruments referenced by the sequence in their order of appearance
+    std::vector<int> instruments;
     for (auto& track : _sequence->data.tracks) {
-        auto rit = track.events.rbegin();
-        for (; rit != track.events.rend(); ++rit) {
-            auto event = *(rit);
+        for (auto event : track.events) {
             if (event.type == EVENT_TYPE_PROGRAM_CHANGE) {
                 // Rechannelize the event unless this is a mult-channel track
                 if (track.channel != SEQUENCE_TRACK_MULTI_CHANNEL) event.channel = track.channel;
 
-                processEvent(event, true, true, isLoadingInstrumentInBackground);
+                int instrument = instrumentForEvent(event);
+                if (std::find(instruments.begin(), instruments.end(), instrument) == instruments.end())
+                    instruments.push_back(instrument);
             }
         }
     }
+
+    _studio->preloadInstruments(instruments, isLoadingInstrumentInBackground);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -485,7 +664,7 @@ void Sequencer::programMetronome() {
     std::vector<std::pair<UInt32, unsigned int>> bpms;
     std::vector<std::pair<UInt32, std::pair<UInt32, UInt32>>> timeSignatures;
     UInt32 tick = 0;
-    for (auto event : _sequence->data.tracks[0].events) {
+    for (auto& event : _sequence->data.tracks[0].events) {
         tick += event.tickCount;
         if (event.type == EVENT_TYPE_META_SET_TEMPO) {
             bpms.push_back({tick, 60000000.0f / (float)(event.param1)});
@@ -520,7 +699,7 @@ void Sequencer::play() {
 
         // We initialize the player
         int trackIndex = 0;
-        for (auto track : _sequence->data.tracks) {
+        for (auto& track : _sequence->data.tracks) {
             _playerEventIndices[trackIndex] = 0;
             if (track.events.size() > 0) {
                 Event event = track.events[0];
@@ -739,11 +918,13 @@ void Sequencer::addEvent(int source, UInt8 type, Float64 timestamp, UInt32 tick,
             }
 
             if (isAdded) {
-                // We calculate the tick count delta for the event
-                event.tickCount = tick - _recordLastTicks[trackIndex];
+                // We calculate the tick count delta for the event. An event dated at its arrival may precede the
+                // last recorded one, in which case both are kept at the same tick.
+                UInt32 eventTick = std::max(tick, _recordLastTicks[trackIndex]);
+                event.tickCount = eventTick - _recordLastTicks[trackIndex];
                 _sequence->data.tracks[trackIndex].addEvent(event);
                 // The new last timestamp is now
-                _recordLastTicks[trackIndex] = tick;
+                _recordLastTicks[trackIndex] = eventTick;
             }
         }  // for each armed track index
     }
@@ -877,6 +1058,8 @@ std::shared_ptr<Sequence> Sequencer::sequence() { return _sequence; }
 
 // ---------------------------------------------------------------------------------------------------------------------
 void Sequencer::updateCurrentSequence() {
+    _seekIndex.clear();
+
     if (_sequence) {
         _playerEventIndices.resize(_sequence->data.tracks.size());
         _playerTicks.resize(_sequence->data.tracks.size());
@@ -10,11 +10,19 @@
 #define SEQUENCER_H
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "event.h"
 #include "sequence.h"
 #include "studio.h"
 
+// Number of events between two checkpoints of the seek index
+#define SEQUENCER_SEEK_CHECKPOINT_INTERVAL 512
+
+// Capacity reserved for the payload of the system exclusive events played
+#define SEQUENCER_SYSEX_BUFFER_SIZE 1024
+
 namespace MDStudio {
 
 class Sequencer {
@@ -55,6 +63,22 @@ class Sequencer {
     std::atomic<bool> _isLastNoteOffDetected;
     UInt32 _lastNoteOffTick;
 
+    // Seek index of a track
+    struct SeekTrackIndex {
+        UInt8 channel;                         // Channel of the track when the index was built
+        std::vector<UInt32> ticks;             // Cumulative tick of each event
+        UInt32 endOfTrackEventIndex;           // Index of the first end of track event (number of events if none)
+        std::vector<UInt32> sequentialEvents;  // Indices of the events that must all be replayed in order
+
+        // For every interval of events, the (state, event index) pairs of the last events setting a channel state
+        std::vector<std::vector<std::pair<UInt16, UInt32>>> checkpoints;
+    };
+    std::vector<SeekTrackIndex> _seekIndex;
+    std::vector<UInt32> _seekStateEvents;   // Last event setting each state while seeking
+    std::vector<UInt32> _seekChasedEvents;  // Events replayed while seeking
+
+    std::vector<UInt8> _sysExData;  // Payload of the system exclusive event being played
+
     // Published notifications
     std::vector<std::shared_ptr<playbackDidStartFnType>> _playbackDidStartFns;
     std::vector<std::shared_ptr<playbackDidFinishFnType>> _playbackDidFinishFns;
@@ -107,11 +131,16 @@ class Sequencer {
     void reportPlaybackWasInterrupted();
 
     bool processMetaEvent(const MDStudio::Event& event);
-    void processEvent(const MDStudio::Event& event, bool ignoreNotes, bool isPreloadingOnly = false,
-                      bool* isLoadingInstrumentInBackground = nullptr);
+    void processEvent(const MDStudio::Track& track, const MDStudio::Event& event, bool ignoreNotes,
+                      bool isPreloadingOnly = false, bool* isLoadingInstrumentInBackground = nullptr,
+                      UInt64 sampleTime = 0);
     bool metronomeDidTick(Metronome* metronome);
     void metronomeDidMoveTick(Metronome* metronome);
 
+    bool isSeekIndexValid();
+    void buildSeekIndex();
+    void chaseEvents(size_t trackIndex, UInt32 nbEvents);
+
     void addEvent(int source, UInt8 type, Float64 timestamp, UInt32 tick, UInt8 channel, SInt32 param1, SInt32 param2);
 
     void preloadInstruments(bool* isLoadingInstrumentInBackground);
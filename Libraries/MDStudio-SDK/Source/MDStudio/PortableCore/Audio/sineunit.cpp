@@ -11,7 +11,6 @@
 #include <math.h>
 #include <mixer.h>
 
-#define GRAPH_SAMPLE_RATE 44100
 #define SINE_RATE_FOR_PITCH(_base_pitch_, _pitch_) exp2f((float)(_pitch_ - _base_pitch_) / 12.0f)
 
 using namespace MDStudio;
@@ -1074,7 +1073,7 @@ int SineUnit::renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UIn
 
 // ---------------------------------------------------------------------------------------------------------------------
 void SineUnit::noteOn(float pitch, float velocity) {
-    _phaseDelta = SINE_RATE_FOR_PITCH(69, pitch) * 440.0f * 1024.0f / GRAPH_SAMPLE_RATE;
+    _phaseDelta = SINE_RATE_FOR_PITCH(69, pitch) * 440.0f * 1024.0f / _sampleRate;
     _velocity = velocity;
     _pitch = pitch;
 }
@@ -21,7 +21,8 @@ SoundFont2::Types SoundFont2::getType(UInt8 id[4]) {
         {'i', 's', 'n', 'g'}, {'i', 'r', 'o', 'm'}, {'i', 'v', 'e', 'r'}, {'I', 'N', 'A', 'M'}, {'I', 'C', 'R', 'D'},
         {'I', 'E', 'N', 'G'}, {'I', 'P', 'R', 'D'}, {'I', 'C', 'O', 'P'}, {'I', 'C', 'M', 'T'}, {'I', 'S', 'F', 'T'},
         {'s', 'm', 'p', 'l'}, {'p', 'h', 'd', 'r'}, {'p', 'b', 'a', 'g'}, {'p', 'm', 'o', 'd'}, {'p', 'g', 'e', 'n'},
-        {'i', 'n', 's', 't'}, {'i', 'b', 'a', 'g'}, {'i', 'm', 'o', 'd'}, {'i', 'g', 'e', 'n'}, {'s', 'h', 'd', 'r'}};
+        {'i', 'n', 's', 't'}, {'i', 'b', 'a', 'g'}, {'i', 'm', 'o', 'd'}, {'i', 'g', 'e', 'n'}, {'s', 'h', 'd', 'r'},
+        {'s', 'm', '2', '4'}};
 
     int i = 0;
     for (auto t : types) {
@@ -216,6 +217,8 @@ bool SoundFont2::readSFBK(std::ifstream& ifs) {
         return false;
     }
 
+    std::streampos sdtaEnd = ifs.tellg() + (std::streamoff)riffChunk.size;
+
     ifs.read((char*)id, sizeof(id));
     type = getType(id);
 
@@ -233,9 +236,22 @@ bool SoundFont2::readSFBK(std::ifstream& ifs) {
     }
 
     _samplesOffset = (UInt32)ifs.tellg();
+    _samplesSize = riffChunk.size;
 
     skipChunk(riffChunk, ifs);
 
+    // The sm24 chunk is ignored unless it matches the smpl chunk (SoundFont 2.04)
+    _samples24Offset = 0;
+    _samples24Size = 0;
+    if (ifs.tellg() < sdtaEnd) {
+        ifs.read((char*)&riffChunk, sizeof(RIFFChunk));
+        if (getType(riffChunk.id) == SM24 && riffChunk.size >= _samplesSize / sizeof(SInt16)) {
+            _samples24Offset = (UInt32)ifs.tellg();
+            _samples24Size = riffChunk.size;
+        }
+    }
+    ifs.seekg(sdtaEnd);
+
     // PDTA list
     ifs.read((char*)&riffChunk, sizeof(RIFFChunk));
     type = getType(riffChunk.id);
@@ -319,6 +335,24 @@ bool SoundFont2::load(std::string path) {
 
     ifs.close();
 
+    // Index the presets, the last header being the terminal one
+    _presetIndices.clear();
+    for (size_t presetNdx = 0; presetNdx + 1 < _presetHeaders.size(); ++presetNdx) {
+        auto& presetHeader = _presetHeaders[presetNdx];
+        _presetIndices.emplace(((UInt32)presetHeader.bank << 16) | presetHeader.preset, (UInt16)presetNdx);
+    }
+
+    // Map the file in order to access the sample data
+    if (!_mappedFile.open(path)) return false;
+
+    if ((size_t)_samplesOffset + _samplesSize > _mappedFile.size()) {
+        std::cout << "Truncated sample data\n";
+        _mappedFile.close();
+        return false;
+    }
+
+    if ((size_t)_samples24Offset + _samples24Size > _mappedFile.size()) _samples24Size = 0;
+
     return true;
 }
 
@@ -574,193 +608,186 @@ void SoundFont2::combineDatum(SoundFont2Data* destDatum, SoundFont2Data* srcDatu
 std::vector<SoundFont2Data> SoundFont2::dataForPreset(UInt16 bank, UInt16 preset) {
     std::vector<SoundFont2Data> ret;
 
-    UInt16 presetNdx = 0;
-    for (auto presetHeader : _presetHeaders) {
-        if (presetHeader.bank == bank && presetHeader.preset == preset) {
-            //
-            // The preset has been found
-            //
-
-            auto minPresetBagNdx = presetHeader.presetBagNdx;
-            auto maxPresetBagNdx = minPresetBagNdx;
-
-            if (presetNdx < _presetHeaders.size() - 1) maxPresetBagNdx = _presetHeaders[presetNdx + 1].presetBagNdx;
-
-            SoundFont2Data globalGlobalDatum;
-            memset(&globalGlobalDatum, 0, sizeof(globalGlobalDatum));
-
-            // For each preset bag
-            SoundFont2PresetBag* globalPresetBagPtr = nullptr;
-            for (auto presetBagNdx = minPresetBagNdx; presetBagNdx < maxPresetBagNdx; ++presetBagNdx) {
-                auto presetBag = _presetBags.at(presetBagNdx);
-
-                auto minGenListNdx = presetBag.genNdx;
-                auto maxGenListNdx = _presetBags[presetBagNdx + 1].genNdx;
-
-                if (maxGenListNdx > minGenListNdx) {
-                    SoundFont2Data datum;
-                    memset(&datum, 0, sizeof(datum));
-
-                    bool isGlobalGlobalDatum = true;
-
-                    // For each gen list
-                    for (auto genListNdx = minGenListNdx; genListNdx < maxGenListNdx; ++genListNdx) {
-                        auto genList = _genLists.at(genListNdx);
-
-                        // auto modList = _modLists.at(presetBag.modNdx);
-
-                        switch (genList.oper) {
-                            case 41: {
-                                // Instrument
-                                isGlobalGlobalDatum = false;
-
-                                auto instNdx = genList.amount.shAmount;
-                                auto inst = _instruments.at(instNdx);
-
-                                auto minInstBagNdx = inst.bagNdx;
-                                auto maxInstBagNdx = _instruments.at(instNdx + 1).bagNdx;
-
-                                SoundFont2Data datum2 = datum;
-
-                                SoundFont2Data globalDatum;
-                                memset(&globalDatum, 0, sizeof(globalDatum));
-
-                                // For each inst bag
-                                for (auto instBagNdx = minInstBagNdx; instBagNdx < maxInstBagNdx; ++instBagNdx) {
-                                    SoundFont2Data datum3;
-                                    memset(&datum3, 0, sizeof(datum3));
-
-                                    auto instBag = _instBags.at(instBagNdx);
-
-                                    auto minIGenNdx = instBag.genNdx;
-                                    auto maxIGenNdx = _instBags.at(instBagNdx + 1).genNdx;
-
-                                    bool isGlobal = true;
-                                    for (auto iGenNdx = minIGenNdx; iGenNdx < maxIGenNdx; ++iGenNdx) {
-                                        auto iGenList = _instGenLists.at(iGenNdx);
-                                        processGenOperator(&datum3, iGenList.oper, iGenList.amount);
-                                        // If this is a sample operator, we add
-                                        if (iGenList.oper == 53) {
-                                            // Must be the last
-                                            assert(iGenNdx + 1 == maxIGenNdx);
-                                            isGlobal = false;
-
-                                            // Add the sample
-                                            auto sampleNdx = iGenList.amount.shAmount;
-                                            auto sample = _samples.at(sampleNdx);
-                                            datum3.origKeyAndCorr =
-                                                ((UInt16)sample.originalKey << 8) | sample.correction;
-                                            datum3.startLoop = sample.startLoop;
-                                            datum3.endLoop = sample.endLoop;
-                                            datum3.start = sample.start;
-                                            datum3.end = sample.end;
-                                            datum3.sampleRate = sample.sampleRate;
-                                        }
-                                    }
-
-                                    if (isGlobal) {
-                                        globalDatum = datum3;
-                                    } else {
-                                        SoundFont2Data datum4;
-                                        memset(&datum4, 0, sizeof(datum4));
-
-                                        combineDatum(&datum4, &globalGlobalDatum, false);
-                                        combineDatum(&datum4, &datum2, false);
-
-                                        SoundFont2Data datum5;
-                                        memset(&datum5, 0, sizeof(datum5));
-
-                                        combineDatum(&datum5, &globalDatum, false);
-                                        combineDatum(&datum5, &datum3, false);
-
-                                        // Add missing defaults
-                                        if (!datum5.isInitialFilterFcSet) {
-                                            datum5.initialFilterFc = 13500;
-                                            datum5.isInitialFilterFcSet = true;
-                                        }
-                                        if (!datum5.isInitialFilterQSet) {
-                                            datum5.initialFilterQ = 0;
-                                            datum5.isInitialFilterQSet = true;
-                                        }
-                                        if (!datum5.isAttackVolEnvSet) {
-                                            datum5.attackVolEnv = -12000;
-                                            datum5.isAttackVolEnvSet = true;
-                                        }
-                                        if (!datum5.isHoldVolEnvSet) {
-                                            datum5.holdVolEnv = -12000;
-                                            datum5.isHoldVolEnvSet = true;
-                                        }
-                                        if (!datum5.isDecayVolEnvSet) {
-                                            datum5.decayVolEnv = -12000;
-                                            datum5.isDecayVolEnvSet = true;
-                                        }
-                                        if (!datum5.isSustainVolEnvSet) {
-                                            datum5.sustainVolEnv = 0;
-                                            datum5.isSustainVolEnvSet = true;
-                                        }
-                                        if (!datum5.isReleaseVolEnvSet) {
-                                            datum5.releaseVolEnv = -12000;
-                                            datum5.isReleaseVolEnvSet = true;
-                                        }
-
-                                        combineDatum(&datum4, &datum5, true);
-
-                                        // Add missing default ranges
-                                        if (!datum4.isKeyRangeSet) {
-                                            datum4.minPitch = 0;
-                                            datum4.maxPitch = 127;
-                                            datum4.isKeyRangeSet = true;
-                                        }
-                                        if (!datum4.isVelocityRangeSet) {
-                                            datum4.minVelocity = 0;
-                                            datum4.maxVelocity = 127;
-                                            datum4.isVelocityRangeSet = true;
-                                        }
-
-                                        // Adjust the root key
-                                        if (datum4.isRootKeySet) {
-                                            datum4.origKeyAndCorr = datum4.rootKey << 8;
-                                        }
-
-                                        // Adjust the start loop offset
-                                        if (datum4.isStartLoopOffsetSet) datum4.startLoop += datum4.startLoopOffset;
-
-                                        // Adjust the end loop offset
-                                        if (datum4.isEndLoopOffsetSet) datum4.endLoop += datum4.endLoopOffset;
-
-                                        SInt16 minPitch = datum2.isKeyRangeSet ? datum2.minPitch : 0;
-                                        SInt16 maxPitch = datum2.isKeyRangeSet ? datum2.maxPitch : 127;
-                                        SInt16 minVelocity = datum2.isVelocityRangeSet ? datum2.minVelocity : 0;
-                                        SInt16 maxVelocity = datum2.isVelocityRangeSet ? datum2.maxVelocity : 127;
-
-                                        if (datum4.minPitch >= minPitch && datum4.maxPitch <= maxPitch &&
-                                            datum4.minVelocity >= minVelocity && datum4.maxVelocity <= maxVelocity) {
-                                            ret.push_back(datum4);
-                                        }
-                                    }
-
-                                }  // for each inst bag
-                            } break;
-                            default:
-                                processGenOperator(&datum, genList.oper, genList.amount);
-                        }
-                    }
-
-                    if (isGlobalGlobalDatum) {
-                        globalGlobalDatum = datum;
+    auto it = _presetIndices.find(((UInt32)bank << 16) | preset);
+    if (it == _presetIndices.end()) return ret;
+
+    UInt16 presetNdx = it->second;
+    auto& presetHeader = _presetHeaders[presetNdx];
+
+    auto minPresetBagNdx = presetHeader.presetBagNdx;
+    auto maxPresetBagNdx = minPresetBagNdx;
+
+    if (presetNdx < _presetHeaders.size() - 1) maxPresetBagNdx = _presetHeaders[presetNdx + 1].presetBagNdx;
+
+    SoundFont2Data globalGlobalDatum;
+    memset(&globalGlobalDatum, 0, sizeof(globalGlobalDatum));
+
+    // For each preset bag
+    SoundFont2PresetBag* globalPresetBagPtr = nullptr;
+    for (auto presetBagNdx = minPresetBagNdx; presetBagNdx < maxPresetBagNdx; ++presetBagNdx) {
+        auto presetBag = _presetBags.at(presetBagNdx);
+
+        auto minGenListNdx = presetBag.genNdx;
+        auto maxGenListNdx = _presetBags[presetBagNdx + 1].genNdx;
+
+        if (maxGenListNdx > minGenListNdx) {
+            SoundFont2Data datum;
+            memset(&datum, 0, sizeof(datum));
+
+            bool isGlobalGlobalDatum = true;
+
+            // For each gen list
+            for (auto genListNdx = minGenListNdx; genListNdx < maxGenListNdx; ++genListNdx) {
+                auto genList = _genLists.at(genListNdx);
+
+                // auto modList = _modLists.at(presetBag.modNdx);
+
+                switch (genList.oper) {
+                    case 41: {
+                        // Instrument
                         isGlobalGlobalDatum = false;
-                    }
 
-                } else {
-                    // This is a global preset bag
-                    globalPresetBagPtr = &_presetBags.at(presetBagNdx);
+                        auto instNdx = genList.amount.shAmount;
+                        auto inst = _instruments.at(instNdx);
+
+                        auto minInstBagNdx = inst.bagNdx;
+                        auto maxInstBagNdx = _instruments.at(instNdx + 1).bagNdx;
+
+                        SoundFont2Data datum2 = datum;
+
+                        SoundFont2Data globalDatum;
+                        memset(&globalDatum, 0, sizeof(globalDatum));
+
+                        // For each inst bag
+                        for (auto instBagNdx = minInstBagNdx; instBagNdx < maxInstBagNdx; ++instBagNdx) {
+                            SoundFont2Data datum3;
+                            memset(&datum3, 0, sizeof(datum3));
+
+                            auto instBag = _instBags.at(instBagNdx);
+
+                            auto minIGenNdx = instBag.genNdx;
+                            auto maxIGenNdx = _instBags.at(instBagNdx + 1).genNdx;
+
+                            bool isGlobal = true;
+                            for (auto iGenNdx = minIGenNdx; iGenNdx < maxIGenNdx; ++iGenNdx) {
+                                auto iGenList = _instGenLists.at(iGenNdx);
+                                processGenOperator(&datum3, iGenList.oper, iGenList.amount);
+                                // If this is a sample operator, we add
+                                if (iGenList.oper == 53) {
+                                    // Must be the last
+                                    assert(iGenNdx + 1 == maxIGenNdx);
+                                    isGlobal = false;
+
+                                    // Add the sample
+                                    auto sampleNdx = iGenList.amount.shAmount;
+                                    auto sample = _samples.at(sampleNdx);
+                                    datum3.origKeyAndCorr = ((UInt16)sample.originalKey << 8) | sample.correction;
+                                    datum3.startLoop = sample.startLoop;
+                                    datum3.endLoop = sample.endLoop;
+                                    datum3.start = sample.start;
+                                    datum3.end = sample.end;
+                                    datum3.sampleRate = sample.sampleRate;
+                                }
+                            }
+
+                            if (isGlobal) {
+                                globalDatum = datum3;
+                            } else {
+                                SoundFont2Data datum4;
+                                memset(&datum4, 0, sizeof(datum4));
+
+                                combineDatum(&datum4, &globalGlobalDatum, false);
+                                combineDatum(&datum4, &datum2, false);
+
+                                SoundFont2Data datum5;
+                                memset(&datum5, 0, sizeof(datum5));
+
+                                combineDatum(&datum5, &globalDatum, false);
+                                combineDatum(&datum5, &datum3, false);
+
+                                // Add missing defaults
+                                if (!datum5.isInitialFilterFcSet) {
+                                    datum5.initialFilterFc = 13500;
+                                    datum5.isInitialFilterFcSet = true;
+                                }
+                                if (!datum5.isInitialFilterQSet) {
+                                    datum5.initialFilterQ = 0;
+                                    datum5.isInitialFilterQSet = true;
+                                }
+                                if (!datum5.isAttackVolEnvSet) {
+                                    datum5.attackVolEnv = -12000;
+                                    datum5.isAttackVolEnvSet = true;
+                                }
+                                if (!datum5.isHoldVolEnvSet) {
+                                    datum5.holdVolEnv = -12000;
+                                    datum5.isHoldVolEnvSet = true;
+                                }
+                                if (!datum5.isDecayVolEnvSet) {
+                                    datum5.decayVolEnv = -12000;
+                                    datum5.isDecayVolEnvSet = true;
+                                }
+                                if (!datum5.isSustainVolEnvSet) {
+                                    datum5.sustainVolEnv = 0;
+                                    datum5.isSustainVolEnvSet = true;
+                                }
+                                if (!datum5.isReleaseVolEnvSet) {
+                                    datum5.releaseVolEnv = -12000;
+                                    datum5.isReleaseVolEnvSet = true;
+                                }
+
+                                combineDatum(&datum4, &datum5, true);
+
+                                // Add missing default ranges
+                                if (!datum4.isKeyRangeSet) {
+                                    datum4.minPitch = 0;
+                                    datum4.maxPitch = 127;
+                                    datum4.isKeyRangeSet = true;
+                                }
+                                if (!datum4.isVelocityRangeSet) {
+                                    datum4.minVelocity = 0;
+                                    datum4.maxVelocity = 127;
+                                    datum4.isVelocityRangeSet = true;
+                                }
+
+                                // Adjust the root key
+                                if (datum4.isRootKeySet) {
+                                    datum4.origKeyAndCorr = datum4.rootKey << 8;
+                                }
+
+                                // Adjust the start loop offset
+                                if (datum4.isStartLoopOffsetSet) datum4.startLoop += datum4.startLoopOffset;
+
+                                // Adjust the end loop offset
+                                if (datum4.isEndLoopOffsetSet) datum4.endLoop += datum4.endLoopOffset;
+
+                                SInt16 minPitch = datum2.isKeyRangeSet ? datum2.minPitch : 0;
+                                SInt16 maxPitch = datum2.isKeyRangeSet ? datum2.maxPitch : 127;
+                                SInt16 minVelocity = datum2.isVelocityRangeSet ? datum2.minVelocity : 0;
+                                SInt16 maxVelocity = datum2.isVelocityRangeSet ? datum2.maxVelocity : 127;
+
+                                if (datum4.minPitch >= minPitch && datum4.maxPitch <= maxPitch &&
+                                    datum4.minVelocity >= minVelocity && datum4.maxVelocity <= maxVelocity) {
+                                    ret.push_back(datum4);
+                                }
+                            }
+
+                        }  // for each inst bag
+                    } break;
+                    default:
+                        processGenOperator(&datum, genList.oper, genList.amount);
                 }
-            }  // for each preset bag
+            }
 
-            break;
+            if (isGlobalGlobalDatum) {
+                globalGlobalDatum = datum;
+                isGlobalGlobalDatum = false;
+            }
+
+        } else {
+            // This is a global preset bag
+            globalPresetBagPtr = &_presetBags.at(presetBagNdx);
         }
-        ++presetNdx;
-    }
+    }  // for each preset bag
 
     return ret;
 }
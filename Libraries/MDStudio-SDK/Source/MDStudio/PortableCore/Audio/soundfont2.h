@@ -14,8 +14,10 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <vector>
 
+#include "../mappedfile.h"
 #include "../types.h"
 
 namespace MDStudio {
@@ -238,7 +240,8 @@ class SoundFont2 {
         IBAG,
         IMOD,
         IGEN,
-        SHDR
+        SHDR,
+        SM24
     } Types;
     Types getType(UInt8 id[4]);
 
@@ -276,8 +279,18 @@ class SoundFont2 {
     std::vector<SoundFont2Sample> _samples;
 
     UInt32 _samplesOffset;
+    UInt32 _samplesSize;
+    UInt32 _samples24Offset;
+    UInt32 _samples24Size;
+
+    // Index of the preset headers by bank and preset number
+    std::map<UInt32, UInt16> _presetIndices;
+
+    // Mapping of the file, used to access the sample data without copying it
+    MappedFile _mappedFile;
 
    public:
+    // Parses the hydra and maps the sample data
     bool load(std::string path);
 
     SoundFont2Version fileVersion() { return _fileVersion; }
@@ -293,6 +306,15 @@ class SoundFont2 {
     std::vector<SoundFont2PresetHeader> presetHeaders();
     UInt32 samplesOffset() { return _samplesOffset; }
 
+    // Sample data of the smpl chunk (16-bit, little-endian) directly from the mapped file
+    const SInt16* samples() { return reinterpret_cast<const SInt16*>(_mappedFile.data() + _samplesOffset); }
+    UInt32 nbSamples() { return _samplesSize / sizeof(SInt16); }
+
+    // Least significant bytes of the 24-bit samples from the optional sm24 chunk, nullptr if absent
+    const UInt8* samples24() {
+        return _samples24Size > 0 ? reinterpret_cast<const UInt8*>(_mappedFile.data() + _samples24Offset) : nullptr;
+    }
+
     std::vector<SoundFont2Data> dataForPreset(UInt16 bank, UInt16 preset);
 };
 
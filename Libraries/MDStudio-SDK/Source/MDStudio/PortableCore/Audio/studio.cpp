@@ -8,6 +8,9 @@
 
 #include "studio.h"
 
+#include <assert.h>
+#include <math.h>
+
 #include <algorithm>
 #include <chrono>
 #include <string>
@@ -23,8 +26,20 @@
 
 using namespace MDStudio;
 
+// Age of the events performed by the current thread
+static thread_local double eventAge = 0.0;
+
+// ---------------------------------------------------------------------------------------------------------------------
+StudioEventAgeScope::StudioEventAgeScope(double age) {
+    _previousAge = eventAge;
+    eventAge = std::min(std::max(age, 0.0), STUDIO_MAX_EVENT_AGE);
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
-Studio::Studio(int nbChannels, std::string sf2Path, UInt32 nbVoices) {
+StudioEventAgeScope::~StudioEventAgeScope() { eventAge = _previousAge; }
+
+// ---------------------------------------------------------------------------------------------------------------------
+Studio::Studio(int nbChannels, std::string sf2Path, UInt32 nbVoices, bool isNullOutput) {
     using namespace std::placeholders;
 
     // Initialize the MIDI output callbacks
@@ -49,6 +64,14 @@ Studio::Studio(int nbChannels, std::string sf2Path, UInt32 nbVoices) {
 
     _isNonRegisteredDataEntry = false;
 
+    _isAudioClockEnabled = false;
+
+    _isOfflineRendering = false;
+    _offlineSampleTimeOrigin = 0;
+
+    _isEventDeliveryScheduled = false;
+    _deliveredEvents.reserve(STUDIO_EVENT_QUEUE_CAPACITY);
+
     // We initialize the playing notes
     memset(_playingNotes, 0, sizeof(_playingNotes));
 
@@ -58,6 +81,11 @@ Studio::Studio(int nbChannels, std::string sf2Path, UInt32 nbVoices) {
     // Create the instrument manager
     _instrumentManager = new InstrumentManager(sf2Path);
 
+    // Create the background instrument loader
+    _instrumentLoader =
+        new InstrumentLoader(_instrumentManager, STUDIO_GM_SF2_FILENAME, STUDIO_INSTRUMENT_LOADER_NB_THREADS,
+                             std::bind(&Studio::instrumentLoaderDidLoadInstrument, this, _1, _2, _3, _4));
+
     // We create the metronome instrument
     _metronomeInstrument = _instrumentManager->loadSF2MultiInstrument(STUDIO_GM_SF2_FILENAME, 128, 0);
 
@@ -72,7 +100,7 @@ Studio::Studio(int nbChannels, std::string sf2Path, UInt32 nbVoices) {
     _metronomeSampler->setReverb(0.0f, STUDIO_METRONOME_CHANNEL);
 
     // Create our mixer with graph
-    _mixer = new Mixer();
+    _mixer = new Mixer(isNullOutput);
     _mixer->addUnit(_sampler);
     _mixer->addUnit(_audioPlayer);
     _mixer->addUnit(_metronomeSampler);
@@ -125,6 +153,7 @@ Studio::~Studio() {
 
     delete _metronome;
     delete _mixer;
+    delete _instrumentLoader;
     delete _instrumentManager;
 }
 
@@ -157,6 +186,49 @@ void Studio::setIsLoading(bool isLoading) {
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the instrument if available. Otherwise, the instrument is either loaded right away or queued to the loader.
+// Must be called with the play mutex locked.
+std::shared_ptr<MultiInstrument> Studio::loadInstrument(int instrument, bool isUrgent, bool* isLoadingInBackground) {
+    int bank = STUDIO_PRESET_BANK_FROM_INSTRUMENT(instrument);
+    int number = STUDIO_PRESET_NUMBER_FROM_INSTRUMENT(instrument);
+
+    auto multiInstrument = _gmInstruments[bank][number];
+    if (multiInstrument) return multiInstrument;
+
+    if (_areInstrumentsLoadedInBackground) {
+        if (isLoadingInBackground) *isLoadingInBackground = true;
+        if (_instrumentLoader->load(bank, number, isUrgent))
+            Platform::sharedInstance()->invoke([=]() { setIsLoading(true); });
+        return nullptr;
+    }
+
+    multiInstrument = _gmInstruments[bank][number] =
+        _instrumentManager->loadSF2MultiInstrument(STUDIO_GM_SF2_FILENAME, bank, number);
+    return multiInstrument;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Called from a thread of the instrument loader
+void Studio::instrumentLoaderDidLoadInstrument(InstrumentLoader* sender, int bank, int number,
+                                               std::shared_ptr<MultiInstrument> multiInstrument) {
+    _playMutex.lock();
+
+    _gmInstruments[bank][number] = multiInstrument;
+
+    // We assign the instrument to the channels waiting for it
+    for (int channel = 0; channel < _nbChannels; ++channel) {
+        if (_instruments[channel] != STUDIO_INSTRUMENT_NONE &&
+            STUDIO_PRESET_BANK_FROM_INSTRUMENT(_instruments[channel]) == bank &&
+            STUDIO_PRESET_NUMBER_FROM_INSTRUMENT(_instruments[channel]) == number)
+            _multiInstruments[channel] = multiInstrument;
+    }
+
+    _playMutex.unlock();
+
+    Platform::sharedInstance()->invoke([=]() { setIsLoading(false); });
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 void Studio::setInstrument(int source, int instrument, int channel, bool isPreloadingOnly,
                            bool* isLoadingInBackground) {
@@ -165,38 +237,14 @@ void Studio::setInstrument(int source, int instrument, int channel, bool isPrelo
     _playMutex.lock();
 
     if (_isInternalSynthEnabled) {
-        std::shared_ptr<MultiInstrument> multiInstrument = nullptr;
-
-        int bank = STUDIO_PRESET_BANK_FROM_INSTRUMENT(instrument);
-        int number = STUDIO_PRESET_NUMBER_FROM_INSTRUMENT(instrument);
-
-        multiInstrument = _gmInstruments[bank][number];
-
-        if (multiInstrument == nullptr) {
-            if (_areInstrumentsLoadedInBackground) {
-                if (isLoadingInBackground) *isLoadingInBackground = true;
-                std::thread([=] {
-                    Platform::sharedInstance()->invoke([=]() { setIsLoading(true); });
-                    _loadInstrumentMutex.lock();
-                    std::shared_ptr<MultiInstrument> mi =
-                        _instrumentManager->loadSF2MultiInstrument(STUDIO_GM_SF2_FILENAME, bank, number);
-                    _loadInstrumentMutex.unlock();
-                    _playMutex.lock();
-                    _gmInstruments[bank][number] = mi;
-                    if (!isPreloadingOnly) _multiInstruments[channel] = mi;
-                    _playMutex.unlock();
-                    Platform::sharedInstance()->invoke([=]() { setIsLoading(false); });
-                }).detach();
-            } else {
-                multiInstrument = _gmInstruments[bank][number] =
-                    _instrumentManager->loadSF2MultiInstrument(STUDIO_GM_SF2_FILENAME, bank, number);
-                if (!isPreloadingOnly) {
-                    // We load the instrument
-                    _multiInstruments[channel] = multiInstrument;
-                }
-            }
-        } else {
-            if (!isPreloadingOnly) _multiInstruments[channel] = multiInstrument;
+        bool isQueued = false;
+        auto multiInstrument = loadInstrument(instrument, !isPreloadingOnly, &isQueued);
+
+        // When loaded in background, the channel is assigned once the instrument is available
+        if (isQueued) {
+            if (isLoadingInBackground) *isLoadingInBackground = true;
+        } else if (!isPreloadingOnly) {
+            _multiInstruments[channel] = multiInstrument;
         }
     }  // if internal synth is enabled
 
@@ -210,6 +258,15 @@ void Studio::setInstrument(int source, int instrument, int channel, bool isPrelo
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::preloadInstruments(const std::vector<int>& instruments, bool* isLoadingInBackground) {
+    if (!_isInternalSynthEnabled) return;
+
+    _playMutex.lock();
+    for (auto instrument : instruments) loadInstrument(instrument, false, isLoadingInBackground);
+    _playMutex.unlock();
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 int Studio::instrument(int channel) {
     if (channel >= _nbChannels) return STUDIO_INSTRUMENT_NONE;
@@ -241,6 +298,9 @@ void Studio::clearInstrumentCache() {
                         break;
                     }
 
+                // Check if the instrument is still referenced by a voice of the sampler
+                if (!isFound && _sampler->isMultiInstrumentInUse(multiInstrument)) isFound = true;
+
                 // If the instrument is not currently in use, we remove it from the cache
                 if (!isFound) {
                     _instrumentManager->unloadMultiInstrument(_gmInstruments[bank][instrument]);
@@ -253,43 +313,35 @@ void Studio::clearInstrumentCache() {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Studio::playNote(int source, int pitch, Float32 velocity, int channel) {
+void Studio::playNote(int source, int pitch, Float32 velocity, int channel, UInt64 sampleTime) {
     if (channel >= _nbChannels) return;
 
     _playMutex.lock();
     if (_isInternalSynthEnabled)
-        _sampler->playNote(static_cast<Float32>(pitch), velocity, _multiInstruments[channel], channel);
+        _sampler->playNote(static_cast<Float32>(pitch), velocity, _multiInstruments[channel], channel, sampleTime);
     _playingNotes[channel][pitch] = true;
     _playMutex.unlock();
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didPlayNote : _didPlayNoteFns) {
-            (*didPlayNote)(this, source, getTimestamp(), tick, channel, pitch, velocity);
-        }
-    });
+    postEvent(STUDIO_EVENT_PLAY_NOTE, source, channel, tick, pitch, 0, velocity);
 
     if (_isMIDIOutputEnabled && _midiOutputDidPlayNoteFn)
         _midiOutputDidPlayNoteFn(this, source, getTimestamp(), tick, channel, pitch, velocity);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Studio::releaseNote(int source, int pitch, Float32 velocity, int channel) {
+void Studio::releaseNote(int source, int pitch, Float32 velocity, int channel, UInt64 sampleTime) {
     if (channel >= _nbChannels) return;
 
     _playMutex.lock();
-    if (_isInternalSynthEnabled) _sampler->releaseNote(static_cast<Float32>(pitch), channel);
+    if (_isInternalSynthEnabled) _sampler->releaseNote(static_cast<Float32>(pitch), channel, sampleTime);
     _playingNotes[channel][pitch] = false;
     _playMutex.unlock();
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didReleaseNote : _didReleaseNoteFns) {
-            (*didReleaseNote)(this, source, getTimestamp(), tick, channel, pitch, velocity);
-        }
-    });
+    postEvent(STUDIO_EVENT_RELEASE_NOTE, source, channel, tick, pitch, 0, velocity);
 
     if (_isMIDIOutputEnabled && _midiOutputDidReleaseNoteFn)
         _midiOutputDidReleaseNoteFn(this, source, getTimestamp(), tick, channel, pitch, velocity);
@@ -314,10 +366,7 @@ void Studio::channelAftertouch(int source, Float32 value, int channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-// The notifications are sent immediately if the call is performed from the main thread.
 void Studio::stopNotes(int source, int channel) {
-    std::vector<std::function<void()>> invokeFns;
-
     _playMutex.lock();
 
     // For each pitch
@@ -325,13 +374,10 @@ void Studio::stopNotes(int source, int channel) {
         if (_playingNotes[channel][pitch]) {
             _playingNotes[channel][pitch] = false;
 
-            UInt32 tick = _metronome->tick();
+            UInt32 tick = eventTick();
 
             // We send the notification
-            invokeFns.push_back([=]() {
-                for (auto didReleaseNote : _didReleaseNoteFns)
-                    (*didReleaseNote)(this, source, getTimestamp(), tick, channel, pitch, 1.0f);
-            });
+            postEvent(STUDIO_EVENT_RELEASE_NOTE, source, channel, tick, pitch, 0, 1.0f);
 
             if (_isMIDIOutputEnabled && _midiOutputDidReleaseNoteFn)
                 _midiOutputDidReleaseNoteFn(this, source, getTimestamp(), tick, channel, pitch, 1.0f);
@@ -342,8 +388,6 @@ void Studio::stopNotes(int source, int channel) {
     if (_isInternalSynthEnabled) _sampler->stopAllNotes(channel);
 
     _playMutex.unlock();
-
-    for (auto invokeFn : invokeFns) Platform::sharedInstance()->invoke(invokeFn);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -371,12 +415,12 @@ bool Studio::isNotePlaying(int channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Studio::setSustain(int source, Float32 sustain, int channel) {
+void Studio::setSustain(int source, Float32 sustain, int channel, UInt64 sampleTime) {
     if (channel >= _nbChannels) return;
 
     _playMutex.lock();
     _sustainValues[channel] = sustain;
-    if (_isInternalSynthEnabled) _sampler->setSustain(sustain, channel);
+    if (_isInternalSynthEnabled) _sampler->setSustain(sustain, channel, sampleTime);
     sendSustain(source, channel);
     _playMutex.unlock();
 }
@@ -395,12 +439,12 @@ Float32 Studio::sustain(int channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Studio::setPitchBend(int source, Float32 pitchBend, int channel) {
+void Studio::setPitchBend(int source, Float32 pitchBend, int channel, UInt64 sampleTime) {
     if (channel >= _nbChannels) return;
 
     _playMutex.lock();
     _pitchBendValues[channel] = pitchBend;
-    if (_isInternalSynthEnabled) _sampler->setPitchBend(pitchBend, channel);
+    if (_isInternalSynthEnabled) _sampler->setPitchBend(pitchBend, channel, sampleTime);
     sendPitchBend(source, channel);
     _playMutex.unlock();
 }
@@ -417,16 +461,44 @@ Float32 Studio::pitchBend(int channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Studio::setModulation(int source, Float32 modulation, int channel) {
+void Studio::setModulation(int source, Float32 modulation, int channel, UInt64 sampleTime) {
     if (channel >= _nbChannels) return;
 
     _playMutex.lock();
     _modulationValues[channel] = modulation;
-    if (_isInternalSynthEnabled) _sampler->setModulation(modulation, channel);
+    if (_isInternalSynthEnabled) _sampler->setModulation(modulation, channel, sampleTime);
     sendModulation(source, channel);
     _playMutex.unlock();
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+UInt64 Studio::sampleTimeForTick(UInt32 tick) {
+    Metronome::timePointType timePoint = _metronome->timePointForTick(tick);
+
+    if (_isOfflineRendering) {
+        Metronome::doublePrecisionDurationType offset = timePoint - _metronome->startTime();
+        return _offlineSampleTimeOrigin + (UInt64)llround(offset.count() * _sampler->sampleRate());
+    }
+
+    if (!_metronome->isRunning()) return 0;
+
+    // With the audio clock, the time points are in seconds of rendered audio
+    if (_isAudioClockEnabled) return (UInt64)llround(timePoint.time_since_epoch().count() * _sampler->sampleRate());
+
+    return _sampler->sampleTimeForTimestamp(timePoint.time_since_epoch().count());
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::startOfflineRendering() {
+    assert(!_mixer->isRunning());
+
+    _offlineSampleTimeOrigin = _sampler->sampleTime();
+    _isOfflineRendering = true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::stopOfflineRendering() { _isOfflineRendering = false; }
+
 // ---------------------------------------------------------------------------------------------------------------------
 Float32 Studio::modulation(int channel) {
     if (channel >= _nbChannels) return 0.0f;
@@ -528,12 +600,12 @@ Float32 Studio::pitchBendFactor(int channel) {
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Studio::sendSystemExclusive(int source, std::vector<UInt8> data, int channel) {
+void Studio::sendSystemExclusive(int source, const std::vector<UInt8>& data, int channel) {
     if (channel >= _nbChannels) return;
 
     _playMutex.lock();
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
     if (_areStateNotificationsEnabled && _isMIDIOutputEnabled && _midiOutputDidSetControlValueFn)
         _midiOutputDidSendSystemExclusiveFn(this, source, getTimestamp(), tick, channel, data);
@@ -812,6 +884,109 @@ void Studio::dumpStates(int source) {
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Tick of the event being performed by the current thread
+UInt32 Studio::eventTick() {
+    UInt32 tick = _metronome->tick();
+    if (eventAge == 0.0 || !_metronome->isRunning()) return tick;
+
+    // The tempo is assumed constant over the age of the event
+    double ticksPerSecond = _metronome->bpmForTick(tick) / 60.0 * _metronome->timeDivision();
+    UInt32 nbTicks = static_cast<UInt32>(eventAge * ticksPerSecond);
+
+    return nbTicks < tick ? tick - nbTicks : 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Queues the notification without locking or allocating unless the queue overflows, and schedules a single delivery
+// for the pending batch.
+void Studio::postEvent(int type, int source, int channel, UInt32 tick, SInt32 param1, UInt32 param2, Float32 value) {
+    StudioEvent event;
+    event.type = static_cast<UInt8>(type);
+    event.channel = static_cast<SInt8>(channel);
+    event.source = static_cast<SInt16>(source);
+    event.tick = tick;
+    event.param1 = param1;
+    event.param2 = param2;
+    event.value = value;
+
+    _eventQueue.enqueue(event);
+
+    if (!_isEventDeliveryScheduled.exchange(true)) Platform::sharedInstance()->invoke([=]() { deliverEvents(); });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::deliverEvents() {
+    // Cleared before draining, so an event queued meanwhile schedules another delivery
+    _isEventDeliveryScheduled = false;
+
+    _eventQueue.drain(&_deliveredEvents);
+
+    double timestamp = getTimestamp();
+    for (auto& event : _deliveredEvents) deliverEvent(event, timestamp);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::deliverEvent(const StudioEvent& event, double timestamp) {
+    int source = event.source;
+    int channel = event.channel;
+    UInt32 tick = event.tick;
+
+    switch (event.type) {
+        case STUDIO_EVENT_PLAY_NOTE:
+            for (auto didPlayNote : _didPlayNoteFns)
+                (*didPlayNote)(this, source, timestamp, tick, channel, event.param1, event.value);
+            break;
+        case STUDIO_EVENT_RELEASE_NOTE:
+            for (auto didReleaseNote : _didReleaseNoteFns)
+                (*didReleaseNote)(this, source, timestamp, tick, channel, event.param1, event.value);
+            break;
+        case STUDIO_EVENT_INSTRUMENT:
+            for (auto didSetInstrumentFn : _didSetInstrumentFns)
+                (*didSetInstrumentFn)(this, source, timestamp, tick, channel, event.param1);
+            break;
+        case STUDIO_EVENT_TEMPO:
+            for (auto didSetTempo : _didSetTempoFns) (*didSetTempo)(this, source, timestamp, tick, event.param1);
+            break;
+        case STUDIO_EVENT_TIME_SIGNATURE:
+            for (auto didSetTimeSignature : _didSetTimeSignatureFns)
+                (*didSetTimeSignature)(this, source, timestamp, tick, event.param1, event.param2);
+            break;
+        case STUDIO_EVENT_MIXER_LEVEL:
+            for (auto didSetMixerLevelFn : _didSetMixerLevelFns)
+                (*didSetMixerLevelFn)(this, source, timestamp, tick, channel, event.value);
+            break;
+        case STUDIO_EVENT_MIXER_BALANCE:
+            for (auto didSetMixerBalanceFn : _didSetMixerBalanceFns)
+                (*didSetMixerBalanceFn)(this, source, timestamp, tick, channel, event.value);
+            break;
+        case STUDIO_EVENT_SUSTAIN:
+            for (auto didSetSustain : _didSetSustainFns)
+                (*didSetSustain)(this, source, timestamp, tick, channel, event.value);
+            break;
+        case STUDIO_EVENT_PITCH_BEND:
+            for (auto didSetPitchBend : _didSetPitchBendFns)
+                (*didSetPitchBend)(this, source, timestamp, tick, channel, event.value);
+            break;
+        case STUDIO_EVENT_MODULATION:
+            for (auto didSetModulation : _didSetModulationFns)
+                (*didSetModulation)(this, source, timestamp, tick, channel, event.value);
+            break;
+        case STUDIO_EVENT_CONTROL_VALUE:
+            for (auto didSetControlValue : _didSetControlValueFns)
+                (*didSetControlValue)(this, source, timestamp, tick, channel, event.param1, event.param2);
+            break;
+        case STUDIO_EVENT_KEY_AFTERTOUCH:
+            for (auto didPerformKeyAftertouch : _didPerformKeyAftertouchFns)
+                (*didPerformKeyAftertouch)(this, source, timestamp, tick, channel, event.param1, event.value);
+            break;
+        case STUDIO_EVENT_CHANNEL_AFTERTOUCH:
+            for (auto didPerformChannelAftertouch : _didPerformChannelAftertouchFns)
+                (*didPerformChannelAftertouch)(this, source, timestamp, tick, channel, event.value);
+            break;
+    }
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 void Studio::sendMixerLevel(int source, int channel) {
     if (!_areStateNotificationsEnabled) return;
@@ -821,13 +996,9 @@ void Studio::sendMixerLevel(int source, int channel) {
 
     Float32 mixerLevel = _mixerLevelValues[channel];
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetMixerLevelFn : _didSetMixerLevelFns) {
-            (*didSetMixerLevelFn)(this, source, getTimestamp(), tick, channel, mixerLevel);
-        }
-    });
+    postEvent(STUDIO_EVENT_MIXER_LEVEL, source, channel, tick, 0, 0, mixerLevel);
 
     if (_isMIDIOutputEnabled && _midiOutputDidSetMixerLevelFn)
         _midiOutputDidSetMixerLevelFn(this, source, getTimestamp(), tick, channel, mixerLevel);
@@ -842,13 +1013,9 @@ void Studio::sendMixerBalance(int source, int channel) {
 
     Float32 mixerBalance = _mixerBalanceValues[channel];
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetMixerBalanceFn : _didSetMixerBalanceFns) {
-            (*didSetMixerBalanceFn)(this, source, getTimestamp(), tick, channel, mixerBalance);
-        }
-    });
+    postEvent(STUDIO_EVENT_MIXER_BALANCE, source, channel, tick, 0, 0, mixerBalance);
 
     if (_isMIDIOutputEnabled && _midiOutputDidSetMixerBalanceFn)
         _midiOutputDidSetMixerBalanceFn(this, source, getTimestamp(), tick, channel, mixerBalance);
@@ -863,13 +1030,9 @@ void Studio::sendInstrument(int source, int channel) {
 
     int instrument = _instruments[channel];
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetInstrumentFn : _didSetInstrumentFns) {
-            (*didSetInstrumentFn)(this, source, getTimestamp(), tick, channel, instrument);
-        }
-    });
+    postEvent(STUDIO_EVENT_INSTRUMENT, source, channel, tick, instrument, 0, 0.0f);
 
     if (_isMIDIOutputEnabled && _midiOutputDidSetInstrumentFn)
         _midiOutputDidSetInstrumentFn(this, source, getTimestamp(), tick, channel, instrument);
@@ -886,11 +1049,7 @@ void Studio::sendTempo(int source) {
 
     UInt32 mpqn = 60000000 / bpm;
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetTempo : _didSetTempoFns) {
-            (*didSetTempo)(this, source, getTimestamp(), tick, mpqn);
-        }
-    });
+    postEvent(STUDIO_EVENT_TEMPO, source, 0, tick, mpqn, 0, 0.0f);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -902,11 +1061,7 @@ void Studio::sendTimeSignature(int source) {
     UInt32 tick = _metronome->tick();
     auto timeSignature = _metronome->timeSignatureForTick(tick);
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetTimeSignature : _didSetTimeSignatureFns) {
-            (*didSetTimeSignature)(this, source, getTimestamp(), tick, timeSignature.first, timeSignature.second);
-        }
-    });
+    postEvent(STUDIO_EVENT_TIME_SIGNATURE, source, 0, tick, timeSignature.first, timeSignature.second, 0.0f);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -918,13 +1073,9 @@ void Studio::sendSustain(int source, int channel) {
 
     Float32 sustain = _sustainValues[channel];
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetSustain : _didSetSustainFns) {
-            (*didSetSustain)(this, source, getTimestamp(), tick, channel, sustain);
-        }
-    });
+    postEvent(STUDIO_EVENT_SUSTAIN, source, channel, tick, 0, 0, sustain);
 
     if (_isMIDIOutputEnabled && _midiOutputDidSetSustainFn)
         _midiOutputDidSetSustainFn(this, source, getTimestamp(), tick, channel, sustain);
@@ -939,13 +1090,9 @@ void Studio::sendPitchBend(int source, int channel) {
 
     Float32 pitchBend = _pitchBendValues[channel];
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetPitchBend : _didSetPitchBendFns) {
-            (*didSetPitchBend)(this, source, getTimestamp(), tick, channel, pitchBend);
-        }
-    });
+    postEvent(STUDIO_EVENT_PITCH_BEND, source, channel, tick, 0, 0, pitchBend);
 
     if (_isMIDIOutputEnabled && _midiOutputDidSetPitchBendFn)
         _midiOutputDidSetPitchBendFn(this, source, getTimestamp(), tick, channel, pitchBend);
@@ -960,13 +1107,9 @@ void Studio::sendModulation(int source, int channel) {
 
     Float32 modulation = _modulationValues[channel];
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetModulation : _didSetModulationFns) {
-            (*didSetModulation)(this, source, getTimestamp(), tick, channel, modulation);
-        }
-    });
+    postEvent(STUDIO_EVENT_MODULATION, source, channel, tick, 0, 0, modulation);
 
     if (_isMIDIOutputEnabled && _midiOutputDidSetModulationFn)
         _midiOutputDidSetModulationFn(this, source, getTimestamp(), tick, channel, modulation);
@@ -979,13 +1122,9 @@ void Studio::sendControlValue(int source, UInt32 control, UInt32 value, int chan
     // Send the pitch bend value
     if (channel >= _nbChannels) return;
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didSetControlValue : _didSetControlValueFns) {
-            (*didSetControlValue)(this, source, getTimestamp(), tick, channel, control, value);
-        }
-    });
+    postEvent(STUDIO_EVENT_CONTROL_VALUE, source, channel, tick, control, value, 0.0f);
 
     if (_isMIDIOutputEnabled && _midiOutputDidSetControlValueFn)
         _midiOutputDidSetControlValueFn(this, source, getTimestamp(), tick, channel, control, value);
@@ -998,13 +1137,9 @@ void Studio::sendKeyAftertouch(int source, int pitch, Float32 value, int channel
     // Send the pitch bend value
     if (channel >= _nbChannels) return;
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didPerformKeyAftertouch : _didPerformKeyAftertouchFns) {
-            (*didPerformKeyAftertouch)(this, source, getTimestamp(), tick, channel, pitch, value);
-        }
-    });
+    postEvent(STUDIO_EVENT_KEY_AFTERTOUCH, source, channel, tick, pitch, 0, value);
 
     if (_isMIDIOutputEnabled && _midiOutputDidPerformKeyAftertouchFn)
         _midiOutputDidPerformKeyAftertouchFn(this, source, getTimestamp(), tick, channel, pitch, value);
@@ -1017,13 +1152,9 @@ void Studio::sendChannelAftertouch(int source, Float32 value, int channel) {
     // Send the pitch bend value
     if (channel >= _nbChannels) return;
 
-    UInt32 tick = _metronome->tick();
+    UInt32 tick = eventTick();
 
-    Platform::sharedInstance()->invoke([=]() {
-        for (auto didPerformChannelAftertouch : _didPerformChannelAftertouchFns) {
-            (*didPerformChannelAftertouch)(this, source, getTimestamp(), tick, channel, value);
-        }
-    });
+    postEvent(STUDIO_EVENT_CHANNEL_AFTERTOUCH, source, channel, tick, 0, 0, value);
 
     if (_isMIDIOutputEnabled && _midiOutputDidPerformChannelAftertouchFn)
         _midiOutputDidPerformChannelAftertouchFn(this, source, getTimestamp(), tick, channel, value);
@@ -1033,6 +1164,39 @@ void Studio::sendChannelAftertouch(int source, Float32 value, int channel) {
 // Metronome control
 //
 
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::setIsAudioClockEnabled(bool isAudioClockEnabled) {
+    assert(!_metronome->isRunning());
+
+    _isAudioClockEnabled = isAudioClockEnabled;
+
+    if (!isAudioClockEnabled) {
+        _metronome->setWaitForClockFn(nullptr);
+        return;
+    }
+
+    _metronome->setWaitForClockFn([this](Metronome* sender, double* time) {
+        if (!_mixer->waitForRender()) {
+            // The clock is stopped
+            double blockPeriod = _mixer->framesPerBuffer() / _mixer->sampleRate();
+            std::this_thread::sleep_for(std::chrono::duration<double>(blockPeriod));
+            return false;
+        }
+
+        // The block following the one just rendered may already be in progress, so we reach the end of the next one
+        *time = (double)(_sampler->sampleTime() + 2 * _mixer->framesPerBuffer()) / _sampler->sampleRate();
+        return true;
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::setIsStreamingEnabled(bool isStreamingEnabled) {
+    assert(!_mixer->isRunning());
+
+    _instrumentManager->setIsStreaming(isStreamingEnabled);
+    _sampler->setIsStreaming(isStreamingEnabled);
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 bool Studio::isMetronomeRunning() { return _metronome->isRunning(); }
 
@@ -1118,6 +1282,21 @@ void Studio::setAudioOutputDevice(const std::string& audioOutputDeviceName, doub
     if (mixerWasRunning) _mixer->start();
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+void Studio::setAudioFormat(Float64 sampleRate, UInt32 framesPerBuffer) {
+    bool mixerWasRunning = _mixer->isRunning();
+
+    // Make sure the mixer is stopped
+    _mixer->stop();
+    _sampler->clearAllVoices();
+
+    _mixer->setSampleRate(sampleRate);
+    _mixer->setFramesPerBuffer(framesPerBuffer);
+
+    // Re-start the mixer if necessary
+    if (mixerWasRunning) _mixer->start();
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 void Studio::startMixer() {
     if (!_mixer->isRunning()) {
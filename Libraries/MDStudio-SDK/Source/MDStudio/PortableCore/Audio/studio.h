@@ -9,19 +9,25 @@
 #ifndef STUDIO_H
 #define STUDIO_H
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <vector>
 
 #include "audioplayerunit.h"
+#include "instrumentloader.h"
 #include "instrumentmanager.h"
 #include "metronome.h"
 #include "mixer.h"
 #include "samplerunit.h"
+#include "studioeventqueue.h"
 
 #define STUDIO_MAX_CHANNELS 16
 
+// Number of threads loading the instruments in background
+#define STUDIO_INSTRUMENT_LOADER_NB_THREADS 2
+
 #define STUDIO_INSTRUMENT_FROM_PRESET(_bank_, _number_) ((_bank_ << 8) | (_number_))
 #define STUDIO_PRESET_BANK_FROM_INSTRUMENT(_instrument_) (_instrument_ >> 8)
 #define STUDIO_PRESET_NUMBER_FROM_INSTRUMENT(_instrument_) (_instrument_ & 0xff)
@@ -50,8 +56,20 @@
 #define STUDIO_SOURCE_USER 0
 #define STUDIO_SOURCE_SEQUENCER 1
 
+#define STUDIO_MAX_EVENT_AGE 0.1  // in seconds
+
 namespace MDStudio {
 
+// Dates the events performed by the current thread for the lifetime of the object. Their notifications are placed at
+// the tick the metronome was on when the events arrived, age seconds ago, instead of the tick of their processing.
+class StudioEventAgeScope {
+    double _previousAge;
+
+   public:
+    StudioEventAgeScope(double age);
+    ~StudioEventAgeScope();
+};
+
 class Studio {
    public:
     typedef std::function<void(Studio* sender, int source, double timestamp, UInt32 tick, int channel, int instrument)>
@@ -90,7 +108,7 @@ class Studio {
     typedef std::function<void(Studio* sender, int source, double timestamp, UInt32 tick, int channel, Float32 value)>
         didPerformChannelAftertouchFnType;
     typedef std::function<void(Studio* sender, int source, double timestamp, UInt32 tick, int channel,
-                               std::vector<UInt8> data)>
+                               const std::vector<UInt8>& data)>
         didSendSystemExclusiveFnType;
     typedef std::function<void(Studio* sender, bool state)> didSetStudioLoadingStateFnType;
 
@@ -106,6 +124,7 @@ class Studio {
 
     Mixer* _mixer;
     InstrumentManager* _instrumentManager;
+    InstrumentLoader* _instrumentLoader;
     std::shared_ptr<SamplerUnit> _sampler;
     std::shared_ptr<SamplerUnit> _metronomeSampler;
     std::shared_ptr<AudioPlayerUnit> _audioPlayer;
@@ -150,7 +169,22 @@ class Studio {
 
     bool _isNonRegisteredDataEntry;
 
+    bool _isAudioClockEnabled;
+
+    bool _isOfflineRendering;
+    UInt64 _offlineSampleTimeOrigin;  // Sampler sample time of the tick 0 while rendering offline
+
     double getTimestamp();
+    UInt32 eventTick();
+
+    // Notifications waiting to be delivered on the main thread
+    StudioEventQueue _eventQueue;
+    std::atomic<bool> _isEventDeliveryScheduled;
+    std::vector<StudioEvent> _deliveredEvents;
+
+    void postEvent(int type, int source, int channel, UInt32 tick, SInt32 param1, UInt32 param2, Float32 value);
+    void deliverEvents();
+    void deliverEvent(const StudioEvent& event, double timestamp);
 
     void sendMixerLevel(int source, int channel);
     void sendMixerBalance(int source, int channel);
@@ -169,6 +203,10 @@ class Studio {
 
     void setIsLoading(bool isLoading);
 
+    std::shared_ptr<MultiInstrument> loadInstrument(int instrument, bool isUrgent, bool* isLoadingInBackground);
+    void instrumentLoaderDidLoadInstrument(InstrumentLoader* sender, int bank, int number,
+                                           std::shared_ptr<MultiInstrument> multiInstrument);
+
     bool _areStateNotificationsEnabled;
 
     unsigned _loadingCounter;
@@ -179,7 +217,8 @@ class Studio {
     bool _isMIDIOutputEnabled;
 
    public:
-    Studio(int nbChannels, std::string sf2Path, UInt32 nbVoices = SAMPLER_MAX_VOICES);
+    // With a null output, the mixer renders into memory without opening an audio device (see Mixer)
+    Studio(int nbChannels, std::string sf2Path, UInt32 nbVoices = SAMPLER_MAX_VOICES, bool isNullOutput = false);
     ~Studio();
 
     void setNbVoices(UInt32 nbVoices);
@@ -190,6 +229,13 @@ class Studio {
     bool areInstrumentsLoadedInBackground() { return _areInstrumentsLoadedInBackground; }
 
     Mixer* mixer() { return _mixer; }
+    SamplerUnit* sampler() { return _sampler.get(); }
+
+    // Resets the statistics of the mixer and the counters of the sampler
+    void resetStats() {
+        _mixer->resetStats();
+        _sampler->resetNbStolenVoices();
+    }
     Metronome* metronome() { return _metronome; }
 
     void addDidSetInstrumentFn(std::shared_ptr<didSetInstrumentFnType> didSetInstrumentFn);
@@ -273,19 +319,33 @@ class Studio {
     int instrument(int channel);
     void clearInstrumentCache();
 
+    // Loads the instruments ahead of their use, in background if enabled. The channels waiting for an instrument are
+    // served first.
+    void preloadInstruments(const std::vector<int>& instruments, bool* isLoadingInBackground = nullptr);
+
     // Play (thread safe)
 
-    void playNote(int source, int pitch, Float32 velocity, int channel);
-    void releaseNote(int source, int pitch, Float32 velocity, int channel);
+    // The sample time schedules the change on the internal synth (0 = as soon as possible)
+    void playNote(int source, int pitch, Float32 velocity, int channel, UInt64 sampleTime = 0);
+    void releaseNote(int source, int pitch, Float32 velocity, int channel, UInt64 sampleTime = 0);
     void keyAftertouch(int source, int pitch, Float32 velocity, int channel);
     void channelAftertouch(int source, Float32 velocity, int channel);
-    void setSustain(int source, Float32 sustain, int channel);
+    void setSustain(int source, Float32 sustain, int channel, UInt64 sampleTime = 0);
     Float32 sustain(int channel);
-    void setPitchBend(int source, Float32 pitchBend, int channel);
+    void setPitchBend(int source, Float32 pitchBend, int channel, UInt64 sampleTime = 0);
     Float32 pitchBend(int channel);
-    void setModulation(int source, Float32 modulation, int channel);
+    void setModulation(int source, Float32 modulation, int channel, UInt64 sampleTime = 0);
     Float32 modulation(int channel);
 
+    // Returns the sample time of a tick of the running metronome, or 0 if the metronome is not running
+    UInt64 sampleTimeForTick(UInt32 tick);
+
+    // While rendering offline, the metronome is driven manually and the sample times of the ticks are relative to the
+    // sample time of the sampler when the rendering started. The mixer must be stopped.
+    void startOfflineRendering();
+    void stopOfflineRendering();
+    bool isOfflineRendering() { return _isOfflineRendering; }
+
     void setMixerLevel(int source, Float32 level, int channel);
     Float32 mixerLevel(int channel);
     void setMixerBalance(int source, Float32 balance, int channel);
@@ -299,7 +359,7 @@ class Studio {
 
     Float32 pitchBendFactor(int channel);
 
-    void sendSystemExclusive(int source, std::vector<UInt8> data, int channel);
+    void sendSystemExclusive(int source, const std::vector<UInt8>& data, int channel);
 
     void stopNotes(int source, int channel);
     void clearVoices(int channel);
@@ -313,6 +373,7 @@ class Studio {
         return std::make_pair(_mixer->outputDeviceName(), _mixer->outputLatency());
     }
     void setAudioOutputDevice(const std::string& audioOutputDeviceName, double latency);
+    void setAudioFormat(Float64 sampleRate, UInt32 framesPerBuffer);
     void startMixer();
     void stopMixer();
 
@@ -325,6 +386,17 @@ class Studio {
     void setMetronomeTimeSignatures(int source,
                                     std::vector<std::pair<UInt32, std::pair<UInt32, UInt32>>> timeSignatures);
 
+    // When enabled, the metronome is driven by the blocks rendered by the mixer and the events are scheduled one block
+    // ahead at the sample time of their tick instead of following the system clock. Must be called while the metronome
+    // is stopped.
+    void setIsAudioClockEnabled(bool isAudioClockEnabled);
+    bool isAudioClockEnabled() { return _isAudioClockEnabled; }
+
+    // When enabled, the body of the large samples loaded afterwards is streamed from the SoundFont by the sampler.
+    // Must be called while the mixer is stopped.
+    void setIsStreamingEnabled(bool isStreamingEnabled);
+    bool isStreamingEnabled() { return _sampler->isStreaming(); }
+
     bool isMetronomeRunning();
     void startMetronome();
     void stopMetronome();
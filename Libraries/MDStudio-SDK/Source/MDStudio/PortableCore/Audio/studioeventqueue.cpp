@@ -0,0 +1,146 @@
+//
+//  studioeventqueue.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-10.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "studioeventqueue.h"
+
+#include <algorithm>
+
+#define STUDIO_EVENT_DROPPED 0xFF
+
+#define STUDIO_EVENT_NB_CONTROLLER_TYPES (STUDIO_EVENT_LAST_CONTROLLER - STUDIO_EVENT_FIRST_CONTROLLER + 1)
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+StudioEventQueue::StudioEventQueue(size_t capacity)
+    : _enqueuePos(0), _dequeuePos(0), _isOverflowing(false), _generation(0) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+
+    _cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) _cells[i].sequence.store(i, std::memory_order_relaxed);
+    _mask = size - 1;
+
+    _coalescingSlots.resize(STUDIO_EVENT_NB_CONTROLLER_TYPES * STUDIO_EVENT_QUEUE_MAX_CHANNELS * 128, {0, 0});
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Each cell carries a sequence number telling whether it is free for the producer claiming the position or ready for
+// the consumer, so the producers only compete on the enqueue position.
+bool StudioEventQueue::tryEnqueue(const StudioEvent& event) {
+    Cell* cell;
+    size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        cell = &_cells[pos & _mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // Full
+            return false;
+        } else {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->event = event;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Once an event has overflowed, the following ones are also appended to the overflow list until it is drained, even if
+// the queue has room again, so that none of them is delivered before it.
+void StudioEventQueue::enqueue(const StudioEvent& event) {
+    if (!_isOverflowing.load(std::memory_order_acquire) && tryEnqueue(event)) return;
+
+    std::lock_guard<std::mutex> lock(_overflowedEventsMutex);
+    if (!_isOverflowing.load(std::memory_order_relaxed) && tryEnqueue(event)) return;
+    _overflowedEvents.push_back(event);
+    _isOverflowing.store(true, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool StudioEventQueue::tryDequeue(StudioEvent* event) {
+    size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell = &_cells[pos & _mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0) return false;
+
+    *event = cell->event;
+    _dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// A controller update is dropped when the next update of the same controller in the batch comes from the same source
+// at the same tick. The notes and the other events are always kept, so the recorded performance is unchanged.
+void StudioEventQueue::coalesce(std::vector<StudioEvent>* events) {
+    if (++_generation == 0) {
+        std::fill(_coalescingSlots.begin(), _coalescingSlots.end(), CoalescingSlot{0, 0});
+        _generation = 1;
+    }
+
+    bool isDropping = false;
+
+    for (size_t i = events->size(); i-- > 0;) {
+        StudioEvent& event = (*events)[i];
+        if (event.type < STUDIO_EVENT_FIRST_CONTROLLER || event.type > STUDIO_EVENT_LAST_CONTROLLER) continue;
+        if (event.channel < 0 || event.channel >= STUDIO_EVENT_QUEUE_MAX_CHANNELS) continue;
+
+        SInt32 param = 0;
+        if (event.type == STUDIO_EVENT_CONTROL_VALUE || event.type == STUDIO_EVENT_KEY_AFTERTOUCH) {
+            param = event.param1;
+            if (param < 0 || param > 127) continue;
+        }
+
+        size_t slotIndex =
+            ((event.type - STUDIO_EVENT_FIRST_CONTROLLER) * STUDIO_EVENT_QUEUE_MAX_CHANNELS + event.channel) * 128 +
+            param;
+        CoalescingSlot& slot = _coalescingSlots[slotIndex];
+
+        if (slot.generation == _generation) {
+            const StudioEvent& nextEvent = (*events)[slot.eventIndex];
+            if (nextEvent.tick == event.tick && nextEvent.source == event.source) {
+                event.type = STUDIO_EVENT_DROPPED;
+                isDropping = true;
+                continue;
+            }
+        }
+
+        slot.generation = _generation;
+        slot.eventIndex = static_cast<UInt32>(i);
+    }
+
+    if (isDropping)
+        events->erase(std::remove_if(events->begin(), events->end(),
+                                     [](const StudioEvent& event) { return event.type == STUDIO_EVENT_DROPPED; }),
+                      events->end());
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void StudioEventQueue::drain(std::vector<StudioEvent>* events) {
+    events->clear();
+
+    StudioEvent event;
+    while (tryDequeue(&event)) events->push_back(event);
+
+    // The overflowed events follow the ones queued before the first of them, the queue being possibly refilled before
+    // the lock is taken
+    if (_isOverflowing.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(_overflowedEventsMutex);
+        while (tryDequeue(&event)) events->push_back(event);
+        events->insert(events->end(), _overflowedEvents.begin(), _overflowedEvents.end());
+        _overflowedEvents.clear();
+        _isOverflowing.store(false, std::memory_order_release);
+    }
+
+    coalesce(events);
+}
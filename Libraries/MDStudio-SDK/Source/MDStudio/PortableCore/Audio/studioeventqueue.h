@@ -0,0 +1,105 @@
+//
+//  studioeventqueue.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-04-10.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef STUDIOEVENTQUEUE_H
+#define STUDIOEVENTQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "types.h"
+
+#define STUDIO_EVENT_QUEUE_CAPACITY 4096
+
+#define STUDIO_EVENT_PLAY_NOTE 0
+#define STUDIO_EVENT_RELEASE_NOTE 1
+#define STUDIO_EVENT_INSTRUMENT 2
+#define STUDIO_EVENT_TEMPO 3
+#define STUDIO_EVENT_TIME_SIGNATURE 4
+#define STUDIO_EVENT_MIXER_LEVEL 5
+#define STUDIO_EVENT_MIXER_BALANCE 6
+#define STUDIO_EVENT_SUSTAIN 7
+#define STUDIO_EVENT_PITCH_BEND 8
+#define STUDIO_EVENT_MODULATION 9
+#define STUDIO_EVENT_CONTROL_VALUE 10
+#define STUDIO_EVENT_KEY_AFTERTOUCH 11
+#define STUDIO_EVENT_CHANNEL_AFTERTOUCH 12
+
+// Range of the controller types that can be coalesced
+#define STUDIO_EVENT_FIRST_CONTROLLER STUDIO_EVENT_MIXER_LEVEL
+#define STUDIO_EVENT_LAST_CONTROLLER STUDIO_EVENT_CHANNEL_AFTERTOUCH
+
+#define STUDIO_EVENT_QUEUE_MAX_CHANNELS 16
+
+namespace MDStudio {
+
+// Notification of the studio waiting to be delivered on the main thread.
+// param1: pitch, instrument, control, MPQN or time signature numerator
+// param2: control value or time signature denominator
+struct StudioEvent {
+    UInt8 type;
+    SInt8 channel;
+    SInt16 source;
+    UInt32 tick;
+    SInt32 param1;
+    UInt32 param2;
+    Float32 value;
+};
+
+// Bounded multiple-producer, single-consumer queue of studio events. Any thread may enqueue without locking or
+// allocating. The main thread drains the queue in batches and drops the controller updates that are superseded by
+// a later update of the same controller at the same tick. When the queue is full, the events are appended to an
+// overflow list under a lock until the next drain, so that they are still delivered in order.
+class StudioEventQueue {
+    struct Cell {
+        std::atomic<size_t> sequence;
+        StudioEvent event;
+    };
+
+    struct CoalescingSlot {
+        UInt32 generation;
+        UInt32 eventIndex;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask;
+    std::atomic<size_t> _enqueuePos;
+    std::atomic<size_t> _dequeuePos;
+
+    std::atomic<bool> _isOverflowing;
+    std::vector<StudioEvent> _overflowedEvents;
+    std::mutex _overflowedEventsMutex;
+
+    std::vector<CoalescingSlot> _coalescingSlots;
+    UInt32 _generation;
+
+    void coalesce(std::vector<StudioEvent>* events);
+
+   public:
+    // The capacity is rounded up to the next power of two
+    StudioEventQueue(size_t capacity = STUDIO_EVENT_QUEUE_CAPACITY);
+
+    // Returns false if the queue is full (called from any thread)
+    bool tryEnqueue(const StudioEvent& event);
+
+    // Falls back to the overflow list if the queue is full or still overflowing (called from any thread)
+    void enqueue(const StudioEvent& event);
+
+    // Returns false if the queue is empty (called from the consumer thread only)
+    bool tryDequeue(StudioEvent* event);
+
+    // Replaces the content of the given vector by the pending events followed by the overflowed ones, coalesced (called
+    // from the consumer thread only)
+    void drain(std::vector<StudioEvent>* events);
+};
+
+}  // namespace MDStudio
+
+#endif  // STUDIOEVENTQUEUE_H
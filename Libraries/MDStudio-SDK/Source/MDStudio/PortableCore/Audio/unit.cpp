@@ -11,4 +11,14 @@
 using namespace MDStudio;
 
 // ---------------------------------------------------------------------------------------------------------------------
-Unit::Unit() { _isRunning = false; }
+Unit::Unit() {
+    _isRunning = false;
+    _sampleRate = UNIT_DEFAULT_SAMPLE_RATE;
+    _framesPerBuffer = UNIT_DEFAULT_FRAMES_PER_BUFFER;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Unit::setFormat(Float64 sampleRate, UInt32 framesPerBuffer) {
+    _sampleRate = sampleRate;
+    _framesPerBuffer = framesPerBuffer;
+}
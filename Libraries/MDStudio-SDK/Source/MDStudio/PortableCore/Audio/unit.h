@@ -12,20 +12,37 @@
 #include <atomic>
 
 #include "../types.h"
+#include "renderstats.h"
+
+#define UNIT_DEFAULT_SAMPLE_RATE 44100.0
+#define UNIT_DEFAULT_FRAMES_PER_BUFFER 256
 
 namespace MDStudio {
 
 class Unit {
     std::atomic<bool> _isRunning;
+    RenderStats _renderStats;
+
+   protected:
+    Float64 _sampleRate;
+    UInt32 _framesPerBuffer;  // Maximum number of frames per render call
 
    public:
     Unit();
     virtual ~Unit() = default;
 
+    // Sets the format used for rendering. Never called while rendering, so the units may reallocate their buffers.
+    virtual void setFormat(Float64 sampleRate, UInt32 framesPerBuffer);
+    Float64 sampleRate() { return _sampleRate; }
+    UInt32 framesPerBuffer() { return _framesPerBuffer; }
+
     virtual int renderInput(UInt32 inNumberFrames, GraphSampleType* ioData[2], UInt32 stride = 1) = 0;
 
     void setIsRunning(bool isRunning) { _isRunning = isRunning; }
     bool isRunning() { return _isRunning; }
+
+    // Render times recorded by the mixer
+    RenderStats& renderStats() { return _renderStats; }
 };
 
 }  // namespace MDStudio
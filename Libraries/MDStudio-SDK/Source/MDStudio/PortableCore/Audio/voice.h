@@ -18,6 +18,8 @@
 
 namespace MDStudio {
 
+struct SampleStream;
+
 struct Voice {
     UInt32 channel;
 
@@ -26,7 +28,10 @@ struct Voice {
     Float32 instrumentBasePitch;
     Float64 instrumentSampleRate;
 
-    SampleType* data;
+    const void* data;  // Sample data in the format below
+    UInt8 dataFormat;
+    Float32 dataGain;      // Factor applied to the data when rendered
+    SampleStream* stream;  // Frames of a streamed sample past its head, nullptr otherwise
     UInt64 length;
     UInt64 loopStart;
     UInt64 loopEnd;
@@ -3,7 +3,7 @@
 //  MDStudio
 //
 //  Created by Daniel Cliche on 2014-06-15.
-//  Copyright (c) 2014-2020 Daniel Cliche. All rights reserved.
+//  Copyright (c) 2014-2021 Daniel Cliche. All rights reserved.
 //
 
 #include "db.h"
@@ -24,7 +24,7 @@ static int callback(void* sender, int argc, char** argv, char** azColName) {
     for (i = 0; i < argc; i++) {
         columns.push_back(std::make_pair(std::string(azColName[i]), std::string(argv[i] ? argv[i] : "")));
     }
-    db->addRow(columns);
+    db->addRow(std::move(columns));
     return 0;
 }
 
@@ -136,11 +136,37 @@ bool DB::writeBlob(const char* command, char* blob, size_t size, bool rollbackOn
     return rc == SQLITE_OK;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+DB::Statement* DB::prepare(const char* sql, bool rollbackOnError) {
+    auto it = _statements.find(sql);
+    if (it != _statements.end()) {
+        it->second->reset();
+        return it->second.get();
+    }
+
+    sqlite3_stmt* stmt;
+    int rc = sqlite3_prepare_v2(_db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK) {
+        std::cout << "SQL error: " << sqlite3_errmsg(_db) << std::endl;
+        std::cout << "  Command: " << sql << std::endl;
+        if (rollbackOnError) exec("ROLLBACK;", false);
+        return nullptr;
+    }
+
+    Statement* statement = new Statement(this, stmt);
+    _statements.emplace(sql, std::unique_ptr<Statement>(statement));
+    return statement;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 sqlite3_int64 DB::lastInsertID() { return sqlite3_last_insert_rowid(_db); }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void DB::close() { sqlite3_close(_db); }
+void DB::close() {
+    // The statements must be finalized before closing the connection
+    _statements.clear();
+    sqlite3_close(_db);
+}
 
 // ---------------------------------------------------------------------------------------------------------------------
 void DB::printResults() {
@@ -152,3 +178,61 @@ void DB::printResults() {
         std::cout << std::endl;
     }
 }
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool DB::Statement::bindInt64(int index, sqlite3_int64 value) {
+    return sqlite3_bind_int64(_stmt, index, value) == SQLITE_OK;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool DB::Statement::bindDouble(int index, double value) {
+    return sqlite3_bind_double(_stmt, index, value) == SQLITE_OK;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool DB::Statement::bindText(int index, const std::string& text) {
+    return sqlite3_bind_text(_stmt, index, text.c_str(), static_cast<int>(text.size()), SQLITE_TRANSIENT) == SQLITE_OK;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool DB::Statement::bindBlob(int index, const void* data, size_t size) {
+    return sqlite3_bind_blob(_stmt, index, data, static_cast<int>(size), SQLITE_STATIC) == SQLITE_OK;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool DB::Statement::bindNull(int index) { return sqlite3_bind_null(_stmt, index) == SQLITE_OK; }
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool DB::Statement::step(bool rollbackOnError) {
+    _rc = sqlite3_step(_stmt);
+    if (_rc == SQLITE_ROW) return true;
+
+    if (_rc != SQLITE_DONE) {
+        std::cout << "SQL error: " << sqlite3_errmsg(sqlite3_db_handle(_stmt)) << std::endl;
+        std::cout << "  Command: " << sqlite3_sql(_stmt) << std::endl;
+        // The statement must be reset before the rollback can release the transaction
+        sqlite3_reset(_stmt);
+        if (rollbackOnError) _db->exec("ROLLBACK;", false);
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool DB::Statement::exec(bool rollbackOnError) {
+    while (step(rollbackOnError)) {
+    }
+    return isDone();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void DB::Statement::reset() {
+    sqlite3_reset(_stmt);
+    sqlite3_clear_bindings(_stmt);
+    _rc = SQLITE_OK;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+const char* DB::Statement::columnText(int column) {
+    const unsigned char* text = sqlite3_column_text(_stmt, column);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
@@ -3,7 +3,7 @@
 //  MDStudio
 //
 //  Created by Daniel Cliche on 2014-06-15.
-//  Copyright (c) 2014-2020 Daniel Cliche. All rights reserved.
+//  Copyright (c) 2014-2021 Daniel Cliche. All rights reserved.
 //
 
 #ifndef DB_H
@@ -11,14 +11,58 @@
 
 #include <sqlite3.h>
 
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace MDStudio {
 class DB {
+   public:
+    // Prepared statement owned by the statement cache of the database. The parameters are numbered from 1 and the
+    // columns from 0. The values read from a row are valid until the next step or reset.
+    class Statement {
+        DB* _db;
+        sqlite3_stmt* _stmt;
+        int _rc;
+
+       public:
+        Statement(DB* db, sqlite3_stmt* stmt) : _db(db), _stmt(stmt), _rc(SQLITE_OK) {}
+        ~Statement() { sqlite3_finalize(_stmt); }
+
+        bool bindInt64(int index, sqlite3_int64 value);
+        bool bindDouble(int index, double value);
+        bool bindText(int index, const std::string& text);
+        bool bindBlob(int index, const void* data, size_t size);  // The data must remain valid until the next reset
+        bool bindNull(int index);
+
+        // Moves to the next row. Returns false once all the rows are read or on error.
+        bool step(bool rollbackOnError = false);
+
+        // Runs a statement returning no row
+        bool exec(bool rollbackOnError = false);
+
+        // Returns true if the statement ran to completion without error
+        bool isDone() const { return _rc == SQLITE_DONE; }
+
+        // Resets the statement and clears its bindings
+        void reset();
+
+        int columnType(int column) { return sqlite3_column_type(_stmt, column); }
+        bool isNull(int column) { return columnType(column) == SQLITE_NULL; }
+        sqlite3_int64 columnInt64(int column) { return sqlite3_column_int64(_stmt, column); }
+        double columnDouble(int column) { return sqlite3_column_double(_stmt, column); }
+        const char* columnText(int column);  // Empty string if null
+        const void* columnBlob(int column) { return sqlite3_column_blob(_stmt, column); }
+        size_t columnBytes(int column) { return static_cast<size_t>(sqlite3_column_bytes(_stmt, column)); }
+    };
+
+   private:
     sqlite3* _db;
     std::vector<std::vector<std::pair<std::string, std::string>>> _rows;
+    std::map<std::string, std::unique_ptr<Statement>, std::less<>> _statements;
 
    public:
     bool open(const char* path);
@@ -26,13 +70,20 @@ class DB {
     bool readBlob(const char* command, char** blob, size_t* size, bool rollbackOnError = false);
     bool writeBlob(const char* command, char* blob, size_t size, bool rollbackOnError = false);
 
+    // Returns the reset statement prepared for the given SQL, compiling it on first use, or nullptr on error. A
+    // statement must not be prepared again while its rows are being read.
+    Statement* prepare(const char* sql, bool rollbackOnError = false);
+    Statement* prepare(const std::string& sql, bool rollbackOnError = false) {
+        return prepare(sql.c_str(), rollbackOnError);
+    }
+
     sqlite3_int64 lastInsertID();
 
     void close();
 
     void clearResults() { _rows.clear(); }
-    void addRow(std::vector<std::pair<std::string, std::string>> columns) { _rows.push_back(columns); }
-    std::vector<std::vector<std::pair<std::string, std::string>>> rows() { return _rows; }
+    void addRow(std::vector<std::pair<std::string, std::string>> columns) { _rows.push_back(std::move(columns)); }
+    const std::vector<std::vector<std::pair<std::string, std::string>>>& rows() const { return _rows; }
 
     void printResults();
 };
@@ -0,0 +1,117 @@
+//
+//  mappedfile.cpp
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile() {
+    _data = nullptr;
+    _size = 0;
+#ifdef _WIN32
+    _fileHandle = INVALID_HANDLE_VALUE;
+    _mappingHandle = NULL;
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile() { close(); }
+
+#ifdef _WIN32
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    _fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (_fileHandle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_fileHandle, &size) || size.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    _mappingHandle = CreateFileMappingA(_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (_mappingHandle == NULL) {
+        close();
+        return false;
+    }
+
+    _data = static_cast<const UInt8*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr) {
+        close();
+        return false;
+    }
+
+    _size = static_cast<size_t>(size.QuadPart);
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void MappedFile::close() {
+    if (_data) UnmapViewOfFile(_data);
+    if (_mappingHandle != NULL) CloseHandle(_mappingHandle);
+    if (_fileHandle != INVALID_HANDLE_VALUE) CloseHandle(_fileHandle);
+
+    _data = nullptr;
+    _size = 0;
+    _fileHandle = INVALID_HANDLE_VALUE;
+    _mappingHandle = NULL;
+}
+
+#else
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping remains valid once the descriptor is closed
+    ::close(fd);
+
+    if (data == MAP_FAILED) return false;
+
+    _data = static_cast<const UInt8*>(data);
+    _size = static_cast<size_t>(st.st_size);
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void MappedFile::close() {
+    if (_data) munmap(const_cast<UInt8*>(_data), _size);
+
+    _data = nullptr;
+    _size = 0;
+}
+
+#endif
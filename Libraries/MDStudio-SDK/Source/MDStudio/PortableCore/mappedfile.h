@@ -0,0 +1,47 @@
+//
+//  mappedfile.h
+//  MDStudio
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+
+#include <string>
+
+#include "types.h"
+
+namespace MDStudio {
+
+// Read-only memory mapping of a whole file. The pages are loaded by the system on first access.
+class MappedFile {
+    const UInt8* _data;
+    size_t _size;
+
+#ifdef _WIN32
+    void* _fileHandle;
+    void* _mappingHandle;
+#endif
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+   public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() { return _data != nullptr; }
+    const UInt8* data() { return _data; }
+    size_t size() { return _size; }
+};
+
+}  // namespace MDStudio
+
+#endif  // MAPPEDFILE_H
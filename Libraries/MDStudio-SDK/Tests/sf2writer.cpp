@@ -0,0 +1,125 @@
+//
+//  sf2writer.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "sf2writer.h"
+
+#include <soundfont2.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+static void appendBytes(std::vector<UInt8>* data, const void* bytes, size_t size) {
+    data->insert(data->end(), (const UInt8*)bytes, (const UInt8*)bytes + size);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static void appendChunk(std::vector<UInt8>* data, const char* id, const std::vector<UInt8>& chunkData) {
+    UInt32 size = (UInt32)chunkData.size();
+    appendBytes(data, id, 4);
+    appendBytes(data, &size, sizeof(size));
+    appendBytes(data, chunkData.data(), chunkData.size());
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static void appendList(std::vector<UInt8>* data, const char* type, const std::vector<UInt8>& listData) {
+    std::vector<UInt8> chunkData;
+    appendBytes(&chunkData, type, 4);
+    appendBytes(&chunkData, listData.data(), listData.size());
+    appendChunk(data, "LIST", chunkData);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+template <class T>
+static std::vector<UInt8> records(const std::vector<T>& v) {
+    std::vector<UInt8> data;
+    appendBytes(&data, v.data(), v.size() * sizeof(T));
+    return data;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool writeTestSF2(const std::string& path, const std::vector<SInt16>& samples, const std::vector<UInt8>& samples24,
+                  bool hasDrumKit) {
+    std::vector<UInt8> info;
+    SoundFont2Version version = {1, 2};
+    appendChunk(&info, "ifil", records(std::vector<SoundFont2Version>{version}));
+    for (auto id : {"isng", "INAM", "ICRD", "IENG", "IPRD", "ICOP", "ICMT", "ISFT"})
+        appendChunk(&info, id, {'x', 0});
+
+    std::vector<UInt8> sdta;
+    appendChunk(&sdta, "smpl", records(samples));
+    if (!samples24.empty()) appendChunk(&sdta, "sm24", samples24);
+
+    // The presets followed by the terminal one
+    UInt16 nbPresets = hasDrumKit ? 3 : 2;
+    std::vector<SoundFont2PresetHeader> presetHeaders(nbPresets + 1);
+    memset(presetHeaders.data(), 0, presetHeaders.size() * sizeof(SoundFont2PresetHeader));
+    std::vector<SoundFont2PresetBag> presetBags;
+    for (UInt16 i = 0; i <= nbPresets; ++i) {
+        presetHeaders[i].preset = i;
+        presetHeaders[i].presetBagNdx = i;
+        presetBags.push_back({i, 0});
+    }
+    if (hasDrumKit) {
+        presetHeaders[2].preset = 0;
+        presetHeaders[2].bank = 128;
+    }
+
+    SoundFont2GenList instrumentGen;
+    instrumentGen.oper = 41;
+    instrumentGen.amount.shAmount = 0;
+    SoundFont2GenList terminalGen;
+    memset(&terminalGen, 0, sizeof(terminalGen));
+
+    std::vector<SoundFont2Inst> instruments(2);
+    memset(instruments.data(), 0, instruments.size() * sizeof(SoundFont2Inst));
+    instruments[1].bagNdx = 1;
+
+    SoundFont2InstGenList sampleGen;
+    sampleGen.oper = 53;
+    sampleGen.amount.shAmount = 0;
+    SoundFont2InstGenList terminalInstGen;
+    memset(&terminalInstGen, 0, sizeof(terminalInstGen));
+
+    std::vector<SoundFont2Sample> sampleHeaders(2);
+    memset(sampleHeaders.data(), 0, sampleHeaders.size() * sizeof(SoundFont2Sample));
+    sampleHeaders[0].end = (UInt32)samples.size();
+    sampleHeaders[0].endLoop = (UInt32)samples.size();
+    sampleHeaders[0].sampleRate = 22050;
+    sampleHeaders[0].originalKey = 60;
+
+    std::vector<UInt8> pdta;
+    appendChunk(&pdta, "phdr", records(presetHeaders));
+    appendChunk(&pdta, "pbag", records(presetBags));
+    appendChunk(&pdta, "pmod", records(std::vector<SoundFont2ModList>(1, SoundFont2ModList{0, 0, 0, 0, 0})));
+    std::vector<SoundFont2GenList> presetGens(nbPresets, instrumentGen);
+    presetGens.push_back(terminalGen);
+    appendChunk(&pdta, "pgen", records(presetGens));
+    appendChunk(&pdta, "inst", records(instruments));
+    appendChunk(&pdta, "ibag", records(std::vector<SoundFont2InstBag>{{0, 0}, {1, 0}}));
+    appendChunk(&pdta, "imod", records(std::vector<SoundFont2InstModList>(1, SoundFont2InstModList{0, 0, 0, 0, 0})));
+    appendChunk(&pdta, "igen", records(std::vector<SoundFont2InstGenList>{sampleGen, terminalInstGen}));
+    appendChunk(&pdta, "shdr", records(sampleHeaders));
+
+    std::vector<UInt8> sfbk;
+    appendBytes(&sfbk, "sfbk", 4);
+    appendList(&sfbk, "INFO", info);
+    appendList(&sfbk, "sdta", sdta);
+    appendList(&sfbk, "pdta", pdta);
+
+    std::vector<UInt8> file;
+    appendChunk(&file, "RIFF", sfbk);
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fwrite(file.data(), 1, file.size(), f);
+    fclose(f);
+
+    return true;
+}
@@ -0,0 +1,22 @@
+//
+//  sf2writer.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef SF2WRITER_H
+#define SF2WRITER_H
+
+#include <types.h>
+
+#include <string>
+#include <vector>
+
+// Writes a bank with two presets (0 and 1 of bank 0) playing the same instrument and sample, with 24-bit samples if
+// samples24 is not empty. A drum kit (preset 0 of bank 128) playing that instrument is added if requested.
+bool writeTestSF2(const std::string& path, const std::vector<SInt16>& samples, const std::vector<UInt8>& samples24,
+                  bool hasDrumKit = false);
+
+#endif  // SF2WRITER_H
@@ -0,0 +1,44 @@
+//
+//  sineinstrument.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "sineinstrument.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include <vector>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::shared_ptr<MultiInstrument> createSineMultiInstrument(const std::string& path, UInt32 length) {
+    std::vector<SInt16> data(length);
+    for (UInt32 i = 0; i < length; ++i) data[i] = (SInt16)(16000.0f * sinf(i * 2.0f * M_PI / 100.0f));
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return nullptr;
+    fwrite(data.data(), sizeof(SInt16), data.size(), f);
+    fclose(f);
+
+    auto instrument = std::make_shared<Instrument>();
+    instrument->setSF2SampleRate(44100.0);
+    instrument->setSF2SampleStart(0);
+    instrument->setSF2SampleEnd(length);
+    instrument->setSF2SampleBasePos(0);
+    instrument->loadSF2Sample(path);
+    instrument->setLoopStart(length / 4);
+    instrument->setLoopEnd(3 * length / 4);
+    instrument->setFilterFc(8000.0f);
+    instrument->setFilterQ(0.7f);
+
+    remove(path.c_str());
+
+    auto multiInstrument = std::make_shared<MultiInstrument>();
+    multiInstrument->addInstrument(instrument);
+    return multiInstrument;
+}
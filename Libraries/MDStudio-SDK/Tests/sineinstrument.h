@@ -0,0 +1,22 @@
+//
+//  sineinstrument.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef SINEINSTRUMENT_H
+#define SINEINSTRUMENT_H
+
+#include <multiinstrument.h>
+#include <types.h>
+
+#include <memory>
+#include <string>
+
+// Creates an instrument playing a raw 16-bit sine wave of the given length, looped over its middle half. The samples
+// are written to the given path, which is removed once loaded. Shared by the tests and the benchmarks.
+std::shared_ptr<MDStudio::MultiInstrument> createSineMultiInstrument(const std::string& path, UInt32 length);
+
+#endif  // SINEINSTRUMENT_H
@@ -0,0 +1,119 @@
+//
+//  test_audioexport.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_audioexport.h"
+
+#include <audioexport.h>
+#include <math.h>
+#include <sequencer.h>
+#include <stdio.h>
+#include <studio.h>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "sf2writer.h"
+
+extern "C" {
+#include <libaiff/libaiff.h>
+}
+
+using namespace MDStudio;
+
+#define TEST_EXPORT_PATH "test_audioexport.aif"
+#define TEST_EXPORT_TIME_DIVISION 480
+#define TEST_EXPORT_SAMPLE_LENGTH 64
+
+// ---------------------------------------------------------------------------------------------------------------------
+// One second at 120 BPM: a note played for a beat, then a beat of silence
+static std::shared_ptr<Sequence> createSequence() {
+    auto sequence = std::make_shared<Sequence>();
+    sequence->data.tickPeriod = 60.0 / (TEST_EXPORT_TIME_DIVISION * 125.0);
+
+    Track& track = sequence->data.tracks[0];
+    track.addEvent(makeEvent(EVENT_TYPE_PROGRAM_CHANGE, 0, 0, 0, 0));
+    track.addEvent(makeEvent(EVENT_TYPE_NOTE_ON, 0, 0, 60, 100));
+    track.addEvent(makeEvent(EVENT_TYPE_NOTE_OFF, 0, TEST_EXPORT_TIME_DIVISION, 60, 0));
+    track.addEvent(makeEvent(EVENT_TYPE_META_END_OF_TRACK, 0, TEST_EXPORT_TIME_DIVISION, 0, 0));
+
+    return sequence;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Reads the interleaved stereo samples of the exported file
+static bool readExport(std::vector<float>* samples, double* sampleRate) {
+    AIFF_Ref aiffRef = AIFF_OpenFile(TEST_EXPORT_PATH, F_RDONLY);
+    if (!aiffRef) return false;
+
+    uint64_t nbFrames;
+    int channels, bitsPerSample, segmentSize;
+    bool isRead = AIFF_GetAudioFormat(aiffRef, &nbFrames, &channels, sampleRate, &bitsPerSample, &segmentSize) > 0 &&
+                  channels == 2;
+    if (isRead) {
+        samples->resize(static_cast<size_t>(2 * nbFrames));
+        isRead = AIFF_ReadSamplesFloat(aiffRef, samples->data(), static_cast<int>(samples->size())) ==
+                 static_cast<int>(samples->size());
+    }
+
+    AIFF_CloseFile(aiffRef);
+    return isRead;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The sequence is rendered synchronously by a studio without audio device
+bool testAudioExport() {
+    std::vector<SInt16> samples(TEST_EXPORT_SAMPLE_LENGTH);
+    for (int i = 0; i < TEST_EXPORT_SAMPLE_LENGTH; ++i)
+        samples[i] = (SInt16)(16000.0f * sinf(i * 2.0f * M_PI / 16.0f));
+    if (!writeTestSF2("./GM.sf2", samples, {})) {
+        std::cout << "Unable to write the SoundFont\n";
+        return false;
+    }
+
+    bool isRendered;
+    {
+        Studio studio(STUDIO_MAX_CHANNELS, ".", SAMPLER_MAX_VOICES, true);
+        Sequencer sequencer(nullptr, &studio);
+        sequencer.setSequence(createSequence());
+
+        AudioExport audioExport(&sequencer);
+        isRendered = audioExport.renderAudio(TEST_EXPORT_PATH);
+    }
+
+    // The bank is unmapped once the studio is released
+    remove("./GM.sf2");
+
+    std::vector<float> output;
+    double sampleRate = 0.0;
+    bool isRead = isRendered && readExport(&output, &sampleRate);
+    remove(TEST_EXPORT_PATH);
+
+    if (!isRead) {
+        std::cout << "Unable to render the sequence\n";
+        return false;
+    }
+
+    // The sequence followed by one second of tail, the last block of the sequence being complete
+    size_t nbFrames = output.size() / 2;
+    size_t expectedNbFrames = static_cast<size_t>(2.0 * sampleRate);
+    if (nbFrames < expectedNbFrames || nbFrames > expectedNbFrames + AUDIO_EXPORT_BLOCK_FRAMES) {
+        std::cout << "Unexpected number of exported frames: " << nbFrames << "\n";
+        return false;
+    }
+
+    bool isSilent = true;
+    for (auto s : output)
+        if (s != 0.0f) isSilent = false;
+    if (isSilent) {
+        std::cout << "The exported sequence is silent\n";
+        return false;
+    }
+
+    return true;
+}
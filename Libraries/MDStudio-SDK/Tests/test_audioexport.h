@@ -0,0 +1,14 @@
+//
+//  test_audioexport.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_AUDIOEXPORT_H
+#define TEST_AUDIOEXPORT_H
+
+bool testAudioExport();
+
+#endif  // TEST_AUDIOEXPORT_H
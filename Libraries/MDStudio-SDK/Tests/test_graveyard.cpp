@@ -0,0 +1,98 @@
+//
+//  test_graveyard.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-20.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_graveyard.h"
+
+#include <graveyard.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The references that do not fit in the queue are kept until a later block and still collected by the collect thread
+static bool testOverflow() {
+    const int nbObjects = 48;
+    std::atomic<int> nbDestroyed(0), nbDestroyedByBuryingThread(0);
+    std::thread::id buryingThreadID = std::this_thread::get_id();
+
+    Graveyard graveyard(16, nbObjects);
+
+    for (int i = 0; i < nbObjects; ++i) {
+        std::shared_ptr<int> object(new int(i), [&](int* p) {
+            if (std::this_thread::get_id() == buryingThreadID) ++nbDestroyedByBuryingThread;
+            delete p;
+            ++nbDestroyed;
+        });
+        graveyard.bury(object);
+    }
+
+    if (graveyard.nbOverflowed() == 0) {
+        std::cout << "The full queue did not overflow\n";
+        return false;
+    }
+
+    // Each block enqueues the overflow again as the queue is collected
+    for (int i = 0; i < 100 && (nbDestroyed < nbObjects || graveyard.nbOverflowed() > 0); ++i) {
+        graveyard.retry();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (nbDestroyed != nbObjects || graveyard.nbOverflowed() != 0) {
+        std::cout << "The overflowed objects were not collected\n";
+        return false;
+    }
+
+    if (nbDestroyedByBuryingThread != 0) {
+        std::cout << "An overflowed object was destroyed by the burying thread\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testGraveyard() {
+    std::atomic<bool> isDestroyed(false);
+    std::thread::id destroyingThreadID;
+
+    Graveyard graveyard;
+
+    std::shared_ptr<int> object(new int(42), [&](int* p) {
+        destroyingThreadID = std::this_thread::get_id();
+        delete p;
+        isDestroyed = true;
+    });
+
+    graveyard.bury(object);
+
+    if (object) {
+        std::cout << "The reference was not moved into the graveyard\n";
+        return false;
+    }
+
+    // The object must be destroyed by the collect thread
+    for (int i = 0; i < 100 && !isDestroyed; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (!isDestroyed) {
+        std::cout << "The object was not collected\n";
+        return false;
+    }
+
+    if (destroyingThreadID == std::this_thread::get_id()) {
+        std::cout << "The object was destroyed by the burying thread\n";
+        return false;
+    }
+
+    if (!testOverflow()) return false;
+
+    return true;
+}
@@ -0,0 +1,14 @@
+//
+//  test_graveyard.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-20.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_GRAVEYARD_H
+#define TEST_GRAVEYARD_H
+
+bool testGraveyard();
+
+#endif  // TEST_GRAVEYARD_H
@@ -20,22 +20,21 @@ static bool compareSequences(Sequence* s1, Sequence* s2) {
 
     size_t trackIndex = 0;
     for (auto& track : s1->data.tracks) {
+        auto& track2 = s2->data.tracks[trackIndex];
         auto nbEvents1 = track.events.size();
-        auto nbEvents2 = s2->data.tracks[trackIndex].events.size();
+        auto nbEvents2 = track2.events.size();
         if (nbEvents1 != nbEvents2) return false;
         size_t eventIndex = 0;
         for (auto& e1 : track.events) {
-            auto& e2 = s2->data.tracks[trackIndex].events[eventIndex];
+            auto& e2 = track2.events[eventIndex];
             if (e1.type != e2.type || e1.channel != e2.channel || e1.param1 != e2.param1 || e1.param2 != e2.param2 ||
                 e1.tickCount != e2.tickCount)
                 return false;
 
-            if (e1.data.size() != e2.data.size()) return false;
+            if (track.dataLength(e1) != track2.dataLength(e2)) return false;
 
-            size_t dataIndex = 0;
-            for (auto& d : e1.data) {
-                if (d != e2.data[dataIndex]) return false;
-                dataIndex++;
+            for (UInt32 dataIndex = 0; dataIndex < track.dataLength(e1); ++dataIndex) {
+                if (track.data(e1)[dataIndex] != track2.data(e2)[dataIndex]) return false;
             }
 
             eventIndex++;
@@ -0,0 +1,251 @@
+//
+//  test_instrumentmanager.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_instrumentmanager.h"
+
+#include <instrumentloader.h>
+#include <instrumentmanager.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "sf2writer.h"
+
+using namespace MDStudio;
+
+#define TEST_SF2_NAME "test_instrumentmanager"
+#define TEST_SF2_24_NAME "test_instrumentmanager24"
+#define TEST_SF2_SAMPLE_LENGTH 64
+
+// ---------------------------------------------------------------------------------------------------------------------
+static size_t nbInstruments(std::shared_ptr<MultiInstrument> multiInstrument) {
+    return multiInstrument->instrumentsEnd() - multiInstrument->instrumentsBegin();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The requests of a preset being loaded are merged and the urgent ones are loaded first
+static bool testInstrumentLoader(InstrumentManager* instrumentManager) {
+    std::promise<void> firstLoadStarted, firstLoadRelease, allLoaded;
+    auto firstLoadReleaseFuture = firstLoadRelease.get_future();
+
+    std::vector<std::pair<int, int>> loadedPresets;
+
+    {
+        InstrumentLoader loader(instrumentManager, TEST_SF2_NAME, 1,
+                                [&](InstrumentLoader* sender, int bank, int number,
+                                    std::shared_ptr<MultiInstrument> multiInstrument) {
+                                    if (loadedPresets.empty()) {
+                                        firstLoadStarted.set_value();
+                                        firstLoadReleaseFuture.wait();
+                                    }
+                                    loadedPresets.push_back({bank, number});
+                                    if (loadedPresets.size() == 3) allLoaded.set_value();
+                                });
+
+        bool isQueued0 = loader.load(0, 0, false);
+
+        // The single thread is now busy with the first preset
+        firstLoadStarted.get_future().wait();
+
+        bool isMerged = !loader.load(0, 0, true);
+        bool isQueued1 = loader.load(0, 1, false);
+        bool isQueued2 = loader.load(1, 0, true);
+        firstLoadRelease.set_value();
+
+        if (allLoaded.get_future().wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+            std::cout << "The instruments were not loaded\n";
+            return false;
+        }
+
+        if (!isQueued0 || !isMerged || !isQueued1 || !isQueued2) {
+            std::cout << "Unexpected instrument requests\n";
+            return false;
+        }
+    }
+
+    if (loadedPresets != std::vector<std::pair<int, int>>{{0, 0}, {1, 0}, {0, 1}}) {
+        std::cout << "Unexpected instrument loading order\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The 24-bit samples are converted to floating point
+static bool testSamples24(const std::vector<SInt16>& samples) {
+    std::vector<UInt8> samples24(TEST_SF2_SAMPLE_LENGTH);
+    for (int i = 0; i < TEST_SF2_SAMPLE_LENGTH; ++i) samples24[i] = (UInt8)(i * 3);
+
+    std::string path = std::string("./") + TEST_SF2_24_NAME + ".sf2";
+    if (!writeTestSF2(path, samples, samples24)) {
+        std::cout << "Unable to write the SoundFont\n";
+        return false;
+    }
+
+    InstrumentManager instrumentManager(".");
+    auto multiInstrument = instrumentManager.loadSF2MultiInstrument(TEST_SF2_24_NAME, 0, 0);
+
+    // The converted sample does not need the file, which is unmapped once its last multi-instrument is unloaded
+    if (multiInstrument) instrumentManager.unloadMultiInstrument(multiInstrument);
+    remove(path.c_str());
+
+    if (!multiInstrument || nbInstruments(multiInstrument) != 1) {
+        std::cout << "Unable to load the 24-bit multi-instrument\n";
+        return false;
+    }
+
+    auto sample = (*multiInstrument->instrumentsBegin())->sample();
+    if (!sample || sample->format() != SAMPLE_FORMAT_FLOAT32 || !sample->data()) {
+        std::cout << "Unexpected 24-bit sample storage\n";
+        return false;
+    }
+
+    for (int i = 0; i < TEST_SF2_SAMPLE_LENGTH; ++i) {
+        SampleType expected = (SampleType)(samples[i] * 256 + samples24[i]) / 16777216.0f * 0.95f;
+        if (fabsf(sample->data()[i] - expected) > 1e-7f) {
+            std::cout << "24-bit sample data mismatch at " << i << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The presets loaded concurrently share the bank and the sample converted by the first thread to complete
+static bool testConcurrentLoads() {
+    InstrumentManager instrumentManager(".");
+
+    std::vector<std::future<std::shared_ptr<MultiInstrument>>> loads;
+    for (int i = 0; i < 8; ++i)
+        loads.push_back(std::async(std::launch::async, [&instrumentManager, i]() {
+            return instrumentManager.loadSF2MultiInstrument(TEST_SF2_NAME, 0, i % 2);
+        }));
+
+    std::shared_ptr<Sample> sample;
+    for (auto& load : loads) {
+        auto multiInstrument = load.get();
+        if (!multiInstrument || nbInstruments(multiInstrument) != 1) {
+            std::cout << "Unable to load the multi-instruments concurrently\n";
+            return false;
+        }
+
+        auto instrumentSample = (*multiInstrument->instrumentsBegin())->sample();
+        if (!sample) sample = instrumentSample;
+        if (!instrumentSample || instrumentSample != sample) {
+            std::cout << "The sample is not shared between the concurrent loads\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testInstrumentManager() {
+    std::vector<SInt16> samples(TEST_SF2_SAMPLE_LENGTH);
+    for (int i = 0; i < TEST_SF2_SAMPLE_LENGTH; ++i) samples[i] = (SInt16)(16000.0f * sinf(i * 2.0f * M_PI / 16.0f));
+
+    std::string path = std::string("./") + TEST_SF2_NAME + ".sf2";
+    if (!writeTestSF2(path, samples, {})) {
+        std::cout << "Unable to write the SoundFont\n";
+        return false;
+    }
+
+    InstrumentManager instrumentManager(".");
+
+    auto presets = instrumentManager.getSF2Presets(TEST_SF2_NAME);
+    auto multiInstrument0 = instrumentManager.loadSF2MultiInstrument(TEST_SF2_NAME, 0, 0);
+    auto multiInstrument1 = instrumentManager.loadSF2MultiInstrument(TEST_SF2_NAME, 0, 1);
+    auto missingMultiInstrument = instrumentManager.loadSF2MultiInstrument(TEST_SF2_NAME, 1, 0);
+
+    if (presets.size() != 2) {
+        std::cout << "Unexpected number of presets\n";
+        return false;
+    }
+
+    if (!multiInstrument0 || !multiInstrument1 || !missingMultiInstrument) {
+        std::cout << "Unable to load the multi-instruments\n";
+        return false;
+    }
+
+    if (nbInstruments(multiInstrument0) != 1 || nbInstruments(multiInstrument1) != 1 ||
+        nbInstruments(missingMultiInstrument) != 0) {
+        std::cout << "Unexpected number of instruments\n";
+        return false;
+    }
+
+    auto sample = (*multiInstrument0->instrumentsBegin())->sample();
+    if (!sample || sample != (*multiInstrument1->instrumentsBegin())->sample()) {
+        std::cout << "The sample is not shared between the presets\n";
+        return false;
+    }
+
+    if (sample->length() != TEST_SF2_SAMPLE_LENGTH || sample->sampleRate() != 22050.0) {
+        std::cout << "Unexpected sample format\n";
+        return false;
+    }
+
+    // The 16-bit samples are kept as is
+    if (sample->format() != SAMPLE_FORMAT_INT16 || sample->data() || fabsf(sample->gain() - 0.95f / 65536.0f) > 1e-9f) {
+        std::cout << "Unexpected sample storage\n";
+        return false;
+    }
+
+    for (int i = 0; i < TEST_SF2_SAMPLE_LENGTH; ++i) {
+        if (sample->data16()[i] != samples[i]) {
+            std::cout << "Sample data mismatch at " << i << "\n";
+            return false;
+        }
+    }
+
+    // Unloading a multi-instrument keeps the samples still used by another one
+    instrumentManager.unloadMultiInstrument(multiInstrument1);
+    multiInstrument1 = instrumentManager.loadSF2MultiInstrument(TEST_SF2_NAME, 0, 1);
+    if (!multiInstrument1 || (*multiInstrument1->instrumentsBegin())->sample() != sample) {
+        std::cout << "The shared sample was released\n";
+        return false;
+    }
+
+    // Once released, the sample is converted again on demand
+    sample = nullptr;
+    multiInstrument0 = nullptr;
+    instrumentManager.unloadMultiInstrument(multiInstrument1);
+    multiInstrument1 = nullptr;
+
+    multiInstrument0 = instrumentManager.loadSF2MultiInstrument(TEST_SF2_NAME, 0, 0);
+    if (!multiInstrument0 || !(*multiInstrument0->instrumentsBegin())->sample() ||
+        (*multiInstrument0->instrumentsBegin())->sample()->data16()[1] != samples[1]) {
+        std::cout << "Unable to reload the sample\n";
+        return false;
+    }
+
+    if (!testSamples24(samples)) return false;
+
+    if (!testInstrumentLoader(&instrumentManager)) return false;
+
+    if (!testConcurrentLoads()) return false;
+
+    // Unloading the last multi-instrument of the bank unmaps its file, which is parsed again on the next load
+    instrumentManager.unloadMultiInstrument(multiInstrument0);
+    multiInstrument0 = nullptr;
+    remove(path.c_str());
+
+    if (instrumentManager.loadSF2MultiInstrument(TEST_SF2_NAME, 0, 0)) {
+        std::cout << "The bank was not released\n";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,14 @@
+//
+//  test_instrumentmanager.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-27.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_INSTRUMENTMANAGER_H
+#define TEST_INSTRUMENTMANAGER_H
+
+bool testInstrumentManager();
+
+#endif  // TEST_INSTRUMENTMANAGER_H
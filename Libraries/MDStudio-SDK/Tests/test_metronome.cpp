@@ -0,0 +1,74 @@
+//
+//  test_metronome.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-28.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_metronome.h"
+
+#include <metronome.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace MDStudio;
+
+#define TEST_NB_CLOCK_TICKS 20
+#define TEST_CLOCK_START_TIME 8.0
+#define TEST_CLOCK_PERIOD (1.0 / 64.0)
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The position of a metronome driven by a clock must only depend on the time of that clock
+bool testMetronome() {
+    Metronome metronome;
+
+    // 120 BPM with 512 ticks per beat, so that a tick lasts exactly 1/1024 second
+    metronome.setTimeDivision(512);
+    metronome.setBPMs({{0, 120}});
+    metronome.setTimeSignatures({});
+
+    double clockTime = TEST_CLOCK_START_TIME;
+    metronome.setWaitForClockFn([&](Metronome* sender, double* time) {
+        *time = clockTime;
+        clockTime += TEST_CLOCK_PERIOD;
+        return true;
+    });
+
+    std::vector<UInt32> ticks;
+    std::vector<double> tickTimes;
+    std::atomic<bool> isDone(false);
+    metronome.setDidTickFn([&](Metronome* sender) {
+        ticks.push_back(sender->tick());
+        tickTimes.push_back(sender->timePointForTick(sender->tick()).time_since_epoch().count());
+        if (ticks.size() < TEST_NB_CLOCK_TICKS) return true;
+        isDone = true;
+        return false;
+    });
+
+    metronome.start();
+    for (int i = 0; i < 100 && !isDone; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    metronome.stop();
+
+    if (ticks.size() != TEST_NB_CLOCK_TICKS) {
+        std::cout << "The metronome did not follow the clock\n";
+        return false;
+    }
+
+    for (UInt32 i = 0; i < TEST_NB_CLOCK_TICKS; ++i) {
+        if (ticks[i] != i * 16) {
+            std::cout << "Unexpected tick " << ticks[i] << " at clock period " << i << "\n";
+            return false;
+        }
+        if (tickTimes[i] != TEST_CLOCK_START_TIME + i * TEST_CLOCK_PERIOD) {
+            std::cout << "Unexpected time point for tick " << ticks[i] << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,14 @@
+//
+//  test_metronome.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-28.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_METRONOME_H
+#define TEST_METRONOME_H
+
+bool testMetronome();
+
+#endif  // TEST_METRONOME_H
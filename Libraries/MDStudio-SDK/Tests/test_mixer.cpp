@@ -0,0 +1,142 @@
+//
+//  test_mixer.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_mixer.h"
+
+#include <lowpassfilterunit.h>
+#include <math.h>
+#include <mixer.h>
+#include <sineunit.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// A format set while running must not reach the units before the next start
+static bool testFormatChange() {
+    Mixer mixer(true);
+    mixer.setFramesPerBuffer(256);
+
+    auto sineUnit = std::make_shared<SineUnit>();
+    sineUnit->noteOn(69.0f, 1.0f);
+    mixer.addUnit(sineUnit);
+    auto filterUnit = std::make_shared<LowPassFilterUnit>();
+    mixer.addUnit(filterUnit);
+
+    std::atomic<UInt32> maxNbFrames(0);
+    mixer.setDidRenderNullOutputFn([&](Mixer* sender, const GraphSampleType* samples, UInt32 nbFrames) {
+        if (nbFrames > maxNbFrames) maxNbFrames = nbFrames;
+    });
+
+    if (!mixer.start()) {
+        std::cout << "Unable to start the null output\n";
+        return false;
+    }
+
+    mixer.waitForRender();
+    mixer.setFramesPerBuffer(1024);
+    mixer.setSampleRate(48000.0);
+    for (int i = 0; i < 20; ++i) mixer.waitForRender();
+
+    if (mixer.framesPerBuffer() != 256 || filterUnit->framesPerBuffer() != 256 || maxNbFrames != 256) {
+        std::cout << "The format was changed while running\n";
+        return false;
+    }
+
+    mixer.stop();
+    if (!mixer.start()) {
+        std::cout << "Unable to restart the null output\n";
+        return false;
+    }
+    for (int i = 0; i < 20; ++i) mixer.waitForRender();
+    mixer.stop();
+
+    if (mixer.framesPerBuffer() != 1024 || mixer.sampleRate() != 48000.0 || filterUnit->framesPerBuffer() != 1024 ||
+        filterUnit->sampleRate() != 48000.0 || maxNbFrames != 1024) {
+        std::cout << "The format was not applied at the next start\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testMixer() {
+    Mixer mixer(true);
+
+    if (mixer.outputDeviceName() != MIXER_NULL_OUTPUT_DEVICE_NAME) {
+        std::cout << "Unexpected output device\n";
+        return false;
+    }
+
+    auto sineUnit = std::make_shared<SineUnit>();
+    sineUnit->noteOn(69.0f, 1.0f);
+    mixer.addUnit(sineUnit);
+
+    std::atomic<UInt64> nbRenderedFrames(0);
+    std::atomic<bool> isSilent(true);
+    mixer.setDidRenderNullOutputFn([&](Mixer* sender, const GraphSampleType* samples, UInt32 nbFrames) {
+        for (UInt32 i = 0; i < 2 * nbFrames; ++i)
+            if (fabsf(samples[i]) > 0.0f) isSilent = false;
+        nbRenderedFrames += nbFrames;
+    });
+
+    if (!mixer.start()) {
+        std::cout << "Unable to start the null output\n";
+        return false;
+    }
+
+    // The blocks are rendered without any device
+    for (int i = 0; i < 100; ++i) {
+        if (!mixer.waitForRender()) {
+            std::cout << "The mixer did not render\n";
+            return false;
+        }
+    }
+
+    mixer.stop();
+
+    if (nbRenderedFrames < 100 * mixer.framesPerBuffer()) {
+        std::cout << "Not enough frames rendered: " << nbRenderedFrames << "\n";
+        return false;
+    }
+
+    if (isSilent) {
+        std::cout << "The output of the units was not rendered\n";
+        return false;
+    }
+
+    if (mixer.waitForRender()) {
+        std::cout << "The mixer is still rendering after being stopped\n";
+        return false;
+    }
+
+    // Every block and every unit render is timed
+    RenderStatsSnapshot stats = mixer.renderStats().snapshot();
+    RenderStatsSnapshot unitStats = sineUnit->renderStats().snapshot();
+    UInt64 nbHistogramRenders = 0;
+    for (auto count : stats.histogram) nbHistogramRenders += count;
+    if (stats.nbRenders < 100 || unitStats.nbRenders != stats.nbRenders || nbHistogramRenders != stats.nbRenders ||
+        stats.maxRenderTime == 0 || stats.peakLoad <= 0.0f) {
+        std::cout << "Unexpected render statistics\n";
+        return false;
+    }
+
+    mixer.resetStats();
+    if (mixer.renderStats().snapshot().nbRenders != 0 || sineUnit->renderStats().snapshot().nbRenders != 0) {
+        std::cout << "The render statistics were not reset\n";
+        return false;
+    }
+
+    if (!testFormatChange()) return false;
+
+    return true;
+}
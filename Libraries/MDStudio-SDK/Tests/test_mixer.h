@@ -0,0 +1,14 @@
+//
+//  test_mixer.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-17.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_MIXER_H
+#define TEST_MIXER_H
+
+bool testMixer();
+
+#endif  // TEST_MIXER_H
@@ -0,0 +1,476 @@
+//
+//  test_samplerunit.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-14.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_samplerunit.h"
+
+#include <math.h>
+#include <samplerunit.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "sineinstrument.h"
+
+using namespace MDStudio;
+
+#define TEST_SAMPLE_LENGTH 2000
+#define TEST_SAMPLE_MARGIN 32
+#define TEST_TOLERANCE 1e-5f
+
+// ---------------------------------------------------------------------------------------------------------------------
+static void initVoice(struct Voice* voice, const void* data, UInt8 dataFormat, Float32 dataGain, Float32 pitch,
+                      bool isLooped) {
+    voice->channel = 0;
+    voice->data = data;
+    voice->dataFormat = dataFormat;
+    voice->dataGain = dataGain;
+    voice->stream = nullptr;
+    voice->length = (UInt64)TEST_SAMPLE_LENGTH << VOICE_FRACTION_BITS;
+    voice->loopStart = isLooped ? (UInt64)500 << VOICE_FRACTION_BITS : 0;
+    voice->loopEnd = isLooped ? (UInt64)900 << VOICE_FRACTION_BITS : 0;
+    voice->pos = 0;
+    voice->pitch = pitch;
+    voice->isNoteSustained = false;
+    voice->volEnvFactor = 1.0f;
+    voice->volEnvHoldCounter = 100;
+    voice->isNoteOn = true;
+    voice->isPlaying = true;
+    voice->decayRatePerSample = 1.0f / (0.01f * 44100.0f);
+    voice->sustainLevel = 0.5f;
+    voice->releaseRatePerSample = 1.0f / (0.02f * 44100.0f);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static bool compareRenderers(SampleType* data, Float32 pitch, bool isLooped, UInt32 nbFramesBeforeRelease,
+                             UInt32 nbFrames, UInt32 blockSize) {
+    struct Voice refVoice, blockVoice;
+    initVoice(&refVoice, data, SAMPLE_FORMAT_FLOAT32, 1.0f, pitch, isLooped);
+    initVoice(&blockVoice, data, SAMPLE_FORMAT_FLOAT32, 1.0f, pitch, isLooped);
+
+    UInt64 rate = exp2f((pitch - 60.0f) / 12.0f) * ((UInt64)1 << VOICE_FRACTION_BITS);
+    if (pitch == 60.0f) rate = (UInt64)1 << VOICE_FRACTION_BITS;
+
+    std::vector<GraphSampleType> refOut(nbFrames), blockOut(nbFrames);
+
+    for (UInt32 i = 0; i < nbFrames; ++i) {
+        if (i == nbFramesBeforeRelease) refVoice.isNoteOn = false;
+        SamplerUnit::renderVoice(&refVoice, rate, &refOut[i]);
+    }
+
+    for (UInt32 i = 0; i < nbFrames;) {
+        if (i == nbFramesBeforeRelease) blockVoice.isNoteOn = false;
+        UInt32 n = (nbFrames - i) < blockSize ? (nbFrames - i) : blockSize;
+        // The block is split at the release like a command would
+        if (i < nbFramesBeforeRelease && i + n > nbFramesBeforeRelease) n = nbFramesBeforeRelease - i;
+        SamplerUnit::renderVoiceBlock(&blockVoice, rate, &blockOut[i], n);
+        i += n;
+    }
+
+    for (UInt32 i = 0; i < nbFrames; ++i) {
+        if (fabsf(refOut[i] - blockOut[i]) > TEST_TOLERANCE) {
+            std::cout << "Block output mismatch at frame " << i << " (pitch " << pitch << ")\n";
+            return false;
+        }
+    }
+
+    if (refVoice.pos != blockVoice.pos || refVoice.isPlaying != blockVoice.isPlaying ||
+        refVoice.volEnvFactor != blockVoice.volEnvFactor) {
+        std::cout << "Voice state mismatch (pitch " << pitch << ")\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The 16-bit data must be rendered like the same data converted to floating point
+static bool compareFormats(Float32 pitch) {
+    const Float32 gain = 0.95f / 65536.0f;
+
+    std::vector<SInt16> buffer16(TEST_SAMPLE_LENGTH + 2 * TEST_SAMPLE_MARGIN, 0);
+    std::vector<SampleType> buffer(TEST_SAMPLE_LENGTH + 2 * TEST_SAMPLE_MARGIN, 0.0f);
+    for (int i = 0; i < TEST_SAMPLE_LENGTH; ++i) {
+        buffer16[TEST_SAMPLE_MARGIN + i] = (SInt16)(30000.0f * sinf(i * 0.05f));
+        buffer[TEST_SAMPLE_MARGIN + i] = buffer16[TEST_SAMPLE_MARGIN + i] * gain;
+    }
+
+    struct Voice voice16, voice, refVoice16;
+    initVoice(&voice16, &buffer16[TEST_SAMPLE_MARGIN], SAMPLE_FORMAT_INT16, gain, pitch, true);
+    initVoice(&voice, &buffer[TEST_SAMPLE_MARGIN], SAMPLE_FORMAT_FLOAT32, 1.0f, pitch, true);
+    initVoice(&refVoice16, &buffer16[TEST_SAMPLE_MARGIN], SAMPLE_FORMAT_INT16, gain, pitch, true);
+
+    UInt64 rate = exp2f((pitch - 60.0f) / 12.0f) * ((UInt64)1 << VOICE_FRACTION_BITS);
+    if (pitch == 60.0f) rate = (UInt64)1 << VOICE_FRACTION_BITS;
+
+    const UInt32 nbFrames = 1000;
+    std::vector<GraphSampleType> out16(nbFrames), out(nbFrames), refOut16(nbFrames);
+    SamplerUnit::renderVoiceBlock(&voice16, rate, out16.data(), nbFrames);
+    SamplerUnit::renderVoiceBlock(&voice, rate, out.data(), nbFrames);
+    for (UInt32 i = 0; i < nbFrames; ++i) SamplerUnit::renderVoice(&refVoice16, rate, &refOut16[i]);
+
+    for (UInt32 i = 0; i < nbFrames; ++i) {
+        if (fabsf(out16[i] - out[i]) > TEST_TOLERANCE || fabsf(refOut16[i] - out[i]) > TEST_TOLERANCE) {
+            std::cout << "16-bit output mismatch at frame " << i << " (pitch " << pitch << ")\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Renders a block larger than the configured number of frames per buffer
+static bool testFormat() {
+    SamplerUnit samplerUnit(4);
+    samplerUnit.setFormat(48000.0, 64);
+
+    std::vector<GraphSampleType> outA(1000, 0.0f), outB(1000, 0.0f);
+    GraphSampleType* ioData[2] = {outA.data(), outB.data()};
+    samplerUnit.renderInput(1000, ioData, 1);
+
+    if (samplerUnit.sampleTime() != 1000) {
+        std::cout << "Unexpected sample time after rendering\n";
+        return false;
+    }
+
+    for (UInt32 i = 0; i < 1000; ++i) {
+        if (outA[i] != 0.0f || outB[i] != 0.0f) {
+            std::cout << "Silence expected at frame " << i << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The channels rendered by the worker pool must be mixed exactly like the single-threaded rendering
+static bool testParallelRendering() {
+    auto multiInstrument = createSineMultiInstrument("test_samplerunit.raw", TEST_SAMPLE_LENGTH);
+    if (!multiInstrument) return false;
+
+    SamplerUnit serialSamplerUnit(SAMPLER_MAX_VOICES), parallelSamplerUnit(SAMPLER_MAX_VOICES);
+    parallelSamplerUnit.setNbRenderWorkers(3);
+
+    std::vector<GraphSampleType> serialOut(2 * 256), parallelOut(2 * 256);
+
+    for (int block = 0; block < 20; ++block) {
+        // Start and release notes on several channels
+        for (UInt32 channel = 0; channel < 8; ++channel) {
+            Float32 pitch = 48.0f + channel * 3 + block % 4;
+            if (block % 2 == 0) {
+                serialSamplerUnit.playNote(pitch, 0.8f, multiInstrument, channel);
+                parallelSamplerUnit.playNote(pitch, 0.8f, multiInstrument, channel);
+            } else {
+                serialSamplerUnit.releaseNote(pitch - 1.0f, channel);
+                parallelSamplerUnit.releaseNote(pitch - 1.0f, channel);
+            }
+        }
+
+        std::fill(serialOut.begin(), serialOut.end(), 0.0f);
+        std::fill(parallelOut.begin(), parallelOut.end(), 0.0f);
+        GraphSampleType* serialIOData[2] = {&serialOut[0], &serialOut[1]};
+        GraphSampleType* parallelIOData[2] = {&parallelOut[0], &parallelOut[1]};
+        serialSamplerUnit.renderInput(256, serialIOData, 2);
+        parallelSamplerUnit.renderInput(256, parallelIOData, 2);
+
+        if (serialOut != parallelOut) {
+            std::cout << "Parallel output mismatch in block " << block << "\n";
+            return false;
+        }
+    }
+
+    GraphSampleType sum = 0.0f;
+    for (auto s : serialOut) sum += fabsf(s);
+    if (sum == 0.0f) {
+        std::cout << "No output rendered\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The voice counters are published at each block
+static bool testVoiceStats() {
+    auto multiInstrument = createSineMultiInstrument("test_samplerunit_stats.raw", TEST_SAMPLE_LENGTH);
+    if (!multiInstrument) return false;
+
+    SamplerUnit samplerUnit(2);
+    for (int i = 0; i < 3; ++i) samplerUnit.playNote(60.0f + i, 0.8f, multiInstrument, 0);
+
+    if (samplerUnit.nbPendingCmds() != 3) {
+        std::cout << "Unexpected number of pending commands\n";
+        return false;
+    }
+
+    std::vector<GraphSampleType> out(2 * 256);
+    GraphSampleType* ioData[2] = {&out[0], &out[1]};
+    samplerUnit.renderInput(256, ioData, 2);
+
+    if (samplerUnit.nbPendingCmds() != 0 || samplerUnit.nbPlayingVoices() != 2 || samplerUnit.nbStolenVoices() != 1) {
+        std::cout << "Unexpected voice statistics\n";
+        return false;
+    }
+
+    samplerUnit.resetNbStolenVoices();
+    if (samplerUnit.nbStolenVoices() != 0) {
+        std::cout << "The stolen voices are not reset\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The voice states reflect the last rendered block only, not the commands sent since
+static bool testVoiceStates() {
+    auto multiInstrument = createSineMultiInstrument("test_samplerunit_states.raw", TEST_SAMPLE_LENGTH);
+    if (!multiInstrument) return false;
+
+    SamplerUnit samplerUnit(4);
+    std::vector<GraphSampleType> out(2 * 256);
+    GraphSampleType* ioData[2] = {&out[0], &out[1]};
+
+    samplerUnit.playNote(60.0f, 0.8f, multiInstrument, 2);
+    if (samplerUnit.isNotePlaying(2) || samplerUnit.isNotePlaying(60.0f, 2) ||
+        samplerUnit.isMultiInstrumentInUse(multiInstrument)) {
+        std::cout << "Note reported before being rendered\n";
+        return false;
+    }
+
+    samplerUnit.renderInput(256, ioData, 2);
+    if (!samplerUnit.isNotePlaying(2) || !samplerUnit.isNotePlaying(60.0f, 2) || samplerUnit.isNotePlaying(61.0f, 2) ||
+        samplerUnit.isNotePlaying(0) || !samplerUnit.isMultiInstrumentInUse(multiInstrument)) {
+        std::cout << "Unexpected voice states after rendering\n";
+        return false;
+    }
+
+    samplerUnit.clearVoices(2);
+    if (!samplerUnit.isNotePlaying(60.0f, 2) || !samplerUnit.isMultiInstrumentInUse(multiInstrument)) {
+        std::cout << "Voices reported cleared before being rendered\n";
+        return false;
+    }
+
+    samplerUnit.renderInput(256, ioData, 2);
+    if (samplerUnit.isNotePlaying(2) || samplerUnit.isMultiInstrumentInUse(multiInstrument)) {
+        std::cout << "Voices still reported after being cleared\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// A scheduled note must start exactly at its sample offset, and an immediate command sent after it must not wait for it
+static bool testSampleOffset() {
+    auto multiInstrument = createSineMultiInstrument("test_samplerunit_offset.raw", TEST_SAMPLE_LENGTH);
+    if (!multiInstrument) return false;
+
+    SamplerUnit scheduledSamplerUnit(4), referenceSamplerUnit(4);
+    scheduledSamplerUnit.setFormat(44100.0, 512);
+    referenceSamplerUnit.setFormat(44100.0, 512);
+
+    scheduledSamplerUnit.playNote(60.0f, 0.8f, multiInstrument, 0, 300);
+    scheduledSamplerUnit.playNote(67.0f, 0.8f, multiInstrument, 1);
+    referenceSamplerUnit.playNote(67.0f, 0.8f, multiInstrument, 1);
+
+    std::vector<GraphSampleType> scheduledOut(2 * 3 * 256), referenceOut(2 * 3 * 256);
+
+    // The scheduled unit splits its second block at the offset, the reference one plays the note between two blocks
+    for (int block = 0; block < 3; ++block) {
+        GraphSampleType* ioData[2] = {&scheduledOut[2 * 256 * block], &scheduledOut[2 * 256 * block + 1]};
+        scheduledSamplerUnit.renderInput(256, ioData, 2);
+    }
+    UInt32 referenceBlocks[] = {256, 44, 212, 256};
+    UInt32 frameIndex = 0;
+    for (auto nbFrames : referenceBlocks) {
+        if (frameIndex == 300) referenceSamplerUnit.playNote(60.0f, 0.8f, multiInstrument, 0);
+        GraphSampleType* ioData[2] = {&referenceOut[2 * frameIndex], &referenceOut[2 * frameIndex + 1]};
+        referenceSamplerUnit.renderInput(nbFrames, ioData, 2);
+        frameIndex += nbFrames;
+    }
+
+    for (size_t i = 0; i < scheduledOut.size(); ++i) {
+        if (scheduledOut[i] != referenceOut[i]) {
+            std::cout << "Scheduled output mismatch at frame " << i / 2 << "\n";
+            return false;
+        }
+    }
+
+    if (scheduledSamplerUnit.nbPlayingVoices() != 2) {
+        std::cout << "Unexpected number of playing voices after the offset\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// A note scheduled before its channel is stopped must never be played, while the notes of the other channels are kept
+static bool testStoppedScheduledNotes() {
+    auto multiInstrument = createSineMultiInstrument("test_samplerunit_stopped.raw", TEST_SAMPLE_LENGTH);
+    if (!multiInstrument) return false;
+
+    SamplerUnit samplerUnit(4);
+    samplerUnit.setFormat(44100.0, 512);
+    std::vector<GraphSampleType> out(2 * 256);
+    GraphSampleType* ioData[2] = {&out[0], &out[1]};
+
+    samplerUnit.playNote(60.0f, 0.8f, multiInstrument, 0, 300);
+    samplerUnit.releaseNote(60.0f, 0, 900);
+    samplerUnit.playNote(64.0f, 0.8f, multiInstrument, 1, 300);
+    samplerUnit.stopAllNotes(0);
+    for (int block = 0; block < 3; ++block) samplerUnit.renderInput(256, ioData, 2);
+    if (samplerUnit.isNotePlaying(0) || !samplerUnit.isNotePlaying(64.0f, 1) || samplerUnit.nbPlayingVoices() != 1) {
+        std::cout << "A scheduled note is played after its channel is stopped\n";
+        return false;
+    }
+
+    samplerUnit.playNote(67.0f, 0.8f, multiInstrument, 2, samplerUnit.sampleTime() + 300);
+    samplerUnit.clearAllVoices();
+    for (int block = 0; block < 3; ++block) samplerUnit.renderInput(256, ioData, 2);
+    if (samplerUnit.nbPlayingVoices() != 0 || samplerUnit.nbPendingCmds() != 0) {
+        std::cout << "A scheduled note is played after the voices are cleared\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Creates an instrument playing a long looped 16-bit sample, either fully loaded or streamed past a short head
+static std::shared_ptr<MultiInstrument> createLongMultiInstrument(std::shared_ptr<std::vector<SInt16>> data,
+                                                                  bool isStreamed) {
+    UInt32 length = (UInt32)data->size();
+
+    auto sample = std::make_shared<Sample>();
+    sample->setSF2SampleRate(44100.0);
+    sample->setSF2SampleStart(0);
+    sample->setSF2SampleEnd(length);
+    sample->setSF2SampleBasePos(0);
+    bool isLoaded = isStreamed ? sample->streamSF2Audio(data->data(), data, length - 5000, length - 1000, 1024)
+                               : sample->loadSF2Audio(data->data());
+    if (!isLoaded || sample->isStreamed() != isStreamed) return nullptr;
+
+    auto instrument = std::make_shared<Instrument>();
+    instrument->setSample(sample);
+    instrument->setLoopStart(length - 5000);
+    instrument->setLoopEnd(length - 1000);
+    instrument->setFilterFc(8000.0f);
+    instrument->setFilterQ(0.7f);
+
+    auto multiInstrument = std::make_shared<MultiInstrument>();
+    multiInstrument->addInstrument(instrument);
+    return multiInstrument;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// A streamed sample must be rendered exactly like the same sample fully loaded, through its head, ring and loop
+static bool testStreaming() {
+    auto data = std::make_shared<std::vector<SInt16>>(60000);
+    for (size_t i = 0; i < data->size(); ++i)
+        (*data)[i] = (SInt16)(12000.0f * sinf(i * 0.05f) + 4000.0f * sinf(i * 0.31f));
+
+    auto loadedMultiInstrument = createLongMultiInstrument(data, false);
+    auto streamedMultiInstrument = createLongMultiInstrument(data, true);
+    if (!loadedMultiInstrument || !streamedMultiInstrument) {
+        std::cout << "Unable to create the instruments\n";
+        return false;
+    }
+
+    // Without streaming, the note of a streamed sample is cancelled
+    SamplerUnit samplerUnit(4);
+    samplerUnit.playNote(72.5f, 0.8f, streamedMultiInstrument, 0);
+    std::vector<GraphSampleType> out(2 * 256);
+    GraphSampleType* ioData[2] = {&out[0], &out[1]};
+    samplerUnit.renderInput(256, ioData, 2);
+    if (samplerUnit.nbPlayingVoices() != 0) {
+        std::cout << "A streamed sample is played without streaming\n";
+        return false;
+    }
+
+    SamplerUnit loadedSamplerUnit(4), streamedSamplerUnit(4);
+    streamedSamplerUnit.setIsStreaming(true);
+    loadedSamplerUnit.playNote(72.5f, 0.8f, loadedMultiInstrument, 0);
+    streamedSamplerUnit.playNote(72.5f, 0.8f, streamedMultiInstrument, 0);
+
+    std::vector<GraphSampleType> loadedOut(2 * 256), streamedOut(2 * 256);
+
+    // Enough blocks to reach the loop
+    for (int block = 0; block < 300; ++block) {
+        std::fill(loadedOut.begin(), loadedOut.end(), 0.0f);
+        std::fill(streamedOut.begin(), streamedOut.end(), 0.0f);
+        GraphSampleType* loadedIOData[2] = {&loadedOut[0], &loadedOut[1]};
+        GraphSampleType* streamedIOData[2] = {&streamedOut[0], &streamedOut[1]};
+        loadedSamplerUnit.renderInput(256, loadedIOData, 2);
+        streamedSamplerUnit.renderInput(256, streamedIOData, 2);
+
+        if (streamedOut != loadedOut) {
+            std::cout << "Streamed output mismatch in block " << block << "\n";
+            return false;
+        }
+
+        // Leave some time to the reader thread, as an audio device would
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    GraphSampleType sum = 0.0f;
+    for (auto s : streamedOut) sum += fabsf(s);
+    if (sum == 0.0f) {
+        std::cout << "No output rendered in the loop\n";
+        return false;
+    }
+
+    if (streamedSamplerUnit.nbStreamUnderruns() != 0) {
+        std::cout << "Unexpected stream underruns\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testSamplerUnit() {
+    // The constructor initializes the resampler and attenuation tables
+    SamplerUnit samplerUnit(1);
+
+    std::vector<SampleType> buffer(TEST_SAMPLE_LENGTH + 2 * TEST_SAMPLE_MARGIN, 0.0f);
+    SampleType* data = &buffer[TEST_SAMPLE_MARGIN];
+    for (int i = 0; i < TEST_SAMPLE_LENGTH; ++i) data[i] = 0.5f * sinf(i * 0.05f) + 0.25f * sinf(i * 0.31f);
+
+    // Unity rate, looped, released before the end of the sample
+    if (!compareRenderers(data, 60.0f, true, 700, 1500, 256)) return false;
+
+    // Upsampled and looped with a block size that is not a multiple of the chunk size
+    if (!compareRenderers(data, 55.5f, true, 900, 3000, 100)) return false;
+
+    // Downsampled, not looped, released before the end of the sample
+    if (!compareRenderers(data, 63.0f, false, 400, 1200, 512)) return false;
+
+    // Native 16-bit data at unity rate and resampled
+    if (!compareFormats(60.0f) || !compareFormats(55.5f) || !compareFormats(63.0f)) return false;
+
+    if (!testFormat()) return false;
+
+    if (!testParallelRendering()) return false;
+
+    if (!testSampleOffset()) return false;
+
+    if (!testStoppedScheduledNotes()) return false;
+
+    if (!testVoiceStates()) return false;
+
+    if (!testStreaming()) return false;
+
+    if (!testVoiceStats()) return false;
+
+    return true;
+}
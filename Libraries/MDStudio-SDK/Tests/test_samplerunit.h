@@ -0,0 +1,14 @@
+//
+//  test_samplerunit.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-03-14.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_SAMPLERUNIT_H
+#define TEST_SAMPLERUNIT_H
+
+bool testSamplerUnit();
+
+#endif  // TEST_SAMPLERUNIT_H
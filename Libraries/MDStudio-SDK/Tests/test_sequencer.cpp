@@ -0,0 +1,343 @@
+//
+//  test_sequencer.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_sequencer.h"
+
+#include <math.h>
+#include <platform.h>
+#include <sequencer.h>
+#include <stdio.h>
+#include <studio.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "sf2writer.h"
+
+using namespace MDStudio;
+
+#define TEST_SEQUENCER_TICK_COUNT 2
+#define TEST_SEQUENCER_NB_EVENTS 1500
+#define TEST_SEQUENCER_EOT_EVENT_INDEX 700
+#define TEST_SEQUENCER_FIRST_CONTROL 16
+#define TEST_SEQUENCER_NB_CONTROLS 4
+#define TEST_SEQUENCER_NB_CHANNELS 6
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Event setting a state, a pitch bend sensitivity selected by RPN or a note, depending on the index
+static void addEvent(Track* track, int eventIndex, UInt8 channel) {
+    int value = (eventIndex * 37) % 128;
+    switch (eventIndex % 12) {
+        case 0:
+            track->addEvent(makeEvent(EVENT_TYPE_PROGRAM_CHANGE, channel, TEST_SEQUENCER_TICK_COUNT,
+                                      STUDIO_INSTRUMENT_FROM_PRESET(0, eventIndex % 3), 0));
+            break;
+        case 1:
+            track->addEvent(makeEvent(EVENT_TYPE_MIXER_LEVEL_CHANGE, channel, TEST_SEQUENCER_TICK_COUNT, value, 0));
+            break;
+        case 2:
+            track->addEvent(makeEvent(EVENT_TYPE_MIXER_BALANCE_CHANGE, channel, TEST_SEQUENCER_TICK_COUNT, value, 0));
+            break;
+        case 3:
+            track->addEvent(makeEvent(EVENT_TYPE_SUSTAIN, channel, TEST_SEQUENCER_TICK_COUNT, value, 0));
+            break;
+        case 4:
+            track->addEvent(
+                makeEvent(EVENT_TYPE_PITCH_BEND, channel, TEST_SEQUENCER_TICK_COUNT, (eventIndex * 37) % 16384, 0));
+            break;
+        case 5:
+            track->addEvent(makeEvent(EVENT_TYPE_MODULATION, channel, TEST_SEQUENCER_TICK_COUNT, value, 0));
+            break;
+        case 6:
+            track->addEvent(makeEvent(EVENT_TYPE_CONTROL_CHANGE, channel, TEST_SEQUENCER_TICK_COUNT,
+                                      TEST_SEQUENCER_FIRST_CONTROL + (eventIndex / 12) % TEST_SEQUENCER_NB_CONTROLS,
+                                      value));
+            break;
+        case 7:
+            track->addEvent(makeEvent(EVENT_TYPE_CONTROL_CHANGE, channel, TEST_SEQUENCER_TICK_COUNT,
+                                      STUDIO_CONTROL_REG_PARAM_NUM_MSB, 0));
+            break;
+        case 8:
+            track->addEvent(makeEvent(EVENT_TYPE_CONTROL_CHANGE, channel, TEST_SEQUENCER_TICK_COUNT,
+                                      STUDIO_CONTROL_REG_PARAM_NUM_LSB, 0));
+            break;
+        case 9:
+            track->addEvent(makeEvent(EVENT_TYPE_CONTROL_CHANGE, channel, TEST_SEQUENCER_TICK_COUNT,
+                                      STUDIO_CONTROL_DATA_ENTRY_MSB, 1 + eventIndex % 24));
+            break;
+        case 10:
+            track->addEvent(makeEvent(EVENT_TYPE_NOTE_ON, channel, TEST_SEQUENCER_TICK_COUNT, 60, 100));
+            break;
+        case 11:
+            track->addEvent(makeEvent(EVENT_TYPE_NOTE_OFF, channel, TEST_SEQUENCER_TICK_COUNT, 60, 0));
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The event at index i of a non-empty track is at tick (i + 1) * TEST_SEQUENCER_TICK_COUNT
+static std::shared_ptr<Sequence> createSequence() {
+    auto sequence = std::make_shared<Sequence>();
+    sequence->data.format = SEQUENCE_DATA_FORMAT_MULTI_TRACK;
+    sequence->data.tickPeriod = 60.0 / (480 * 125.0);
+    sequence->data.tracks.resize(4);
+
+    // Track rechannelized to the channel 0
+    Track& track0 = sequence->data.tracks[0];
+    track0.channel = 0;
+    for (int i = 0; i < TEST_SEQUENCER_NB_EVENTS; ++i) addEvent(&track0, i, i % 3);
+
+    // Multi-channel track on the channels 1 to 3, ended early, followed by events that must never be played
+    Track& track1 = sequence->data.tracks[1];
+    track1.channel = SEQUENCE_TRACK_MULTI_CHANNEL;
+    for (int i = 0; i < TEST_SEQUENCER_NB_EVENTS; ++i) {
+        if (i == TEST_SEQUENCER_EOT_EVENT_INDEX) {
+            track1.addEvent(makeEvent(EVENT_TYPE_META_END_OF_TRACK, 0, TEST_SEQUENCER_TICK_COUNT, 0, 0));
+        } else {
+            addEvent(&track1, i, 1 + i % 3);
+        }
+    }
+
+    // Empty track
+    sequence->data.tracks[2].channel = 4;
+
+    // Track holding only an end of track
+    Track& track3 = sequence->data.tracks[3];
+    track3.channel = 5;
+    track3.addEvent(makeEvent(EVENT_TYPE_META_END_OF_TRACK, 0, TEST_SEQUENCER_TICK_COUNT, 0, 0));
+
+    return sequence;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Plays a state event the way the sequencer does
+static void replayEvent(Studio* studio, const Event& event) {
+    switch (event.type) {
+        case EVENT_TYPE_PROGRAM_CHANGE:
+            studio->setInstrument(STUDIO_SOURCE_SEQUENCER, event.param1, event.channel);
+            break;
+        case EVENT_TYPE_MIXER_LEVEL_CHANGE:
+            studio->setMixerLevel(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel);
+            break;
+        case EVENT_TYPE_MIXER_BALANCE_CHANGE:
+            studio->setMixerBalance(STUDIO_SOURCE_SEQUENCER, ((Float32)event.param1 / 127.0f) * 2.0f - 1.0f,
+                                    event.channel);
+            break;
+        case EVENT_TYPE_SUSTAIN:
+            studio->setSustain(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel);
+            break;
+        case EVENT_TYPE_PITCH_BEND:
+            studio->setPitchBend(STUDIO_SOURCE_SEQUENCER, ((Float32)event.param1 - 0.5f) * 2.0f / 16383.0f - 1.0f,
+                                 event.channel);
+            break;
+        case EVENT_TYPE_MODULATION:
+            studio->setModulation(STUDIO_SOURCE_SEQUENCER, (Float32)event.param1 / 127.0f, event.channel);
+            break;
+        case EVENT_TYPE_CONTROL_CHANGE:
+            studio->setControlValue(STUDIO_SOURCE_SEQUENCER, event.param1, event.param2, event.channel);
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Plays every event of the sequence preceding the tick, from the start and up to the end of each track
+static void replaySequence(Studio* studio, std::shared_ptr<Sequence> sequence, UInt32 tick) {
+    for (auto& track : sequence->data.tracks) {
+        UInt32 eventTick = 0;
+        for (auto event : track.events) {
+            eventTick += event.tickCount;
+            if (eventTick >= tick) break;
+            if (event.type == EVENT_TYPE_META_END_OF_TRACK) break;
+            if (track.channel != SEQUENCE_TRACK_MULTI_CHANNEL) event.channel = track.channel;
+            replayEvent(studio, event);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static bool compareStates(Studio* studio, Studio* refStudio, UInt32 tick) {
+    for (int channel = 0; channel < TEST_SEQUENCER_NB_CHANNELS; ++channel) {
+        bool isEqual = studio->instrument(channel) == refStudio->instrument(channel) &&
+                       studio->mixerLevel(channel) == refStudio->mixerLevel(channel) &&
+                       studio->mixerBalance(channel) == refStudio->mixerBalance(channel) &&
+                       studio->sustain(channel) == refStudio->sustain(channel) &&
+                       studio->pitchBend(channel) == refStudio->pitchBend(channel) &&
+                       studio->modulation(channel) == refStudio->modulation(channel) &&
+                       studio->pitchBendFactor(channel) == refStudio->pitchBendFactor(channel);
+        for (UInt32 control = TEST_SEQUENCER_FIRST_CONTROL;
+             control < TEST_SEQUENCER_FIRST_CONTROL + TEST_SEQUENCER_NB_CONTROLS; ++control)
+            if (studio->controlValue(channel, control) != refStudio->controlValue(channel, control)) isEqual = false;
+
+        if (!isEqual) {
+            std::cout << "Unexpected state of the channel " << channel << " after seeking to the tick " << tick
+                      << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Seeking must leave the studio in the state of a linear replay from the tick 0
+static bool testSeek() {
+    auto sequence = createSequence();
+
+    Studio studio(STUDIO_MAX_CHANNELS, ".", SAMPLER_MAX_VOICES, true);
+    studio.setIsInternalSynthEnabled(false);
+    Sequencer sequencer(nullptr, &studio);
+    sequencer.setSequence(sequence);
+
+    // Number of preceding events of the first track, around the checkpoints, the end of track of the second track and
+    // the end of the sequence, in increasing order so the states set by a previous seek are also set by the next one
+    std::vector<UInt32> nbPrecedingEvents = {0,
+                                             1,
+                                             SEQUENCER_SEEK_CHECKPOINT_INTERVAL - 1,
+                                             SEQUENCER_SEEK_CHECKPOINT_INTERVAL,
+                                             SEQUENCER_SEEK_CHECKPOINT_INTERVAL + 1,
+                                             TEST_SEQUENCER_EOT_EVENT_INDEX,
+                                             TEST_SEQUENCER_EOT_EVENT_INDEX + 1,
+                                             TEST_SEQUENCER_EOT_EVENT_INDEX + 2,
+                                             2 * SEQUENCER_SEEK_CHECKPOINT_INTERVAL - 1,
+                                             2 * SEQUENCER_SEEK_CHECKPOINT_INTERVAL,
+                                             2 * SEQUENCER_SEEK_CHECKPOINT_INTERVAL + 1,
+                                             TEST_SEQUENCER_NB_EVENTS - 1,
+                                             TEST_SEQUENCER_NB_EVENTS,
+                                             TEST_SEQUENCER_NB_EVENTS + 100};
+
+    std::vector<UInt32> ticks;
+    for (auto nbEvents : nbPrecedingEvents) {
+        // Between two events and on the next event, which is not yet played
+        ticks.push_back(nbEvents * TEST_SEQUENCER_TICK_COUNT + 1);
+        ticks.push_back((nbEvents + 1) * TEST_SEQUENCER_TICK_COUNT);
+    }
+
+    // Back before the second checkpoint, every state being already set at that point
+    ticks.push_back(SEQUENCER_SEEK_CHECKPOINT_INTERVAL * TEST_SEQUENCER_TICK_COUNT + 1);
+
+    for (auto tick : ticks) {
+        studio.metronome()->moveToTick(tick);
+
+        Studio refStudio(STUDIO_MAX_CHANNELS, ".", SAMPLER_MAX_VOICES, true);
+        refStudio.setIsInternalSynthEnabled(false);
+        replaySequence(&refStudio, sequence, tick);
+
+        // The notifications are delivered while the studios are alive
+        bool isEqual = compareStates(&studio, &refStudio, tick);
+        Platform::sharedInstance()->process();
+        if (!isEqual) return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Cumulative ticks of the note on events of the track
+static std::vector<UInt32> noteOnTicks(const Track& track) {
+    std::vector<UInt32> ticks;
+    UInt32 tick = 0;
+    for (auto& event : track.events) {
+        tick += event.tickCount;
+        if (event.type == EVENT_TYPE_NOTE_ON) ticks.push_back(tick);
+    }
+    return ticks;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The notes performed in an age scope are dated at their arrival, and recorded no earlier than the previous event
+static bool testEventAge() {
+    Studio studio(STUDIO_MAX_CHANNELS, ".", SAMPLER_MAX_VOICES, true);
+    studio.setIsInternalSynthEnabled(false);
+    Sequencer sequencer(nullptr, &studio);
+
+    auto sequence = std::make_shared<Sequence>();
+    sequence->data.format = SEQUENCE_DATA_FORMAT_MULTI_TRACK;
+    sequence->data.tickPeriod = 60.0 / (480 * 125.0);
+    sequence->data.tracks.resize(2);
+    sequence->data.tracks[0].channel = 0;
+    sequence->data.tracks[1].channel = 0;
+    sequencer.setSequence(sequence);
+
+    std::vector<UInt32> notifiedTicks;
+    auto didPlayNoteFn = std::make_shared<Studio::didPlayNoteFnType>(
+        [&notifiedTicks](Studio* sender, int source, double timestamp, UInt32 tick, int channel, int pitch,
+                         Float32 velocity) { notifiedTicks.push_back(tick); });
+    studio.addDidPlayNoteFn(didPlayNoteFn);
+
+    sequencer.setArmedTrackIndices({1});
+    sequencer.record();
+
+    // The metronome runs past the maximum age
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // A note having arrived the maximum age ago
+    UInt32 tickBefore = studio.metronome()->tick();
+    {
+        StudioEventAgeScope eventAgeScope(STUDIO_MAX_EVENT_AGE);
+        studio.playNote(STUDIO_SOURCE_USER, 60, 1.0f, 0);
+    }
+    UInt32 tickAfter = studio.metronome()->tick();
+
+    // A note performed now, followed by one having arrived before it
+    studio.playNote(STUDIO_SOURCE_USER, 62, 1.0f, 0);
+    {
+        StudioEventAgeScope eventAgeScope(STUDIO_MAX_EVENT_AGE);
+        studio.playNote(STUDIO_SOURCE_USER, 64, 1.0f, 0);
+    }
+
+    Platform::sharedInstance()->process();
+    auto recordedTicks = noteOnTicks(sequence->data.tracks[1]);
+    sequencer.stop();
+    studio.removeDidPlayNoteFn(didPlayNoteFn);
+    Platform::sharedInstance()->process();
+
+    if (notifiedTicks.size() != 3 || recordedTicks.size() != 3) {
+        std::cout << "Unexpected number of notes\n";
+        return false;
+    }
+
+    UInt32 nbAgeTicks = static_cast<UInt32>(STUDIO_MAX_EVENT_AGE * studio.metronome()->bpmForTick(tickBefore) / 60.0 *
+                                            studio.metronome()->timeDivision());
+    if (tickBefore < nbAgeTicks + 1 || notifiedTicks[0] + nbAgeTicks + 1 < tickBefore ||
+        notifiedTicks[0] + nbAgeTicks > tickAfter) {
+        std::cout << "The note is not dated at its arrival\n";
+        return false;
+    }
+
+    if (notifiedTicks[2] >= notifiedTicks[1]) {
+        std::cout << "The late note is not dated before the previous one\n";
+        return false;
+    }
+
+    if (recordedTicks[0] != notifiedTicks[0] || recordedTicks[1] != notifiedTicks[1] ||
+        recordedTicks[2] != recordedTicks[1]) {
+        std::cout << "The late note is not recorded at the tick of the previous one\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testSequencer() {
+    std::vector<SInt16> samples(64);
+    for (int i = 0; i < 64; ++i) samples[i] = (SInt16)(16000.0f * sinf(i * 2.0f * M_PI / 16.0f));
+    if (!writeTestSF2("./GM.sf2", samples, {})) {
+        std::cout << "Unable to write the SoundFont\n";
+        return false;
+    }
+
+    bool isPassed = testSeek() && testEventAge();
+
+    remove("./GM.sf2");
+
+    return isPassed;
+}
@@ -0,0 +1,14 @@
+//
+//  test_sequencer.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-24.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_SEQUENCER_H
+#define TEST_SEQUENCER_H
+
+bool testSequencer();
+
+#endif  // TEST_SEQUENCER_H
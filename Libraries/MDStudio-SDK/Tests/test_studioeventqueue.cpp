@@ -0,0 +1,238 @@
+//
+//  test_studioeventqueue.cpp
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-10.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#include "test_studioeventqueue.h"
+
+#include <platform.h>
+#include <studio.h>
+#include <studioeventqueue.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace MDStudio;
+
+// ---------------------------------------------------------------------------------------------------------------------
+static StudioEvent makeStudioEvent(int type, int source, int channel, UInt32 tick, SInt32 param1, Float32 value) {
+    StudioEvent event;
+    event.type = type;
+    event.source = source;
+    event.channel = channel;
+    event.tick = tick;
+    event.param1 = param1;
+    event.param2 = 0;
+    event.value = value;
+    return event;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static bool testProducers() {
+    const int nbProducers = 4;
+    const int nbEventsPerProducer = 1000;
+
+    StudioEventQueue queue(nbProducers * nbEventsPerProducer);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < nbProducers; ++producer)
+        producers.push_back(std::thread([&queue, producer]() {
+            for (int i = 0; i < nbEventsPerProducer; ++i)
+                queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, producer, i, i, 1.0f));
+        }));
+    for (auto& producer : producers) producer.join();
+
+    std::vector<StudioEvent> events;
+    queue.drain(&events);
+
+    if (events.size() != nbProducers * nbEventsPerProducer) {
+        std::cout << "Unexpected number of events: " << events.size() << "\n";
+        return false;
+    }
+
+    // The events of each producer must be received in order
+    std::vector<UInt32> nextTicks(nbProducers, 0);
+    for (auto& event : events) {
+        if (event.tick != nextTicks[event.channel]) {
+            std::cout << "Events received out of order\n";
+            return false;
+        }
+        nextTicks[event.channel]++;
+    }
+
+    StudioEvent event;
+    if (queue.tryDequeue(&event)) {
+        std::cout << "The queue is not empty after draining\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static bool testFullQueue() {
+    StudioEventQueue queue(4);
+
+    for (int i = 0; i < 4; ++i)
+        if (!queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, i, 60, 1.0f))) {
+            std::cout << "Unable to fill the queue\n";
+            return false;
+        }
+
+    if (queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, 4, 60, 1.0f))) {
+        std::cout << "An event was queued past the capacity\n";
+        return false;
+    }
+
+    StudioEvent event;
+    if (!queue.tryDequeue(&event) || event.tick != 0) return false;
+
+    // The freed cell must be reused
+    if (!queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, 4, 60, 1.0f))) {
+        std::cout << "Unable to reuse a freed cell\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Once an event has overflowed, the following ones are kept behind it until the next drain
+static bool testOverflow() {
+    StudioEventQueue queue(4);
+
+    for (int i = 0; i < 6; ++i) queue.enqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, i, 60, 1.0f));
+
+    // Room is made in the queue while the overflowed events are still pending
+    StudioEvent event;
+    if (!queue.tryDequeue(&event) || event.tick != 0) return false;
+    queue.enqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, 6, 60, 1.0f));
+
+    std::vector<StudioEvent> events;
+    queue.drain(&events);
+    if (events.size() != 6) {
+        std::cout << "Unexpected number of drained events: " << events.size() << "\n";
+        return false;
+    }
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (events[i].tick != i + 1) {
+            std::cout << "Overflowed event drained out of order at " << i << "\n";
+            return false;
+        }
+    }
+
+    // The queue is used again after the drain
+    queue.enqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, 7, 60, 1.0f));
+    if (!queue.tryDequeue(&event) || event.tick != 7) {
+        std::cout << "The queue was not used after the overflow\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static bool testCoalescing() {
+    StudioEventQueue queue;
+
+    // Superseded at the same tick
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PITCH_BEND, 0, 0, 10, 0, 0.1f));
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PITCH_BEND, 0, 0, 10, 0, 0.2f));
+    // Notes are never coalesced
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, 10, 60, 1.0f));
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PLAY_NOTE, 0, 0, 10, 60, 1.0f));
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PITCH_BEND, 0, 0, 10, 0, 0.3f));
+    // Another channel, control, source or tick is kept
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PITCH_BEND, 0, 1, 10, 0, 0.4f));
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_CONTROL_VALUE, 0, 0, 10, 7, 0.0f));
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_CONTROL_VALUE, 0, 0, 10, 10, 0.0f));
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PITCH_BEND, 1, 0, 10, 0, 0.5f));
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PITCH_BEND, 0, 0, 11, 0, 0.6f));
+
+    std::vector<StudioEvent> events;
+    queue.drain(&events);
+
+    std::vector<Float32> expectedPitchBends = {0.3f, 0.4f, 0.5f, 0.6f};
+    std::vector<Float32> pitchBends;
+    int nbNotes = 0, nbControlValues = 0;
+    for (auto& event : events) {
+        if (event.type == STUDIO_EVENT_PITCH_BEND) pitchBends.push_back(event.value);
+        if (event.type == STUDIO_EVENT_PLAY_NOTE) nbNotes++;
+        if (event.type == STUDIO_EVENT_CONTROL_VALUE) nbControlValues++;
+    }
+
+    if (pitchBends != expectedPitchBends || nbNotes != 2 || nbControlValues != 2) {
+        std::cout << "Unexpected coalescing\n";
+        return false;
+    }
+
+    // The slots of a previous batch must not affect the next one
+    queue.tryEnqueue(makeStudioEvent(STUDIO_EVENT_PITCH_BEND, 0, 0, 11, 0, 0.7f));
+    queue.drain(&events);
+    if (events.size() != 1) {
+        std::cout << "An event was coalesced with a previous batch\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The notifications of a thread outrunning the main thread are delivered in order, including the overflowing ones
+static bool testOverflowOrder() {
+    const int nbEvents = 20 * STUDIO_EVENT_QUEUE_CAPACITY;
+
+    Studio studio(STUDIO_MAX_CHANNELS, ".", SAMPLER_MAX_VOICES, true);
+    studio.setIsInternalSynthEnabled(false);
+
+    std::vector<int> instruments;
+    instruments.reserve(nbEvents);
+    auto didSetInstrumentFn = std::make_shared<Studio::didSetInstrumentFnType>(
+        [&instruments](Studio* sender, int source, double timestamp, UInt32 tick, int channel, int instrument) {
+            instruments.push_back(instrument);
+        });
+    studio.addDidSetInstrumentFn(didSetInstrumentFn);
+
+    std::thread producer([&studio]() {
+        for (int i = 0; i < nbEvents; ++i) studio.setInstrument(STUDIO_SOURCE_USER, i, 0);
+    });
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (instruments.size() < nbEvents && std::chrono::steady_clock::now() < deadline) {
+        // The main thread is lagging behind
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        Platform::sharedInstance()->process();
+    }
+    producer.join();
+    Platform::sharedInstance()->process();
+
+    if (instruments.size() != nbEvents) {
+        std::cout << "Unexpected number of delivered notifications: " << instruments.size() << "\n";
+        return false;
+    }
+
+    for (int i = 0; i < nbEvents; ++i) {
+        if (instruments[i] != i) {
+            std::cout << "Notification delivered out of order at " << i << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testStudioEventQueue() {
+    if (!testProducers()) return false;
+    if (!testFullQueue()) return false;
+    if (!testOverflow()) return false;
+    if (!testCoalescing()) return false;
+    if (!testOverflowOrder()) return false;
+    return true;
+}
@@ -0,0 +1,14 @@
+//
+//  test_studioeventqueue.h
+//  MDStudioTest
+//
+//  Created by Daniel Cliche on 2021-04-10.
+//  Copyright (c) 2021 Daniel Cliche. All rights reserved.
+//
+
+#ifndef TEST_STUDIOEVENTQUEUE_H
+#define TEST_STUDIOEVENTQUEUE_H
+
+bool testStudioEventQueue();
+
+#endif  // TEST_STUDIOEVENTQUEUE_H
@@ -13,16 +13,32 @@
 #include <iostream>
 #include <map>
 
+#include "test_audioexport.h"
+#include "test_graveyard.h"
 #include "test_importexport.h"
+#include "test_instrumentmanager.h"
+#include "test_metronome.h"
+#include "test_mixer.h"
 #include "test_pasteboard.h"
 #include "test_plist.h"
+#include "test_samplerunit.h"
+#include "test_sequencer.h"
+#include "test_studioeventqueue.h"
 #include "test_undomanager.h"
 
 bool executeTest(const std::string& testName) {
     std::map<std::string, std::function<bool()>> tests = {{"Plist", testPlist},
                                                           {"UndoManager", testUndoManager},
                                                           {"PasteBoard", testPasteboard},
-                                                          {"ImportExport", testImportExport}};
+                                                          {"ImportExport", testImportExport},
+                                                          {"SamplerUnit", testSamplerUnit},
+                                                          {"Graveyard", testGraveyard},
+                                                          {"InstrumentManager", testInstrumentManager},
+                                                          {"Metronome", testMetronome},
+                                                          {"Mixer", testMixer},
+                                                          {"StudioEventQueue", testStudioEventQueue},
+                                                          {"AudioExport", testAudioExport},
+                                                          {"Sequencer", testSequencer}};
 
     if (tests.find(testName) == tests.end()) {
         std::cout << "Test not found\n";
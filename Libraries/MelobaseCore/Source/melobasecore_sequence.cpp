@@ -107,9 +107,13 @@ std::shared_ptr<MDStudio::Sequence> MelobaseCore::getStudioSequence(std::shared_
         MDStudio::Track studioTrack;
         for (auto event : trackEvents) {
             auto channelEvent = std::dynamic_pointer_cast<ChannelEvent>(event);
-            studioTrack.events.push_back(MDStudio::makeEvent(channelEvent->type(), channelEvent->channel(),
-                                                             channelEvent->tickCount(), channelEvent->param1(),
-                                                             channelEvent->param2(), channelEvent->data()));
+            auto studioEvent = MDStudio::makeEvent(channelEvent->type(), channelEvent->channel(),
+                                                   channelEvent->tickCount(), channelEvent->param1(),
+                                                   channelEvent->param2());
+            if (channelEvent->type() == CHANNEL_EVENT_TYPE_SYSTEM_EXCLUSIVE ||
+                channelEvent->type() == CHANNEL_EVENT_TYPE_META_GENERIC)
+                studioEvent.dataOffset = studioTrack.addEventData(channelEvent->data());
+            studioTrack.events.push_back(studioEvent);
         }
 
         studioTrack.name = track->name;
@@ -130,7 +134,7 @@ std::shared_ptr<Sequence> MelobaseCore::getMelobaseCoreSequence(std::shared_ptr<
 
     melobaseCoreSequence->data.tracks.clear();
 
-    for (auto studioTrack : studioSequence->data.tracks) {
+    for (auto& studioTrack : studioSequence->data.tracks) {
         std::stack<UInt32> noteOnTickCounts[STUDIO_MAX_CHANNELS][128];
         std::stack<std::shared_ptr<ChannelEvent>> noteOnChannelEvents[STUDIO_MAX_CHANNELS][128];
 
@@ -162,8 +166,10 @@ std::shared_ptr<Sequence> MelobaseCore::getMelobaseCoreSequence(std::shared_ptr<
                 } break;
 
                 default: {
+                    const UInt8* data = studioTrack.data(event);
                     auto channelEvent = std::make_shared<MelobaseCore::ChannelEvent>(
-                        event.type, event.channel, currentTickCount, 0, event.param1, event.param2, 0, event.data);
+                        event.type, event.channel, currentTickCount, 0, event.param1, event.param2, 0,
+                        std::vector<UInt8>(data, data + studioTrack.dataLength(event)));
                     melobaseCoreTrack->clips[0]->events.push_back(channelEvent);
                 }
             }
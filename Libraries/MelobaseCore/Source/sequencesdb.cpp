@@ -9,8 +9,11 @@
 #include "sequencesdb.h"
 
 #include <string.h>
+#include <zlib.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -19,8 +22,41 @@
 #include "platform.h"
 #include "plist.h"
 
+// Header of the binary sequence data blobs, followed by the version and the flags
+#define SEQUENCE_DATA_BLOB_MAGIC "MBSD"
+#define SEQUENCE_DATA_BLOB_MAGIC_SIZE 4
+#define SEQUENCE_DATA_BLOB_VERSION 1
+#define SEQUENCE_DATA_BLOB_COMPRESSED 0x01
+
+// Columns read by setSequence() and setFolder()
+#define SEQUENCE_COLUMNS "Z_PK,ZDATE,ZVERSION,ZNAME,ZRATING,ZPLAYCOUNT,ZFOLDER,ZDATAVERSION,ZANNOTATIONS"
+#define FOLDER_COLUMNS "Z_PK,ZDATE,ZNAME,ZRATING,ZVERSION,ZPARENT"
+
+// Folder bound to parameter 1 and its subfolders
+#define INSIDE_FOLDER_CTE                                                                                             \
+    "WITH RECURSIVE inside_folder(n) AS ( VALUES(?1) UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE " \
+    "ZPARENT=inside_folder.n) "
+
 using namespace MelobaseCore;
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the full-text query matching the words starting with each word of the search, or an empty string if the
+// search has no word. The words are split as by the simple tokenizer of the index and lowercased so that they cannot
+// be read as operators.
+static std::string searchQuery(const std::string& nameSearch) {
+    std::string query, word;
+    for (char c : nameSearch + " ") {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (u >= 0x80 || isalnum(u)) {
+            word += static_cast<char>(tolower(u));
+        } else if (!word.empty()) {
+            query += (query.empty() ? "" : " ") + word + "*";
+            word.clear();
+        }
+    }
+    return query;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 std::vector<char> MelobaseCore::base64Decode(const char* encodedData) {
     using namespace std;
@@ -92,7 +128,249 @@ std::vector<char> MelobaseCore::getSequenceDataBlob(std::shared_ptr<Sequence> se
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-bool MelobaseCore::setSequenceDataFromBlob(std::shared_ptr<Sequence> sequence, char* blob, size_t size) {
+static void writeVarint(std::vector<char>& blob, UInt64 value) {
+    while (value >= 0x80) {
+        blob.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    blob.push_back(static_cast<char>(value));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The signed values are zigzag encoded so that the small negative values are short
+static void writeSignedVarint(std::vector<char>& blob, SInt64 value) {
+    writeVarint(blob, (static_cast<UInt64>(value) << 1) ^ static_cast<UInt64>(value >> 63));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Layout of the data following the header:
+//   format, number of tracks
+//   for each track: name length, name, channel, number of clips
+//     for each clip: number of events, then the columns of the events:
+//       tick count deltas, types, channels, lengths, param1 deltas, param2 deltas, param3 deltas,
+//       data size and data of the variable-length events
+// The integers are variable-length encoded, the types and the channels being single bytes.
+std::vector<char> MelobaseCore::getSequenceDataBinaryBlob(std::shared_ptr<Sequence> sequence, bool isCompressed) {
+    std::vector<char> data;
+
+    writeVarint(data, sequence->data.format);
+    writeVarint(data, sequence->data.tracks.size());
+
+    std::vector<ChannelEvent*> events;
+    for (auto track : sequence->data.tracks) {
+        writeVarint(data, track->name.size());
+        data.insert(data.end(), track->name.begin(), track->name.end());
+        data.push_back(static_cast<char>(track->channel));
+        writeVarint(data, track->clips.size());
+
+        for (auto clip : track->clips) {
+            events.clear();
+            for (auto event : clip->events)
+                if (event->classType() == 0) events.push_back(static_cast<ChannelEvent*>(event.get()));
+
+            writeVarint(data, events.size());
+
+            SInt64 previousValue = 0;
+            for (auto event : events) {
+                writeSignedVarint(data, static_cast<SInt64>(event->tickCount()) - previousValue);
+                previousValue = event->tickCount();
+            }
+            for (auto event : events) data.push_back(static_cast<char>(event->type()));
+            for (auto event : events) data.push_back(static_cast<char>(event->channel()));
+            for (auto event : events) writeVarint(data, event->length());
+
+            SInt64 previousValues[3] = {0, 0, 0};
+            for (int param = 0; param < 3; ++param) {
+                for (auto event : events) {
+                    SInt64 value = param == 0 ? event->param1() : (param == 1 ? event->param2() : event->param3());
+                    writeSignedVarint(data, value - previousValues[param]);
+                    previousValues[param] = value;
+                }
+            }
+
+            for (auto event : events) {
+                if (!event->isVariableLength()) continue;
+                writeVarint(data, event->data().size());
+                data.insert(data.end(), event->data().begin(), event->data().end());
+            }
+        }
+    }
+
+    std::vector<char> blob(SEQUENCE_DATA_BLOB_MAGIC, SEQUENCE_DATA_BLOB_MAGIC + SEQUENCE_DATA_BLOB_MAGIC_SIZE);
+    blob.push_back(SEQUENCE_DATA_BLOB_VERSION);
+
+    // The compressed data is preceded by the size of the data
+    if (isCompressed) {
+        uLongf compressedSize = compressBound(static_cast<uLong>(data.size()));
+        std::vector<char> compressedData(compressedSize);
+        if (compress2(reinterpret_cast<Bytef*>(compressedData.data()), &compressedSize,
+                      reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size()),
+                      Z_DEFAULT_COMPRESSION) == Z_OK &&
+            compressedSize < data.size()) {
+            blob.push_back(SEQUENCE_DATA_BLOB_COMPRESSED);
+            writeVarint(blob, data.size());
+            blob.insert(blob.end(), compressedData.begin(), compressedData.begin() + compressedSize);
+            return blob;
+        }
+    }
+
+    blob.push_back(0);
+    blob.insert(blob.end(), data.begin(), data.end());
+    return blob;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Reader of the values of a binary blob. Reading past the end sets an error and returns zeros.
+struct BlobReader {
+    const UInt8* p;
+    const UInt8* end;
+    bool isValid;
+
+    BlobReader(const char* data, size_t size)
+        : p(reinterpret_cast<const UInt8*>(data)), end(reinterpret_cast<const UInt8*>(data) + size), isValid(true) {}
+
+    bool isAvailable(size_t size) {
+        if (static_cast<size_t>(end - p) < size) isValid = false;
+        return isValid;
+    }
+
+    UInt8 readByte() { return isAvailable(1) ? *p++ : 0; }
+
+    const char* readBytes(size_t size) {
+        if (!isAvailable(size)) return nullptr;
+        const char* bytes = reinterpret_cast<const char*>(p);
+        p += size;
+        return bytes;
+    }
+
+    UInt64 readVarint() {
+        UInt64 value = 0;
+        for (int shift = 0; shift < 64 && isAvailable(1); shift += 7) {
+            UInt8 byte = *p++;
+            value |= static_cast<UInt64>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        isValid = false;
+        return 0;
+    }
+
+    SInt64 readSignedVarint() {
+        UInt64 value = readVarint();
+        return static_cast<SInt64>(value >> 1) ^ -static_cast<SInt64>(value & 1);
+    }
+
+    // Number of elements of at least one byte each, which cannot exceed the remaining bytes
+    size_t readCount() {
+        UInt64 count = readVarint();
+        return isAvailable(count) ? static_cast<size_t>(count) : 0;
+    }
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The columns of each clip are decoded into arrays, from which the events of the clip are constructed in a single
+// block. The events share the ownership of their block.
+static bool setSequenceDataFromBinaryBlob(std::shared_ptr<Sequence> sequence, const char* blob, size_t size) {
+    BlobReader header(blob, size);
+    header.readBytes(SEQUENCE_DATA_BLOB_MAGIC_SIZE);
+    UInt8 version = header.readByte();
+    UInt8 flags = header.readByte();
+    if (!header.isValid || version != SEQUENCE_DATA_BLOB_VERSION) return false;
+
+    std::vector<char> uncompressedData;
+    const char* data = reinterpret_cast<const char*>(header.p);
+    size_t dataSize = header.end - header.p;
+    if (flags & SEQUENCE_DATA_BLOB_COMPRESSED) {
+        // Deflate cannot expand the data more than 1032 times
+        UInt64 expectedSize = header.readVarint();
+        if (!header.isValid || expectedSize > static_cast<UInt64>(header.end - header.p) * 1032) return false;
+        uLongf uncompressedSize = static_cast<uLongf>(expectedSize);
+        uncompressedData.resize(uncompressedSize);
+        if (uncompress(reinterpret_cast<Bytef*>(uncompressedData.data()), &uncompressedSize, header.p,
+                       static_cast<uLong>(header.end - header.p)) != Z_OK ||
+            uncompressedSize != uncompressedData.size())
+            return false;
+        data = uncompressedData.data();
+        dataSize = uncompressedData.size();
+    }
+
+    BlobReader reader(data, dataSize);
+    SequenceData sequenceData;
+    sequenceData.tracks.clear();
+    sequenceData.format = static_cast<UInt8>(reader.readVarint());
+
+    std::vector<UInt32> tickCounts, lengths;
+    std::vector<SInt32> params[3];
+    std::vector<UInt8> types, channels;
+
+    size_t nbTracks = reader.readCount();
+    for (size_t trackIndex = 0; trackIndex < nbTracks && reader.isValid; ++trackIndex) {
+        auto track = std::make_shared<Track>();
+        track->clips.clear();
+        size_t nameSize = reader.readCount();
+        const char* name = reader.readBytes(nameSize);
+        if (name) track->name.assign(name, nameSize);
+        track->channel = reader.readByte();
+
+        size_t nbClips = reader.readCount();
+        for (size_t clipIndex = 0; clipIndex < nbClips && reader.isValid; ++clipIndex) {
+            size_t nbEvents = reader.readCount();
+
+            tickCounts.resize(nbEvents);
+            SInt64 value = 0;
+            for (auto& tickCount : tickCounts) tickCount = static_cast<UInt32>(value += reader.readSignedVarint());
+
+            const char* bytes = reader.readBytes(nbEvents);
+            if (bytes) types.assign(bytes, bytes + nbEvents);
+            bytes = reader.readBytes(nbEvents);
+            if (bytes) channels.assign(bytes, bytes + nbEvents);
+
+            lengths.resize(nbEvents);
+            for (auto& length : lengths) length = static_cast<UInt32>(reader.readVarint());
+
+            for (auto& paramValues : params) {
+                paramValues.resize(nbEvents);
+                value = 0;
+                for (auto& paramValue : paramValues)
+                    paramValue = static_cast<SInt32>(value += reader.readSignedVarint());
+            }
+            if (!reader.isValid) break;
+
+            auto events = std::make_shared<std::vector<ChannelEvent>>();
+            events->reserve(nbEvents);
+            for (size_t i = 0; i < nbEvents; ++i) {
+                events->emplace_back(types[i], channels[i], tickCounts[i], lengths[i], params[0][i], params[1][i],
+                                     params[2][i]);
+                ChannelEvent& event = events->back();
+                if (event.isVariableLength()) {
+                    size_t eventDataSize = reader.readCount();
+                    const char* eventData = reader.readBytes(eventDataSize);
+                    if (eventData) event.setData(std::vector<UInt8>(eventData, eventData + eventDataSize));
+                    event.setLength(static_cast<UInt32>(eventDataSize));
+                }
+            }
+
+            auto clip = std::make_shared<Clip>();
+            clip->events.reserve(nbEvents);
+            for (auto& event : *events) clip->events.push_back(std::shared_ptr<Event>(events, &event));
+            track->clips.push_back(clip);
+        }
+
+        sequenceData.tracks.push_back(track);
+    }
+
+    if (!reader.isValid) return false;
+
+    sequence->data.format = sequenceData.format;
+    sequence->data.tracks = std::move(sequenceData.tracks);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool MelobaseCore::setSequenceDataFromBlob(std::shared_ptr<Sequence> sequence, const char* blob, size_t size) {
+    if (size >= SEQUENCE_DATA_BLOB_MAGIC_SIZE &&
+        memcmp(blob, SEQUENCE_DATA_BLOB_MAGIC, SEQUENCE_DATA_BLOB_MAGIC_SIZE) == 0)
+        return setSequenceDataFromBinaryBlob(sequence, blob, size);
+
     Any message;
 
     try {
@@ -265,16 +543,13 @@ bool MelobaseCore::setSequenceAnnotationsFromBlob(Sequence* sequence, const char
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-static std::string sanitizedSQLString(std::string s) {
-    std::string ret;
-    for (auto c : s) {
-        if (c == '\'') {
-            ret += "\'\'";
-        } else {
-            ret += c;
-        }
+// The sequences without folder have an empty string as folder
+static void bindFolderID(MDStudio::DB::Statement* statement, int index, std::shared_ptr<SequencesFolder> folder) {
+    if (folder) {
+        statement->bindInt64(index, folder->id);
+    } else {
+        statement->bindText(index, "");
     }
-    return ret;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -293,7 +568,9 @@ MelobaseCore::SequencesDB::SequencesDB(std::string dbPath, MDStudio::UndoManager
     _maxSequenceDataID = 0L;
     _maxSequencesFolderID = 0L;
 
-    _isSequencesCacheValid = false;
+    _sequencesListsUse = 0;
+    _nbSequencesListsCounted = 0;
+    _nbSequencesPagesRead = 0;
     _isFoldersCacheValid = false;
 
     _db = new MDStudio::DB();
@@ -324,6 +601,45 @@ bool MelobaseCore::SequencesDB::addStandardFolders() {
     return true;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// The indexes on the ordered columns also hold the primary key, which orders the sequences with the same value
+bool MelobaseCore::SequencesDB::addIndexes() {
+    if (!_db->exec("CREATE INDEX ZMDSEQUENCE_ZDATE_INDEX ON ZMDSEQUENCE (ZDATE);\n", true)) return false;
+    if (!_db->exec("CREATE INDEX ZMDSEQUENCE_ZRATING_INDEX ON ZMDSEQUENCE (ZRATING);\n", true)) return false;
+    if (!_db->exec("CREATE INDEX ZMDSEQUENCE_ZNAME_INDEX ON ZMDSEQUENCE (ZNAME COLLATE NOCASE);\n", true))
+        return false;
+    if (!_db->exec("CREATE INDEX ZMDSEQUENCE_ZFOLDER_INDEX ON ZMDSEQUENCE (ZFOLDER);\n", true)) return false;
+    if (!_db->exec("CREATE INDEX ZMDSEQUENCESFOLDER_ZPARENT_INDEX ON ZMDSEQUENCESFOLDER (ZPARENT);\n", true))
+        return false;
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Full-text index of the names and descriptions of the sequences, kept up to date by triggers
+bool MelobaseCore::SequencesDB::addSearchIndex() {
+    if (!_db->exec("CREATE VIRTUAL TABLE ZMDSEQUENCE_FTS USING fts4 (ZNAME, ZDESC);\n", true)) return false;
+    if (!_db->exec("CREATE TRIGGER ZMDSEQUENCE_FTS_INSERT AFTER INSERT ON ZMDSEQUENCE BEGIN INSERT INTO "
+                   "ZMDSEQUENCE_FTS (docid, ZNAME, ZDESC) VALUES(new.Z_PK, new.ZNAME, new.ZDESC); END;\n",
+                   true))
+        return false;
+    if (!_db->exec("CREATE TRIGGER ZMDSEQUENCE_FTS_UPDATE AFTER UPDATE OF ZNAME, ZDESC ON ZMDSEQUENCE BEGIN UPDATE "
+                   "ZMDSEQUENCE_FTS SET ZNAME=new.ZNAME, ZDESC=new.ZDESC WHERE docid=new.Z_PK; END;\n",
+                   true))
+        return false;
+    if (!_db->exec("CREATE TRIGGER ZMDSEQUENCE_FTS_DELETE AFTER DELETE ON ZMDSEQUENCE BEGIN DELETE FROM "
+                   "ZMDSEQUENCE_FTS WHERE docid=old.Z_PK; END;\n",
+                   true))
+        return false;
+
+    // Index the existing sequences
+    if (!_db->exec("INSERT INTO ZMDSEQUENCE_FTS (docid, ZNAME, ZDESC) SELECT Z_PK, ZNAME, ZDESC FROM ZMDSEQUENCE;\n",
+                   true))
+        return false;
+
+    return true;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 bool MelobaseCore::SequencesDB::validateAndFixStandardFolders() {
     invalidateFoldersCache();
@@ -387,7 +703,6 @@ bool MelobaseCore::SequencesDB::open(bool isInitiallyEmpty) {
     if (!_db->open(path)) return false;
 
     if (isNew) {
-        _db->clearResults();
         if (!_db->exec("BEGIN TRANSACTION;\n", false)) return false;
         if (!_db->exec("CREATE TABLE Z_PRIMARYKEY (Z_ENT INTEGER PRIMARY KEY, Z_NAME VARCHAR, Z_SUPER INTEGER, Z_MAX "
                        "INTEGER);\n",
@@ -414,24 +729,26 @@ bool MelobaseCore::SequencesDB::open(bool isInitiallyEmpty) {
         // Add standard folders
         if (!addStandardFolders()) return false;
 
+        if (!addIndexes()) return false;
+        if (!addSearchIndex()) return false;
+
         // Update database version
-        if (!_db->exec("PRAGMA user_version = 4;\n", false)) return false;
+        if (!_db->exec("PRAGMA user_version = 7;\n", false)) return false;
         if (!_db->exec("COMMIT;\n", true)) return false;
 
     } else {
         // Read the current version
-        _db->clearResults();
-
         if (!_db->exec("BEGIN TRANSACTION;\n", false)) return false;
-        if (!_db->exec("PRAGMA user_version;\n", false)) return false;
+        MDStudio::DB::Statement* statement = _db->prepare("PRAGMA user_version;", true);
+        if (!statement || !statement->step(true)) return false;
+        unsigned long version = static_cast<unsigned long>(statement->columnInt64(0));
+        statement->reset();
         if (!_db->exec("COMMIT;\n", true)) return false;
 
-        unsigned long version = std::stol(_db->rows()[0][0].second);
-
         std::cout << "Database version: " << version << std::endl;
 
         // Check if the application is out-dated
-        if (version > 4) {
+        if (version > 7) {
             std::cout << "The database is more recent than the application therefore it cannot be opened." << std::endl;
             _db->close();
             if (MDStudio::Platform::sharedInstance()->language() == "fr") {
@@ -511,37 +828,81 @@ bool MelobaseCore::SequencesDB::open(bool isInitiallyEmpty) {
 
             std::cout << "Migration to version 4 successful." << std::endl;
         }
+
+        // Perform the migration if necessary
+        if (version < 5) {
+            std::cout << "Performing database migration to version 5..." << std::endl;
+
+            if (!_db->exec("BEGIN TRANSACTION;\n", false)) return false;
+
+            // The pages of sequences are read from the values of the ordered columns, which cannot be null. The null
+            // values were already read as zero or as an empty name.
+            if (!_db->exec("UPDATE `ZMDSEQUENCE` SET ZDATE=0 WHERE ZDATE IS NULL;\n", true)) return false;
+            if (!_db->exec("UPDATE `ZMDSEQUENCE` SET ZRATING=0 WHERE ZRATING IS NULL;\n", true)) return false;
+            if (!_db->exec("UPDATE `ZMDSEQUENCE` SET ZNAME='' WHERE ZNAME IS NULL;\n", true)) return false;
+
+            if (!addIndexes()) return false;
+
+            // Update database version
+            if (!_db->exec("PRAGMA user_version = 5;\n", false)) return false;
+            if (!_db->exec("COMMIT;\n", true)) return false;
+
+            std::cout << "Migration to version 5 successful." << std::endl;
+        }
+
+        // Perform the migration if necessary
+        if (version < 6) {
+            std::cout << "Performing database migration to version 6..." << std::endl;
+
+            if (!_db->exec("BEGIN TRANSACTION;\n", false)) return false;
+
+            if (!addSearchIndex()) return false;
+
+            // Update database version
+            if (!_db->exec("PRAGMA user_version = 6;\n", false)) return false;
+            if (!_db->exec("COMMIT;\n", true)) return false;
+
+            std::cout << "Migration to version 6 successful." << std::endl;
+        }
+
+        // Perform the migration if necessary
+        if (version < 7) {
+            std::cout << "Performing database migration to version 7..." << std::endl;
+
+            // The sequence data is now written as binary blobs, which the previous versions cannot read. The existing
+            // plist blobs are still read and are converted when the sequences are saved.
+            if (!_db->exec("BEGIN TRANSACTION;\n", false)) return false;
+
+            // Update database version
+            if (!_db->exec("PRAGMA user_version = 7;\n", false)) return false;
+            if (!_db->exec("COMMIT;\n", true)) return false;
+
+            std::cout << "Migration to version 7 successful." << std::endl;
+        }
     }
 
     // Validate and fix if necessary the standard folders due to non-atomic SQL operation in previous versions
     validateAndFixStandardFolders();
 
     // Read the primary keys table
-    std::string s;
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) return false;
-    if (!_db->exec("SELECT * FROM Z_PRIMARYKEY;\n", true)) return false;
-    if (!_db->exec("COMMIT;\n", true)) return false;
-
-    UInt64* maxID = nullptr;
-
-    for (auto row : _db->rows()) {
-        for (auto column : row) {
-            if (column.first == std::string("Z_NAME")) {
-                if (column.second == std::string("MDSequence")) {
-                    maxID = &_maxSequenceID;
-                } else if (column.second == std::string("MDSequenceData")) {
-                    maxID = &_maxSequenceDataID;
-                } else if (column.second == std::string("MDSequencesFolder")) {
-                    maxID = &_maxSequencesFolderID;
-                }
-            } else if (column.first == std::string("Z_MAX")) {
-                assert(maxID);
-                *maxID = std::stoul(column.second);
-                maxID = nullptr;
-            }
+    MDStudio::DB::Statement* statement = _db->prepare("SELECT Z_NAME,Z_MAX FROM Z_PRIMARYKEY;", true);
+    if (!statement) return false;
+
+    while (statement->step(true)) {
+        const char* name = statement->columnText(0);
+        UInt64 maxID = statement->columnInt64(1);
+        if (strcmp(name, "MDSequence") == 0) {
+            _maxSequenceID = maxID;
+        } else if (strcmp(name, "MDSequenceData") == 0) {
+            _maxSequenceDataID = maxID;
+        } else if (strcmp(name, "MDSequencesFolder") == 0) {
+            _maxSequencesFolderID = maxID;
         }
     }
+    if (!statement->isDone()) return false;
+
+    if (!_db->exec("COMMIT;\n", true)) return false;
 
     return true;
 }
@@ -571,46 +932,71 @@ bool MelobaseCore::SequencesDB::addSequence(std::shared_ptr<Sequence> sequence,
         sequenceDataID = _maxSequenceDataID + 1;
     }
 
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
 
-    std::vector<char> plist = getSequenceDataBlob(sequence, true);
+    SequencePosition oldPosition, newPosition;
+    bool isOldPositionRead = getSequencePosition(sequenceID, &oldPosition);
+
+    std::vector<char> blob = getSequenceDataBinaryBlob(sequence);
 
-    std::string s =
-        std::string("INSERT INTO `ZMDSEQUENCEDATA` VALUES (" + std::to_string(sequenceDataID) + ",2,2,0," +
-                    std::to_string(sequenceID) + ",'" + std::to_string(sequence->data.tickPeriod) + "',?);\n");
-    if (!_db->writeBlob(s.c_str(), plist.data(), plist.size(), true)) {
+    MDStudio::DB::Statement* statement = _db->prepare("INSERT INTO `ZMDSEQUENCEDATA` VALUES (?,2,2,0,?,?,?);", true);
+    if (statement) {
+        statement->bindInt64(1, sequenceDataID);
+        statement->bindInt64(2, sequenceID);
+        statement->bindDouble(3, sequence->data.tickPeriod);
+        statement->bindBlob(4, blob.data(), blob.size());
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
 
-    plist = getSequenceAnnotationsBlob(sequence.get());
+    std::vector<char> annotationsPlist = getSequenceAnnotationsBlob(sequence.get());
 
-    s = std::string("INSERT INTO `ZMDSEQUENCE` VALUES(" + std::to_string(sequenceID) + ",1,5," +
-                    std::to_string(sequence->playCount) + "," + std::to_string(sequence->version) + "," +
-                    std::to_string(sequenceDataID) + "," +
-                    (sequence->folder ? std::to_string(sequence->folder->id) : std::string("''")) + std::string(",") +
-                    std::to_string(sequence->date) + "," + std::to_string(sequence->rating) + ",'','" +
-                    sanitizedSQLString(sequence->name) + "'," + std::to_string(sequence->dataVersion) + ",?)\n");
-    if (!_db->writeBlob(s.c_str(), plist.size() > 0 ? plist.data() : nullptr, plist.size(), true)) {
+    statement = _db->prepare("INSERT INTO `ZMDSEQUENCE` VALUES(?,1,5,?,?,?,?,?,?,'',?,?,?);", true);
+    if (statement) {
+        statement->bindInt64(1, sequenceID);
+        statement->bindInt64(2, sequence->playCount);
+        statement->bindDouble(3, sequence->version);
+        statement->bindInt64(4, sequenceDataID);
+        bindFolderID(statement, 5, sequence->folder);
+        statement->bindDouble(6, sequence->date);
+        statement->bindDouble(7, sequence->rating);
+        statement->bindText(8, sequence->name);
+        statement->bindDouble(9, sequence->dataVersion);
+        statement->bindBlob(10, annotationsPlist.size() > 0 ? annotationsPlist.data() : nullptr,
+                            annotationsPlist.size());
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
-    s = std::string("UPDATE `Z_PRIMARYKEY` SET Z_MAX=" + std::to_string(sequenceID) + " WHERE Z_NAME='MDSequence';\n");
-    if (!_db->exec(s.c_str(), true)) {
+
+    statement = _db->prepare("UPDATE `Z_PRIMARYKEY` SET Z_MAX=? WHERE Z_NAME=?;", true);
+    if (statement) {
+        statement->bindInt64(1, sequenceID);
+        statement->bindText(2, "MDSequence");
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
-    s = std::string("UPDATE `Z_PRIMARYKEY` SET Z_MAX=" + std::to_string(sequenceDataID) +
-                    " WHERE Z_NAME='MDSequenceData';\n");
-    if (!_db->exec(s.c_str(), true)) {
+
+    statement = _db->prepare("UPDATE `Z_PRIMARYKEY` SET Z_MAX=? WHERE Z_NAME=?;", true);
+    if (statement) {
+        statement->bindInt64(1, sequenceDataID);
+        statement->bindText(2, "MDSequenceData");
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
 
+    bool isNewPositionRead = getSequencePosition(sequenceID, &newPosition);
+
     if (!_db->exec("COMMIT;\n", true)) {
         _dbMutex.unlock();
         return false;
@@ -625,6 +1011,8 @@ bool MelobaseCore::SequencesDB::addSequence(std::shared_ptr<Sequence> sequence,
         sequence->data.id = _maxSequenceDataID;
     }
 
+    updateSequencesLists(isOldPositionRead ? &oldPosition : nullptr, isNewPositionRead ? &newPosition : nullptr);
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _sequenceAddedFn) {
@@ -651,8 +1039,6 @@ bool MelobaseCore::SequencesDB::addFolder(std::shared_ptr<SequencesFolder> folde
         maxSequencesFolderID = specificID;
     }
 
-    _db->clearResults();
-
     if (!isInsideTransaction) {
         if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
             _dbMutex.unlock();
@@ -660,20 +1046,29 @@ bool MelobaseCore::SequencesDB::addFolder(std::shared_ptr<SequencesFolder> folde
         }
     }
 
-    std::string s;
+    MDStudio::DB::Statement* statement;
     if (folder) {
-        s = std::string("INSERT INTO `ZMDSEQUENCESFOLDER` VALUES(" + std::to_string(maxSequencesFolderID) + ",3,6," +
-                        std::to_string(folder->parentID) + ",''," + "'" + sanitizedSQLString(folder->name) +
-                        std::string("',") + std::to_string(folder->date) + "," + std::to_string(folder->rating) + "," +
-                        std::to_string(folder->version) + ")\n");
-        if (!_db->exec(s.c_str(), true)) {
+        statement = _db->prepare("INSERT INTO `ZMDSEQUENCESFOLDER` VALUES(?,3,6,?,'',?,?,?,?);", true);
+        if (statement) {
+            statement->bindInt64(1, maxSequencesFolderID);
+            statement->bindInt64(2, folder->parentID);
+            statement->bindText(3, folder->name);
+            statement->bindDouble(4, folder->date);
+            statement->bindDouble(5, folder->rating);
+            statement->bindDouble(6, folder->version);
+        }
+        if (!statement || !statement->exec(true)) {
             _dbMutex.unlock();
             return false;
         }
     }
-    s = std::string("UPDATE `Z_PRIMARYKEY` SET Z_MAX=" + std::to_string(maxSequencesFolderID) +
-                    " WHERE Z_NAME='MDSequencesFolder';\n");
-    if (!_db->exec(s.c_str(), true)) {
+
+    statement = _db->prepare("UPDATE `Z_PRIMARYKEY` SET Z_MAX=? WHERE Z_NAME=?;", true);
+    if (statement) {
+        statement->bindInt64(1, maxSequencesFolderID);
+        statement->bindText(2, "MDSequencesFolder");
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
@@ -712,25 +1107,37 @@ bool MelobaseCore::SequencesDB::removeSequence(std::shared_ptr<Sequence> sequenc
     if (_undoManager)
         _undoManager->pushFn([=]() { addSequence(sequence, true, true, sequence->id, sequence->data.id); });
 
-    std::string s;
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
 
-    s = std::string("DELETE FROM `ZMDSEQUENCE` WHERE Z_PK=") + std::to_string(sequence->id) + std::string(";\n");
-    s += std::string("DELETE FROM `ZMDSEQUENCEDATA` WHERE Z_PK=") + std::to_string(sequence->data.id) +
-         std::string(";\n");
+    SequencePosition oldPosition, newPosition;
+    bool isOldPositionRead = getSequencePosition(sequence->id, &oldPosition);
+
+    MDStudio::DB::Statement* statement = _db->prepare("DELETE FROM `ZMDSEQUENCE` WHERE Z_PK=?;", true);
+    if (statement) statement->bindInt64(1, sequence->id);
+    if (!statement || !statement->exec(true)) {
+        _dbMutex.unlock();
+        return false;
+    }
 
-    if (!_db->exec(s.c_str(), true)) {
+    statement = _db->prepare("DELETE FROM `ZMDSEQUENCEDATA` WHERE Z_PK=?;", true);
+    if (statement) statement->bindInt64(1, sequence->data.id);
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
+
+    bool isNewPositionRead = getSequencePosition(sequence->id, &newPosition);
+
     if (!_db->exec("COMMIT;\n", true)) {
         _dbMutex.unlock();
         return false;
     }
+
+    updateSequencesLists(isOldPositionRead ? &oldPosition : nullptr, isNewPositionRead ? &newPosition : nullptr);
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _sequenceRemovedFn) {
@@ -752,24 +1159,21 @@ bool MelobaseCore::SequencesDB::removeFolder(std::shared_ptr<SequencesFolder> fo
 
     if (_undoManager) _undoManager->pushFn([=]() { addFolder(folder, true, true, folder->id); });
 
-    std::string s;
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
 
-    s = std::string("UPDATE `ZMDSEQUENCE` SET ZFOLDER='' WHERE ZFOLDER=") + std::to_string(folder->id) +
-        std::string(";\n");
-
-    if (!_db->exec(s.c_str(), true)) {
+    MDStudio::DB::Statement* statement = _db->prepare("UPDATE `ZMDSEQUENCE` SET ZFOLDER='' WHERE ZFOLDER=?;", true);
+    if (statement) statement->bindInt64(1, folder->id);
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
 
-    s = std::string("DELETE FROM `ZMDSEQUENCESFOLDER` WHERE Z_PK=") + std::to_string(folder->id) + std::string(";\n");
-
-    if (!_db->exec(s.c_str(), true)) {
+    statement = _db->prepare("DELETE FROM `ZMDSEQUENCESFOLDER` WHERE Z_PK=?;", true);
+    if (statement) statement->bindInt64(1, folder->id);
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
@@ -778,6 +1182,10 @@ bool MelobaseCore::SequencesDB::removeFolder(std::shared_ptr<SequencesFolder> fo
         _dbMutex.unlock();
         return false;
     }
+
+    // The sequences of the folder are moved out of it
+    _sequencesLists.clear();
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _folderRemovedFn) {
@@ -790,7 +1198,7 @@ bool MelobaseCore::SequencesDB::removeFolder(std::shared_ptr<SequencesFolder> fo
 // ---------------------------------------------------------------------------------------------------------------------
 void MelobaseCore::SequencesDB::invalidateSequencesCache() {
     _dbMutex.lock();
-    _isSequencesCacheValid = false;
+    _sequencesLists.clear();
     _dbMutex.unlock();
 }
 
@@ -806,31 +1214,10 @@ unsigned long MelobaseCore::SequencesDB::getNbSequences(sequencesFilterEnum filt
                                                         std::shared_ptr<SequencesFolder> folder,
                                                         bool isIncludingSubfolders) {
     _dbMutex.lock();
-    std::string s;
-    _db->clearResults();
-    if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
-        _dbMutex.unlock();
-        return false;
-    }
-    if (folder && isIncludingSubfolders) {
-        s = std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(folder->id) +
-                        ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) "
-                        "SELECT COUNT(*) FROM `ZMDSEQUENCE` " +
-                        filterString(filter, nameSearch, nullptr, true) + ";\n");
-    } else {
-        s = std::string("SELECT COUNT(*) FROM `ZMDSEQUENCE` ") + filterString(filter, nameSearch, folder, false) +
-            ";\n";
-    }
-    if (!_db->exec(s.c_str(), true)) {
-        _dbMutex.unlock();
-        return false;
-    }
-    if (!_db->exec("COMMIT;\n", true)) {
-        _dbMutex.unlock();
-        return false;
-    }
 
-    unsigned long ret = std::stol(_db->rows()[0][0].second);
+    SequencesList* list = getSequencesList(filter, nameSearch, folder, isIncludingSubfolders);
+    unsigned long ret = list ? list->nbSequences : 0;
+
     _dbMutex.unlock();
     return ret;
 }
@@ -838,160 +1225,113 @@ unsigned long MelobaseCore::SequencesDB::getNbSequences(sequencesFilterEnum filt
 // ---------------------------------------------------------------------------------------------------------------------
 unsigned long MelobaseCore::SequencesDB::getNbFolders(std::shared_ptr<SequencesFolder> parentFolder) {
     _dbMutex.lock();
-    std::string s;
 
-    std::string filter = parentFolder ? " WHERE ZPARENT=" + std::to_string(parentFolder->id) + " AND Z_PK<>0" : "";
-
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
-    s = std::string("SELECT COUNT(*) FROM `ZMDSEQUENCESFOLDER`" + filter + ";\n");
-    if (!_db->exec(s.c_str(), true)) {
+    MDStudio::DB::Statement* statement =
+        _db->prepare(parentFolder ? "SELECT COUNT(*) FROM `ZMDSEQUENCESFOLDER` WHERE ZPARENT=? AND Z_PK<>0;"
+                                  : "SELECT COUNT(*) FROM `ZMDSEQUENCESFOLDER`;",
+                     true);
+    if (statement && parentFolder) statement->bindInt64(1, parentFolder->id);
+    if (!statement || !statement->step(true)) {
         _dbMutex.unlock();
         return false;
     }
+    unsigned long ret = static_cast<unsigned long>(statement->columnInt64(0));
+    statement->reset();
+
     if (!_db->exec("COMMIT;\n", true)) {
         _dbMutex.unlock();
         return false;
     }
 
-    unsigned long ret = std::stol(_db->rows()[0][0].second);
     _dbMutex.unlock();
     return ret;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void MelobaseCore::SequencesDB::setSequence(std::shared_ptr<Sequence> sequence,
-                                            std::vector<std::pair<std::string, std::string>> columns) {
-    for (auto column : columns) {
-        if (column.first == std::string("Z_PK")) {
-            sequence->id = std::stol(column.second);
-        } else if (column.first == std::string("ZDATE")) {
-            sequence->date = std::stod(column.second);
-        } else if (column.first == std::string("ZVERSION")) {
-            sequence->version = std::stod(column.second);
-        } else if (column.first == std::string("ZNAME")) {
-            sequence->name = column.second;
-        } else if (column.first == std::string("ZRATING")) {
-            sequence->rating = std::stof(column.second);
-        } else if (column.first == std::string("ZPLAYCOUNT")) {
-            sequence->playCount = std::stoi(column.second);
-        } else if (column.first == std::string("ZFOLDER")) {
-            if (!column.second.empty()) {
-                sequence->folder = getFolderWithIDInternal(stoull(column.second));
-            } else {
-                sequence->folder = nullptr;
-            }
-        } else if (column.first == std::string("ZDATAVERSION")) {
-            if (column.second != "") {
-                sequence->dataVersion = std::stod(column.second);
-            } else {
-                sequence->dataVersion = 0;
-            }
+bool MelobaseCore::SequencesDB::setSequence(std::shared_ptr<Sequence> sequence, MDStudio::DB::Statement* statement,
+                                            std::map<UInt64, std::shared_ptr<SequencesFolder>>* folders) {
+    sequence->id = statement->columnInt64(0);
+    sequence->date = statement->columnDouble(1);
+    sequence->version = statement->columnDouble(2);
+    sequence->name = statement->columnText(3);
+    sequence->rating = static_cast<Float32>(statement->columnDouble(4));
+    sequence->playCount = static_cast<SInt32>(statement->columnInt64(5));
+
+    // The sequences without folder have an empty string as folder
+    if (statement->columnType(6) == SQLITE_INTEGER) {
+        UInt64 folderID = statement->columnInt64(6);
+        if (folders) {
+            auto it = folders->find(folderID);
+            if (it == folders->end()) it = folders->emplace(folderID, getFolderWithIDInternal(folderID)).first;
+            sequence->folder = it->second;
+        } else {
+            sequence->folder = getFolderWithIDInternal(folderID);
         }
+    } else {
+        sequence->folder = nullptr;
     }
 
+    // Zero if null
+    sequence->dataVersion = statement->columnDouble(7);
     if (sequence->dataVersion == 0) sequence->dataVersion = sequence->version;
-}
 
-// ---------------------------------------------------------------------------------------------------------------------
-void MelobaseCore::SequencesDB::setSequenceData(SequenceData* sequenceData,
-                                                std::vector<std::pair<std::string, std::string>> columns) {
-    for (auto column : columns) {
-        if (column.first == std::string("Z_PK")) {
-            sequenceData->id = std::stol(column.second);
-        }
-    }
+    // The annotations are parsed in place
+    return setSequenceAnnotationsFromBlob(sequence.get(), static_cast<const char*>(statement->columnBlob(8)),
+                                          statement->columnBytes(8));
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 void MelobaseCore::SequencesDB::setFolder(std::shared_ptr<SequencesFolder> folder,
-                                          std::vector<std::pair<std::string, std::string>> columns) {
-    for (auto column : columns) {
-        if (column.first == std::string("Z_PK")) {
-            folder->id = std::stol(column.second);
-        } else if (column.first == std::string("ZDATE")) {
-            if (column.second != "") {
-                folder->date = std::stod(column.second);
-            } else {
-                folder->date = 0;
-            }
-        } else if (column.first == std::string("ZNAME")) {
-            folder->name = column.second;
-        } else if (column.first == std::string("ZRATING")) {
-            if (column.second != "") {
-                folder->rating = std::stof(column.second);
-            } else {
-                folder->rating = 0;
-            }
-        } else if (column.first == std::string("ZVERSION")) {
-            if (column.second != "") {
-                folder->version = std::stod(column.second);
-            } else {
-                folder->version = 0;
-            }
-        } else if (column.first == std::string("ZPARENT")) {
-            if (column.second != "") {
-                folder->parentID = std::stol(column.second);
-            } else {
-                folder->parentID = 0;
-            }
-        }
-    }
+                                          MDStudio::DB::Statement* statement) {
+    // The null values are read as zero
+    folder->id = statement->columnInt64(0);
+    folder->date = statement->columnDouble(1);
+    folder->name = statement->columnText(2);
+    folder->rating = static_cast<Float32>(statement->columnDouble(3));
+    folder->version = statement->columnDouble(4);
+    folder->parentID = statement->columnInt64(5);
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
-bool MelobaseCore::SequencesDB::readSequenceAnnotations(Sequence* sequence) {
-    auto s = std::string("SELECT ZANNOTATIONS FROM `ZMDSEQUENCE` WHERE Z_PK=") + std::to_string(sequence->id) +
-             std::string(";\n");
-
-    char* blob;
-    size_t size;
-
-    if (_db->readBlob(s.c_str(), &blob, &size)) {
-        Any message;
-
-        if (!setSequenceAnnotationsFromBlob(sequence, blob, size)) {
-            free(blob);
-            return false;
-        }
-    }
-
-    free(blob);
-    return true;
-}
 // ---------------------------------------------------------------------------------------------------------------------
 std::vector<std::shared_ptr<Sequence>> MelobaseCore::SequencesDB::getSequences() {
     _dbMutex.lock();
     std::vector<std::shared_ptr<Sequence>> sequences;
 
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return {};
     }
-    if (!_db->exec("SELECT Z_PK,ZDATE,ZVERSION,ZNAME,ZRATING,ZPLAYCOUNT,ZFOLDER,ZDATAVERSION FROM `ZMDSEQUENCE`;\n",
-                   true)) {
-        _dbMutex.unlock();
-        return {};
-    }
-    if (!_db->exec("COMMIT;\n", true)) {
+    MDStudio::DB::Statement* statement = _db->prepare("SELECT " SEQUENCE_COLUMNS " FROM `ZMDSEQUENCE`;", true);
+    if (!statement) {
         _dbMutex.unlock();
         return {};
     }
 
-    for (auto row : _db->rows()) {
+    std::map<UInt64, std::shared_ptr<SequencesFolder>> folders;
+    while (statement->step(true)) {
         std::shared_ptr<Sequence> sequence = std::shared_ptr<Sequence>(new Sequence());
-        setSequence(sequence, row);
-        if (!readSequenceAnnotations(sequence.get())) {
+        if (!setSequence(sequence, statement, &folders)) {
+            statement->reset();
+            _db->exec("ROLLBACK;\n", false);
             _dbMutex.unlock();
             return {};
         }
 
         sequences.push_back(sequence);
     }
+    if (!statement->isDone()) {
+        _dbMutex.unlock();
+        return {};
+    }
+
+    if (!_db->exec("COMMIT;\n", true)) {
+        _dbMutex.unlock();
+        return {};
+    }
 
     _dbMutex.unlock();
     return sequences;
@@ -1003,29 +1343,35 @@ std::vector<std::shared_ptr<SequencesFolder>> MelobaseCore::SequencesDB::getFold
     _dbMutex.lock();
     std::vector<std::shared_ptr<SequencesFolder>> folders;
 
-    std::string s;
-    std::string filter = parentFolder ? " WHERE ZPARENT=" + std::to_string(parentFolder->id) + " AND Z_PK<>0" : "";
-
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return folders;
     }
-    s = std::string("SELECT * FROM `ZMDSEQUENCESFOLDER`" + filter + ";\n");
-    if (!_db->exec(s.c_str(), true)) {
-        _dbMutex.unlock();
-        return folders;
-    }
-    if (!_db->exec("COMMIT;\n", true)) {
+    MDStudio::DB::Statement* statement =
+        _db->prepare(parentFolder ? "SELECT " FOLDER_COLUMNS " FROM `ZMDSEQUENCESFOLDER` WHERE ZPARENT=? AND Z_PK<>0;"
+                                  : "SELECT " FOLDER_COLUMNS " FROM `ZMDSEQUENCESFOLDER`;",
+                     true);
+    if (!statement) {
         _dbMutex.unlock();
         return folders;
     }
+    if (parentFolder) statement->bindInt64(1, parentFolder->id);
 
-    for (auto row : _db->rows()) {
+    while (statement->step(true)) {
         std::shared_ptr<SequencesFolder> folder = std::shared_ptr<SequencesFolder>(new SequencesFolder());
-        setFolder(folder, row);
+        setFolder(folder, statement);
         folders.push_back(folder);
     }
+    if (!statement->isDone()) {
+        _dbMutex.unlock();
+        return {};
+    }
+
+    if (!_db->exec("COMMIT;\n", true)) {
+        _dbMutex.unlock();
+        return {};
+    }
+
     _dbMutex.unlock();
     return folders;
 }
@@ -1073,7 +1419,10 @@ std::string MelobaseCore::SequencesDB::filterString(sequencesFilterEnum filter,
         } else {
             filterString += " AND ";
         }
-        filterString += "ZNAME LIKE '%%" + nameSearch + "%%'";
+        // A search without any word is matched as a part of the names
+        filterString += searchQuery(nameSearch).empty()
+                            ? "ZNAME LIKE '%' || ?2 || '%'"
+                            : "Z_PK IN (SELECT docid FROM ZMDSEQUENCE_FTS WHERE ZMDSEQUENCE_FTS MATCH ?2)";
     }
 
     if (folder && !isIncludingSubfolders) {
@@ -1082,7 +1431,7 @@ std::string MelobaseCore::SequencesDB::filterString(sequencesFilterEnum filter,
         } else {
             filterString += " AND ";
         }
-        filterString += "ZFOLDER = " + std::to_string(folder->id);
+        filterString += "ZFOLDER = ?1";
     }
 
     if (isIncludingSubfolders) {
@@ -1097,6 +1446,16 @@ std::string MelobaseCore::SequencesDB::filterString(sequencesFilterEnum filter,
     return filterString;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+void MelobaseCore::SequencesDB::bindFilter(MDStudio::DB::Statement* statement, const std::string& nameSearch,
+                                           std::shared_ptr<SequencesFolder> folder) {
+    if (folder) statement->bindInt64(1, folder->id);
+    if (nameSearch != "") {
+        std::string query = searchQuery(nameSearch);
+        statement->bindText(2, query.empty() ? nameSearch : query);
+    }
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 std::string MelobaseCore::SequencesDB::orderString(sequencesOrderFieldEnum orderField,
                                                    orderDirectionEnum orderDirection) {
@@ -1110,79 +1469,379 @@ std::string MelobaseCore::SequencesDB::orderString(sequencesOrderFieldEnum order
         orderString += "ZNAME COLLATE NOCASE ";
     }
 
+    // The sequences with the same value are ordered by ID so that their position is known
     if (orderDirection == Ascending) {
-        orderString += "ASC";
+        orderString += "ASC, Z_PK ASC";
     } else {
-        orderString += "DESC";
+        orderString += "DESC, Z_PK DESC";
     }
 
     return orderString;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-std::shared_ptr<Sequence> MelobaseCore::SequencesDB::getSequence(
-    unsigned long index, sequencesFilterEnum filter, std::string nameSearch, std::shared_ptr<SequencesFolder> folder,
-    bool isIncludingSubfolders, sequencesOrderFieldEnum orderField, orderDirectionEnum orderDirection) {
-    _dbMutex.lock();
+// Condition selecting the sequences ordered after the key bound to parameters 3 and 4, written so that the range is
+// read from the index of the ordered column
+std::string MelobaseCore::SequencesDB::afterKeyString(sequencesOrderFieldEnum orderField,
+                                                      orderDirectionEnum orderDirection) {
+    std::string key = orderField == Date ? "ZDATE" : (orderField == Rating ? "ZRATING" : "ZNAME COLLATE NOCASE");
+    std::string op = orderDirection == Ascending ? ">" : "<";
+
+    return "(" + key + op + "=?3 AND (" + key + op + "?3 OR Z_PK" + op + "?4))";
+}
 
-    if (!_isSequencesCacheValid) {
-        _cachedSequences.clear();
+// ---------------------------------------------------------------------------------------------------------------------
+std::string MelobaseCore::SequencesDB::selectSequencesString(const std::string& columns, sequencesFilterEnum filter,
+                                                             std::string nameSearch,
+                                                             std::shared_ptr<SequencesFolder> folder,
+                                                             bool isIncludingSubfolders, const std::string& condition) {
+    bool isInsideFolder = folder && isIncludingSubfolders;
+    std::string where = isInsideFolder ? filterString(filter, nameSearch, nullptr, true)
+                                       : filterString(filter, nameSearch, folder, false);
+    if (!condition.empty()) where += (where.empty() ? "WHERE " : " AND ") + condition;
+
+    return std::string(isInsideFolder ? INSIDE_FOLDER_CTE : "") + "SELECT " + columns + " FROM `ZMDSEQUENCE` " + where;
+}
 
-        std::string s;
+// ---------------------------------------------------------------------------------------------------------------------
+bool MelobaseCore::SequencesDB::SequencesList::hasSelection(sequencesFilterEnum filter, const std::string& nameSearch,
+                                                             std::shared_ptr<SequencesFolder> folder,
+                                                             bool isIncludingSubfolders) const {
+    if (this->filter != filter || this->nameSearch != nameSearch) return false;
+    if ((this->folder != nullptr) != (folder != nullptr)) return false;
+    if (folder && this->folder->id != folder->id) return false;
+
+    // The subfolders are only included with a folder
+    return !folder || this->isIncludingSubfolders == isIncludingSubfolders;
+}
 
-        _db->clearResults();
-        if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
-            _dbMutex.unlock();
-            return nullptr;
+// ---------------------------------------------------------------------------------------------------------------------
+// Compares the names as the NOCASE collation does, folding the ASCII letters only
+static int compareNamesNoCase(const std::string& name1, const std::string& name2) {
+    size_t length = std::min(name1.size(), name2.size());
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c1 = static_cast<unsigned char>(name1[i]), c2 = static_cast<unsigned char>(name2[i]);
+        if (c1 >= 'A' && c1 <= 'Z') c1 += 'a' - 'A';
+        if (c2 >= 'A' && c2 <= 'Z') c2 += 'a' - 'A';
+        if (c1 != c2) return c1 < c2 ? -1 : 1;
+    }
+    return name1.size() == name2.size() ? 0 : (name1.size() < name2.size() ? -1 : 1);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int MelobaseCore::SequencesDB::SequencesList::compareKeys(const SequenceKey& key1, const SequenceKey& key2) const {
+    int result;
+    if (orderField == Name) {
+        result = compareNamesNoCase(key1.name, key2.name);
+    } else {
+        double value1 = orderField == Date ? key1.date : key1.rating;
+        double value2 = orderField == Date ? key2.date : key2.rating;
+        result = value1 == value2 ? 0 : (value1 < value2 ? -1 : 1);
+    }
+
+    // The sequences with the same value are ordered by ID
+    if (result == 0 && key1.id != key2.id) result = key1.id < key2.id ? -1 : 1;
+
+    return orderDirection == Ascending ? result : -result;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// The pages and the keys following the sequence move up by one and the page holding it is dropped
+void MelobaseCore::SequencesDB::SequencesList::removeSequence(const SequenceKey& key) {
+    if (nbSequences > 0) --nbSequences;
+
+    std::map<unsigned long, SequencesPage> movedPages;
+    for (auto& pageIt : pages) {
+        SequencesPage& page = pageIt.second;
+        if (page.sequences.empty()) continue;
+        if (compareKeys(key, page.firstKey) < 0) {
+            if (pageIt.first > 0) movedPages.emplace(pageIt.first - 1, std::move(page));
+        } else if (compareKeys(key, page.lastKey) > 0 && page.sequences.size() == SEQUENCES_PAGE_SIZE) {
+            movedPages.emplace(pageIt.first, std::move(page));
         }
+    }
+    pages = std::move(movedPages);
 
-        if (folder && isIncludingSubfolders) {
-            s = std::string(
-                "WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(folder->id) +
-                ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) "
-                "SELECT Z_PK,ZDATE,ZVERSION,ZNAME,ZRATING,ZPLAYCOUNT,ZFOLDER,ZDATAVERSION FROM `ZMDSEQUENCE` " +
-                filterString(filter, nameSearch, nullptr, true) + " " + orderString(orderField, orderDirection) +
-                ";\n");
-        } else {
-            s = std::string(
-                "SELECT Z_PK,ZDATE,ZVERSION,ZNAME,ZRATING,ZPLAYCOUNT,ZFOLDER,ZDATAVERSION FROM `ZMDSEQUENCE` " +
-                filterString(filter, nameSearch, folder, false) + " " + orderString(orderField, orderDirection) +
-                ";\n");
+    std::map<unsigned long, SequenceKey> movedKeys;
+    for (auto& keyIt : keys) {
+        int result = compareKeys(key, keyIt.second);
+        if (result < 0) {
+            movedKeys.emplace(keyIt.first - 1, std::move(keyIt.second));
+        } else if (result > 0) {
+            movedKeys.emplace(keyIt.first, std::move(keyIt.second));
         }
+    }
+    keys = std::move(movedKeys);
+}
 
-        if (!_db->exec(s.c_str(), true)) {
-            _dbMutex.unlock();
-            return nullptr;
+// ---------------------------------------------------------------------------------------------------------------------
+// The pages and the keys following the sequence move down by one and the page where it is inserted is dropped, as is
+// the last page of the list if the sequence is inserted after it
+void MelobaseCore::SequencesDB::SequencesList::insertSequence(const SequenceKey& key) {
+    ++nbSequences;
+
+    std::map<unsigned long, SequencesPage> movedPages;
+    for (auto& pageIt : pages) {
+        SequencesPage& page = pageIt.second;
+        if (page.sequences.empty()) continue;
+        if (compareKeys(key, page.firstKey) < 0) {
+            movedPages.emplace(pageIt.first + 1, std::move(page));
+        } else if (compareKeys(key, page.lastKey) > 0 && page.sequences.size() == SEQUENCES_PAGE_SIZE) {
+            movedPages.emplace(pageIt.first, std::move(page));
         }
-        if (!_db->exec("COMMIT;\n", true)) {
-            _dbMutex.unlock();
-            return nullptr;
+    }
+    pages = std::move(movedPages);
+
+    std::map<unsigned long, SequenceKey> movedKeys;
+    for (auto& keyIt : keys) {
+        int result = compareKeys(key, keyIt.second);
+        if (result < 0) {
+            movedKeys.emplace(keyIt.first + 1, std::move(keyIt.second));
+        } else if (result > 0) {
+            movedKeys.emplace(keyIt.first, std::move(keyIt.second));
         }
+    }
+    keys = std::move(movedKeys);
+}
 
-        for (auto row : _db->rows()) {
-            std::shared_ptr<Sequence> sequence = std::shared_ptr<Sequence>(new Sequence());
-            std::vector<std::pair<std::string, std::string>> columns = row;
-            setSequence(sequence, columns);
-            if (!readSequenceAnnotations(sequence.get())) {
-                _dbMutex.unlock();
-                return nullptr;
-            }
+// ---------------------------------------------------------------------------------------------------------------------
+// Each list is checked against the primary key, so that no list is counted again
+bool MelobaseCore::SequencesDB::getSequencePosition(UInt64 id, SequencePosition* position) {
+    position->isSelected.assign(_sequencesLists.size(), false);
+
+    MDStudio::DB::Statement* statement = _db->prepare("SELECT ZDATE,ZRATING,ZNAME FROM `ZMDSEQUENCE` WHERE Z_PK=?;");
+    if (!statement) return false;
+    statement->bindInt64(1, id);
+    if (!statement->step()) return statement->isDone();
+    position->key.date = statement->columnDouble(0);
+    position->key.rating = statement->columnDouble(1);
+    position->key.name = statement->columnText(2);
+    position->key.id = id;
+    statement->reset();
+
+    for (size_t listIndex = 0; listIndex < _sequencesLists.size(); ++listIndex) {
+        SequencesList* list = _sequencesLists[listIndex].get();
+        std::string s = selectSequencesString("Z_PK", list->filter, list->nameSearch, list->folder,
+                                              list->isIncludingSubfolders, "Z_PK=?5") +
+                        ";";
+        statement = _db->prepare(s);
+        if (!statement) return false;
+        bindFilter(statement, list->nameSearch, list->folder);
+        statement->bindInt64(5, id);
+        position->isSelected[listIndex] = statement->step();
+        if (!position->isSelected[listIndex] && !statement->isDone()) return false;
+        statement->reset();
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void MelobaseCore::SequencesDB::updateSequencesLists(const SequencePosition* oldPosition,
+                                                     const SequencePosition* newPosition) {
+    if (!oldPosition || !newPosition) {
+        _sequencesLists.clear();
+        return;
+    }
+
+    for (size_t listIndex = 0; listIndex < _sequencesLists.size(); ++listIndex) {
+        SequencesList* list = _sequencesLists[listIndex].get();
+        if (oldPosition->isSelected[listIndex]) list->removeSequence(oldPosition->key);
+        if (newPosition->isSelected[listIndex]) list->insertSequence(newPosition->key);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the cached list with the given selection, counting its sequences if not cached
+MelobaseCore::SequencesDB::SequencesList* MelobaseCore::SequencesDB::getSequencesList(
+    sequencesFilterEnum filter, std::string nameSearch, std::shared_ptr<SequencesFolder> folder,
+    bool isIncludingSubfolders) {
+    for (auto& list : _sequencesLists) {
+        if (list->hasSelection(filter, nameSearch, folder, isIncludingSubfolders)) {
+            list->lastUse = ++_sequencesListsUse;
+            return list.get();
+        }
+    }
+
+    std::unique_ptr<SequencesList> list(new SequencesList());
+    list->filter = filter;
+    list->nameSearch = nameSearch;
+    list->folder = folder;
+    list->isIncludingSubfolders = isIncludingSubfolders;
+    list->orderField = Date;
+    list->orderDirection = Descending;
+    list->lastUse = ++_sequencesListsUse;
+
+    if (!_db->exec("BEGIN TRANSACTION;\n", false)) return nullptr;
+    std::string s = selectSequencesString("COUNT(*)", filter, nameSearch, folder, isIncludingSubfolders) + ";";
+    MDStudio::DB::Statement* statement = _db->prepare(s, true);
+    if (statement) bindFilter(statement, nameSearch, folder);
+    if (!statement || !statement->step(true)) return nullptr;
+    list->nbSequences = static_cast<unsigned long>(statement->columnInt64(0));
+    statement->reset();
+    if (!_db->exec("COMMIT;\n", true)) return nullptr;
+    ++_nbSequencesListsCounted;
+
+    // Replace the least recently used list if the cache is full
+    if (_sequencesLists.size() >= SEQUENCES_LISTS_CACHE_SIZE) {
+        auto it = std::min_element(_sequencesLists.begin(), _sequencesLists.end(),
+                                   [](const std::unique_ptr<SequencesList>& list1,
+                                      const std::unique_ptr<SequencesList>& list2) {
+                                       return list1->lastUse < list2->lastUse;
+                                   });
+        _sequencesLists.erase(it);
+    }
+
+    _sequencesLists.push_back(std::move(list));
+    return _sequencesLists.back().get();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns the page of the list holding the sequence at the given index in the given order. A missing page is read from
+// the given index and the nearest preceding key, so that scrolling through the list reads each page without offset.
+MelobaseCore::SequencesDB::SequencesPage* MelobaseCore::SequencesDB::getSequencesPage(
+    SequencesList* list, unsigned long index, sequencesOrderFieldEnum orderField, orderDirectionEnum orderDirection,
+    unsigned long* firstIndex) {
+    // The pages and the keys are only valid for the order in which they were read
+    if (list->orderField != orderField || list->orderDirection != orderDirection) {
+        list->orderField = orderField;
+        list->orderDirection = orderDirection;
+        list->pages.clear();
+        list->keys.clear();
+    }
+
+    auto pageIt = list->pages.upper_bound(index);
+    if (pageIt != list->pages.begin()) {
+        --pageIt;
+        if (index < pageIt->first + pageIt->second.sequences.size()) {
+            pageIt->second.lastUse = ++_sequencesListsUse;
+            *firstIndex = pageIt->first;
+            return &pageIt->second;
+        }
+    }
+
+    // Find the nearest preceding key
+    unsigned long keyIndex = 0;
+    const SequenceKey* key = nullptr;
+    auto keyIt = list->keys.upper_bound(index);
+    if (keyIt != list->keys.begin()) {
+        --keyIt;
+        keyIndex = keyIt->first;
+        key = &keyIt->second;
+    }
+
+    SequencesPage page;
+    page.lastUse = ++_sequencesListsUse;
+
+    if (!_db->exec("BEGIN TRANSACTION;\n", false)) return nullptr;
+
+    std::string s = selectSequencesString(SEQUENCE_COLUMNS, list->filter, list->nameSearch, list->folder,
+                                          list->isIncludingSubfolders,
+                                          key ? afterKeyString(orderField, orderDirection) : "") +
+                    " " + orderString(orderField, orderDirection) + " LIMIT ?5 OFFSET ?6;";
+    MDStudio::DB::Statement* statement = _db->prepare(s, true);
+    if (!statement) return nullptr;
+    bindFilter(statement, list->nameSearch, list->folder);
+    if (key) {
+        if (orderField == Name) {
+            statement->bindText(3, key->name);
+        } else {
+            statement->bindDouble(3, orderField == Date ? key->date : key->rating);
+        }
+        statement->bindInt64(4, key->id);
+    }
+    statement->bindInt64(5, SEQUENCES_PAGE_SIZE);
+    statement->bindInt64(6, index - keyIndex);
 
-            _cachedSequences.push_back(sequence);
+    std::map<UInt64, std::shared_ptr<SequencesFolder>> folders;
+    while (statement->step(true)) {
+        std::shared_ptr<Sequence> sequence = std::shared_ptr<Sequence>(new Sequence());
+        if (!setSequence(sequence, statement, &folders)) {
+            statement->reset();
+            _db->exec("ROLLBACK;\n", false);
+            return nullptr;
         }
+        page.sequences.push_back(sequence);
+
+        // The keys are read from the columns, as stored
+        SequenceKey& sequenceKey = page.sequences.size() == 1 ? page.firstKey : page.lastKey;
+        sequenceKey.date = statement->columnDouble(1);
+        sequenceKey.rating = statement->columnDouble(4);
+        sequenceKey.name = statement->columnText(3);
+        sequenceKey.id = statement->columnInt64(0);
+    }
+    if (!statement->isDone()) return nullptr;
 
-        _isSequencesCacheValid = true;
+    if (!_db->exec("COMMIT;\n", true)) return nullptr;
+    ++_nbSequencesPagesRead;
+
+    if (page.sequences.size() == 1) page.lastKey = page.firstKey;
+    if (page.sequences.size() == SEQUENCES_PAGE_SIZE) list->keys[index + SEQUENCES_PAGE_SIZE] = page.lastKey;
+
+    // Drop the least recently used page if the cache of the list is full
+    if (list->pages.size() >= SEQUENCES_LIST_NB_PAGES) {
+        auto it = std::min_element(list->pages.begin(), list->pages.end(),
+                                   [](const std::pair<const unsigned long, SequencesPage>& page1,
+                                      const std::pair<const unsigned long, SequencesPage>& page2) {
+                                       return page1.second.lastUse < page2.second.lastUse;
+                                   });
+        list->pages.erase(it);
     }
 
-    assert(index < _cachedSequences.size());
+    // A page starting at the same index was found too short
+    list->pages.erase(index);
 
-    std::shared_ptr<Sequence> retSequence = _cachedSequences[index];
+    *firstIndex = index;
+    return &list->pages.emplace(index, std::move(page)).first->second;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::shared_ptr<Sequence> MelobaseCore::SequencesDB::getSequence(
+    unsigned long index, sequencesFilterEnum filter, std::string nameSearch, std::shared_ptr<SequencesFolder> folder,
+    bool isIncludingSubfolders, sequencesOrderFieldEnum orderField, orderDirectionEnum orderDirection) {
+    _dbMutex.lock();
+
+    SequencesList* list = getSequencesList(filter, nameSearch, folder, isIncludingSubfolders);
+    unsigned long firstIndex = 0;
+    SequencesPage* page = (list && index < list->nbSequences)
+                              ? getSequencesPage(list, index, orderField, orderDirection, &firstIndex)
+                              : nullptr;
+    std::shared_ptr<Sequence> retSequence;
+    if (page && index - firstIndex < page->sequences.size()) retSequence = page->sequences[index - firstIndex];
 
     _dbMutex.unlock();
 
     return retSequence;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+std::vector<std::shared_ptr<Sequence>> MelobaseCore::SequencesDB::getSequences(
+    unsigned long index, unsigned long nbSequences, sequencesFilterEnum filter, std::string nameSearch,
+    std::shared_ptr<SequencesFolder> folder, bool isIncludingSubfolders, sequencesOrderFieldEnum orderField,
+    orderDirectionEnum orderDirection) {
+    _dbMutex.lock();
+
+    std::vector<std::shared_ptr<Sequence>> sequences;
+
+    SequencesList* list = getSequencesList(filter, nameSearch, folder, isIncludingSubfolders);
+    if (list) {
+        unsigned long endIndex = std::min(index + nbSequences, list->nbSequences);
+        while (index < endIndex) {
+            unsigned long firstIndex = 0;
+            SequencesPage* page = getSequencesPage(list, index, orderField, orderDirection, &firstIndex);
+            if (!page || index - firstIndex >= page->sequences.size()) break;
+            auto begin = page->sequences.begin() + (index - firstIndex);
+            auto end = page->sequences.begin() + std::min<size_t>(page->sequences.size(), endIndex - firstIndex);
+            sequences.insert(sequences.end(), begin, end);
+            index += end - begin;
+        }
+    }
+
+    _dbMutex.unlock();
+
+    return sequences;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 std::shared_ptr<SequencesFolder> MelobaseCore::SequencesDB::getFolder(unsigned long index,
                                                                       std::shared_ptr<SequencesFolder> parentFolder) {
@@ -1191,30 +1850,35 @@ std::shared_ptr<SequencesFolder> MelobaseCore::SequencesDB::getFolder(unsigned l
     if (!_isFoldersCacheValid) {
         _cachedFolders.clear();
 
-        std::string s;
-
-        std::string filter = parentFolder ? " WHERE ZPARENT=" + std::to_string(parentFolder->id) + " AND Z_PK<>0" : "";
-
-        _db->clearResults();
         if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
             _dbMutex.unlock();
             return nullptr;
         }
-        s = std::string("SELECT * FROM `ZMDSEQUENCESFOLDER`" + filter + ";\n");
-        if (!_db->exec(s.c_str(), true)) {
+        MDStudio::DB::Statement* statement = _db->prepare(
+            parentFolder ? "SELECT " FOLDER_COLUMNS " FROM `ZMDSEQUENCESFOLDER` WHERE ZPARENT=? AND Z_PK<>0;"
+                         : "SELECT " FOLDER_COLUMNS " FROM `ZMDSEQUENCESFOLDER`;",
+            true);
+        if (!statement) {
             _dbMutex.unlock();
             return nullptr;
         }
-        if (!_db->exec("COMMIT;\n", true)) {
+        if (parentFolder) statement->bindInt64(1, parentFolder->id);
+
+        while (statement->step(true)) {
+            std::shared_ptr<SequencesFolder> folder = std::shared_ptr<SequencesFolder>(new SequencesFolder());
+            setFolder(folder, statement);
+            _cachedFolders.push_back(folder);
+        }
+        if (!statement->isDone()) {
+            _cachedFolders.clear();
             _dbMutex.unlock();
             return nullptr;
         }
 
-        for (auto row : _db->rows()) {
-            std::shared_ptr<SequencesFolder> folder = std::shared_ptr<SequencesFolder>(new SequencesFolder());
-            std::vector<std::pair<std::string, std::string>> columns = row;
-            setFolder(folder, columns);
-            _cachedFolders.push_back(folder);
+        if (!_db->exec("COMMIT;\n", true)) {
+            _cachedFolders.clear();
+            _dbMutex.unlock();
+            return nullptr;
         }
 
         _isFoldersCacheValid = true;
@@ -1233,41 +1897,34 @@ std::shared_ptr<SequencesFolder> MelobaseCore::SequencesDB::getFolder(unsigned l
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-std::shared_ptr<Sequence> MelobaseCore::SequencesDB::getSequenceWithID(UInt64 id) {
-    _dbMutex.lock();
+// Returns nullptr if the sequence is not found
+std::shared_ptr<Sequence> MelobaseCore::SequencesDB::getSequenceWithIDInternal(UInt64 id) {
+    MDStudio::DB::Statement* statement = _db->prepare("SELECT " SEQUENCE_COLUMNS " FROM `ZMDSEQUENCE` WHERE Z_PK=?;");
+    if (!statement) return nullptr;
+    statement->bindInt64(1, id);
 
-    std::string s;
-
-    _db->clearResults();
-    if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
-        _dbMutex.unlock();
-        return nullptr;
+    std::shared_ptr<Sequence> sequence = nullptr;
+    if (statement->step()) {
+        sequence = std::shared_ptr<Sequence>(new Sequence());
+        if (!setSequence(sequence, statement)) sequence = nullptr;
     }
+    statement->reset();
 
-    s = std::string(
-            "SELECT Z_PK,ZDATE,ZVERSION,ZNAME,ZRATING,ZPLAYCOUNT,ZFOLDER,ZDATAVERSION FROM `ZMDSEQUENCE` WHERE Z_PK=") +
-        std::to_string(id) + std::string(";\n");
-    if (!_db->exec(s.c_str(), true)) {
-        _dbMutex.unlock();
-        return nullptr;
-    }
+    return sequence;
+}
 
-    if (!_db->exec("COMMIT;\n", true)) {
-        _dbMutex.unlock();
-        return nullptr;
-    }
+// ---------------------------------------------------------------------------------------------------------------------
+std::shared_ptr<Sequence> MelobaseCore::SequencesDB::getSequenceWithID(UInt64 id) {
+    _dbMutex.lock();
 
-    if (_db->rows().size() == 0) {
-        // Sequence not found
+    if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return nullptr;
     }
 
-    std::shared_ptr<Sequence> sequence = std::shared_ptr<Sequence>(new Sequence());
-    std::vector<std::pair<std::string, std::string>> columns = _db->rows().at(0);
+    std::shared_ptr<Sequence> sequence = getSequenceWithIDInternal(id);
 
-    setSequence(sequence, columns);
-    if (!readSequenceAnnotations(sequence.get())) {
+    if (!_db->exec("COMMIT;\n", true)) {
         _dbMutex.unlock();
         return nullptr;
     }
@@ -1277,29 +1934,19 @@ std::shared_ptr<Sequence> MelobaseCore::SequencesDB::getSequenceWithID(UInt64 id
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
+// Also called while reading the sequences, so the query runs in the transaction of the caller if any
 std::shared_ptr<SequencesFolder> MelobaseCore::SequencesDB::getFolderWithIDInternal(UInt64 id) {
-    std::string s;
+    MDStudio::DB::Statement* statement =
+        _db->prepare("SELECT " FOLDER_COLUMNS " FROM `ZMDSEQUENCESFOLDER` WHERE Z_PK=?;");
+    if (!statement) return nullptr;
+    statement->bindInt64(1, id);
 
-    _db->clearResults();
-    if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
-        return nullptr;
-    }
-
-    s = std::string("SELECT * FROM `ZMDSEQUENCESFOLDER` WHERE Z_PK=") + std::to_string(id) + std::string(";\n");
-    if (!_db->exec(s.c_str(), true)) {
-        return nullptr;
-    }
-
-    if (!_db->exec("COMMIT;\n", true)) {
-        return nullptr;
+    std::shared_ptr<SequencesFolder> folder = nullptr;
+    if (statement->step()) {
+        folder = std::shared_ptr<SequencesFolder>(new SequencesFolder());
+        setFolder(folder, statement);
     }
-
-    if (_db->rows().size() == 0) return nullptr;
-
-    std::shared_ptr<SequencesFolder> folder = std::shared_ptr<SequencesFolder>(new SequencesFolder());
-    std::vector<std::pair<std::string, std::string>> columns = _db->rows().at(0);
-
-    setFolder(folder, columns);
+    statement->reset();
 
     return folder;
 }
@@ -1317,64 +1964,51 @@ std::shared_ptr<SequencesFolder> MelobaseCore::SequencesDB::getFolderWithID(UInt
 bool MelobaseCore::SequencesDB::readSequenceData(std::shared_ptr<Sequence> sequence) {
     _dbMutex.lock();
 
-    std::string s;
-
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
-    s = std::string("SELECT ZDATA FROM `ZMDSEQUENCE` WHERE Z_PK=") + std::to_string(sequence->id) + std::string(";\n");
-    if (!_db->exec(s.c_str(), true)) {
-        _dbMutex.unlock();
-        return false;
-    }
-    if (!_db->exec("COMMIT;\n", true)) {
+
+    MDStudio::DB::Statement* statement = _db->prepare("SELECT ZDATA FROM `ZMDSEQUENCE` WHERE Z_PK=?;", true);
+    if (statement) statement->bindInt64(1, sequence->id);
+    if (!statement || !statement->step(true)) {
+        if (statement && statement->isDone()) _db->exec("ROLLBACK;\n", false);
         _dbMutex.unlock();
         return false;
     }
+    UInt64 dataID = statement->columnInt64(0);
+    statement->reset();
 
-    std::vector<std::pair<std::string, std::string>> columns = _db->rows().at(0);
-
-    long dataID = std::stol(columns.at(0).second);
     sequence->data.id = dataID;
 
-    _db->clearResults();
-    s = std::string("SELECT ZTICKPERIOD FROM `ZMDSEQUENCEDATA` WHERE Z_PK=") + std::to_string(dataID) +
-        std::string(";\n");
-    if (!_db->exec(s.c_str(), true)) {
+    statement = _db->prepare("SELECT ZTICKPERIOD,ZEVENTS FROM `ZMDSEQUENCEDATA` WHERE Z_PK=?;", true);
+    if (statement) statement->bindInt64(1, dataID);
+    if (!statement || !statement->step(true)) {
+        if (statement && statement->isDone()) _db->exec("ROLLBACK;\n", false);
         _dbMutex.unlock();
         return false;
     }
-    columns = _db->rows().at(0);
-    Float64 tickPeriod = std::stold(columns.at(0).second);
+
+    Float64 tickPeriod = statement->columnDouble(0);
     if (tickPeriod == 0) {
         std::cout << "Warning: tickPeriod is zero, using 0.001" << std::endl;
         tickPeriod = 0.001;
     }
     sequence->data.tickPeriod = tickPeriod;
 
-    s = std::string("SELECT ZEVENTS FROM `ZMDSEQUENCEDATA` WHERE Z_PK=") + std::to_string(dataID) + std::string(";\n");
-
-    char* blob;
-    size_t size;
-
-    if (_db->readBlob(s.c_str(), &blob, &size)) {
-        Any message;
-
-        if (!setSequenceDataFromBlob(sequence, blob, size)) {
-            free(blob);
-            _dbMutex.unlock();
-            return false;
-        }
+    // The events are parsed in place
+    const char* blob = static_cast<const char*>(statement->columnBlob(1));
+    size_t size = statement->columnBytes(1);
+    bool isDataSet = setSequenceDataFromBlob(sequence, blob, size);
+    statement->reset();
 
-        free(blob);
-    } else {
+    if (!_db->exec("COMMIT;\n", true)) {
         _dbMutex.unlock();
         return false;
     }
+
     _dbMutex.unlock();
-    return true;
+    return isDataSet;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -1394,53 +2028,62 @@ bool MelobaseCore::SequencesDB::updateSequences(std::vector<std::shared_ptr<Sequ
 
         if (isDataVersionUpdated) sequence->dataVersion = MDStudio::getTimestamp();
 
-        std::string s;
-
-        _db->clearResults();
         if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
             _dbMutex.unlock();
             return false;
         }
-        s = std::string("UPDATE `ZMDSEQUENCE` SET ZNAME='" + sanitizedSQLString(sequence->name) + "',ZRATING=" +
-                        std::to_string(sequence->rating) + ",ZPLAYCOUNT=" + std::to_string(sequence->playCount) +
-                        ",ZVERSION=" + std::to_string(sequence->version) +
-                        ",ZDATAVERSION=" + std::to_string(sequence->dataVersion) + ",ZFOLDER=" +
-                        (sequence->folder ? std::to_string(sequence->folder->id) : "''") + " WHERE Z_PK=") +
-            std::to_string(sequence->id) + std::string(";\n");
-        if (!_db->exec(s.c_str(), true)) {
-            _dbMutex.unlock();
-            return false;
-        }
 
-        // Update annotations
+        SequencePosition oldPosition, newPosition;
+        bool isOldPositionRead = getSequencePosition(sequence->id, &oldPosition);
+
+        // Update the fields and the annotations
         auto annotationsPlist = getSequenceAnnotationsBlob(sequence.get());
-        s = std::string("UPDATE `ZMDSEQUENCE` SET ZANNOTATIONS=? WHERE Z_PK=") + std::to_string(sequence->id) +
-            std::string(";\n");
-        if (!_db->writeBlob(s.c_str(), annotationsPlist.size() > 0 ? annotationsPlist.data() : nullptr,
-                            annotationsPlist.size(), true)) {
+        MDStudio::DB::Statement* statement = _db->prepare(
+            "UPDATE `ZMDSEQUENCE` SET ZNAME=?,ZRATING=?,ZPLAYCOUNT=?,ZVERSION=?,ZDATAVERSION=?,ZFOLDER=?,"
+            "ZANNOTATIONS=? WHERE Z_PK=?;",
+            true);
+        if (statement) {
+            statement->bindText(1, sequence->name);
+            statement->bindDouble(2, sequence->rating);
+            statement->bindInt64(3, sequence->playCount);
+            statement->bindDouble(4, sequence->version);
+            statement->bindDouble(5, sequence->dataVersion);
+            bindFolderID(statement, 6, sequence->folder);
+            statement->bindBlob(7, annotationsPlist.size() > 0 ? annotationsPlist.data() : nullptr,
+                                annotationsPlist.size());
+            statement->bindInt64(8, sequence->id);
+        }
+        if (!statement || !statement->exec(true)) {
             _dbMutex.unlock();
             return false;
         }
 
         if (isDataUpdated) {
-            std::vector<char> plist = getSequenceDataBlob(sequence, true);
+            std::vector<char> blob = getSequenceDataBinaryBlob(sequence);
 
             //
             // Update the database
             //
 
-            std::string s = std::string("UPDATE `ZMDSEQUENCEDATA` SET ZEVENTS=? WHERE Z_PK=") +
-                            std::to_string(sequence->data.id) + std::string(";\n");
-            if (!_db->writeBlob(s.c_str(), plist.data(), plist.size(), true)) {
+            statement = _db->prepare("UPDATE `ZMDSEQUENCEDATA` SET ZEVENTS=? WHERE Z_PK=?;", true);
+            if (statement) {
+                statement->bindBlob(1, blob.data(), blob.size());
+                statement->bindInt64(2, sequence->data.id);
+            }
+            if (!statement || !statement->exec(true)) {
                 _dbMutex.unlock();
                 return false;
             }
         }
 
+        bool isNewPositionRead = getSequencePosition(sequence->id, &newPosition);
+
         if (!_db->exec("COMMIT;\n", true)) {
             _dbMutex.unlock();
             return false;
         }
+
+        updateSequencesLists(isOldPositionRead ? &oldPosition : nullptr, isNewPositionRead ? &newPosition : nullptr);
     }  // for each sequence
 
     _dbMutex.unlock();
@@ -1463,18 +2106,20 @@ bool MelobaseCore::SequencesDB::updateFolder(std::shared_ptr<SequencesFolder> fo
 
     if (isVersionUpdated) folder->version = MDStudio::getTimestamp();
 
-    std::string s;
-
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
-    s = std::string("UPDATE `ZMDSEQUENCESFOLDER` SET ZNAME='" + sanitizedSQLString(folder->name) +
-                    "',ZRATING=" + std::to_string(folder->rating) + ",ZVERSION=" + std::to_string(folder->version) +
-                    ",ZPARENT=" + std::to_string(folder->parentID) + " WHERE Z_PK=" + std::to_string(folder->id) +
-                    std::string(";\n"));
-    if (!_db->exec(s.c_str(), true)) {
+    MDStudio::DB::Statement* statement =
+        _db->prepare("UPDATE `ZMDSEQUENCESFOLDER` SET ZNAME=?,ZRATING=?,ZVERSION=?,ZPARENT=? WHERE Z_PK=?;", true);
+    if (statement) {
+        statement->bindText(1, folder->name);
+        statement->bindDouble(2, folder->rating);
+        statement->bindDouble(3, folder->version);
+        statement->bindInt64(4, folder->parentID);
+        statement->bindInt64(5, folder->id);
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
@@ -1483,6 +2128,10 @@ bool MelobaseCore::SequencesDB::updateFolder(std::shared_ptr<SequencesFolder> fo
         _dbMutex.unlock();
         return false;
     }
+
+    // The folders of the sequences in the cached lists are outdated
+    _sequencesLists.clear();
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _folderUpdatedFn) {
@@ -1502,26 +2151,29 @@ bool MelobaseCore::SequencesDB::promoteAllSequences(std::shared_ptr<SequencesFol
     std::string folderFilter;
     std::string recursivePrefix;
 
+    // The folder is bound to parameter 1
     if (folder && isIncludingSubfolders) {
-        recursivePrefix =
-            std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(folder->id) +
-                        ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) ");
+        recursivePrefix = INSIDE_FOLDER_CTE;
     } else {
-        folderFilter = std::string("AND ZFOLDER = ") + (folder ? std::to_string(folder->id) : "''");
+        folderFilter = "AND ZFOLDER = ?1";
     }
 
     std::string s;
 
     double version = MDStudio::getTimestamp();
 
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
-    s = recursivePrefix + std::string("UPDATE `ZMDSEQUENCE` SET ZRATING=ZRATING+0.2,ZVERSION=" +
-                                      std::to_string(version) + " WHERE ZPLAYCOUNT > 0 " + folderFilter + ";\n");
-    if (!_db->exec(s.c_str(), true)) {
+    s = recursivePrefix + "UPDATE `ZMDSEQUENCE` SET ZRATING=ZRATING+0.2,ZVERSION=?2 WHERE ZPLAYCOUNT > 0 " +
+        folderFilter + ";";
+    MDStudio::DB::Statement* statement = _db->prepare(s, true);
+    if (statement) {
+        bindFolderID(statement, 1, folder);
+        statement->bindDouble(2, version);
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
@@ -1529,6 +2181,10 @@ bool MelobaseCore::SequencesDB::promoteAllSequences(std::shared_ptr<SequencesFol
         _dbMutex.unlock();
         return false;
     }
+
+    // The cached lists are read again when needed
+    _sequencesLists.clear();
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _sequenceUpdatedFn) {
@@ -1548,26 +2204,29 @@ bool MelobaseCore::SequencesDB::demoteAllSequences(std::shared_ptr<SequencesFold
     std::string folderFilter;
     std::string recursivePrefix;
 
+    // The folder is bound to parameter 1
     if (folder && isIncludingSubfolders) {
-        recursivePrefix =
-            std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(folder->id) +
-                        ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) ");
+        recursivePrefix = INSIDE_FOLDER_CTE;
     } else {
-        folderFilter = std::string("AND ZFOLDER = ") + (folder ? std::to_string(folder->id) : "''");
+        folderFilter = "AND ZFOLDER = ?1";
     }
 
     std::string s;
 
     double version = MDStudio::getTimestamp();
 
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
-    s = recursivePrefix + std::string("UPDATE `ZMDSEQUENCE` SET ZRATING=ZRATING-0.2,ZVERSION=" +
-                                      std::to_string(version) + " WHERE ZPLAYCOUNT > 0 " + folderFilter + ";\n");
-    if (!_db->exec(s.c_str(), true)) {
+    s = recursivePrefix + "UPDATE `ZMDSEQUENCE` SET ZRATING=ZRATING-0.2,ZVERSION=?2 WHERE ZPLAYCOUNT > 0 " +
+        folderFilter + ";";
+    MDStudio::DB::Statement* statement = _db->prepare(s, true);
+    if (statement) {
+        bindFolderID(statement, 1, folder);
+        statement->bindDouble(2, version);
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
@@ -1575,6 +2234,10 @@ bool MelobaseCore::SequencesDB::demoteAllSequences(std::shared_ptr<SequencesFold
         _dbMutex.unlock();
         return false;
     }
+
+    // The cached lists are read again when needed
+    _sequencesLists.clear();
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _sequenceUpdatedFn) {
@@ -1595,25 +2258,24 @@ bool MelobaseCore::SequencesDB::setAsPlayedAllSequences(std::shared_ptr<Sequence
     std::string folderFilter;
     std::string recursivePrefix;
 
+    // The folder is bound to parameter 1
     if (folder && isIncludingSubfolders) {
-        recursivePrefix =
-            std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(folder->id) +
-                        ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) ");
+        recursivePrefix = INSIDE_FOLDER_CTE;
     } else {
-        folderFilter = std::string("AND ZFOLDER = ") + (folder ? std::to_string(folder->id) : "''");
+        folderFilter = "AND ZFOLDER = ?1";
     }
 
     std::string s;
 
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
 
-    s = recursivePrefix +
-        std::string("UPDATE `ZMDSEQUENCE` SET ZPLAYCOUNT=1 WHERE ZPLAYCOUNT <= 0 " + folderFilter + ";\n");
-    if (!_db->exec(s.c_str(), true)) {
+    s = recursivePrefix + "UPDATE `ZMDSEQUENCE` SET ZPLAYCOUNT=1 WHERE ZPLAYCOUNT <= 0 " + folderFilter + ";";
+    MDStudio::DB::Statement* statement = _db->prepare(s, true);
+    if (statement) bindFolderID(statement, 1, folder);
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
@@ -1621,6 +2283,10 @@ bool MelobaseCore::SequencesDB::setAsPlayedAllSequences(std::shared_ptr<Sequence
         _dbMutex.unlock();
         return false;
     }
+
+    // The cached lists are read again when needed
+    _sequencesLists.clear();
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _sequenceUpdatedFn) {
@@ -1641,27 +2307,29 @@ bool MelobaseCore::SequencesDB::cleanupSequences(std::shared_ptr<SequencesFolder
     std::string folderFilter;
     std::string recursivePrefix;
 
+    // The folder is bound to parameter 1
     if (folder && isIncludingSubfolders) {
-        recursivePrefix =
-            std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(folder->id) +
-                        ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) ");
+        recursivePrefix = INSIDE_FOLDER_CTE;
     } else {
-        folderFilter = std::string("AND ZFOLDER = ") + (folder ? std::to_string(folder->id) : "''");
+        folderFilter = "AND ZFOLDER = ?1";
     }
 
     std::string s;
 
     double version = MDStudio::getTimestamp();
 
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
-    s = recursivePrefix +
-        std::string("UPDATE `ZMDSEQUENCE` SET ZFOLDER=" + std::to_string(TRASH_FOLDER_ID) +
-                    ",ZVERSION=" + std::to_string(version) + " WHERE ZRATING < 0 " + folderFilter + ";\n");
-    if (!_db->exec(s.c_str(), true)) {
+    s = recursivePrefix + "UPDATE `ZMDSEQUENCE` SET ZFOLDER=?2,ZVERSION=?3 WHERE ZRATING < 0 " + folderFilter + ";";
+    MDStudio::DB::Statement* statement = _db->prepare(s, true);
+    if (statement) {
+        bindFolderID(statement, 1, folder);
+        statement->bindInt64(2, TRASH_FOLDER_ID);
+        statement->bindDouble(3, version);
+    }
+    if (!statement || !statement->exec(true)) {
         _dbMutex.unlock();
         return false;
     }
@@ -1669,6 +2337,10 @@ bool MelobaseCore::SequencesDB::cleanupSequences(std::shared_ptr<SequencesFolder
         _dbMutex.unlock();
         return false;
     }
+
+    // The cached lists are read again when needed
+    _sequencesLists.clear();
+
     _dbMutex.unlock();
 
     if (isDelegateNotified && _sequenceUpdatedFn) {
@@ -1685,37 +2357,25 @@ bool MelobaseCore::SequencesDB::emptyTrash(bool isDelegateNotified) {
     // For now, this operation cannot be undone so we clear the undo/redo stacks
     if (_undoManager) _undoManager->clear();
 
-    std::string s;
-
-    _db->clearResults();
     if (!_db->exec("BEGIN TRANSACTION;\n", false)) {
         _dbMutex.unlock();
         return false;
     }
 
-    s = std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(TRASH_FOLDER_ID) +
-                    ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) DELETE "
-                    "FROM `ZMDSEQUENCEDATA` WHERE ZMDSEQUENCEDATA.ZSEQUENCE IN (SELECT ZMDSEQUENCE.ZDATA FROM "
-                    "`ZMDSEQUENCE` WHERE ZMDSEQUENCE.ZFOLDER IN inside_folder);\n");
-    if (!_db->exec(s.c_str(), true)) {
-        _dbMutex.unlock();
-        return false;
-    }
-
-    s = std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(TRASH_FOLDER_ID) +
-                    ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) DELETE "
-                    "FROM `ZMDSEQUENCE` WHERE ZMDSEQUENCE.ZFOLDER IN inside_folder;\n");
-    if (!_db->exec(s.c_str(), true)) {
-        _dbMutex.unlock();
-        return false;
-    }
+    const char* commands[] = {
+        INSIDE_FOLDER_CTE
+        "DELETE FROM `ZMDSEQUENCEDATA` WHERE ZMDSEQUENCEDATA.ZSEQUENCE IN (SELECT ZMDSEQUENCE.ZDATA FROM `ZMDSEQUENCE` "
+        "WHERE ZMDSEQUENCE.ZFOLDER IN inside_folder);",
+        INSIDE_FOLDER_CTE "DELETE FROM `ZMDSEQUENCE` WHERE ZMDSEQUENCE.ZFOLDER IN inside_folder;",
+        INSIDE_FOLDER_CTE "DELETE FROM `ZMDSEQUENCESFOLDER` WHERE ZMDSEQUENCESFOLDER.ZPARENT IN inside_folder;"};
 
-    s = std::string("WITH RECURSIVE inside_folder(n) AS ( VALUES(" + std::to_string(TRASH_FOLDER_ID) +
-                    ") UNION SELECT Z_PK FROM ZMDSEQUENCESFOLDER, inside_folder WHERE ZPARENT=inside_folder.n) DELETE "
-                    "FROM `ZMDSEQUENCESFOLDER` WHERE ZMDSEQUENCESFOLDER.ZPARENT IN inside_folder;\n");
-    if (!_db->exec(s.c_str(), true)) {
-        _dbMutex.unlock();
-        return false;
+    for (auto command : commands) {
+        MDStudio::DB::Statement* statement = _db->prepare(command, true);
+        if (statement) statement->bindInt64(1, TRASH_FOLDER_ID);
+        if (!statement || !statement->exec(true)) {
+            _dbMutex.unlock();
+            return false;
+        }
     }
 
     if (!_db->exec("COMMIT;\n", true)) {
@@ -1723,6 +2383,9 @@ bool MelobaseCore::SequencesDB::emptyTrash(bool isDelegateNotified) {
         return false;
     }
 
+    // The cached lists are read again when needed
+    _sequencesLists.clear();
+
     _dbMutex.unlock();
 
     if (isDelegateNotified) {
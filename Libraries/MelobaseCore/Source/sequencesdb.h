@@ -13,6 +13,7 @@
 #include <undomanager.h>
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -33,6 +34,13 @@
 #define RESERVED6_FOLDER_ID 9
 #define LAST_STANDARD_FOLDER_ID RESERVED6_FOLDER_ID
 
+// Number of sequence lists kept in the cache, one per combination of filter, search and folder
+#define SEQUENCES_LISTS_CACHE_SIZE 8
+
+// Number of sequences read at once from a list and number of pages kept in the cache of each list
+#define SEQUENCES_PAGE_SIZE 64
+#define SEQUENCES_LIST_NB_PAGES 8
+
 namespace MelobaseCore {
 
 class SequencesDB {
@@ -50,6 +58,51 @@ class SequencesDB {
     typedef enum { Ascending, Descending } orderDirectionEnum;
 
    private:
+    // Position of a sequence in the orders of the lists, as stored
+    struct SequenceKey {
+        double date;
+        double rating;
+        std::string name;
+        UInt64 id;
+    };
+
+    struct SequencesPage {
+        std::vector<std::shared_ptr<Sequence>> sequences;
+        SequenceKey firstKey, lastKey;
+        UInt64 lastUse;
+    };
+
+    // Sequences selected by a filter, a name search and a folder. The pages of the list are read in its current order
+    // from the key preceding them, so that only the pages shown are read. The sequences added, removed or updated one
+    // by one move the pages and the keys following them, and drop the pages holding them.
+    struct SequencesList {
+        sequencesFilterEnum filter;
+        std::string nameSearch;
+        std::shared_ptr<SequencesFolder> folder;
+        bool isIncludingSubfolders;
+        unsigned long nbSequences;
+        sequencesOrderFieldEnum orderField;
+        orderDirectionEnum orderDirection;
+        std::map<unsigned long, SequencesPage> pages;  // By index of their first sequence
+        std::map<unsigned long, SequenceKey> keys;     // Key of the sequence preceding each index, kept once dropped
+        UInt64 lastUse;
+
+        bool hasSelection(sequencesFilterEnum filter, const std::string& nameSearch,
+                          std::shared_ptr<SequencesFolder> folder, bool isIncludingSubfolders) const;
+
+        // Compares the keys in the order of the list (negative if the first key comes first)
+        int compareKeys(const SequenceKey& key1, const SequenceKey& key2) const;
+
+        void removeSequence(const SequenceKey& key);
+        void insertSequence(const SequenceKey& key);
+    };
+
+    // Whether a sequence is selected by each cached list, and its key
+    struct SequencePosition {
+        std::vector<bool> isSelected;
+        SequenceKey key;
+    };
+
     MDStudio::DB* _db;
     std::string _dbPath;
     std::mutex _dbMutex;
@@ -67,25 +120,51 @@ class SequencesDB {
     UInt64 _maxSequenceDataID;
     UInt64 _maxSequencesFolderID;
 
-    void setSequence(std::shared_ptr<Sequence> sequence, std::vector<std::pair<std::string, std::string>> columns);
-    void setSequenceData(SequenceData* sequenceData, std::vector<std::pair<std::string, std::string>> columns);
-    void setFolder(std::shared_ptr<SequencesFolder> folder, std::vector<std::pair<std::string, std::string>> columns);
-
-    bool readSequenceAnnotations(Sequence* sequence);
+    // Set from the columns SEQUENCE_COLUMNS and FOLDER_COLUMNS of the current row of the statement. The folders
+    // already read while setting the sequences of a list are shared through the given map.
+    bool setSequence(std::shared_ptr<Sequence> sequence, MDStudio::DB::Statement* statement,
+                     std::map<UInt64, std::shared_ptr<SequencesFolder>>* folders = nullptr);
+    void setFolder(std::shared_ptr<SequencesFolder> folder, MDStudio::DB::Statement* statement);
 
+    // The folder ID is bound to parameter 1 and the name search to parameter 2 by bindFilter(). The words of the name
+    // search are matched as prefixes of the words of the names and descriptions only, so that the index is always used.
     std::string filterString(sequencesFilterEnum filter, std::string nameSearch,
                              std::shared_ptr<SequencesFolder> folder, bool isIncludingSubfolders);
+    void bindFilter(MDStudio::DB::Statement* statement, const std::string& nameSearch,
+                    std::shared_ptr<SequencesFolder> folder);
     std::string orderString(sequencesOrderFieldEnum orderField, orderDirectionEnum orderDirection);
+    std::string afterKeyString(sequencesOrderFieldEnum orderField, orderDirectionEnum orderDirection);
+    std::string selectSequencesString(const std::string& columns, sequencesFilterEnum filter, std::string nameSearch,
+                                      std::shared_ptr<SequencesFolder> folder, bool isIncludingSubfolders,
+                                      const std::string& condition = "");
 
+    std::shared_ptr<Sequence> getSequenceWithIDInternal(UInt64 id);
     std::shared_ptr<SequencesFolder> getFolderWithIDInternal(UInt64 id);
 
+    SequencesList* getSequencesList(sequencesFilterEnum filter, std::string nameSearch,
+                                    std::shared_ptr<SequencesFolder> folder, bool isIncludingSubfolders);
+    SequencesPage* getSequencesPage(SequencesList* list, unsigned long index, sequencesOrderFieldEnum orderField,
+                                    orderDirectionEnum orderDirection, unsigned long* firstIndex);
+
+    // Reads the position of a sequence in the cached lists within the transaction of the caller. A missing sequence
+    // is selected by no list.
+    bool getSequencePosition(UInt64 id, SequencePosition* position);
+    // Moves a changed sequence in the cached lists, or drops the lists if either position is unknown
+    void updateSequencesLists(const SequencePosition* oldPosition, const SequencePosition* newPosition);
+
     bool addStandardFolders();
+    bool addIndexes();
+    bool addSearchIndex();
     bool validateAndFixStandardFolders();
 
     MDStudio::UndoManager* _undoManager;
 
-    bool _isSequencesCacheValid, _isFoldersCacheValid;
-    std::vector<std::shared_ptr<Sequence>> _cachedSequences;
+    std::vector<std::unique_ptr<SequencesList>> _sequencesLists;
+    UInt64 _sequencesListsUse;
+    UInt64 _nbSequencesListsCounted;
+    UInt64 _nbSequencesPagesRead;
+
+    bool _isFoldersCacheValid;
     std::vector<std::shared_ptr<SequencesFolder>> _cachedFolders;
 
    public:
@@ -109,7 +188,8 @@ class SequencesDB {
     std::vector<std::shared_ptr<Sequence>> getSequences();
     std::vector<std::shared_ptr<SequencesFolder>> getFolders(std::shared_ptr<SequencesFolder> parentFolder);
 
-    // Thread-safe
+    // Thread-safe. The cached sequence lists follow the changes made through this class, so they only need to be
+    // invalidated after changes made to the database by other means.
     void invalidateSequencesCache();
     void invalidateFoldersCache();
 
@@ -123,8 +203,21 @@ class SequencesDB {
                                           std::shared_ptr<SequencesFolder> folder, bool isIncludingSubfolders,
                                           sequencesOrderFieldEnum orderField = Date,
                                           orderDirectionEnum orderDirection = Descending);
+
+    // Thread-safe. Returns the sequences from the given index, up to the given number. Only the pages holding them are
+    // read, so the cost does not depend on the number of sequences in the list.
+    std::vector<std::shared_ptr<Sequence>> getSequences(unsigned long index, unsigned long nbSequences,
+                                                        sequencesFilterEnum filter, std::string nameSearch,
+                                                        std::shared_ptr<SequencesFolder> folder,
+                                                        bool isIncludingSubfolders,
+                                                        sequencesOrderFieldEnum orderField = Date,
+                                                        orderDirectionEnum orderDirection = Descending);
     std::shared_ptr<SequencesFolder> getFolder(unsigned long index, std::shared_ptr<SequencesFolder> folder);
 
+    // Number of cached lists counted and of pages read since the database was created, for monitoring the cache
+    UInt64 nbSequencesListsCounted() { return _nbSequencesListsCounted; }
+    UInt64 nbSequencesPagesRead() { return _nbSequencesPagesRead; }
+
     // Thread-safe
     std::shared_ptr<Sequence> getSequenceWithID(UInt64 id);
     std::shared_ptr<SequencesFolder> getFolderWithID(UInt64 id);
@@ -179,7 +272,11 @@ std::vector<char> base64Decode(const char* encodedData);
 void base64Encode(std::string& dataEncoded, const std::vector<char>& data);
 
 std::vector<char> getSequenceDataBlob(std::shared_ptr<Sequence> sequence, bool isVLE);
-bool setSequenceDataFromBlob(std::shared_ptr<Sequence> sequence, char* blob, size_t size);
+bool setSequenceDataFromBlob(std::shared_ptr<Sequence> sequence, const char* blob, size_t size);
+
+// Binary blob storing the events of each clip by columns of delta and variable-length encoded values, compressed if
+// requested and smaller. Read by setSequenceDataFromBlob() like the plist blobs.
+std::vector<char> getSequenceDataBinaryBlob(std::shared_ptr<Sequence> sequence, bool isCompressed = true);
 
 std::vector<char> getSequenceAnnotationsBlob(const Sequence* sequence);
 bool setSequenceAnnotationsFromBlob(Sequence* sequence, const char* blob, size_t size);
@@ -8,10 +8,70 @@
 
 #include "test_sequencesdb.h"
 
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <vector>
 
 #include "sequenceutils.h"
 
+struct SequencesView {
+    MelobaseCore::SequencesDB::sequencesFilterEnum filter;
+    std::string nameSearch;
+    UInt64 folderID;  // No folder if zero
+    bool isIncludingSubfolders;
+    MelobaseCore::SequencesDB::sequencesOrderFieldEnum orderField;
+    MelobaseCore::SequencesDB::orderDirectionEnum orderDirection;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+static std::vector<UInt64> getSequenceIDs(MelobaseCore::SequencesDB& sequencesDB, const SequencesView& view) {
+    auto folder = view.folderID ? sequencesDB.getFolderWithID(view.folderID) : nullptr;
+    auto nbSequences = sequencesDB.getNbSequences(view.filter, view.nameSearch, folder, view.isIncludingSubfolders);
+
+    std::vector<UInt64> ids;
+    for (unsigned long index = 0; index < nbSequences; ++index) {
+        auto sequence = sequencesDB.getSequence(index, view.filter, view.nameSearch, folder, view.isIncludingSubfolders,
+                                                view.orderField, view.orderDirection);
+        ids.push_back(sequence ? sequence->id : 0);
+    }
+    return ids;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Compares the cached lists of the database with the lists read by another connection without cache
+static bool compareSequencesViews(MelobaseCore::SequencesDB& sequencesDB, MelobaseCore::SequencesDB& referenceDB,
+                                  const std::vector<SequencesView>& views) {
+    for (auto& view : views) {
+        referenceDB.invalidateSequencesCache();
+        if (getSequenceIDs(sequencesDB, view) != getSequenceIDs(referenceDB, view)) return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Compares the lists after a change, which must not count the cached lists again nor read more than the given number
+// of pages
+static bool compareCachedSequencesViews(MelobaseCore::SequencesDB& sequencesDB, MelobaseCore::SequencesDB& referenceDB,
+                                        const std::vector<SequencesView>& views, UInt64 maxNbPagesRead) {
+    auto nbListsCounted = sequencesDB.nbSequencesListsCounted();
+    auto nbPagesRead = sequencesDB.nbSequencesPagesRead();
+
+    if (!compareSequencesViews(sequencesDB, referenceDB, views)) return false;
+
+    if (sequencesDB.nbSequencesListsCounted() != nbListsCounted) {
+        std::cout << "The cached lists are counted again\n";
+        return false;
+    }
+
+    if (sequencesDB.nbSequencesPagesRead() - nbPagesRead > maxNbPagesRead) {
+        std::cout << "Too many pages read: " << sequencesDB.nbSequencesPagesRead() - nbPagesRead << "\n";
+        return false;
+    }
+
+    return true;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 bool testSequencesDB() {
     MelobaseCore::SequencesDB sequencesDB("/tmp/test_sequencesdb.sqlite");
@@ -88,5 +148,434 @@ bool testSequencesDB() {
         return false;
     }
 
+    // Names, searches and folders
+
+    auto folder = std::make_shared<MelobaseCore::SequencesFolder>();
+    folder->name = "Folder's name";
+    folder->parentID = SEQUENCES_FOLDER_ID;
+    if (!sequencesDB.addFolder(folder)) {
+        std::cout << "Unable to add folder\n";
+        return false;
+    }
+
+    auto sequence3 = std::make_shared<MelobaseCore::Sequence>();
+    sequence3->name = "It's a 100% test";
+    sequence3->folder = sequencesDB.getFolderWithID(folder->id);
+    sequence3->rating = 0.6f;
+    setEvents(sequence3.get(), 5);
+    if (!sequence3->folder || sequence3->folder->name != folder->name || !sequencesDB.addSequence(sequence3)) {
+        std::cout << "Unable to add sequence in folder\n";
+        return false;
+    }
+
+    auto parentFolder = sequencesDB.getFolderWithID(SEQUENCES_FOLDER_ID);
+    if (sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "It's", nullptr, false) != 1 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "Test", nullptr, false) != 2 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::Filter3, "", nullptr, false) != 1 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "", parentFolder, false) != 1 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "", parentFolder, true) != 2 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "test", sequence3->folder, true) != 1) {
+        std::cout << "Invalid nb of sequences found\n";
+        return false;
+    }
+
+    if (sequencesDB.getNbFolders(parentFolder) != 1) {
+        std::cout << "Invalid nb of folders\n";
+        return false;
+    }
+
+    sequencesDB.invalidateSequencesCache();
+    auto sequence4 = sequencesDB.getSequence(0, MelobaseCore::SequencesDB::All, "100%", parentFolder, true);
+    if (!sequence4 || sequence4->id != sequence3->id || sequence4->name != sequence3->name ||
+        sequence4->rating != sequence3->rating || !sequence4->folder || sequence4->folder->id != folder->id) {
+        std::cout << "Unable to find the sequence\n";
+        return false;
+    }
+
+    // The words of the search are prefixes of the words of the names, so the middle of the words is not found
+    if (sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "tes", nullptr, false) != 2 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "est", nullptr, false) != 0 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "TEST 10", nullptr, false) != 1 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "test OR", nullptr, false) != 0 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "'", nullptr, false) != 1) {
+        std::cout << "Invalid nb of sequences found by search\n";
+        return false;
+    }
+
+    // The search index follows the names
+    sequence4->name = "Sketch";
+    if (!sequencesDB.updateSequences({sequence4}) ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "test", nullptr, false) != 1 ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "sk", nullptr, false) != 1 ||
+        !sequencesDB.removeSequence(sequence4) ||
+        sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "sk", nullptr, false) != 0) {
+        std::cout << "Invalid nb of sequences found after rename\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testSequencesDBCache() {
+    const char* path = "/tmp/test_sequencesdb_cache.sqlite";
+
+    MelobaseCore::SequencesDB sequencesDB(path);
+    if (!sequencesDB.open(true)) {
+        std::cout << "Unable to open DB\n";
+        return false;
+    }
+
+    MelobaseCore::SequencesDB referenceDB(path);
+    if (!referenceDB.open(false)) {
+        std::cout << "Unable to open reference DB\n";
+        return false;
+    }
+
+    auto folder = std::make_shared<MelobaseCore::SequencesFolder>();
+    folder->name = "Folder";
+    folder->parentID = SEQUENCES_FOLDER_ID;
+    sequencesDB.addFolder(folder);
+
+    // Sequences sharing dates, ratings and names in different cases, filling several pages
+    const char* names[] = {"Test", "test", "Sketch", "Another test", "Idea"};
+    for (int i = 0; i < 300; ++i) {
+        auto sequence = std::make_shared<MelobaseCore::Sequence>();
+        sequence->name = names[i % 5];
+        sequence->date = 633974598.0 + (i % 7);
+        sequence->version = sequence->date;
+        sequence->rating = 0.2f * (i % 4);
+        sequence->folder = sequencesDB.getFolderWithID(i % 3 ? SEQUENCES_FOLDER_ID : folder->id);
+        setEvents(sequence.get(), 2);
+        if (i % 4 == 0) setAnnotations(sequence.get(), 2);
+        if (!sequencesDB.addSequence(sequence)) {
+            std::cout << "Unable to add sequence\n";
+            return false;
+        }
+    }
+
+    std::vector<SequencesView> views = {
+        {MelobaseCore::SequencesDB::All, "", 0, false, MelobaseCore::SequencesDB::Date,
+         MelobaseCore::SequencesDB::Descending},
+        {MelobaseCore::SequencesDB::All, "", 0, false, MelobaseCore::SequencesDB::Name,
+         MelobaseCore::SequencesDB::Ascending},
+        {MelobaseCore::SequencesDB::Filter2, "", 0, false, MelobaseCore::SequencesDB::Rating,
+         MelobaseCore::SequencesDB::Descending},
+        {MelobaseCore::SequencesDB::Annotated, "", 0, false, MelobaseCore::SequencesDB::Date,
+         MelobaseCore::SequencesDB::Ascending},
+        {MelobaseCore::SequencesDB::All, "test", 0, false, MelobaseCore::SequencesDB::Name,
+         MelobaseCore::SequencesDB::Descending},
+        {MelobaseCore::SequencesDB::All, "", SEQUENCES_FOLDER_ID, true, MelobaseCore::SequencesDB::Rating,
+         MelobaseCore::SequencesDB::Ascending},
+        {MelobaseCore::SequencesDB::All, "", folder->id, false, MelobaseCore::SequencesDB::Date,
+         MelobaseCore::SequencesDB::Descending}};
+
+    // Read the lists, which are cached
+    if (!compareSequencesViews(sequencesDB, referenceDB, views)) {
+        std::cout << "Sequence lists mismatch\n";
+        return false;
+    }
+
+    // Add
+    auto sequence = std::make_shared<MelobaseCore::Sequence>();
+    sequence->name = "New test";
+    sequence->date = 633974601.0;
+    sequence->rating = 0.4f;
+    sequence->folder = sequencesDB.getFolderWithID(folder->id);
+    setEvents(sequence.get(), 2);
+    setAnnotations(sequence.get(), 1);
+    if (!sequencesDB.addSequence(sequence) || !compareSequencesViews(sequencesDB, referenceDB, views)) {
+        std::cout << "Sequence lists mismatch after add\n";
+        return false;
+    }
+
+    // Update the rating, the name, the annotations and the folder
+    auto sequence1 = sequencesDB.getSequenceWithID(3);
+    auto sequence2 = sequencesDB.getSequenceWithID(8);
+    sequence1->rating = 0.8f;
+    sequence1->name = "idea";
+    sequence2->folder = sequencesDB.getFolderWithID(folder->id);
+    setAnnotations(sequence2.get(), 3);
+    if (!sequencesDB.updateSequences({sequence1, sequence2}) ||
+        !compareSequencesViews(sequencesDB, referenceDB, views)) {
+        std::cout << "Sequence lists mismatch after update\n";
+        return false;
+    }
+
+    // The annotations are read with the sequences
+    auto index = sequencesDB.getNbSequences(MelobaseCore::SequencesDB::Annotated, "", nullptr, false);
+    while (index-- > 0) {
+        auto annotatedSequence = sequencesDB.getSequence(index, MelobaseCore::SequencesDB::Annotated, "", nullptr,
+                                                         false, MelobaseCore::SequencesDB::Date,
+                                                         MelobaseCore::SequencesDB::Ascending);
+        if (annotatedSequence->annotations.empty()) {
+            std::cout << "Missing annotations\n";
+            return false;
+        }
+    }
+
+    // Remove
+    if (!sequencesDB.removeSequence(sequencesDB.getSequenceWithID(5)) ||
+        !sequencesDB.removeSequence(sequencesDB.getSequenceWithID(sequence->id)) ||
+        !compareSequencesViews(sequencesDB, referenceDB, views)) {
+        std::cout << "Sequence lists mismatch after remove\n";
+        return false;
+    }
+
+    // The lists of different selections are kept along with their pages, except those holding the changed sequences
+    std::vector<SequencesView> cachedViews = views;
+    cachedViews.erase(cachedViews.begin() + 1);
+    if (!compareSequencesViews(sequencesDB, referenceDB, cachedViews) ||
+        !compareCachedSequencesViews(sequencesDB, referenceDB, cachedViews, 0)) {
+        std::cout << "Sequence lists mismatch when cached\n";
+        return false;
+    }
+
+    UInt64 maxNbPagesRead = 2 * cachedViews.size();
+
+    auto sequence3 = sequencesDB.getSequenceWithID(150);
+    sequence3->rating = 1.0f;
+    sequence3->name = "Sketch 2";
+    setAnnotations(sequence3.get(), 1);
+    if (!sequencesDB.updateSequences({sequence3}) ||
+        !compareCachedSequencesViews(sequencesDB, referenceDB, cachedViews, maxNbPagesRead)) {
+        std::cout << "Sequence lists mismatch after cached update\n";
+        return false;
+    }
+
+    auto sequence4 = std::make_shared<MelobaseCore::Sequence>();
+    sequence4->name = "Test";
+    sequence4->date = 633974600.0;
+    sequence4->rating = 0.6f;
+    sequence4->folder = sequencesDB.getFolderWithID(SEQUENCES_FOLDER_ID);
+    setEvents(sequence4.get(), 2);
+    if (!sequencesDB.addSequence(sequence4) ||
+        !compareCachedSequencesViews(sequencesDB, referenceDB, cachedViews, maxNbPagesRead)) {
+        std::cout << "Sequence lists mismatch after cached add\n";
+        return false;
+    }
+
+    if (!sequencesDB.removeSequence(sequencesDB.getSequenceWithID(100)) ||
+        !compareCachedSequencesViews(sequencesDB, referenceDB, cachedViews, maxNbPagesRead)) {
+        std::cout << "Sequence lists mismatch after cached remove\n";
+        return false;
+    }
+
+    // Bulk operation
+    if (!sequencesDB.promoteAllSequences(nullptr, false) || !compareSequencesViews(sequencesDB, referenceDB, views)) {
+        std::cout << "Sequence lists mismatch after promote\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Returns true if the first sequence is ordered before the second one in the given order
+static bool isOrderedBefore(const MelobaseCore::Sequence* sequence1, const MelobaseCore::Sequence* sequence2,
+                            MelobaseCore::SequencesDB::sequencesOrderFieldEnum orderField,
+                            MelobaseCore::SequencesDB::orderDirectionEnum orderDirection) {
+    if (orderDirection == MelobaseCore::SequencesDB::Descending) std::swap(sequence1, sequence2);
+
+    int comparison = 0;
+    if (orderField == MelobaseCore::SequencesDB::Name) {
+        std::string name1 = sequence1->name, name2 = sequence2->name;
+        std::transform(name1.begin(), name1.end(), name1.begin(), ::tolower);
+        std::transform(name2.begin(), name2.end(), name2.begin(), ::tolower);
+        comparison = name1.compare(name2);
+    } else {
+        double value1 = orderField == MelobaseCore::SequencesDB::Date ? sequence1->date : sequence1->rating;
+        double value2 = orderField == MelobaseCore::SequencesDB::Date ? sequence2->date : sequence2->rating;
+        comparison = value1 < value2 ? -1 : (value1 > value2 ? 1 : 0);
+    }
+
+    return comparison < 0 || (comparison == 0 && sequence1->id < sequence2->id);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Compares the sequences read by index and by windows with all the sequences sorted in each order
+static bool checkSequencesPages(MelobaseCore::SequencesDB& sequencesDB) {
+    auto allSequences = sequencesDB.getSequences();
+    unsigned long nbSequences = sequencesDB.getNbSequences(MelobaseCore::SequencesDB::All, "", nullptr, false);
+    if (nbSequences != allSequences.size()) return false;
+
+    for (auto orderField : {MelobaseCore::SequencesDB::Date, MelobaseCore::SequencesDB::Rating,
+                            MelobaseCore::SequencesDB::Name}) {
+        for (auto orderDirection : {MelobaseCore::SequencesDB::Ascending, MelobaseCore::SequencesDB::Descending}) {
+            std::sort(allSequences.begin(), allSequences.end(),
+                      [=](const std::shared_ptr<MelobaseCore::Sequence>& sequence1,
+                          const std::shared_ptr<MelobaseCore::Sequence>& sequence2) {
+                          return isOrderedBefore(sequence1.get(), sequence2.get(), orderField, orderDirection);
+                      });
+
+            // Backward, so that the pages are first read without preceding key
+            for (unsigned long index = nbSequences; index-- > 0;) {
+                auto sequence = sequencesDB.getSequence(index, MelobaseCore::SequencesDB::All, "", nullptr, false,
+                                                        orderField, orderDirection);
+                if (!sequence || sequence->id != allSequences[index]->id) return false;
+            }
+
+            // Forward by windows, across the pages dropped from the cache
+            for (unsigned long index = 0; index < nbSequences + 50; index += 50) {
+                auto sequences = sequencesDB.getSequences(index, 50, MelobaseCore::SequencesDB::All, "", nullptr,
+                                                          false, orderField, orderDirection);
+                if (sequences.size() != std::min(50UL, nbSequences - std::min(index, nbSequences))) return false;
+                for (size_t i = 0; i < sequences.size(); ++i)
+                    if (sequences[i]->id != allSequences[index + i]->id) return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testSequencesDBPages() {
+    MelobaseCore::SequencesDB sequencesDB("/tmp/test_sequencesdb_pages.sqlite");
+    if (!sequencesDB.open(true)) {
+        std::cout << "Unable to open DB\n";
+        return false;
+    }
+
+    // More sequences than the pages kept in the cache of a list, sharing dates, ratings and names in different cases
+    const char* names[] = {"Test", "test", "Sketch", "Another test", "Idea", "idea", "Loop"};
+    for (int i = 0; i < SEQUENCES_PAGE_SIZE * (SEQUENCES_LIST_NB_PAGES + 2) + 10; ++i) {
+        auto sequence = std::make_shared<MelobaseCore::Sequence>();
+        sequence->name = names[i % 7];
+        sequence->date = 633974598.0 + (i * 37) % 101;
+        sequence->version = sequence->date;
+        sequence->rating = 0.2f * (i % 6);
+        sequence->folder = sequencesDB.getFolderWithID(SEQUENCES_FOLDER_ID);
+        setEvents(sequence.get(), 1);
+        if (!sequencesDB.addSequence(sequence)) {
+            std::cout << "Unable to add sequence\n";
+            return false;
+        }
+    }
+
+    if (!checkSequencesPages(sequencesDB)) {
+        std::cout << "Sequence pages mismatch\n";
+        return false;
+    }
+
+    // Change a sequence ordered in the middle of the pages
+    auto sequence = sequencesDB.getSequenceWithID(SEQUENCES_PAGE_SIZE * 3);
+    sequence->name = "Another idea";
+    sequence->date = 633974550.0;
+    if (!sequencesDB.updateSequences({sequence}) ||
+        !sequencesDB.removeSequence(sequencesDB.getSequenceWithID(SEQUENCES_PAGE_SIZE * 2)) ||
+        !checkSequencesPages(sequencesDB)) {
+        std::cout << "Sequence pages mismatch after update\n";
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Compares the tracks, the clips and the events of two sequences
+static bool compareSequenceData(MelobaseCore::Sequence* s1, MelobaseCore::Sequence* s2) {
+    if (s1->data.format != s2->data.format || s1->data.tracks.size() != s2->data.tracks.size()) return false;
+
+    for (size_t trackIndex = 0; trackIndex < s1->data.tracks.size(); ++trackIndex) {
+        auto track1 = s1->data.tracks[trackIndex];
+        auto track2 = s2->data.tracks[trackIndex];
+        if (track1->name != track2->name || track1->channel != track2->channel ||
+            track1->clips.size() != track2->clips.size())
+            return false;
+
+        for (size_t clipIndex = 0; clipIndex < track1->clips.size(); ++clipIndex) {
+            auto& events1 = track1->clips[clipIndex]->events;
+            auto& events2 = track2->clips[clipIndex]->events;
+            if (events1.size() != events2.size()) return false;
+
+            for (size_t i = 0; i < events1.size(); ++i) {
+                auto event1 = std::dynamic_pointer_cast<MelobaseCore::ChannelEvent>(events1[i]);
+                auto event2 = std::dynamic_pointer_cast<MelobaseCore::ChannelEvent>(events2[i]);
+                if (!event1 || !event2 || event1->type() != event2->type() ||
+                    event1->channel() != event2->channel() || event1->tickCount() != event2->tickCount() ||
+                    event1->length() != event2->length() || event1->param1() != event2->param1() ||
+                    event1->param2() != event2->param2() || event1->param3() != event2->param3() ||
+                    event1->data() != event2->data())
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool testSequenceDataBlob() {
+    auto sequence = std::make_shared<MelobaseCore::Sequence>();
+    sequence->data.format = SEQUENCE_DATA_FORMAT_MULTI_TRACK;
+
+    auto& events = sequence->data.tracks[0]->clips[0]->events;
+    events.push_back(std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_META_SET_TEMPO, 0, 0, 0, 500000));
+    events.push_back(
+        std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_META_GENERIC, 0, 0, 0, 3, 0, 0,
+                                                     std::vector<UInt8>{'T', 'i', 't', 'l', 'e'}));
+    for (UInt32 i = 0; i < 5000; ++i) {
+        events.push_back(std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_NOTE, i % 16, 10 + i * 120,
+                                                                      60 + i % 7, 60 + (i * 5) % 24, 100 - i % 40));
+        if (i % 50 == 0)
+            events.push_back(std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_PITCH_BEND, 1,
+                                                                          10 + i * 120, 0, -8192 + i));
+    }
+
+    // Events out of order and system exclusive events
+    events.push_back(std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_SUSTAIN, 0, 5, 0, 127));
+    events.push_back(std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_SYSTEM_EXCLUSIVE, 0, 20, 0, 0, 0,
+                                                                  0, std::vector<UInt8>{0x7e, 0x7f, 0x09, 0x01}));
+    events.push_back(std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_META_END_OF_TRACK, 0,
+                                                                  0xffffffff, 0));
+
+    auto track = std::make_shared<MelobaseCore::Track>();
+    track->name = "Bass";
+    track->channel = 3;
+    track->clips.push_back(std::make_shared<MelobaseCore::Clip>());
+    track->clips[1]->addEvent(std::make_shared<MelobaseCore::ChannelEvent>(CHANNEL_EVENT_TYPE_PROGRAM_CHANGE, 3, 0, 0,
+                                                                           33, -1, 2147483647));
+    sequence->data.tracks.push_back(track);
+
+    auto compressedBlob = MelobaseCore::getSequenceDataBinaryBlob(sequence, true);
+    auto blob = MelobaseCore::getSequenceDataBinaryBlob(sequence, false);
+    auto plistBlob = MelobaseCore::getSequenceDataBlob(sequence, true);
+
+    for (auto& b : {compressedBlob, blob, plistBlob}) {
+        auto decodedSequence = std::make_shared<MelobaseCore::Sequence>();
+        if (!MelobaseCore::setSequenceDataFromBlob(decodedSequence, b.data(), b.size()) ||
+            !compareSequenceData(sequence.get(), decodedSequence.get())) {
+            std::cout << "Sequence data mismatch\n";
+            return false;
+        }
+    }
+
+    if (compressedBlob.size() >= blob.size() || blob.size() >= plistBlob.size() / 2) {
+        std::cout << "Blob sizes: " << compressedBlob.size() << " " << blob.size() << " " << plistBlob.size() << "\n";
+        return false;
+    }
+
+    // The plist without variable-length encoding drops the variable-length events
+    auto plistBlobWithoutVLE = MelobaseCore::getSequenceDataBlob(sequence, false);
+    auto decodedSequence = std::make_shared<MelobaseCore::Sequence>();
+    if (!MelobaseCore::setSequenceDataFromBlob(decodedSequence, plistBlobWithoutVLE.data(),
+                                               plistBlobWithoutVLE.size()) ||
+        decodedSequence->data.tracks[0]->clips[0]->events.size() != events.size() - 2) {
+        std::cout << "Unable to read the plist\n";
+        return false;
+    }
+
+    // Truncated blobs are rejected
+    for (size_t size = 0; size < 64; ++size) {
+        if (MelobaseCore::setSequenceDataFromBlob(decodedSequence, blob.data(), size) ||
+            MelobaseCore::setSequenceDataFromBlob(decodedSequence, blob.data(), blob.size() - 1 - size) ||
+            MelobaseCore::setSequenceDataFromBlob(decodedSequence, compressedBlob.data(),
+                                                  compressedBlob.size() - 1 - size)) {
+            std::cout << "Truncated blob accepted\n";
+            return false;
+        }
+    }
+
     return true;
-}
\ No newline at end of file
+}
@@ -11,3 +11,6 @@
 #include <stdio.h>
 
 bool testSequencesDB();
+bool testSequencesDBCache();
+bool testSequencesDBPages();
+bool testSequenceDataBlob();
@@ -22,7 +22,9 @@ bool executeTest(const std::string& testName) {
 
         {"MoveEvents", testMoveEvents},   {"QuantizeEvents", testQuantizeEvents},
         {"Tracks", testTracks},           {"StudioSequenceConversion", testStudioSequenceConversion},
-        {"SequencesDB", testSequencesDB}, {"Sync", testSync}};
+        {"SequencesDB", testSequencesDB}, {"SequencesDBCache", testSequencesDBCache},
+        {"SequencesDBPages", testSequencesDBPages}, {"SequenceDataBlob", testSequenceDataBlob},
+        {"Sync", testSync}};
 
     if (tests.find(testName) == tests.end()) {
         std::cout << "Test not found\n";
@@ -7,11 +7,13 @@ if language() == "fr" then
 dateAndTime="Date et heure"
 rating="Cote"
 name="Nom"
+nameSearchTooltip="Recherche les mots commençant par le texte saisi"
 
 else
 
 dateAndTime="Date and Time"
 rating="Rating"
 name="Name"
+nameSearchTooltip="Finds the words starting with the typed text"
 
 end
\ No newline at end of file